@@ -0,0 +1,60 @@
+# Offline shader compile, run by the ShadersCheck target for one file:
+#     cmake -DGLSLANG=... [-DSPIRV_OPT=...] [-DSPIRV_CROSS=...]
+#           -DINPUT=<shader> -DOUTPUT=<shader>.spv -P compile_shader.cmake
+# A GLSL error fails the build. Shaders valid GLSL but not SPIR-V for GL
+# get an empty .spv and are compiled from source at runtime.
+
+get_filename_component(OUTPUT_DIR ${OUTPUT} DIRECTORY)
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+execute_process(
+	COMMAND ${GLSLANG} ${INPUT}
+	RESULT_VARIABLE result
+	OUTPUT_VARIABLE log
+	ERROR_VARIABLE log)
+if (NOT result EQUAL 0)
+	message(FATAL_ERROR "${INPUT}\n${log}")
+endif()
+
+# Uniform locations and bindings the GLSL leaves out are assigned here,
+# the runtime reads them back from the SPIR-V. Varyings are matched by
+# location, not name: auto-mapped ones follow declaration order, so stages
+# declaring them in different orders need explicit locations.
+execute_process(
+	COMMAND ${GLSLANG} -G --auto-map-locations --auto-map-bindings
+		-o ${OUTPUT}.unoptimized ${INPUT}
+	RESULT_VARIABLE result
+	OUTPUT_VARIABLE log
+	ERROR_VARIABLE log)
+if (NOT result EQUAL 0)
+	message(STATUS "${INPUT}: no SPIR-V, compiled from GLSL at runtime.\n${log}")
+	file(WRITE ${OUTPUT} "")
+	file(REMOVE ${OUTPUT}.unoptimized)
+	return()
+endif()
+
+if (SPIRV_OPT)
+	execute_process(
+		COMMAND ${SPIRV_OPT} -O ${OUTPUT}.unoptimized -o ${OUTPUT}
+		RESULT_VARIABLE result
+		OUTPUT_VARIABLE log
+		ERROR_VARIABLE log)
+	if (NOT result EQUAL 0)
+		message(FATAL_ERROR "${INPUT}: spirv-opt failed\n${log}")
+	endif()
+	file(REMOVE ${OUTPUT}.unoptimized)
+else()
+	file(RENAME ${OUTPUT}.unoptimized ${OUTPUT})
+endif()
+
+if (SPIRV_CROSS)
+	string(REGEX REPLACE "\\.spv$" ".json" REFLECTION ${OUTPUT})
+	execute_process(
+		COMMAND ${SPIRV_CROSS} ${OUTPUT} --reflect --output ${REFLECTION}
+		RESULT_VARIABLE result
+		OUTPUT_VARIABLE log
+		ERROR_VARIABLE log)
+	if (NOT result EQUAL 0)
+		message(FATAL_ERROR "${INPUT}: spirv-cross reflection failed\n${log}")
+	endif()
+endif()
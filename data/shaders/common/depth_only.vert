@@ -0,0 +1,18 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// The shading pass tests against this depth, its vertex shader has to
+// compute gl_Position the same way (hello_light/lightShader.vert).
+invariant gl_Position;
+
+void main()
+{
+    vec4 world_pos = model * vec4(aPos, 1.0);
+    vec4 view_pos = view * world_pos;
+    gl_Position = projection * view_pos;
+}
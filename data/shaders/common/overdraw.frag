@@ -0,0 +1,9 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+    // Accumulated with additive blending, one step of an 8 bit channel.
+    FragColor = vec4(1.0 / 255.0, 0.0, 0.0, 0.0);
+}
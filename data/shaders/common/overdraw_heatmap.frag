@@ -0,0 +1,23 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+
+uniform sampler2D overdraw;
+
+// 0 black, 1 blue, 2 green, 3 yellow, 4 red, 8+ white.
+vec3 HeatColor(float count)
+{
+    if (count < 0.5) return vec3(0.0);
+    if (count < 1.5) return vec3(0.0, 0.0, 1.0);
+    if (count < 2.5) return vec3(0.0, 1.0, 0.0);
+    if (count < 3.5) return vec3(1.0, 1.0, 0.0);
+    return mix(vec3(1.0, 0.0, 0.0), vec3(1.0), clamp((count - 4.0) / 4.0, 0.0, 1.0));
+}
+
+void main()
+{
+    float count = texture(overdraw, out_tex).r * 255.0;
+    FragColor = vec4(HeatColor(count), 1.0);
+}
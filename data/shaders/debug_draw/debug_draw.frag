@@ -0,0 +1,10 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec4 out_color;
+
+void main()
+{
+    FragColor = out_color;
+}
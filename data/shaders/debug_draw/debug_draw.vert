@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColor;
+
+out vec4 out_color;
+
+uniform mat4 view_projection;
+
+void main()
+{
+    gl_Position = view_projection * vec4(aPos, 1.0);
+    out_color = aColor;
+}
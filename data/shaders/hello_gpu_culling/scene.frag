@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+in vec3 out_color;
+
+uniform vec3 light_direction;
+
+void main()
+{
+    float diffuse = max(dot(normalize(out_normal), -light_direction), 0.0);
+    FragColor = vec4(out_color * (0.25 + 0.75 * diffuse), 1.0);
+}
@@ -0,0 +1,40 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+// Object index, per instance.
+layout(location = 3) in uint aObject;
+
+struct Object
+{
+    mat4 model;
+    uint mesh;
+};
+
+layout(std430, binding = 12) readonly buffer ObjectBuffer
+{
+    Object objects[];
+};
+
+out vec3 out_normal;
+out vec3 out_color;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+vec3 ObjectColor(uint index)
+{
+    uint hash = index * 2654435761u;
+    return vec3(
+        float((hash >> 8u) & 255u),
+        float((hash >> 16u) & 255u),
+        float((hash >> 24u) & 255u)) / 255.0 * 0.6 + 0.2;
+}
+
+void main()
+{
+    mat4 model = objects[aObject].model;
+    out_normal = mat3(transpose(inverse(model))) * aNormal;
+    out_color = ObjectColor(aObject);
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -2,28 +2,80 @@
 
 layout(location = 0) out vec4 FragColor;
 
-in vec3 out_normal;
-in vec3 out_pos;
-in vec2 out_tex;
-in vec3 camera_view;
+layout(location = 0) in vec3 out_normal;
+layout(location = 2) in vec3 out_pos;
+layout(location = 3) in vec2 out_tex;
+layout(location = 1) in vec3 out_camera_view;
+layout(location = 4) in float out_view_z;
+
+struct PointLight
+{
+    vec4 position_radius;
+    vec4 color_intensity;
+};
+
+layout(std430, binding = 0) readonly buffer LightBuffer
+{
+    PointLight lights[];
+};
+
+// Offset and count into light_indices for every cluster.
+layout(std430, binding = 2) readonly buffer LightGridBuffer
+{
+    uvec2 light_grid[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndexBuffer
+{
+    uint light_indices[];
+};
 
 uniform sampler2D textureDiffuse;
+uniform ivec3 cluster_grid;
+uniform vec2 cluster_tile_size;
+uniform float cluster_slice_scale;
+uniform float cluster_slice_bias;
 
-const float ambientStrength = 0.3;
-const vec3 lightPos = vec3(0.0, -1.5, 3.0);
-const vec3 lightColor = vec3(1.0, 0.0, 0.0);
-const vec3 lightColor2 = vec3(1.0, 1.0, 1.0);
+const float ambientStrength = 0.1;
+const vec3 ambientColor = vec3(1.0, 1.0, 1.0);
 
+uint ClusterIndex()
+{
+    uint slice = uint(max(
+        log(-out_view_z) * cluster_slice_scale + cluster_slice_bias, 
+        0.0));
+    slice = min(slice, uint(cluster_grid.z - 1));
+    uvec2 tile = uvec2(gl_FragCoord.xy / cluster_tile_size);
+    tile = min(tile, uvec2(cluster_grid.xy - 1));
+    return tile.x + 
+        uint(cluster_grid.x) * (tile.y + uint(cluster_grid.y) * slice);
+}
 
 void main()
 {
-    vec3 ambient = ambientStrength * lightColor2;
-
     vec3 normal = normalize(out_normal);
-    vec3 lightDir = normalize(lightPos - out_pos);
-    float diff = max(dot(out_normal, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor2;
+    vec3 view_dir = normalize(out_camera_view - out_pos);
+    vec3 lighting = ambientStrength * ambientColor;
+
+    uvec2 cluster = light_grid[ClusterIndex()];
+    for (uint i = 0u; i < cluster.y; ++i)
+    {
+        PointLight light = lights[light_indices[cluster.x + i]];
+        vec3 to_light = light.position_radius.xyz - out_pos;
+        float dist = length(to_light);
+        vec3 light_dir = to_light / dist;
+        // Smooth window so the light reaches zero at its radius.
+        float window = 
+            clamp(1.0 - pow(dist / light.position_radius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (dist * dist + 1.0);
+        float diff = max(dot(normal, light_dir), 0.0);
+        vec3 halfway = normalize(light_dir + view_dir);
+        float spec = pow(max(dot(normal, halfway), 0.0), 32.0) * 0.25;
+        lighting += 
+            (diff + spec) * attenuation * 
+            light.color_intensity.rgb * light.color_intensity.w;
+    }
 
-    vec3 result = (ambient + diffuse) * texture(textureDiffuse, out_tex).rgb;
+    vec3 result = lighting * texture(textureDiffuse, out_tex).rgb;
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -4,25 +4,30 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTex;
 
-out vec3 out_normal;
-out vec3 out_camera_view;
-out vec3 out_pos;
-out vec2 out_tex;
+layout(location = 0) out vec3 out_normal;
+layout(location = 1) out vec3 out_camera_view;
+layout(location = 2) out vec3 out_pos;
+layout(location = 3) out vec2 out_tex;
+layout(location = 4) out float out_view_z;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 inv_model;
+uniform mat4 model_inverse;
 uniform vec3 camera_pos;
 
-
+// Same expression as common/depth_only.vert, the pre-pass depth is
+// matched with GL_LEQUAL.
+invariant gl_Position;
 
 void main()
 {
-    mat4 pvm = projection * view * model;
-    out_pos = (pvm * vec4(aPos, 1.0)).xyz;
-    gl_Position = pvm * vec4(aPos, 1.0);
+    vec4 world_pos = model * vec4(aPos, 1.0);
+    vec4 view_pos = view * world_pos;
+    out_pos = world_pos.xyz;
+    out_view_z = view_pos.z;
+    gl_Position = projection * view_pos;
     out_tex = aTex;
-    out_normal = vec3(inv_model * vec4(aNormal, 1.0));
+    out_normal = mat3(model_inverse) * aNormal;
     out_camera_view = camera_pos;
-}
\ No newline at end of file
+}
@@ -0,0 +1,17 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+in vec2 out_tex;
+
+uniform sampler2D textureDiffuse;
+uniform vec3 color;
+
+const vec3 lightDir = normalize(vec3(0.3, 1.0, 0.5));
+
+void main()
+{
+    float diff = max(dot(normalize(out_normal), lightDir), 0.0) * 0.7 + 0.3;
+    FragColor = vec4(diff * color * texture(textureDiffuse, out_tex).rgb, 1.0);
+}
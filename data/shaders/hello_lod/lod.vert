@@ -0,0 +1,20 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTex;
+// Per instance, one column per attribute.
+layout(location = 3) in mat4 aModel;
+
+out vec3 out_normal;
+out vec2 out_tex;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+    out_normal = transpose(inverse(mat3(aModel))) * aNormal;
+    out_tex = aTex;
+}
@@ -0,0 +1,63 @@
+#version 450 core
+#extension GL_ARB_bindless_texture : enable
+#extension GL_NV_gpu_shader5 : enable
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+in vec2 out_tex;
+flat in uint out_texture_index;
+
+// Texture table filled by gl::TextureResidency.
+struct TextureEntry
+{
+    uvec2 handle;
+    uint page;
+    uint layer;
+};
+layout(std430, binding = 5) readonly buffer TextureTable
+{
+    TextureEntry texture_table[];
+};
+uniform sampler2DArray texture_pages[8];
+uniform bool use_bindless;
+
+// index may differ between the instances of a multi-draw, so neither the
+// handle nor the page is dynamically uniform. Only NV_gpu_shader5 allows
+// such samplers (TextureResidency doesn't pick bindless without it),
+// otherwise every page is visited with a uniform index and the matching
+// one kept, with gradients taken outside the branch.
+vec4 SampleTexture(uint index, vec2 uv)
+{
+    TextureEntry entry = texture_table[index];
+    vec3 coord = vec3(uv, float(entry.layer));
+#if defined(GL_ARB_bindless_texture) && defined(GL_NV_gpu_shader5)
+    if (use_bindless)
+    {
+        return texture(sampler2D(entry.handle), uv);
+    }
+#endif
+#ifdef GL_NV_gpu_shader5
+    return texture(texture_pages[entry.page], coord);
+#else
+    vec2 dx = dFdx(uv);
+    vec2 dy = dFdy(uv);
+    vec4 color = vec4(0.0);
+    for (int page = 0; page < 8; ++page)
+    {
+        if (entry.page == uint(page))
+        {
+            color = textureGrad(texture_pages[page], coord, dx, dy);
+        }
+    }
+    return color;
+#endif
+}
+
+const vec3 lightDir = normalize(vec3(0.3, 1.0, 0.5));
+
+void main()
+{
+    float diff = max(dot(normalize(out_normal), lightDir), 0.0) * 0.7 + 0.3;
+    FragColor = vec4(diff * SampleTexture(out_texture_index, out_tex).rgb, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTex;
+// Per instance, fetched through the base instance of each draw command.
+layout(location = 3) in mat4 aModel;
+layout(location = 7) in uint aTextureIndex;
+
+out vec3 out_normal;
+out vec2 out_tex;
+flat out uint out_texture_index;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+    out_normal = mat3(aModel) * aNormal;
+    out_tex = aTex;
+    out_texture_index = aTextureIndex;
+}
@@ -0,0 +1,20 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTex;
+
+out vec3 out_normal;
+out vec2 out_tex;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 model_inverse;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    out_normal = mat3(model_inverse) * aNormal;
+    out_tex = aTex;
+}
@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+
+uniform vec3 color;
+uniform vec3 light_direction;
+
+void main()
+{
+    float diffuse = max(dot(normalize(out_normal), -light_direction), 0.0);
+    FragColor = vec4(color * (0.2 + 0.8 * diffuse), 1.0);
+}
@@ -0,0 +1,22 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+
+uniform sampler2D source;
+// One texel along the blur axis.
+uniform vec2 direction;
+
+const float weights[5] = float[](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+
+void main()
+{
+    vec3 color = texture(source, out_tex).rgb * weights[0];
+    for (int i = 1; i < 5; ++i)
+    {
+        color += texture(source, out_tex + direction * i).rgb * weights[i];
+        color += texture(source, out_tex - direction * i).rgb * weights[i];
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+
+uniform sampler2D hdr;
+uniform sampler2D bloom;
+uniform float bloom_intensity;
+
+void main()
+{
+    vec3 color = texture(hdr, out_tex).rgb;
+    color += texture(bloom, out_tex).rgb * bloom_intensity;
+    // Still HDR, the engine post-process tonemaps it.
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,34 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+in vec4 out_light_space;
+
+uniform sampler2D shadow_map;
+uniform vec3 light_direction;
+// Over 1 for the emissive cubes, that's what the bloom picks up.
+uniform vec3 color;
+
+float Shadow()
+{
+    vec3 position = out_light_space.xyz / out_light_space.w * 0.5 + 0.5;
+    if (position.z > 1.0) return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadow_map, 0));
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            float depth = texture(shadow_map, position.xy + vec2(x, y) * texel).r;
+            lit += position.z - 0.002 > depth ? 0.0 : 1.0;
+        }
+    }
+    return lit / 9.0;
+}
+
+void main()
+{
+    float diffuse = max(dot(normalize(out_normal), -light_direction), 0.0);
+    FragColor = vec4(color * (0.15 + 0.85 * diffuse * Shadow()), 1.0);
+}
@@ -0,0 +1,20 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+
+out vec3 out_normal;
+out vec4 out_light_space;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 light_space;
+
+void main()
+{
+    vec4 world = model * vec4(aPos, 1.0);
+    out_normal = mat3(transpose(inverse(model))) * aNormal;
+    out_light_space = light_space * world;
+    gl_Position = projection * view * world;
+}
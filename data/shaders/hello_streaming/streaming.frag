@@ -0,0 +1,33 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec3 out_normal;
+in vec2 out_tex;
+
+uniform sampler2D textureDiffuse;
+// Finest resident level, only used to tint the levels.
+uniform int base_level;
+uniform bool show_levels;
+
+const vec3 lightDir = normalize(vec3(0.3, 1.0, 0.5));
+const vec3 tints[6] = vec3[](
+    vec3(1.0, 0.3, 0.3),
+    vec3(1.0, 1.0, 0.3),
+    vec3(0.3, 1.0, 0.3),
+    vec3(0.3, 1.0, 1.0),
+    vec3(0.3, 0.3, 1.0),
+    vec3(1.0, 0.3, 1.0));
+
+void main()
+{
+    float diff = max(dot(normalize(out_normal), lightDir), 0.0) * 0.7 + 0.3;
+    vec3 color = texture(textureDiffuse, out_tex).rgb;
+    if (show_levels)
+    {
+        // Mip accessed, relative to the base level.
+        int level = base_level + int(textureQueryLod(textureDiffuse, out_tex).x);
+        color *= tints[min(level, 5)];
+    }
+    FragColor = vec4(diff * color, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+in vec4 out_color;
+
+// Soft disc.
+void main()
+{
+    float alpha = out_color.a * clamp(1.0 - dot(out_tex, out_tex), 0.0, 1.0);
+    if (alpha < 1.0 / 255.0) discard;
+    FragColor = vec4(out_color.rgb, alpha);
+}
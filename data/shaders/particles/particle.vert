@@ -0,0 +1,46 @@
+#version 450 core
+
+struct Particle
+{
+    // xyz position, w age in seconds.
+    vec4 position;
+    // xyz velocity, w lifetime in seconds.
+    vec4 velocity;
+};
+
+layout(std430, binding = 6) readonly buffer ParticleBuffer
+{
+    Particle particles[];
+};
+
+layout(std430, binding = 10) readonly buffer SortBuffer
+{
+    uvec2 sorted[];
+};
+
+out vec2 out_tex;
+out vec4 out_color;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec4 color_begin;
+uniform vec4 color_end;
+uniform vec2 size;
+
+const vec2 corners[6] = vec2[6](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+// Six vertices per particle, a camera facing quad in view space.
+void main()
+{
+    uint index = sorted[gl_VertexID / 6].y;
+    vec2 corner = corners[gl_VertexID % 6];
+    Particle particle = particles[index];
+    float t = clamp(particle.position.w / particle.velocity.w, 0.0, 1.0);
+    vec4 center = view * vec4(particle.position.xyz, 1.0);
+    center.xy += corner * mix(size.x, size.y, t);
+    gl_Position = projection * center;
+    out_tex = corner;
+    out_color = mix(color_begin, color_end, t);
+}
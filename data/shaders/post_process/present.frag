@@ -0,0 +1,47 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+
+// Last output of the chain, scaled to the window by the bilinear fetch
+// unless it has been upscaled to it already.
+uniform sampler2D source;
+// Contrast adaptive sharpening in the manner of FSR 1 RCAS, source has to
+// be at the window resolution. Sharpness in stops, 0 is the strongest.
+uniform bool sharpen;
+uniform float sharpness;
+
+const float RCAS_LIMIT = 0.25 - 1.0 / 16.0;
+
+vec3 Fetch(ivec2 texel)
+{
+    texel = clamp(texel, ivec2(0), textureSize(source, 0) - 1);
+    return clamp(texelFetch(source, texel, 0).rgb, 0.0, 1.0);
+}
+
+void main()
+{
+    if (!sharpen)
+    {
+        FragColor = vec4(texture(source, out_tex).rgb, 1.0);
+        return;
+    }
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 b = Fetch(texel + ivec2(0, -1));
+    vec3 d = Fetch(texel + ivec2(-1, 0));
+    vec3 e = Fetch(texel);
+    vec3 f = Fetch(texel + ivec2(1, 0));
+    vec3 h = Fetch(texel + ivec2(0, 1));
+    // The negative lobe as large as it can be without clipping the
+    // neighbourhood, so edges get less than flat areas.
+    vec3 ring_min = min(min(b, d), min(f, h));
+    vec3 ring_max = max(max(b, d), max(f, h));
+    vec3 hit_min = min(ring_min, e) / max(4.0 * ring_max, 1e-5);
+    vec3 hit_max = (1.0 - max(ring_max, e)) / min(4.0 * ring_min - 4.0, -1e-5);
+    vec3 lobes = max(-hit_min, hit_max);
+    float lobe = max(-RCAS_LIMIT, min(max(lobes.r, max(lobes.g, lobes.b)), 0.0)) *
+        exp2(-sharpness);
+    vec3 color = (lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0);
+    FragColor = vec4(color, 1.0);
+}
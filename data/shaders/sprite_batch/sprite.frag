@@ -0,0 +1,13 @@
+#version 450 core
+
+layout(location = 0) out vec4 FragColor;
+
+in vec2 out_tex;
+in vec4 out_color;
+
+uniform sampler2D sprite_texture;
+
+void main()
+{
+    FragColor = out_color * texture(sprite_texture, out_tex);
+}
@@ -0,0 +1,17 @@
+#version 450 core
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTex;
+layout(location = 2) in vec4 aColor;
+
+out vec2 out_tex;
+out vec4 out_color;
+
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * vec4(aPos, 0.0, 1.0);
+    out_tex = aTex;
+    out_color = aColor;
+}
@@ -6,6 +6,8 @@
 
 #include <vector>
 
+#include "input.h"
+
 namespace gl {
 
 	// Defines several possible options for camera movement. Used as
@@ -101,6 +103,28 @@ namespace gl {
 				position += right * velocity;
 		}
 
+		// processes continuous movement, sampled every frame. Amounts go
+		// from -1 to 1 (an input action or a stick), negative is backward
+		// or left
+		void ProcessMovement(float forwardAmount, float rightAmount, float deltaTime)
+		{
+			float velocity = MovementSpeed * deltaTime;
+			position += front * forwardAmount * velocity;
+			position += right * rightAmount * velocity;
+		}
+
+		// processes the "move_forward" and "move_right" actions of the
+		// Input state, sampled every frame rather than at the key repeat
+		// rate. deltaTime may be scaled to speed the camera up
+		void ProcessKeyboardState(float deltaTime)
+		{
+			const Input& input = Input::GetInstance();
+			ProcessMovement(
+				input.GetAction("move_forward"),
+				input.GetAction("move_right"),
+				deltaTime);
+		}
+
 		// processes input received from a mouse input system. Expects the
 		// offset value in both the x and y direction.
 		void ProcessMouseMovement(
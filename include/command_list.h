@@ -0,0 +1,191 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace gl {
+
+	enum class CommandTypeEnum : std::uint16_t {
+		BIND_PROGRAM,
+		BIND_VERTEX_ARRAY,
+		BIND_TEXTURE,
+		SET_INT,
+		SET_FLOAT,
+		SET_VEC3,
+		SET_VEC4,
+		SET_MAT4,
+		DRAW,
+		DRAW_INDEXED,
+	};
+
+	enum class PrimitiveEnum : std::uint16_t {
+		TRIANGLES,
+		LINES,
+		POINTS,
+	};
+
+	// Every command starts with this header, size covers the header and
+	// the payload so unknown commands can be skipped.
+	struct CommandHeader
+	{
+		CommandTypeEnum type;
+		std::uint16_t size;
+	};
+
+	// Payloads, plain data with no API types. Programs, vertex arrays and
+	// textures are backend object names, uniforms are locations looked up
+	// beforehand on the thread owning the context.
+	struct BindProgramCommand
+	{
+		std::uint32_t program;
+	};
+	struct BindVertexArrayCommand
+	{
+		std::uint32_t vertex_array;
+	};
+	struct BindTextureCommand
+	{
+		std::uint32_t unit;
+		std::uint32_t texture;
+	};
+	struct SetIntCommand
+	{
+		std::int32_t location;
+		std::int32_t value;
+	};
+	struct SetFloatCommand
+	{
+		std::int32_t location;
+		float value;
+	};
+	struct SetVec3Command
+	{
+		std::int32_t location;
+		glm::vec3 value;
+	};
+	struct SetVec4Command
+	{
+		std::int32_t location;
+		glm::vec4 value;
+	};
+	struct SetMat4Command
+	{
+		std::int32_t location;
+		glm::mat4 value;
+	};
+	struct DrawCommand
+	{
+		PrimitiveEnum primitive;
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+	// 32 bit indices from the bound vertex array's index buffer.
+	struct DrawIndexedCommand
+	{
+		PrimitiveEnum primitive;
+		std::uint32_t first_index;
+		std::uint32_t count;
+	};
+
+	// Linear buffer of commands, recorded on any thread and replayed on
+	// the one owning the context (see CommandReplayer). Recording is a
+	// copy into memory kept from frame to frame, Reset only rewinds.
+	// Nothing is shared between lists, one list per job needs no locks.
+	class CommandList
+	{
+	public:
+		explicit CommandList(std::size_t initial_bytes = 64 * 1024);
+		CommandList(CommandList&&) noexcept = default;
+		CommandList& operator=(CommandList&&) noexcept = default;
+
+		void Reset()
+		{
+			size_ = 0;
+			command_count_ = 0;
+		}
+		void BindProgram(std::uint32_t program)
+		{
+			Push(CommandTypeEnum::BIND_PROGRAM, BindProgramCommand{ program });
+		}
+		void BindVertexArray(std::uint32_t vertex_array)
+		{
+			Push(
+				CommandTypeEnum::BIND_VERTEX_ARRAY,
+				BindVertexArrayCommand{ vertex_array });
+		}
+		void BindTexture(std::uint32_t unit, std::uint32_t texture)
+		{
+			Push(CommandTypeEnum::BIND_TEXTURE, BindTextureCommand{ unit, texture });
+		}
+		void SetInt(std::int32_t location, std::int32_t value)
+		{
+			Push(CommandTypeEnum::SET_INT, SetIntCommand{ location, value });
+		}
+		void SetFloat(std::int32_t location, float value)
+		{
+			Push(CommandTypeEnum::SET_FLOAT, SetFloatCommand{ location, value });
+		}
+		void SetVec3(std::int32_t location, const glm::vec3& value)
+		{
+			Push(CommandTypeEnum::SET_VEC3, SetVec3Command{ location, value });
+		}
+		void SetVec4(std::int32_t location, const glm::vec4& value)
+		{
+			Push(CommandTypeEnum::SET_VEC4, SetVec4Command{ location, value });
+		}
+		void SetMat4(std::int32_t location, const glm::mat4& value)
+		{
+			Push(CommandTypeEnum::SET_MAT4, SetMat4Command{ location, value });
+		}
+		void Draw(PrimitiveEnum primitive, std::uint32_t first, std::uint32_t count)
+		{
+			Push(CommandTypeEnum::DRAW, DrawCommand{ primitive, first, count });
+		}
+		void DrawIndexed(
+			PrimitiveEnum primitive,
+			std::uint32_t count,
+			std::uint32_t first_index = 0)
+		{
+			Push(
+				CommandTypeEnum::DRAW_INDEXED,
+				DrawIndexedCommand{ primitive, first_index, count });
+		}
+
+		const std::uint8_t* GetData() const { return data_.get(); }
+		std::size_t GetSize() const { return size_; }
+		std::size_t GetCapacity() const { return capacity_; }
+		std::size_t GetCommandCount() const { return command_count_; }
+
+	protected:
+		// Payloads start 4 byte aligned after their header, read them back
+		// with memcpy.
+		template <typename T>
+		void Push(CommandTypeEnum type, const T& payload)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			constexpr std::size_t size = sizeof(CommandHeader) + sizeof(T);
+			static_assert(size <= UINT16_MAX);
+			if (size_ + size > capacity_) Grow(size_ + size);
+			const CommandHeader header = {
+				type,
+				static_cast<std::uint16_t>(size) };
+			std::memcpy(data_.get() + size_, &header, sizeof(header));
+			std::memcpy(data_.get() + size_ + sizeof(header), &payload, sizeof(T));
+			size_ += size;
+			++command_count_;
+		}
+		void Grow(std::size_t minimum);
+
+	protected:
+		std::unique_ptr<std::uint8_t[]> data_;
+		std::size_t size_ = 0;
+		std::size_t capacity_ = 0;
+		std::size_t command_count_ = 0;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "command_list.h"
+
+namespace gl {
+
+	// GL backend of the command lists, replays them on the thread owning
+	// the context. Binds that change nothing (same program, vertex array
+	// or texture as the previous command) are filtered out before they
+	// reach the driver.
+	class CommandReplayer
+	{
+	public:
+		CommandReplayer() { Begin(); }
+		// Forgets the cached state, anything may have been bound since.
+		void Begin();
+		void Replay(const CommandList& list);
+		void Replay(const std::vector<CommandList>& lists);
+		// Unbinds what the lists left bound.
+		void End();
+
+		std::size_t GetCommandCount() const { return command_count_; }
+		std::size_t GetDrawCount() const { return draw_count_; }
+		std::size_t GetFilteredCount() const { return filtered_count_; }
+
+	protected:
+		void IsError(const char* file, int line) const;
+
+	protected:
+		static constexpr std::size_t MAX_TEXTURE_UNITS = 16;
+		// Cached value when the state is unknown, matches no object name.
+		static constexpr std::uint32_t UNKNOWN = 0xFFFFFFFFu;
+
+		std::uint32_t program_ = UNKNOWN;
+		std::uint32_t vertex_array_ = UNKNOWN;
+		std::uint32_t active_unit_ = UNKNOWN;
+		std::array<std::uint32_t, MAX_TEXTURE_UNITS> textures_;
+
+		// Since Begin.
+		std::size_t command_count_ = 0;
+		std::size_t draw_count_ = 0;
+		std::size_t filtered_count_ = 0;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+
+// On unless NDEBUG (Release), -DGL_DEBUG_DRAW=0 or 1 overrides. When off
+// every call below is an empty inline function and nothing is linked in.
+#ifndef GL_DEBUG_DRAW
+#ifdef NDEBUG
+#define GL_DEBUG_DRAW 0
+#else
+#define GL_DEBUG_DRAW 1
+#endif
+#endif
+
+namespace gl {
+
+	class Shader;
+	class StreamBuffer;
+
+	// Immediate mode debug geometry usable from any Program::Update:
+	//
+	//     auto& debug = DebugDraw::GetInstance();
+	//     debug.SetViewProjection(projection * view);
+	//     debug.Aabb(box.min, box.max, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+	//
+	// Calls only append vertices to a CPU list, the engine sends the whole
+	// frame after Program::Update in one draw for the depth tested lines and
+	// one for the overlay. A duration keeps a primitive for that many
+	// seconds instead of a single frame. Text goes through the ImGui
+	// foreground draw list.
+	class DebugDraw
+	{
+	public:
+		static constexpr std::size_t MAX_LINES = 256 * 1024;
+
+		static DebugDraw& GetInstance();
+
+		void Line(
+			const glm::vec3& from,
+			const glm::vec3& to,
+			const glm::vec4& color = glm::vec4(1.0f),
+			float duration = 0.0f,
+			bool depth_test = true);
+		void Aabb(
+			const glm::vec3& min,
+			const glm::vec3& max,
+			const glm::vec4& color = glm::vec4(1.0f),
+			float duration = 0.0f,
+			bool depth_test = true);
+		void Sphere(
+			const glm::vec3& center,
+			float radius,
+			const glm::vec4& color = glm::vec4(1.0f),
+			float duration = 0.0f,
+			bool depth_test = true);
+		// The frustum of a camera, from its projection * view.
+		void Frustum(
+			const glm::mat4& view_projection,
+			const glm::vec4& color = glm::vec4(1.0f),
+			float duration = 0.0f,
+			bool depth_test = true);
+		// X, Y and Z of the transform in red, green and blue.
+		void Axis(
+			const glm::mat4& transform,
+			float size = 1.0f,
+			float duration = 0.0f,
+			bool depth_test = false);
+		void Text3D(
+			const glm::vec3& position,
+			const std::string& text,
+			const glm::vec4& color = glm::vec4(1.0f),
+			float duration = 0.0f);
+		// Camera of the frame, nothing is drawn until it is set.
+		void SetViewProjection(const glm::mat4& view_projection);
+
+		// Called by the engine.
+		void Init(const std::string& path);
+		void Destroy();
+		void Render(float dt);
+		void DrawImGui();
+
+#if GL_DEBUG_DRAW
+	protected:
+		DebugDraw();
+		~DebugDraw();
+
+	protected:
+		struct DebugVertex
+		{
+			glm::vec3 position;
+			std::uint32_t color;
+		};
+		struct TimedLine
+		{
+			DebugVertex from;
+			DebugVertex to;
+			float remaining;
+			bool depth_test;
+		};
+		struct TimedText
+		{
+			glm::vec3 position;
+			std::string text;
+			std::uint32_t color;
+			float remaining;
+		};
+
+		void AddLine(
+			const DebugVertex& from,
+			const DebugVertex& to,
+			float duration,
+			bool depth_test);
+		void DrawTexts(float dt);
+
+		std::vector<DebugVertex> depth_vertices_;
+		std::vector<DebugVertex> overlay_vertices_;
+		std::vector<TimedLine> timed_lines_;
+		std::vector<TimedText> texts_;
+		glm::mat4 view_projection_ = glm::mat4(1.0f);
+		bool has_view_projection_ = false;
+		bool enabled_ = true;
+
+		std::unique_ptr<Shader> shader_;
+		std::unique_ptr<StreamBuffer> stream_;
+		VertexArrayHandle vao_;
+
+		std::size_t last_depth_lines_ = 0;
+		std::size_t last_overlay_lines_ = 0;
+		std::size_t dropped_lines_ = 0;
+		float last_render_ms_ = 0.0f;
+#else
+	protected:
+		DebugDraw() = default;
+#endif
+	};
+
+#if !GL_DEBUG_DRAW
+	inline DebugDraw& DebugDraw::GetInstance()
+	{
+		static DebugDraw instance;
+		return instance;
+	}
+	inline void DebugDraw::Line(
+		const glm::vec3&, const glm::vec3&, const glm::vec4&, float, bool) {}
+	inline void DebugDraw::Aabb(
+		const glm::vec3&, const glm::vec3&, const glm::vec4&, float, bool) {}
+	inline void DebugDraw::Sphere(
+		const glm::vec3&, float, const glm::vec4&, float, bool) {}
+	inline void DebugDraw::Frustum(
+		const glm::mat4&, const glm::vec4&, float, bool) {}
+	inline void DebugDraw::Axis(const glm::mat4&, float, float, bool) {}
+	inline void DebugDraw::Text3D(
+		const glm::vec3&, const std::string&, const glm::vec4&, float) {}
+	inline void DebugDraw::SetViewProjection(const glm::mat4&) {}
+	inline void DebugDraw::Init(const std::string&) {}
+	inline void DebugDraw::Destroy() {}
+	inline void DebugDraw::Render(float) {}
+	inline void DebugDraw::DrawImGui() {}
+#endif
+
+} // End namespace gl.
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace gl {
+
+	// Picks the resolution the scene is rendered at from the GPU time of
+	// the frames, to keep them within a budget. Over it the scale drops at
+	// once, a spike costs sharpness and not a frame. Under it the scale
+	// climbs back a step at a time once the time has stayed low for a
+	// while. Scales are quantized so the targets are only reallocated on
+	// a change.
+	class DynamicResolution
+	{
+	public:
+		// Feed each new GPU frame time as it comes back.
+		void Update(float gpu_milliseconds);
+		glm::ivec2 GetRenderSize(glm::ivec2 output_size) const;
+		float GetScale() const { return enabled_ ? scale_ : 1.0f; }
+		void SetEnabled(bool enabled) { enabled_ = enabled; }
+		bool IsEnabled() const { return enabled_; }
+		void SetBudget(float milliseconds) { budget_ms_ = milliseconds; }
+		float GetBudget() const { return budget_ms_; }
+		void DrawImGui();
+
+	protected:
+		void SetScale(float scale);
+
+	protected:
+		// Timer results come back a few frames late, give a change time to
+		// show before judging it.
+		static constexpr int COOLDOWN_FRAMES = 8;
+		// Frames under the raise threshold before going up a step.
+		static constexpr int RAISE_FRAMES = 30;
+		static constexpr std::size_t HISTORY_SIZE = 120;
+
+		bool enabled_ = true;
+		float budget_ms_ = 16.6f;
+		// Going up has to fit in this fraction of the budget.
+		float headroom_ = 0.85f;
+		float min_scale_ = 0.5f;
+		float step_ = 0.05f;
+		float scale_ = 1.0f;
+		float filtered_ms_ = 0.0f;
+		int cooldown_ = 0;
+		int calm_frames_ = 0;
+		std::array<float, HISTORY_SIZE> ms_history_ = {};
+		std::array<float, HISTORY_SIZE> scale_history_ = {};
+		std::size_t history_index_ = 0;
+	};
+
+} // End namespace gl.
@@ -6,6 +6,9 @@
 
 #include "glm/vec2.hpp"
 
+#include "dynamic_resolution.h"
+#include "post_process.h"
+
 namespace gl
 {
     using seconds = std::chrono::duration<float, std::ratio<1, 1>>;
@@ -14,11 +17,17 @@ namespace gl
     {
     public:
         virtual ~Program() = default;
+        // Before the window and the context exist: add the loading that
+        // needs no GL to Startup, and the uploads depending on it.
+        virtual void Preload() {}
         virtual void Init() = 0;
         virtual void Update(seconds dt) = 0;
         virtual void Destroy() = 0;
         virtual void OnEvent(SDL_Event& event) = 0;
         virtual void DrawImGui() = 0;
+        // Frames are timed against each other: no vsync and no dynamic
+        // resolution.
+        virtual bool IsBenchmark() const { return false; }
     };
 
     class Engine
@@ -35,6 +44,11 @@ namespace gl
         SDL_Window* window_;
         SDL_GLContext glRenderContext_;
         glm::vec2 windowSize_{1024,720};
+        // The program draws into its HDR target, then the effects run.
+        PostProcess postProcess_;
+        // Size of that target, from the GPU time of the whole frame.
+        DynamicResolution dynamicResolution_;
+        GpuTimer frameTimer_;
         float deltaTime_ = 0.0f;
     };
 } // namespace gl
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gl {
+
+	class JobSystem;
+
+	// Content of a file, either a view straight into the mapped archive or
+	// bytes owned by the object (decompressed or read from a loose file).
+	// Views stay valid until the archive is unmounted. Move-only, copying
+	// would leave the view pointing at the source.
+	class FileData
+	{
+	public:
+		FileData() = default;
+		explicit FileData(std::span<const std::uint8_t> view) : view_(view) {}
+		explicit FileData(std::vector<std::uint8_t> bytes) :
+			bytes_(std::move(bytes)),
+			view_(bytes_)
+		{
+		}
+		FileData(FileData&&) noexcept = default;
+		FileData& operator=(FileData&&) noexcept = default;
+		FileData(const FileData&) = delete;
+		FileData& operator=(const FileData&) = delete;
+
+		std::span<const std::uint8_t> GetSpan() const { return view_; }
+		const std::uint8_t* GetData() const { return view_.data(); }
+		std::size_t GetSize() const { return view_.size(); }
+		std::string_view GetText() const
+		{
+			return std::string_view(
+				reinterpret_cast<const char*>(view_.data()),
+				view_.size());
+		}
+		// True if nothing was copied.
+		bool IsMapped() const { return bytes_.empty() && !view_.empty(); }
+
+	protected:
+		std::vector<std::uint8_t> bytes_;
+		std::span<const std::uint8_t> view_;
+	};
+
+	struct PackOptions
+	{
+		// Every entry starts on a multiple of this, a power of two.
+		std::uint32_t alignment = 64;
+		bool compress = true;
+		// Entries are only kept compressed if they shrink below this
+		// fraction of their size (already compressed images won't).
+		float max_ratio = 0.9f;
+	};
+
+	struct PackStats
+	{
+		std::size_t entry_count = 0;
+		std::size_t compressed_count = 0;
+		std::size_t raw_bytes = 0;
+		std::size_t archive_bytes = 0;
+	};
+
+	// Bundles every file under the directories into one archive. Entries
+	// are named by their path from the directory's parent ("data/shaders/
+	// ...", "spirv/data/..."), the names every loader asks for once
+	// normalized. Compressed entries are split in blocks compressed on
+	// their own so a file can be decompressed by several threads. Throws
+	// std::runtime_error.
+	PackStats PackArchive(
+		const std::vector<std::string>& directories,
+		const std::string& archive_name,
+		const PackOptions& options = {});
+
+	// Every asset is read through here. Paths are normalized (separators,
+	// "." and ".." folded, leading ".." dropped) so "../data/x.png" and
+	// "data\\x.png" name the same entry. The mounted archive is searched
+	// first, then the loose files on disk for development: the path as
+	// given, then under the loose root. Reads are thread safe, mounting
+	// and unmounting are not.
+	class FileSystem
+	{
+	public:
+		static FileSystem& GetInstance();
+		~FileSystem();
+		FileSystem(const FileSystem&) = delete;
+		FileSystem& operator=(const FileSystem&) = delete;
+
+		// Maps the archive, false if there is no such file. Throws
+		// std::runtime_error if it isn't a valid archive.
+		bool Mount(const std::string& archive_name);
+		void Unmount();
+		bool IsMounted() const { return archive_ != nullptr; }
+		void SetLooseRoot(const std::string& directory) { loose_root_ = directory; }
+
+		bool Exists(const std::string& path) const;
+		// Throws std::runtime_error if the file can't be found or is
+		// corrupt. With jobs, the blocks of a large compressed entry are
+		// decompressed in parallel.
+		FileData Read(const std::string& path, JobSystem* jobs = nullptr) const;
+		std::string ReadText(const std::string& path) const;
+		// Blocks of every compressed file decompressed in one parallel
+		// loop, results in the order of paths.
+		std::vector<FileData> ReadAll(
+			const std::vector<std::string>& paths,
+			JobSystem& jobs) const;
+		// Files directly in directory, from the archive and the disk, as
+		// paths Read accepts. Sorted, without duplicates.
+		std::vector<std::string> List(const std::string& directory) const;
+		// Reads the file now, on the calling thread, and keeps it for the
+		// next Read of the same path: loading threads prefetch what the
+		// main thread reads later. Uncompressed archive entries are views
+		// already and are left alone. False if there is no such file.
+		bool Prefetch(const std::string& path) const;
+		// Prefetch of every path through ReadAll, the blocks decompressed
+		// and the loose files read in parallel on jobs. Missing files are
+		// skipped.
+		void Prefetch(const std::vector<std::string>& paths, JobSystem& jobs) const;
+		// Drops what was prefetched and not read since.
+		void ClearPrefetched();
+
+		static std::string Normalize(const std::string& path);
+		static std::uint64_t Hash(std::string_view name);
+
+		// Directory entry of an archive, the layout is in file_system.cpp.
+		struct Entry;
+
+	protected:
+		FileSystem() = default;
+
+		const Entry* Find(const std::string& name) const;
+		std::string_view GetName(const Entry& entry) const;
+		// Allocates the output and the block table of a compressed entry.
+		std::vector<std::uint8_t> PrepareBlocks(
+			const Entry& entry,
+			std::vector<std::pair<const std::uint8_t*, std::uint32_t>>& blocks) const;
+		std::string FindLoose(const std::string& path, const std::string& name) const;
+
+	protected:
+		const std::uint8_t* archive_ = nullptr;
+		std::size_t archive_size_ = 0;
+		const Entry* entries_ = nullptr;
+		std::size_t entry_count_ = 0;
+		const char* names_ = nullptr;
+		std::string loose_root_;
+		mutable std::mutex prefetch_mutex_;
+		mutable std::unordered_map<std::string, FileData> prefetched_;
+	};
+
+} // End namespace gl.
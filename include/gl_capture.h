@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gl_intercept.h"
+
+namespace gl {
+
+	// Capture file: "GCAP", the version, the default framebuffer size and
+	// the names of the entry points, then tagged records up to END.
+	// Integers are LEB128 varints, argument slots zigzag encoded first.
+	// Payloads (buffer and texture data, strings, name arrays...) are
+	// stored once as BLOB records and referenced by index from the calls.
+	constexpr char GL_CAPTURE_MAGIC[4] = { 'G', 'C', 'A', 'P' };
+	constexpr std::uint32_t GL_CAPTURE_VERSION = 1;
+
+	enum class GlCaptureTagEnum : std::uint8_t {
+		// Raw size, stored size (0 when not compressed), then the bytes,
+		// LZ4 when compressed. The index is the order of the blobs.
+		BLOB = 1,
+		// Entry point, argument count shifted left once with the low bit
+		// set when there is a result, arguments, the result, then the
+		// payloads.
+		CALL = 2,
+		FRAME = 3,
+		END = 4,
+		// End of the loading, missing when not captured from the start.
+		SETUP = 5,
+	};
+
+	// How a payload goes back into its call.
+	enum class GlPayloadEnum : std::uint8_t {
+		// Read by the call through the argument.
+		ARGUMENT = 0,
+		// The argument points to a pointer to the data (glShaderSource).
+		INDIRECT = 1,
+		// Names written by the call (glGen*), mapped to the replayed ones.
+		OUTPUT = 2,
+		// Written to the mapped range of the target before glUnmapBuffer.
+		MAPPED = 3,
+	};
+
+	inline void AppendVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	// False past the end.
+	inline bool ReadVarint(
+		const std::uint8_t*& data,
+		const std::uint8_t* end,
+		std::uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; data < end && shift < 64; shift += 7)
+		{
+			const std::uint8_t byte = *data++;
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		return false;
+	}
+
+	// Small negative integers, -1 mostly, stay small.
+	inline std::uint64_t ZigZag(GlSlot slot)
+	{
+		const auto value = static_cast<std::int64_t>(slot);
+		return (static_cast<std::uint64_t>(value) << 1) ^
+			static_cast<std::uint64_t>(value >> 63);
+	}
+
+	inline GlSlot UnZigZag(std::uint64_t value)
+	{
+		return (value >> 1) ^ (~(value & 1) + 1);
+	}
+
+	// Records every GL call with its parameters into a capture file for
+	// GlReplay. Only what is called after Start is known, so starting
+	// right after the context is made (GPR5300_GL_CAPTURE, Engine::Init)
+	// gives a file that replays on its own. Writes through persistently
+	// mapped memory are not seen, StreamBuffer does not map while
+	// capturing. Bindless handles stored in buffers are not remapped.
+	class GlCapture : public GlCallListener
+	{
+	public:
+		static GlCapture& GetInstance();
+
+		// Records until frame_count frames ended, needs GlIntercept
+		// installed. Throws std::runtime_error if path cannot be written.
+		void Start(const std::string& path, int frame_count, int width, int height);
+		// Closes the loading calls, they are replayed once before the frames.
+		void EndSetup();
+		// Closes the frame, stops after the last one.
+		void EndFrame();
+		void Stop();
+		bool IsCapturing() const { return capturing_; }
+		void DrawImGui();
+		void BeforeCall(const GlCall& call) override;
+		void AfterCall(const GlCall& call) override;
+
+	protected:
+		GlCapture() = default;
+		// Index of the blob with these bytes, written on first use.
+		std::uint64_t AddBlob(const void* data, std::size_t size);
+		void AddPayload(
+			GlPayloadEnum type,
+			std::size_t arg,
+			const void* data,
+			std::size_t size);
+		void Flush();
+
+	protected:
+		struct Payload
+		{
+			GlPayloadEnum type;
+			std::size_t arg;
+			std::uint64_t blob;
+		};
+		struct Mapping
+		{
+			const void* data = nullptr;
+			std::size_t size = 0;
+			GLbitfield access = 0;
+		};
+		bool capturing_ = false;
+		std::string path_;
+		std::ofstream file_;
+		// Encoded records not written yet.
+		std::vector<std::uint8_t> pending_;
+		// Of the call being recorded.
+		std::vector<Payload> payloads_;
+		// Blob index by hash of size and content.
+		std::unordered_map<std::uint64_t, std::uint64_t> blobs_;
+		std::unordered_map<GLenum, Mapping> mappings_;
+		int unpack_alignment_ = 4;
+		bool unpack_buffer_bound_ = false;
+		int frame_count_ = 0;
+		int frames_done_ = 0;
+		std::uint64_t call_count_ = 0;
+		std::uint64_t payload_bytes_ = 0;
+		std::uint64_t blob_bytes_ = 0;
+		std::uint64_t file_bytes_ = 0;
+	};
+
+} // End namespace gl.
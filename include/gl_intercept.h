@@ -0,0 +1,279 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Every GL entry point called in src/ and main/, new ones are added here.
+#define GL_INTERCEPT_ENTRY_POINTS(X) \
+	X(glActiveTexture) \
+	X(glAttachShader) \
+	X(glBeginQuery) \
+	X(glBindAttribLocation) \
+	X(glBindBuffer) \
+	X(glBindBufferBase) \
+	X(glBindBufferRange) \
+	X(glBindFramebuffer) \
+	X(glBindImageTexture) \
+	X(glBindRenderbuffer) \
+	X(glBindTexture) \
+	X(glBindTextureUnit) \
+	X(glBindVertexArray) \
+	X(glBlendFunc) \
+	X(glBlitFramebuffer) \
+	X(glBufferData) \
+	X(glBufferStorage) \
+	X(glBufferSubData) \
+	X(glCheckFramebufferStatus) \
+	X(glClear) \
+	X(glClearBufferfv) \
+	X(glClearColor) \
+	X(glClientWaitSync) \
+	X(glColorMask) \
+	X(glCompileShader) \
+	X(glCopyBufferSubData) \
+	X(glCreateBuffers) \
+	X(glCreateProgram) \
+	X(glCreateShader) \
+	X(glCreateTextures) \
+	X(glCreateVertexArrays) \
+	X(glDeleteBuffers) \
+	X(glDeleteFramebuffers) \
+	X(glDeleteProgram) \
+	X(glDeleteQueries) \
+	X(glDeleteRenderbuffers) \
+	X(glDeleteShader) \
+	X(glDeleteSync) \
+	X(glDeleteTextures) \
+	X(glDeleteVertexArrays) \
+	X(glDepthFunc) \
+	X(glDepthMask) \
+	X(glDisable) \
+	X(glDispatchCompute) \
+	X(glDispatchComputeIndirect) \
+	X(glDrawArrays) \
+	X(glDrawArraysIndirect) \
+	X(glDrawBuffer) \
+	X(glDrawBuffers) \
+	X(glDrawElements) \
+	X(glDrawElementsInstanced) \
+	X(glEnable) \
+	X(glEnableVertexArrayAttrib) \
+	X(glEnableVertexAttribArray) \
+	X(glEndQuery) \
+	X(glFenceSync) \
+	X(glFinish) \
+	X(glFramebufferRenderbuffer) \
+	X(glFramebufferTexture2D) \
+	X(glGenBuffers) \
+	X(glGenFramebuffers) \
+	X(glGenQueries) \
+	X(glGenRenderbuffers) \
+	X(glGenTextures) \
+	X(glGenVertexArrays) \
+	X(glGenerateMipmap) \
+	X(glGenerateTextureMipmap) \
+	X(glGetBufferSubData) \
+	X(glGetError) \
+	X(glGetFloatv) \
+	X(glGetInteger64v) \
+	X(glGetIntegerv) \
+	X(glGetProgramiv) \
+	X(glGetQueryObjectiv) \
+	X(glGetQueryObjectui64v) \
+	X(glGetShaderInfoLog) \
+	X(glGetShaderiv) \
+	X(glGetString) \
+	X(glGetTextureHandleARB) \
+	X(glGetUniformLocation) \
+	X(glLinkProgram) \
+	X(glMakeTextureHandleNonResidentARB) \
+	X(glMakeTextureHandleResidentARB) \
+	X(glMapBufferRange) \
+	X(glMemoryBarrier) \
+	X(glMultiDrawElementsIndirect) \
+	X(glMultiDrawElementsIndirectCount) \
+	X(glMultiDrawElementsIndirectCountARB) \
+	X(glNamedBufferStorage) \
+	X(glNamedBufferSubData) \
+	X(glPixelStorei) \
+	X(glProgramUniform1f) \
+	X(glProgramUniform1i) \
+	X(glProgramUniform2fv) \
+	X(glProgramUniform2iv) \
+	X(glProgramUniform3fv) \
+	X(glProgramUniform3iv) \
+	X(glProgramUniform4fv) \
+	X(glProgramUniformMatrix2fv) \
+	X(glProgramUniformMatrix3fv) \
+	X(glProgramUniformMatrix4fv) \
+	X(glQueryCounter) \
+	X(glReadBuffer) \
+	X(glReadPixels) \
+	X(glRenderbufferStorage) \
+	X(glShaderBinary) \
+	X(glShaderSource) \
+	X(glSpecializeShader) \
+	X(glSpecializeShaderARB) \
+	X(glTexImage2D) \
+	X(glTexParameterf) \
+	X(glTexParameteri) \
+	X(glTexStorage2D) \
+	X(glTexStorage3D) \
+	X(glTexSubImage2D) \
+	X(glTexSubImage3D) \
+	X(glTextureParameteri) \
+	X(glTextureStorage2D) \
+	X(glTextureSubImage2D) \
+	X(glUniform1f) \
+	X(glUniform1i) \
+	X(glUniform2f) \
+	X(glUniform2fv) \
+	X(glUniform2iv) \
+	X(glUniform3f) \
+	X(glUniform3fv) \
+	X(glUniform3iv) \
+	X(glUniform4f) \
+	X(glUniform4fv) \
+	X(glUniformMatrix2fv) \
+	X(glUniformMatrix3fv) \
+	X(glUniformMatrix4fv) \
+	X(glUnmapBuffer) \
+	X(glUseProgram) \
+	X(glVertexArrayAttribBinding) \
+	X(glVertexArrayAttribFormat) \
+	X(glVertexArrayElementBuffer) \
+	X(glVertexArrayVertexBuffer) \
+	X(glVertexAttribDivisor) \
+	X(glVertexAttribIPointer) \
+	X(glVertexAttribPointer) \
+	X(glViewport)
+
+namespace gl {
+
+	// The names expand to glad's pointers (GlEntryPointEnum::glad_glBindBuffer),
+	// always spell them as the GL function so the same macro applies.
+	enum class GlEntryPointEnum : std::uint16_t {
+#define GL_INTERCEPT_ENUM(name) name,
+		GL_INTERCEPT_ENTRY_POINTS(GL_INTERCEPT_ENUM)
+#undef GL_INTERCEPT_ENUM
+		COUNT
+	};
+
+	constexpr std::size_t GL_ENTRY_POINT_COUNT =
+		static_cast<std::size_t>(GlEntryPointEnum::COUNT);
+
+	const char* GetGlEntryPointName(GlEntryPointEnum entry);
+
+	// Bytes read from client memory by a glTex(Sub)Image call, rows padded
+	// to the unpack alignment.
+	std::size_t GetGlImageBytes(
+		GLsizei width,
+		GLsizei height,
+		GLsizei depth,
+		GLenum format,
+		GLenum type,
+		int alignment = 1);
+
+	// An argument or the result of a GL call: integers sign or zero
+	// extended, floats as their bits and pointers as their address.
+	using GlSlot = std::uint64_t;
+
+	// glTexSubImage3D has the most.
+	constexpr std::size_t GL_MAX_ARGUMENTS = 11;
+
+	template <typename T>
+	GlSlot ToGlSlot(T value)
+	{
+		if constexpr (std::is_pointer_v<T>)
+		{
+			return static_cast<GlSlot>(reinterpret_cast<std::uintptr_t>(value));
+		}
+		else if constexpr (std::is_same_v<T, float>)
+		{
+			return std::bit_cast<std::uint32_t>(value);
+		}
+		else if constexpr (std::is_same_v<T, double>)
+		{
+			return std::bit_cast<std::uint64_t>(value);
+		}
+		else if constexpr (std::is_signed_v<T>)
+		{
+			return static_cast<GlSlot>(static_cast<std::int64_t>(value));
+		}
+		else
+		{
+			return static_cast<GlSlot>(value);
+		}
+	}
+
+	template <typename T>
+	T FromGlSlot(GlSlot slot)
+	{
+		if constexpr (std::is_pointer_v<T>)
+		{
+			return reinterpret_cast<T>(static_cast<std::uintptr_t>(slot));
+		}
+		else if constexpr (std::is_same_v<T, float>)
+		{
+			return std::bit_cast<float>(static_cast<std::uint32_t>(slot));
+		}
+		else if constexpr (std::is_same_v<T, double>)
+		{
+			return std::bit_cast<double>(slot);
+		}
+		else
+		{
+			return static_cast<T>(slot);
+		}
+	}
+
+	struct GlCall
+	{
+		GlEntryPointEnum entry = GlEntryPointEnum::COUNT;
+		const GlSlot* args = nullptr;
+		std::size_t arg_count = 0;
+		bool has_result = false;
+		// Only set after the call.
+		GlSlot result = 0;
+	};
+
+	// Sees every intercepted call, on the thread making it.
+	class GlCallListener
+	{
+	public:
+		virtual ~GlCallListener() = default;
+		virtual void BeforeCall(const GlCall& /*call*/) {}
+		virtual void AfterCall(const GlCall& call) = 0;
+	};
+
+	// Interception of the GL calls made through glad. Install keeps the
+	// pointers glad loaded; while a listener is added they are swapped for
+	// wrappers that forward to them and tell the listeners, otherwise
+	// they are put back and nothing is left in the call path. Calls made
+	// by the ImGui backend, which has its own loader, are not seen.
+	class GlIntercept
+	{
+	public:
+		static GlIntercept& GetInstance();
+
+		// Right after glad loaded, again for a new context.
+		void Install();
+		bool IsInstalled() const { return installed_; }
+		void AddListener(GlCallListener* listener);
+		void RemoveListener(GlCallListener* listener);
+
+	protected:
+		GlIntercept() = default;
+		void SetWrappers(bool enabled);
+
+	protected:
+		bool installed_ = false;
+		bool wrapped_ = false;
+	};
+
+} // End namespace gl.
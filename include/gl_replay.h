@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gl_intercept.h"
+
+namespace gl {
+
+	struct GlReplayOptions
+	{
+		// Binds and state setters leaving the state as it was.
+		bool drop_redundant_binds = false;
+		// Consecutive glDrawArrays/glDrawElements over contiguous ranges of
+		// the same state become one draw.
+		bool merge_draws = false;
+		bool drop_get_error = false;
+		// glFinish after every frame so the frame time is the GPU time.
+		bool finish_frames = true;
+		// Time spent in each call, by entry point.
+		bool time_calls = true;
+		// Times the frames are replayed, the setup is replayed once.
+		int loops = 1;
+		// After the calls of each frame, before the glFinish (swap...).
+		std::function<void()> end_frame;
+	};
+
+	struct GlReplayFrame
+	{
+		// Issuing the calls.
+		float submit_ms = 0.0f;
+		// With the glFinish.
+		float total_ms = 0.0f;
+		std::uint64_t calls = 0;
+	};
+
+	struct GlReplayReport
+	{
+		float setup_ms = 0.0f;
+		std::vector<GlReplayFrame> frames;
+		// Indexed by GlEntryPointEnum.
+		std::vector<std::uint64_t> calls_by_entry_point;
+		std::vector<double> ms_by_entry_point;
+		std::uint64_t dropped_calls = 0;
+		std::uint64_t merged_draws = 0;
+		// Entry points the driver or this build lacks.
+		std::uint64_t skipped_calls = 0;
+
+		// Average, min and max frame, then the costliest entry points.
+		void Print(std::ostream& os, bool per_frame = false) const;
+	};
+
+	// Plays a GlCapture file back on the current context, the same calls
+	// with the same parameters, the GL names mapped to the replayed ones.
+	// Optional transforms of the call stream show what removing driver
+	// overhead would win without touching the engine.
+	class GlReplay
+	{
+	public:
+		// Throws std::runtime_error if the file is missing or malformed.
+		void Load(const std::string& path);
+		int GetWidth() const { return width_; }
+		int GetHeight() const { return height_; }
+		std::size_t GetFrameCount() const { return frame_ends_.size(); }
+		std::size_t GetCallCount() const { return calls_.size(); }
+		// Needs a current context with glad loaded.
+		GlReplayReport Run(const GlReplayOptions& options = {}) const;
+
+	protected:
+		struct Payload
+		{
+			std::uint8_t type = 0;
+			std::size_t arg = 0;
+			std::size_t blob = 0;
+		};
+		struct Call
+		{
+			GlEntryPointEnum entry = GlEntryPointEnum::COUNT;
+			std::uint8_t arg_count = 0;
+			bool has_result = false;
+			GlSlot args[GL_MAX_ARGUMENTS] = {};
+			GlSlot result = 0;
+			std::size_t payload_begin = 0;
+			std::size_t payload_count = 0;
+		};
+		// The calls in [begin, end) left after the transforms of the
+		// options. Nothing is assumed of the state at begin.
+		std::vector<Call> Transform(
+			std::size_t begin,
+			std::size_t end,
+			const GlReplayOptions& options,
+			GlReplayReport& report) const;
+
+	protected:
+		int width_ = 0;
+		int height_ = 0;
+		std::vector<Call> calls_;
+		std::vector<Payload> payloads_;
+		std::vector<std::vector<std::uint8_t>> blobs_;
+		// One past the last call of the setup and of each frame.
+		std::size_t setup_end_ = 0;
+		std::vector<std::size_t> frame_ends_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gl_intercept.h"
+
+namespace gl {
+
+	// GL work of one frame, as seen by GlStats.
+	struct GlFrameStats
+	{
+		float frame_ms = 0.0f;
+		std::uint64_t calls = 0;
+		std::uint64_t draw_calls = 0;
+		// From the draw arguments, indirect draws add none.
+		std::uint64_t primitives = 0;
+		std::uint64_t dispatches = 0;
+		std::uint64_t program_binds = 0;
+		std::uint64_t texture_binds = 0;
+		std::uint64_t buffer_binds = 0;
+		std::uint64_t vertex_array_binds = 0;
+		std::uint64_t framebuffer_binds = 0;
+		// Enable/disable, depth, blend, masks, viewport and texture unit.
+		std::uint64_t state_changes = 0;
+		std::uint64_t uniform_updates = 0;
+		// Bytes given with data to glBufferData/SubData/Storage and their
+		// glNamedBuffer* forms.
+		std::uint64_t buffer_bytes = 0;
+		// Bytes given with pixels to glTexImage2D/glTex(ture)SubImage*.
+		std::uint64_t texture_bytes = 0;
+		// Indexed by GlEntryPointEnum.
+		std::vector<std::uint32_t> calls_by_entry_point;
+	};
+
+	// Optional counting of the GL calls, listening to GlIntercept so
+	// nothing is left in the call path while disabled.
+	class GlStats : public GlCallListener
+	{
+	public:
+		static GlStats& GetInstance();
+
+		// Needs GlIntercept installed.
+		void SetEnabled(bool enabled);
+		bool IsEnabled() const { return enabled_; }
+		// Closes the frame counted since the last call.
+		void EndFrame(float frame_ms);
+		const GlFrameStats& GetLastFrame() const { return last_frame_; }
+		// Counts the next frame_count frames and writes them to path as
+		// JSON, the counters are back to their state afterwards.
+		void StartCapture(int frame_count, const std::string& path);
+		bool IsCapturing() const { return capture_remaining_ > 0; }
+		// Every frame and their average, with the calls by entry point.
+		static void WriteJson(std::ostream& os, const std::vector<GlFrameStats>& frames);
+		void DrawImGui();
+		void AfterCall(const GlCall& call) override;
+
+	protected:
+		GlStats() = default;
+		void ResetFrame();
+		void FinishCapture();
+
+	protected:
+		bool enabled_ = false;
+		// The frame being counted.
+		GlFrameStats frame_;
+		std::vector<std::uint32_t> frame_calls_ =
+			std::vector<std::uint32_t>(GL_ENTRY_POINT_COUNT, 0);
+		// Uploads from a pixel unpack buffer pass an offset, maybe 0.
+		bool unpack_buffer_bound_ = false;
+		GlFrameStats last_frame_;
+		std::vector<GlFrameStats> captured_;
+		std::string capture_path_;
+		int capture_remaining_ = 0;
+		bool enabled_before_capture_ = false;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_resource.h"
+
+namespace gl {
+
+	enum class GpuBackendEnum {
+		// Desktop GL 4.5: direct state access, immutable storage and
+		// glProgramUniform, nothing is bound to be edited.
+		GL45,
+		// GLES 3.0 style, also valid on desktop GL before 4.5: objects are
+		// bound to be edited, the caller's bindings put back afterwards.
+		GLES3,
+	};
+
+	const char* GetGpuBackendName(GpuBackendEnum backend);
+
+	// How resources are created, filled and bound, everything else is the
+	// same GL on both backends. Engine::Init selects one once the context
+	// is current. Neither changes the bindings the caller sees.
+	class GpuBackend
+	{
+	public:
+		virtual ~GpuBackend() = default;
+		// The selected backend, GLES3 until Select.
+		static GpuBackend& GetInstance();
+		// The best backend the current context supports.
+		static GpuBackendEnum Detect();
+		static void Select(GpuBackendEnum backend);
+
+		virtual GpuBackendEnum GetType() const = 0;
+		// Version line for the ImGui backend.
+		virtual const char* GetGlslVersion() const = 0;
+		// Textures need their target to be created by GL45, 0 when unknown
+		// leaves them to be bound first.
+		virtual GLuint CreateObject(GpuResourceTypeEnum type, GLenum target) const = 0;
+
+		// The size is final. GL45 only lets UpdateBuffer change the content
+		// if flags has GL_DYNAMIC_STORAGE_BIT. data may be null.
+		virtual void AllocateBuffer(
+			GLuint buffer,
+			GLsizeiptr size,
+			const void* data,
+			GLbitfield flags) const = 0;
+		virtual void UpdateBuffer(
+			GLuint buffer,
+			GLintptr offset,
+			GLsizeiptr size,
+			const void* data) const = 0;
+		// Immutable GL_TEXTURE_2D storage for every level at once.
+		virtual void AllocateTexture2D(
+			GLuint texture,
+			GLsizei levels,
+			GLenum internal_format,
+			GLsizei width,
+			GLsizei height) const = 0;
+		virtual void UpdateTexture2D(
+			GLuint texture,
+			GLint level,
+			GLsizei width,
+			GLsizei height,
+			GLenum format,
+			GLenum type,
+			const void* pixels) const = 0;
+		virtual void SetTextureParameter(
+			GLuint texture,
+			GLenum name,
+			GLint value) const = 0;
+		virtual void GenerateMipmaps(GLuint texture) const = 0;
+		// Leaves the active texture unit alone on GL45 only.
+		virtual void BindTexture(GLuint unit, GLenum target, GLuint texture) const = 0;
+
+		// Float attribute read from buffer every stride bytes from offset,
+		// enabled. Each attribute gets the vertex buffer binding of its
+		// index on GL45.
+		virtual void SetVertexAttribute(
+			GLuint vertex_array,
+			GLuint attribute,
+			GLuint buffer,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			GLintptr offset) const = 0;
+		virtual void SetIndexBuffer(GLuint vertex_array, GLuint buffer) const = 0;
+
+		virtual void SetUniform(GLuint program, GLint location, int value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, float value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::vec2& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::vec3& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::vec4& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::ivec2& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::ivec3& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::mat2& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::mat3& value) const = 0;
+		virtual void SetUniform(GLuint program, GLint location, const glm::mat4& value) const = 0;
+	};
+
+	// Levels of a full mip chain down to 1x1.
+	GLsizei GetMipLevelCount(GLsizei width, GLsizei height);
+
+} // End namespace gl.
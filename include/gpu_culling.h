@@ -0,0 +1,175 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "mesh.h"
+#include "post_process.h"
+#include "shader.h"
+
+namespace gl {
+
+	// GPU driven culling and draw generation. Every mesh lives in one
+	// vertex and index buffer, every object (transform and mesh) in an
+	// SSBO uploaded when it changes. Each frame:
+	//
+	//     reset    one DrawElementsIndirectCommand per mesh, no instances
+	//     cull     one invocation per object, frustum test of its world
+	//              bounds, then optionally a Hi-Z test against the depth
+	//              pyramid of the last frame. Survivors are appended to
+	//              their mesh's range of the visible list, counted with
+	//              atomics (aggregated per workgroup)
+	//     compact  the commands with instances are packed and counted
+	//     draw     one glMultiDrawElementsIndirectCount, or a
+	//              glMultiDrawElementsIndirect over every mesh's command
+	//              without GL 4.6 or ARB_indirect_parameters
+	//
+	// The visible list doubles as an instanced vertex attribute
+	// (location 3, the object index) and baseInstance points each command
+	// at its mesh's range, so shaders read the transform from the objects
+	// SSBO without gl_BaseInstance. The CPU work per frame is the same for
+	// a thousand or a million objects, only changed objects are uploaded.
+	class GpuCuller
+	{
+	public:
+		// Needs GL 4.3, IsSupported says false otherwise.
+		void Init(const std::string& path, std::size_t max_objects = 1 << 20);
+		void Destroy();
+		bool IsSupported() const { return supported_; }
+		// Replaces the meshes, removes the objects. Meshes use the Vertex
+		// layout of mesh.h.
+		void SetMeshes(const std::vector<MeshData>& meshes);
+		// Returns the object index, throws when max_objects is reached.
+		std::uint32_t AddObject(std::uint32_t mesh, const glm::mat4& model);
+		void SetTransform(std::uint32_t object, const glm::mat4& model);
+		void ClearObjects();
+		std::size_t GetObjectCount() const { return objects_.size(); }
+
+		// Builds the draws for this view.
+		void Cull(const glm::mat4& view, const glm::mat4& projection);
+		// Draws what Cull kept. The shader reads its transform through
+		// objects[object].model at binding OBJECTS_BINDING.
+		void Draw() const;
+		// Max depth pyramid of the depth texture the frame was drawn with,
+		// for the Hi-Z test of the next Cull. Objects are projected with
+		// the view and projection of that frame, so a moving object can be
+		// culled for one frame when it comes out from behind an occluder.
+		void UpdateDepthPyramid(GLuint depth_texture, glm::ivec2 size);
+
+		void SetFrustumCulling(bool enabled) { frustum_culling_ = enabled; }
+		void SetOcclusionCulling(bool enabled) { occlusion_culling_ = enabled; }
+		// Visible objects and draws from a few frames ago, read without
+		// stalling through a fence.
+		std::uint32_t GetVisibleCount() const { return stats_visible_; }
+		std::uint32_t GetDrawCount() const { return stats_draws_; }
+		float GetCpuMilliseconds() const { return cpu_ms_; }
+		float GetCullMilliseconds() const { return cull_timer_.GetMilliseconds(); }
+		float GetDrawMilliseconds() const { return draw_timer_.GetMilliseconds(); }
+		void DrawImGui();
+
+		static constexpr GLuint OBJECTS_BINDING = 12;
+
+	protected:
+		void IsError(const char* file, int line) const;
+		void UploadObjects();
+		void ReadStats();
+
+	protected:
+		// Meshes a workgroup aggregates its atomics for.
+		static constexpr std::size_t MAX_MESHES = 64;
+		static constexpr GLuint MESHES_BINDING = 13;
+		static constexpr GLuint VISIBLE_BINDING = 14;
+		static constexpr GLuint COMMANDS_BINDING = 15;
+		static constexpr GLuint DRAWS_BINDING = 16;
+
+		// Mirrors the shaders in data/shaders/gpu_culling, std430.
+		struct GpuObject
+		{
+			glm::mat4 model;
+			std::uint32_t mesh;
+			std::uint32_t pad[3];
+		};
+		struct GpuMesh
+		{
+			glm::vec4 bounds_min;
+			glm::vec4 bounds_max;
+			std::uint32_t index_count;
+			std::uint32_t first_index;
+			std::int32_t base_vertex;
+			// Start of its range in the visible list.
+			std::uint32_t object_offset;
+		};
+		struct DrawElementsIndirectCommand
+		{
+			std::uint32_t count;
+			std::uint32_t instance_count;
+			std::uint32_t first_index;
+			std::int32_t base_vertex;
+			std::uint32_t base_instance;
+		};
+		// Start of the Draws block, the packed commands follow.
+		struct DrawCounters
+		{
+			std::uint32_t draw_count;
+			std::uint32_t visible_count;
+			std::uint32_t pad[2];
+		};
+
+		bool supported_ = false;
+		bool has_indirect_count_ = false;
+		bool use_indirect_count_ = true;
+		bool frustum_culling_ = true;
+		bool occlusion_culling_ = true;
+		std::size_t max_objects_ = 0;
+
+		std::vector<GpuMesh> meshes_;
+		std::vector<std::uint32_t> mesh_object_counts_;
+		std::vector<GpuObject> objects_;
+		bool meshes_dirty_ = false;
+		// Objects to upload, an empty range when begin >= end.
+		std::size_t dirty_begin_ = 0;
+		std::size_t dirty_end_ = 0;
+
+		BufferHandle vbo_;
+		BufferHandle ebo_;
+		VertexArrayHandle vao_;
+		BufferHandle objects_ssbo_;
+		BufferHandle meshes_ssbo_;
+		BufferHandle visible_;
+		BufferHandle commands_;
+		// DrawCounters then MAX_MESHES packed commands.
+		BufferHandle draws_;
+
+		// Max depth pyramid, level 0 at the power of two below the depth
+		// texture size so every level halves exactly.
+		TextureHandle pyramid_;
+		glm::ivec2 pyramid_size_ = glm::ivec2(0);
+		int pyramid_levels_ = 0;
+		bool pyramid_valid_ = false;
+		// View projection of the frame the pyramid was built from.
+		glm::mat4 pyramid_view_projection_ = glm::mat4(1.0f);
+		glm::mat4 view_projection_ = glm::mat4(1.0f);
+
+		BufferHandle stats_;
+		GLsync stats_fence_ = nullptr;
+		std::uint32_t stats_visible_ = 0;
+		std::uint32_t stats_draws_ = 0;
+		float cpu_ms_ = 0.0f;
+		GpuTimer cull_timer_;
+		GpuTimer pyramid_timer_;
+		mutable GpuTimer draw_timer_;
+
+		std::unique_ptr<Shader> reset_shader_;
+		std::unique_ptr<Shader> cull_shader_;
+		std::unique_ptr<Shader> compact_shader_;
+		std::unique_ptr<Shader> pyramid_shader_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace gl {
+
+	enum class GpuResourceTypeEnum {
+		BUFFER,
+		TEXTURE,
+		VERTEX_ARRAY,
+		PROGRAM,
+		FRAMEBUFFER,
+		RENDERBUFFER,
+		QUERY,
+		COUNT
+	};
+
+	const char* GetGpuResourceTypeName(GpuResourceTypeEnum type);
+
+	// Bytes of a texture, levels = 0 counts the full mip chain.
+	std::size_t EstimateTextureBytes(
+		GLenum internal_format,
+		int width,
+		int height,
+		int layers = 1,
+		int levels = 0);
+
+	// Every live GL object created through a GpuHandle, with an estimate of
+	// the memory it holds. Used for the VRAM budget, the ImGui usage view and
+	// the leak report printed by the engine when it shuts down.
+	class GpuResourceRegistry
+	{
+	public:
+		static GpuResourceRegistry& GetInstance();
+
+		void Register(GpuResourceTypeEnum type, GLuint id, const std::string& label);
+		void Unregister(GpuResourceTypeEnum type, GLuint id);
+		// Throws std::runtime_error, before anything changes, if the new
+		// size would go over the budget.
+		void SetBytes(GpuResourceTypeEnum type, GLuint id, std::size_t bytes);
+		std::size_t GetBytes(GpuResourceTypeEnum type) const;
+		std::size_t GetTotalBytes() const { return total_bytes_; }
+		std::size_t GetCount(GpuResourceTypeEnum type) const;
+		// 0 means no budget.
+		void SetBudget(std::size_t bytes) { budget_bytes_ = bytes; }
+		std::size_t GetBudget() const { return budget_bytes_; }
+		// Objects outliving the context are forgotten instead of deleted.
+		void SetContextAlive(bool alive) { context_alive_ = alive; }
+		bool IsContextAlive() const { return context_alive_; }
+		// Prints every object still alive, returns how many there are.
+		std::size_t ReportLeaks(std::ostream& os) const;
+		void DrawImGui();
+
+	protected:
+		GpuResourceRegistry() = default;
+
+	protected:
+		struct Entry
+		{
+			std::size_t bytes = 0;
+			std::string label;
+		};
+		static constexpr std::size_t TYPE_COUNT =
+			static_cast<std::size_t>(GpuResourceTypeEnum::COUNT);
+		std::array<std::unordered_map<GLuint, Entry>, TYPE_COUNT> entries_;
+		std::array<std::size_t, TYPE_COUNT> bytes_ = {};
+		std::size_t total_bytes_ = 0;
+		std::size_t peak_bytes_ = 0;
+		std::size_t budget_bytes_ = 0;
+		bool context_alive_ = false;
+	};
+
+	// Through the selected GpuBackend, target as in glCreateTextures.
+	GLuint CreateGpuObject(GpuResourceTypeEnum type, GLenum target = 0);
+	void DeleteGpuObject(GpuResourceTypeEnum type, GLuint id);
+
+	// Move-only owner of one GL object, deleted when the handle dies.
+	template <GpuResourceTypeEnum Type>
+	class GpuHandle
+	{
+	public:
+		GpuHandle() = default;
+		explicit GpuHandle(const std::string& label) { Create(label); }
+		~GpuHandle() { Reset(); }
+		GpuHandle(const GpuHandle&) = delete;
+		GpuHandle& operator=(const GpuHandle&) = delete;
+		GpuHandle(GpuHandle&& other) noexcept :
+			id_(std::exchange(other.id_, 0))
+		{
+		}
+		GpuHandle& operator=(GpuHandle&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				id_ = std::exchange(other.id_, 0);
+			}
+			return *this;
+		}
+
+		// Replaces the current object with a new one. Textures given their
+		// target can be edited before they are ever bound.
+		void Create(const std::string& label = "", GLenum target = 0)
+		{
+			Reset();
+			id_ = CreateGpuObject(Type, target);
+			GpuResourceRegistry::GetInstance().Register(Type, id_, label);
+		}
+		void Reset()
+		{
+			if (!id_) return;
+			GpuResourceRegistry::GetInstance().Unregister(Type, id_);
+			DeleteGpuObject(Type, id_);
+			id_ = 0;
+		}
+		// Call before allocating the storage, throws if over budget.
+		void SetBytes(std::size_t bytes) const
+		{
+			GpuResourceRegistry::GetInstance().SetBytes(Type, id_, bytes);
+		}
+		GLuint Get() const { return id_; }
+		explicit operator bool() const { return id_ != 0; }
+
+	private:
+		GLuint id_ = 0;
+	};
+
+	using BufferHandle = GpuHandle<GpuResourceTypeEnum::BUFFER>;
+	using TextureHandle = GpuHandle<GpuResourceTypeEnum::TEXTURE>;
+	using VertexArrayHandle = GpuHandle<GpuResourceTypeEnum::VERTEX_ARRAY>;
+	using ProgramHandle = GpuHandle<GpuResourceTypeEnum::PROGRAM>;
+	using FramebufferHandle = GpuHandle<GpuResourceTypeEnum::FRAMEBUFFER>;
+	using RenderbufferHandle = GpuHandle<GpuResourceTypeEnum::RENDERBUFFER>;
+	using QueryHandle = GpuHandle<GpuResourceTypeEnum::QUERY>;
+
+} // End namespace gl.
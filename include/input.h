@@ -0,0 +1,190 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SDL.h"
+
+#include "gpu_resource.h"
+
+namespace gl {
+
+	enum class InputSourceEnum : std::uint8_t {
+		KEY,
+		MOUSE_BUTTON,
+		GAMEPAD_BUTTON,
+		GAMEPAD_AXIS,
+	};
+
+	// One physical input feeding an action, code is an SDL_Scancode, an
+	// SDL_BUTTON_* or an SDL_GameController button or axis. Its value (0 or
+	// 1, -1 to 1 for an axis) is multiplied by scale, -1 makes S walk back.
+	struct InputBinding
+	{
+		InputSourceEnum source;
+		int code;
+		float scale = 1.0f;
+	};
+
+	// Everything sampled in one frame, plain data so a recording is these
+	// written as is.
+	struct InputFrame
+	{
+		std::array<std::uint64_t, SDL_NUM_SCANCODES / 64> keys = {};
+		std::uint32_t mouse_buttons = 0;
+		std::int32_t mouse_x = 0;
+		std::int32_t mouse_y = 0;
+		// Relative motion and wheel since the last frame.
+		float mouse_dx = 0.0f;
+		float mouse_dy = 0.0f;
+		float wheel = 0.0f;
+		std::uint32_t gamepad_buttons = 0;
+		std::array<float, SDL_CONTROLLER_AXIS_MAX> gamepad_axes = {};
+		// Time step the frame was simulated with.
+		float delta_time = 0.0f;
+	};
+
+	// Keyboard, mouse and gamepad state for Program::Update, instead of
+	// reacting to key events (which come at the key repeat rate):
+	//
+	//     auto& input = Input::GetInstance();
+	//     const float forward = input.GetAction("move_forward");
+	//     camera.position += camera.front * forward * speed * dt.count();
+	//
+	// Fly camera actions are bound from the start: "move_forward" and
+	// "move_right" (WASD, left stick), "look_x" and "look_y" (right stick).
+	// The engine samples it right before Update, after everything else on
+	// the CPU, so the frame sees the freshest input. A recording stores
+	// every sampled frame with its time step, replaying one feeds them
+	// back in place of the devices and makes a fly-through exactly
+	// reproducible. Input to GPU latency is measured with a timestamp
+	// query after each swap, against the GPU clock read at the sample.
+	class Input
+	{
+	public:
+		static Input& GetInstance();
+		Input(const Input&) = delete;
+		Input& operator=(const Input&) = delete;
+
+		// Engine side.
+		void OnEvent(const SDL_Event& event);
+		// Returns the time step to simulate with, the recorded one when
+		// replaying. Ignores the devices when ImGui wants them.
+		float Sample(float delta_time, bool keyboard_captured, bool mouse_captured);
+		// After the swap, the context current.
+		void EndFrame();
+		void Destroy();
+
+		bool IsKeyDown(SDL_Scancode key) const { return IsKeyDown(current_, key); }
+		bool WasKeyPressed(SDL_Scancode key) const
+		{
+			return IsKeyDown(current_, key) && !IsKeyDown(previous_, key);
+		}
+		bool IsMouseButtonDown(int button) const
+		{
+			return (current_.mouse_buttons & SDL_BUTTON(button)) != 0;
+		}
+		float GetMouseDeltaX() const { return current_.mouse_dx; }
+		float GetMouseDeltaY() const { return current_.mouse_dy; }
+		float GetWheel() const { return current_.wheel; }
+		bool HasGamepad() const { return gamepad_ != nullptr; }
+		const InputFrame& GetFrame() const { return current_; }
+
+		// Mouse hidden and motion unbounded, for mouse look.
+		void SetRelativeMouseMode(bool relative);
+		bool IsRelativeMouseMode() const { return relative_mouse_; }
+
+		void BindAction(const std::string& action, const InputBinding& binding);
+		void ClearActions() { actions_.clear(); }
+		// Sum of the bindings, clamped to -1 to 1.
+		float GetAction(const std::string& action) const
+		{
+			return GetAction(current_, action);
+		}
+		bool IsActionDown(const std::string& action) const
+		{
+			return GetAction(current_, action) > 0.5f;
+		}
+		bool WasActionPressed(const std::string& action) const
+		{
+			return GetAction(current_, action) > 0.5f &&
+				GetAction(previous_, action) <= 0.5f;
+		}
+
+		// Recording starts with the next sampled frame.
+		void StartRecording();
+		void StopRecording() { recording_ = false; }
+		bool IsRecording() const { return recording_; }
+		// Replay stops by itself after the last frame.
+		void StartReplay();
+		void StopReplay() { replaying_ = false; }
+		bool IsReplaying() const { return replaying_; }
+		std::size_t GetRecordedFrameCount() const { return recorded_.size(); }
+		std::size_t GetReplayFrame() const { return replay_index_; }
+		// Throw std::runtime_error.
+		void SaveRecording(const std::string& path) const;
+		void LoadRecording(const std::string& path);
+
+		// Averages over the last frames, in milliseconds. Sample to the
+		// end of the GPU work of the frame, then the oldest key or mouse
+		// event of the frame to its sample.
+		float GetLatency() const { return latency_ms_; }
+		float GetEventAge() const { return event_age_ms_; }
+		// Waits for the GPU after every swap: no frame is queued behind the
+		// one on screen, the next samples later, for some throughput.
+		void SetWaitForGpu(bool wait) { wait_for_gpu_ = wait; }
+		void DrawImGui();
+
+	protected:
+		Input();
+		void IsError(const char* file, int line) const;
+		static bool IsKeyDown(const InputFrame& frame, SDL_Scancode key);
+		float GetValue(const InputFrame& frame, const InputBinding& binding) const;
+		float GetAction(const InputFrame& frame, const std::string& action) const;
+		void SampleDevices(InputFrame& frame, bool keyboard, bool mouse);
+		void OpenGamepad();
+
+	protected:
+		// Frames in flight measured at once, with the GPU further behind
+		// frames go unmeasured.
+		static constexpr std::size_t LATENCY_QUERIES = 4;
+		struct LatencyQuery
+		{
+			QueryHandle query;
+			GLint64 sample_time = 0;
+			bool pending = false;
+		};
+
+		InputFrame current_;
+		InputFrame previous_;
+		std::unordered_map<std::string, std::vector<InputBinding>> actions_;
+		SDL_GameController* gamepad_ = nullptr;
+		float dead_zone_ = 0.15f;
+		bool relative_mouse_ = false;
+		// Wheel from events, accumulated until the next sample.
+		float wheel_ = 0.0f;
+
+		std::vector<InputFrame> recorded_;
+		std::size_t replay_index_ = 0;
+		bool recording_ = false;
+		bool replaying_ = false;
+
+		// GPU time at the last sample, -1 without timestamps.
+		GLint64 sample_time_ = -1;
+		std::array<LatencyQuery, LATENCY_QUERIES> queries_;
+		std::size_t query_index_ = 0;
+		// SDL_GetTicks of the oldest input event since the last sample, 0
+		// for none.
+		std::uint32_t oldest_event_ticks_ = 0;
+		float latency_ms_ = 0.0f;
+		float event_age_ms_ = 0.0f;
+		bool wait_for_gpu_ = false;
+	};
+
+} // End namespace gl.
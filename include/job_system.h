@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+	// Small fixed-size thread pool. Jobs are plain functions; ParallelFor
+	// splits an index range in batches and lets the calling thread work
+	// alongside the workers until the whole range is done.
+	class JobSystem
+	{
+	public:
+		// 0 worker threads means hardware concurrency minus the caller.
+		explicit JobSystem(unsigned int worker_count = 0);
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		void Schedule(std::function<void()> job);
+		// Calls func(begin, end) over [0, count) in chunks of batch_size.
+		// May be called from a job, the waiting thread runs queued jobs.
+		void ParallelFor(
+			std::size_t count,
+			std::size_t batch_size,
+			const std::function<void(std::size_t, std::size_t)>& func);
+		// Block until every scheduled job has finished, helping meanwhile.
+		void Wait();
+		unsigned int GetWorkerCount() const
+		{
+			return static_cast<unsigned int>(workers_.size());
+		}
+
+	protected:
+		void WorkerLoop();
+		bool RunPendingJob();
+
+	protected:
+		std::vector<std::thread> workers_;
+		std::deque<std::function<void()>> jobs_;
+		std::mutex mutex_;
+		std::condition_variable job_available_;
+		std::condition_variable job_done_;
+		std::size_t pending_ = 0;
+		bool stop_ = false;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "shader.h"
+
+namespace gl {
+
+	// Point light as stored in the light SSBO (std430 layout, 32 bytes).
+	struct PointLight
+	{
+		// xyz world position, w radius of influence.
+		glm::vec4 position_radius = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		// rgb color, w intensity.
+		glm::vec4 color_intensity = glm::vec4(1.0f);
+	};
+
+	// Shader storage binding points shared by the cluster compute shaders and
+	// the lighting fragment shaders.
+	enum class LightBindingEnum : GLuint {
+		LIGHTS = 0,
+		CLUSTER_AABBS = 1,
+		LIGHT_GRID = 2,
+		LIGHT_INDICES = 3,
+		INDEX_COUNTER = 4
+	};
+
+	// Clustered forward lighting. The view frustum is split into a grid of
+	// screen tiles times exponential depth slices, and every frame a compute
+	// pass bins the lights into the clusters they touch. The lighting shader
+	// then only iterates the lights of the cluster a fragment falls in, so the
+	// cost follows lights-per-pixel rather than the total light count.
+	class ClusteredLighting
+	{
+	public:
+		ClusteredLighting(
+			glm::ivec3 grid = glm::ivec3(16, 9, 24),
+			unsigned int max_lights = 8192,
+			unsigned int max_lights_per_cluster = 128);
+		void Init(const std::string& path);
+		void Destroy();
+		// Upload the light array, must not exceed max_lights.
+		void SetLights(const std::vector<PointLight>& lights);
+		// Rebuild cluster bounds if needed and bin the lights for this frame.
+		void Update(
+			const glm::mat4& view,
+			const glm::mat4& projection,
+			glm::vec2 screen_size,
+			float z_near,
+			float z_far);
+		// Bind the buffers and set the cluster lookup uniforms on a lighting
+		// shader.
+		void Bind(const Shader& shader) const;
+		void DrawImGui();
+		unsigned int GetLightCount() const { return light_count_; }
+		unsigned int GetMaxLights() const { return max_lights_; }
+
+	protected:
+		void BuildClusterAabbs(const glm::mat4& projection);
+		void IsError(const char* file, int line) const;
+
+	protected:
+		glm::ivec3 grid_;
+		unsigned int cluster_count_;
+		unsigned int max_lights_;
+		unsigned int max_lights_per_cluster_;
+		unsigned int light_count_ = 0;
+
+		BufferHandle light_ssbo_;
+		BufferHandle cluster_aabb_ssbo_;
+		BufferHandle light_grid_ssbo_;
+		BufferHandle light_index_ssbo_;
+		BufferHandle index_counter_ssbo_;
+
+		std::unique_ptr<Shader> cluster_aabb_shader_ = nullptr;
+		std::unique_ptr<Shader> cluster_cull_shader_ = nullptr;
+
+		// Cluster bounds only depend on the projection and the screen size.
+		glm::mat4 cached_projection_ = glm::mat4(0.0f);
+		glm::vec2 screen_size_ = glm::vec2(0.0f);
+		glm::vec2 tile_size_ = glm::vec2(0.0f);
+		float z_near_ = 0.1f;
+		float z_far_ = 100.0f;
+
+		bool read_back_stats_ = false;
+		unsigned int last_index_count_ = 0;
+	};
+
+} // End namespace gl.
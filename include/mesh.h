@@ -1,9 +1,230 @@
 #pragma once
 
+#include <glad/glad.h>
+#include <glm/glm.hpp>
 
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gpu_backend.h"
+#include "gpu_resource.h"
 
 namespace gl {
 
-	
+	// Interleaved vertex matching the attribute layout of the demos:
+	// location 0 position, 1 normal, 2 texture coordinates.
+	struct Vertex
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 tex;
+	};
+
+	// CPU side indexed triangle list.
+	struct MeshData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+
+		std::vector<glm::vec3> GetPositions() const
+		{
+			std::vector<glm::vec3> positions;
+			positions.reserve(vertices.size());
+			for (const auto& vertex : vertices)
+				positions.push_back(vertex.position);
+			return positions;
+		}
+	};
+
+	// Unit cube centered on the origin, 4 vertices per face so normals stay
+	// flat.
+	inline MeshData CreateCube()
+	{
+		MeshData data;
+		const std::array<glm::vec3, 6> normals = {
+			glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0),
+			glm::vec3(0, 1, 0), glm::vec3(0, -1, 0),
+			glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+		};
+		const std::array<glm::vec2, 4> corners = {
+			glm::vec2(-1, -1), glm::vec2(1, -1),
+			glm::vec2(1, 1), glm::vec2(-1, 1)
+		};
+		for (const auto& n : normals)
+		{
+			const glm::vec3 u = glm::vec3(n.y, n.z, n.x);
+			const glm::vec3 v = glm::cross(n, u);
+			const auto base = static_cast<std::uint32_t>(data.vertices.size());
+			for (const auto& c : corners)
+			{
+				data.vertices.push_back({
+					(n + u * c.x + v * c.y) * 0.5f,
+					n,
+					c * 0.5f + glm::vec2(0.5f) });
+			}
+			data.indices.insert(
+				data.indices.end(),
+				{ base, base + 1, base + 2, base, base + 2, base + 3 });
+		}
+		return data;
+	}
+
+	// Horizontal plane of size x size facing +y, tiling its texture.
+	inline MeshData CreatePlane(float size, float tiling = 1.0f)
+	{
+		const float half = size * 0.5f;
+		const glm::vec3 up(0.0f, 1.0f, 0.0f);
+		MeshData data;
+		data.vertices = {
+			{ glm::vec3(-half, 0.0f, -half), up, glm::vec2(0.0f, 0.0f) },
+			{ glm::vec3(half, 0.0f, -half), up, glm::vec2(tiling, 0.0f) },
+			{ glm::vec3(half, 0.0f, half), up, glm::vec2(tiling, tiling) },
+			{ glm::vec3(-half, 0.0f, half), up, glm::vec2(0.0f, tiling) }
+		};
+		data.indices = { 0, 2, 1, 0, 3, 2 };
+		return data;
+	}
+
+	// UV sphere of radius 0.5. The first and last column share positions
+	// but not texture coordinates, leaving a seam along the meridian.
+	inline MeshData CreateSphere(int slices = 64, int stacks = 32)
+	{
+		const float pi = 3.14159265358979f;
+		MeshData data;
+		for (int j = 0; j <= stacks; ++j)
+		{
+			const float v = static_cast<float>(j) / stacks;
+			const float phi = v * pi;
+			for (int i = 0; i <= slices; ++i)
+			{
+				const float u = static_cast<float>(i) / slices;
+				const float theta = u * pi * 2.0f;
+				// Pin the meridian and poles so the seam welds exactly.
+				const float sin_theta = (i == slices) ? 0.0f : std::sin(theta);
+				const float cos_theta = (i == slices) ? 1.0f : std::cos(theta);
+				const float sin_phi = (j == 0 || j == stacks) ?
+					0.0f : std::sin(phi);
+				const glm::vec3 n(
+					sin_phi * cos_theta,
+					std::cos(phi),
+					sin_phi * sin_theta);
+				data.vertices.push_back({ n * 0.5f, n, glm::vec2(u, v) });
+			}
+		}
+		const auto row = static_cast<std::uint32_t>(slices + 1);
+		for (std::uint32_t j = 0; j < static_cast<std::uint32_t>(stacks); ++j)
+		{
+			for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(slices); ++i)
+			{
+				const std::uint32_t a = j * row + i;
+				const std::uint32_t b = a + row;
+				if (j != 0)
+				{
+					data.indices.insert(data.indices.end(), { a, a + 1, b });
+				}
+				if (j + 1 != static_cast<std::uint32_t>(stacks))
+				{
+					data.indices.insert(data.indices.end(), { a + 1, b + 1, b });
+				}
+			}
+		}
+		return data;
+	}
+
+	// GPU copy of a MeshData, move-only.
+	class Mesh
+	{
+	public:
+		void Init(const MeshData& data)
+		{
+			const GpuBackend& backend = GpuBackend::GetInstance();
+			index_count_ = static_cast<GLsizei>(data.indices.size());
+			vao_.Create("Mesh vertex array");
+			IsError(__FILE__, __LINE__);
+
+			ebo_.Create("Mesh indices");
+			ebo_.SetBytes(data.indices.size() * sizeof(std::uint32_t));
+			backend.AllocateBuffer(
+				ebo_.Get(),
+				data.indices.size() * sizeof(std::uint32_t),
+				data.indices.data(),
+				0);
+			IsError(__FILE__, __LINE__);
+
+			vbo_.Create("Mesh vertices");
+			vbo_.SetBytes(data.vertices.size() * sizeof(Vertex));
+			backend.AllocateBuffer(
+				vbo_.Get(),
+				data.vertices.size() * sizeof(Vertex),
+				data.vertices.data(),
+				0);
+			IsError(__FILE__, __LINE__);
+
+			backend.SetIndexBuffer(vao_.Get(), ebo_.Get());
+			backend.SetVertexAttribute(
+				vao_.Get(),
+				0,
+				vbo_.Get(),
+				3,
+				GL_FLOAT,
+				sizeof(Vertex),
+				offsetof(Vertex, position));
+			backend.SetVertexAttribute(
+				vao_.Get(),
+				1,
+				vbo_.Get(),
+				3,
+				GL_FLOAT,
+				sizeof(Vertex),
+				offsetof(Vertex, normal));
+			backend.SetVertexAttribute(
+				vao_.Get(),
+				2,
+				vbo_.Get(),
+				2,
+				GL_FLOAT,
+				sizeof(Vertex),
+				offsetof(Vertex, tex));
+			IsError(__FILE__, __LINE__);
+		}
+		void Destroy()
+		{
+			vao_.Reset();
+			vbo_.Reset();
+			ebo_.Reset();
+			index_count_ = 0;
+		}
+		void Draw() const
+		{
+			glBindVertexArray(vao_.Get());
+			glDrawElements(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, 0);
+		}
+		GLuint GetVao() const { return vao_.Get(); }
+		GLuint GetEbo() const { return ebo_.Get(); }
+		GLsizei GetIndexCount() const { return index_count_; }
+
+	protected:
+		void IsError(const char* file, int line) const {
+			auto error_code = glGetError();
+			if (error_code != GL_NO_ERROR)
+			{
+				throw std::runtime_error(
+					std::to_string(error_code) +
+					" in file: " + file +
+					" at line: " + std::to_string(line));
+			}
+		}
+
+	protected:
+		VertexArrayHandle vao_;
+		BufferHandle vbo_;
+		BufferHandle ebo_;
+		GLsizei index_count_ = 0;
+	};
 
 } // End namespace gl.
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "mesh.h"
+#include "stream_buffer.h"
+
+namespace gl {
+
+	// One level of a LOD chain, error is the object space distance the
+	// simplified surface may deviate from the original.
+	struct MeshLod
+	{
+		MeshData data;
+		float error = 0.0f;
+	};
+
+	// Quadric error metric edge collapse. Vertices only collapse onto one of
+	// their neighbours so attributes never need to be interpolated. Vertices
+	// sharing a position with different attributes form seams, and open
+	// edges form borders; both only collapse along themselves so UV seams
+	// and silhouettes stay in place. Stops at target_index_count or when the
+	// next collapse would exceed max_error, result_error gets the error
+	// reached.
+	MeshData SimplifyMesh(
+		const MeshData& mesh,
+		std::size_t target_index_count,
+		float max_error,
+		float* result_error = nullptr);
+
+	// LOD 0 is the mesh itself, every following level aims at ratio times
+	// the triangles of the previous one. Errors are capped at
+	// max_relative_error times the bounding radius, the chain stops early
+	// once the simplifier can't make progress within it.
+	std::vector<MeshLod> GenerateLodChain(
+		const MeshData& mesh,
+		int max_levels = 6,
+		float ratio = 0.5f,
+		float max_relative_error = 0.1f);
+
+	// Radius of the bounding sphere centered on the origin.
+	float ComputeBoundingRadius(const MeshData& mesh);
+
+	// Binary LOD chain file, stored next to the source mesh. Both throw
+	// std::runtime_error on failure.
+	void SaveLodChain(const std::string& file_name, const std::vector<MeshLod>& chain);
+	std::vector<MeshLod> LoadLodChain(const std::string& file_name);
+
+	// Picks a LOD per instance from the projected screen space error. A
+	// level is acceptable if its error covers at most threshold_pixels on
+	// screen. Instances only move to a coarser level once it is under
+	// threshold * (1 - hysteresis), so they don't flicker at the boundary.
+	class LodSelector
+	{
+	public:
+		float threshold_pixels = 1.0f;
+		float hysteresis = 0.25f;
+
+		// errors from the chain, radius is the object space bounding
+		// sphere used to measure distance from its surface.
+		void SetLevels(const std::vector<float>& errors, float radius);
+		// Selects for every model and groups them into one list per level.
+		// Selection state is kept per index so models must keep their order
+		// from frame to frame.
+		void Select(
+			const Camera& camera,
+			float viewport_height,
+			const std::vector<glm::mat4>& models,
+			std::vector<std::vector<glm::mat4>>& per_level);
+		// Projected size of an object space error in pixels.
+		float ComputeScreenError(
+			float error,
+			float distance,
+			float fov_y,
+			float viewport_height) const;
+		int GetLevelCount() const { return static_cast<int>(errors_.size()); }
+
+	protected:
+		std::vector<float> errors_;
+		float radius_ = 0.0f;
+		std::vector<int> current_;
+	};
+
+	// LOD chain on the GPU, each level drawn once with all its instances.
+	// The instance model matrix is read from attributes 3 to 6, streamed
+	// every draw through a StreamBuffer owned by the caller.
+	class LodMesh
+	{
+	public:
+		void Init(const std::vector<MeshLod>& chain);
+		void Destroy();
+		// One instanced draw per non-empty level, returns triangles drawn.
+		std::size_t Draw(
+			const std::vector<std::vector<glm::mat4>>& per_level,
+			StreamBuffer& stream);
+		std::size_t DrawLevel(
+			int level,
+			const std::vector<glm::mat4>& models,
+			StreamBuffer& stream);
+		int GetLevelCount() const { return static_cast<int>(levels_.size()); }
+		GLsizei GetIndexCount(int level) const
+		{
+			return levels_[level].mesh.GetIndexCount();
+		}
+
+	protected:
+		void IsError(const char* file, int line) const;
+
+	protected:
+		struct Level
+		{
+			Mesh mesh;
+		};
+		std::vector<Level> levels_;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "mesh.h"
+
+namespace gl {
+
+	// Minimal Wavefront OBJ reader: v, vt, vn and polygonal f records, the
+	// rest (materials, groups, smoothing) is ignored. Polygons are fanned
+	// into triangles and identical v/vt/vn triples share a vertex. Throws
+	// std::runtime_error if the file can't be read.
+	MeshData LoadObj(const std::string& file_name);
+
+} // End namespace gl.
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "job_system.h"
+#include "simd_math.h"
+
+namespace gl {
+
+	enum class BoxVisibilityEnum {
+		VISIBLE,
+		// Off screen or past the far plane, the frustum would cull it too.
+		OUTSIDE,
+		// On screen behind the occluders.
+		OCCLUDED
+	};
+
+	// Low-poly stand-in geometry rasterized into the occlusion buffer.
+	struct Occluder
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<std::uint32_t> indices;
+		glm::mat4 model = glm::mat4(1.0f);
+	};
+
+	// CPU occlusion culling. Occluders are rasterized with SSE into a small
+	// depth buffer split in 8x8 pixel tiles, each tile also keeping its
+	// farthest depth. Bounding boxes are then tested against it. Occluders
+	// write the farthest depth they reach inside a pixel and boxes test
+	// their nearest depth over every pixel they touch; anything uncertain
+	// (near plane crossing) is reported visible. Pure CPU, no GL needed
+	// except for the debug view.
+	class OcclusionCuller
+	{
+	public:
+		static constexpr int TILE_SIZE = 8;
+
+		OcclusionCuller(JobSystem& jobs, int width = 256, int height = 128);
+		OcclusionCuller(const OcclusionCuller&) = delete;
+		OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+		void ClearOccluders() { occluders_.clear(); }
+		void AddOccluder(const Occluder& occluder);
+		// Clear and rasterize all occluders from this view.
+		void RenderOccluders(const glm::mat4& view_projection);
+		// Fills visible with 1 for boxes that may be visible, 0 otherwise.
+		void TestVisibility(
+			const std::vector<Aabb>& boxes,
+			std::vector<std::uint8_t>& visible);
+		// Depth in [0, 1], 1 being the far plane, row 0 at the bottom.
+		float GetDepth(int x, int y) const { return depth_[y * width_ + x]; }
+		int GetWidth() const { return width_; }
+		int GetHeight() const { return height_; }
+		// Needs a GL context, uploads the buffer for display.
+		void DrawImGui();
+
+	protected:
+		struct ScreenVertex
+		{
+			float x, y, z;
+		};
+		struct ScreenTriangle
+		{
+			ScreenVertex v[3];
+			int min_y;
+			int max_y;
+		};
+		void RasterizeBand(int band);
+		void RasterizeTriangle(const ScreenTriangle& tri, int row_begin, int row_end);
+		void UpdateTileMax(int band);
+		BoxVisibilityEnum ClassifyBox(const Aabb& box) const;
+		bool IsRectVisible(int x0, int y0, int x1, int y1, float min_z) const;
+
+	protected:
+		JobSystem& jobs_;
+		int width_;
+		int height_;
+		int tiles_x_;
+		int tiles_y_;
+		glm::mat4 view_projection_ = glm::mat4(1.0f);
+		std::vector<Occluder> occluders_;
+		std::vector<std::vector<glm::vec4>> clip_positions_;
+		std::vector<ScreenTriangle> triangles_;
+		std::vector<float> depth_;
+		// Farthest depth of each tile, the coarse level of the hierarchy.
+		std::vector<float> tile_max_;
+
+		// Stats of the last frame.
+		std::size_t triangle_count_ = 0;
+		std::size_t tested_count_ = 0;
+		// Culled by the depth test only, the outside boxes aren't counted.
+		std::size_t occluded_count_ = 0;
+		std::size_t outside_count_ = 0;
+		float render_ms_ = 0.0f;
+		float test_ms_ = 0.0f;
+
+		// Debug view.
+		TextureHandle debug_texture_;
+		std::vector<std::uint8_t> debug_pixels_;
+		float debug_contrast_ = 50.0f;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "post_process.h"
+#include "shader.h"
+
+namespace gl {
+
+	// Where and how particles are born, every range is picked uniformly
+	// per particle on the GPU.
+	struct ParticleEmitter
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		// Particles start anywhere in this sphere.
+		float radius = 0.1f;
+		glm::vec3 direction = glm::vec3(0.0f, 1.0f, 0.0f);
+		// Half angle of the cone around direction, radians.
+		float spread = 0.4f;
+		glm::vec2 speed = glm::vec2(2.0f, 4.0f);
+		// Seconds.
+		glm::vec2 lifetime = glm::vec2(2.0f, 4.0f);
+		glm::vec4 color_begin = glm::vec4(1.0f, 0.6f, 0.2f, 1.0f);
+		glm::vec4 color_end = glm::vec4(0.4f, 0.1f, 0.6f, 0.0f);
+		// World size at birth and at death.
+		glm::vec2 size = glm::vec2(0.05f, 0.02f);
+		// Particles per second, fractions carry over to the next frame.
+		float rate = 100000.0f;
+	};
+
+	struct ParticleForces
+	{
+		glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+		// Fraction of the velocity lost per second.
+		float drag = 0.2f;
+		glm::vec3 wind = glm::vec3(0.0f);
+		// Pull towards the attractor, 0 disables it.
+		float attractor_strength = 0.0f;
+		glm::vec3 attractor = glm::vec3(0.0f);
+		// Velocity kept along the normal when bouncing.
+		float restitution = 0.5f;
+		// Velocity kept along the surface when bouncing.
+		float friction = 0.9f;
+	};
+
+	// Particles simulated entirely in compute shaders, the CPU only issues
+	// dispatches and never reads a count back. Every frame:
+	//
+	//     emit      pop indices off the dead list, append them to the
+	//               alive list
+	//     prepare   one thread turns the alive count into the simulate
+	//               dispatch size
+	//     simulate  integrate forces, collide against planes and the
+	//               depth buffer, append survivors to the other alive
+	//               list (compaction) and the dead back to the dead list
+	//     finish    one thread writes the draw and sort dispatch sizes
+	//     sort      bitonic sort of the survivors back to front
+	//     draw      one glDrawArraysIndirect, 6 vertices per particle,
+	//               the vertex shader fetches the particle from the SSBO
+	//
+	// The two alive lists swap every frame. Dispatches sized for the
+	// capacity (the sort steps) return early past the live count, the
+	// others are sized from the counters with glDispatchComputeIndirect.
+	// Needs GL 4.3 (compute and SSBO in the vertex shader).
+	class ParticleSystem
+	{
+	public:
+		void Init(const std::string& path, std::size_t capacity = 1 << 20);
+		void Destroy();
+		bool IsSupported() const { return supported_; }
+		// Kills every particle.
+		void Reset();
+		// Particles emitted on top of the rate next Update.
+		void Burst(std::size_t count) { burst_ += count; }
+		// Runs emission, simulation and the sort, view and projection are
+		// the ones Draw will use (depth collisions, sort distance).
+		void Update(
+			float dt,
+			const glm::mat4& view,
+			const glm::mat4& projection);
+		// Alpha blended and depth tested, without depth writes.
+		void Draw(const glm::mat4& view, const glm::mat4& projection);
+
+		ParticleEmitter& GetEmitter() { return emitter_; }
+		ParticleForces& GetForces() { return forces_; }
+		// Plane as (normal, distance), particles bounce on its front side.
+		void AddCollisionPlane(const glm::vec4& plane);
+		void ClearCollisionPlanes() { planes_.clear(); }
+		// Depth texture of the scene drawn with the view and projection
+		// given to Update, 0 disables depth collisions. Particles closer
+		// than thickness behind the surface bounce off it.
+		void SetDepthTexture(GLuint texture, float thickness = 0.5f);
+		void SetSorting(bool enabled) { sorting_ = enabled; }
+		std::size_t GetCapacity() const { return capacity_; }
+		// Live count from a few frames ago, read without stalling through
+		// a fence, for display only.
+		std::uint32_t GetAliveCount() const { return stats_alive_; }
+		float GetSimulationMilliseconds() const;
+		float GetSortMilliseconds() const { return sort_timer_.GetMilliseconds(); }
+		float GetDrawMilliseconds() const { return draw_timer_.GetMilliseconds(); }
+		void DrawImGui();
+
+	protected:
+		void IsError(const char* file, int line) const;
+		void Sort();
+		void ReadStats();
+
+	protected:
+		static constexpr std::size_t MAX_PLANES = 8;
+		// Elements sorted by one workgroup in shared memory.
+		static constexpr std::uint32_t SORT_GROUP_SIZE = 512;
+		// Shader storage bindings, after the lights and the texture table.
+		static constexpr GLuint PARTICLES_BINDING = 6;
+		static constexpr GLuint DEAD_BINDING = 7;
+		static constexpr GLuint ALIVE_BINDING = 8;
+		static constexpr GLuint ALIVE_NEXT_BINDING = 9;
+		static constexpr GLuint SORT_BINDING = 10;
+		static constexpr GLuint COUNTERS_BINDING = 11;
+
+		// Mirrors the Counters block of the shaders in data/shaders/particles.
+		struct Counters
+		{
+			std::int32_t dead_count;
+			std::uint32_t alive_count;
+			std::uint32_t alive_next_count;
+			std::uint32_t sort_size;
+			std::uint32_t simulate_dispatch[3];
+			std::uint32_t sort_dispatch[3];
+			// DrawArraysIndirectCommand.
+			std::uint32_t draw[4];
+		};
+
+		bool supported_ = false;
+		std::size_t capacity_ = 0;
+		// Power of two the sort steps are issued for.
+		std::uint32_t sort_capacity_ = 0;
+
+		ParticleEmitter emitter_;
+		ParticleForces forces_;
+		std::vector<glm::vec4> planes_;
+		GLuint depth_texture_ = 0;
+		float depth_thickness_ = 0.5f;
+		bool sorting_ = true;
+		bool paused_ = false;
+		float time_scale_ = 1.0f;
+		float emit_carry_ = 0.0f;
+		std::size_t burst_ = 0;
+		std::uint32_t frame_ = 0;
+
+		BufferHandle particles_;
+		BufferHandle dead_;
+		// Swapped every frame, alive_[0] holds the particles to simulate.
+		BufferHandle alive_[2];
+		BufferHandle sort_;
+		BufferHandle counters_;
+		VertexArrayHandle empty_vao_;
+
+		// Counters copied every few frames and read once their fence
+		// signals, never waited on.
+		BufferHandle stats_;
+		GLsync stats_fence_ = nullptr;
+		std::uint32_t stats_alive_ = 0;
+		std::int32_t stats_dead_ = 0;
+
+		GpuTimer emit_timer_;
+		GpuTimer simulate_timer_;
+		GpuTimer sort_timer_;
+		GpuTimer draw_timer_;
+
+		std::unique_ptr<Shader> reset_shader_;
+		std::unique_ptr<Shader> emit_shader_;
+		std::unique_ptr<Shader> prepare_shader_;
+		std::unique_ptr<Shader> simulate_shader_;
+		std::unique_ptr<Shader> finish_shader_;
+		std::unique_ptr<Shader> sort_local_shader_;
+		std::unique_ptr<Shader> sort_step_shader_;
+		std::unique_ptr<Shader> draw_shader_;
+	};
+
+} // End namespace gl.
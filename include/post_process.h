@@ -0,0 +1,168 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "render_graph.h"
+#include "shader.h"
+
+namespace gl {
+
+	enum class PostEffectEnum {
+		BLOOM,
+		TONEMAP,
+		COLOR_GRADING,
+		FXAA,
+		COUNT
+	};
+
+	enum class TonemapOperatorEnum {
+		REINHARD,
+		ACES,
+	};
+
+	// From the scene resolution to the window's.
+	enum class UpscaleFilterEnum {
+		BILINEAR,
+		// Edge adaptive Lanczos then contrast adaptive sharpening.
+		EDGE_ADAPTIVE,
+	};
+
+	// GPU time between two timestamps, read back a few frames later
+	// without stalling. Needs GL 3.3, reads 0 elsewhere.
+	class GpuTimer
+	{
+	public:
+		void Begin();
+		void End();
+		// Picks up the last result if the GPU is done with it, true if a
+		// new one came in.
+		bool Resolve();
+		float GetMilliseconds() const { return milliseconds_; }
+		void Destroy();
+
+	protected:
+		QueryHandle begin_;
+		QueryHandle end_;
+		bool pending_ = false;
+		bool started_ = false;
+		float milliseconds_ = 0.0f;
+	};
+
+	// The engine draws the program into an HDR target, this runs the
+	// compute post-process chain on it and writes the result to the
+	// default framebuffer:
+	//
+	//     bloom (threshold, mip chain down and up) -> bloom composite ->
+	//     tonemap -> color grading -> FXAA -> upscale -> present
+	//
+	// The scene may be smaller than the window (dynamic resolution), the
+	// chain runs at its resolution and the upscale brings it to the
+	// window's.
+	// Every effect has its own resolution scale. Consecutive per-pixel
+	// effects at the same scale run as one dispatch, reading and writing
+	// the image once instead of once per effect. The chain is declared
+	// through a RenderGraph, so the intermediate targets are aliased and
+	// the barriers between dispatches are placed for us.
+	class PostProcess
+	{
+	public:
+		void Init(const std::string& path);
+		void Destroy();
+		// Compute shaders need desktop GL 4.3, without them the engine
+		// draws straight to the backbuffer.
+		bool IsSupported() const { return supported_; }
+		bool IsEnabled() const { return supported_ && enabled_; }
+		// Binds the HDR scene target, (re)created at size, and its viewport.
+		void BeginScene(glm::ivec2 size);
+		// Runs the chain and leaves the default framebuffer bound.
+		void EndScene(glm::ivec2 output_size);
+		GLuint GetSceneFramebuffer() const { return scene_fbo_.Get(); }
+		void DrawImGui();
+
+	protected:
+		void IsError(const char* file, int line) const;
+		void ResizeScene(glm::ivec2 size);
+		void AddBloom(RenderResource scene, RenderResource& chain);
+		RenderResource AddPerPixel(
+			const std::vector<PostEffectEnum>& effects,
+			float scale,
+			RenderResource source,
+			RenderResource bloom);
+		RenderResource AddFxaa(RenderResource source);
+		RenderResource AddUpscale(RenderResource source, glm::ivec2 output_size);
+
+	protected:
+		struct Effect
+		{
+			explicit Effect(const char* effect_name, float effect_scale = 1.0f) :
+				name(effect_name),
+				scale(effect_scale)
+			{
+			}
+			const char* name;
+			bool enabled = true;
+			// Fraction of the scene resolution the effect runs at.
+			float scale = 1.0f;
+			GpuTimer timer;
+			// Effect whose dispatch this one was fused into, or -1.
+			int fused_into = -1;
+		};
+		static constexpr std::size_t EFFECT_COUNT =
+			static_cast<std::size_t>(PostEffectEnum::COUNT);
+
+		bool supported_ = false;
+		bool enabled_ = true;
+		bool fuse_ = true;
+		std::array<Effect, EFFECT_COUNT> effects_ = {
+			Effect("Bloom", 0.5f),
+			Effect("Tonemap"),
+			Effect("Color grading"),
+			Effect("FXAA"),
+		};
+
+		// Bloom.
+		float bloom_threshold_ = 1.0f;
+		float bloom_knee_ = 0.5f;
+		float bloom_intensity_ = 0.6f;
+		int bloom_levels_ = 6;
+		// Levels the chain got this frame, small targets get fewer.
+		int bloom_levels_used_ = 1;
+		// Tonemap.
+		TonemapOperatorEnum operator_ = TonemapOperatorEnum::ACES;
+		float exposure_ = 1.0f;
+		// Color grading, lift, gamma and gain per channel.
+		glm::vec3 lift_ = glm::vec3(0.0f);
+		glm::vec3 gamma_ = glm::vec3(1.0f);
+		glm::vec3 gain_ = glm::vec3(1.0f);
+		float saturation_ = 1.0f;
+		float contrast_ = 1.0f;
+		// Upscale, sharpness in stops, 0 is the strongest.
+		UpscaleFilterEnum upscale_ = UpscaleFilterEnum::EDGE_ADAPTIVE;
+		float sharpness_ = 0.2f;
+		GpuTimer upscale_timer_;
+
+		glm::ivec2 scene_size_ = glm::ivec2(0);
+		FramebufferHandle scene_fbo_;
+		TextureHandle scene_color_;
+		RenderbufferHandle scene_depth_;
+		VertexArrayHandle empty_vao_;
+		RenderGraph graph_;
+		GpuTimer total_timer_;
+		std::size_t dispatch_count_ = 0;
+
+		std::unique_ptr<Shader> bloom_down_shader_;
+		std::unique_ptr<Shader> bloom_up_shader_;
+		std::unique_ptr<Shader> per_pixel_shader_;
+		std::unique_ptr<Shader> fxaa_shader_;
+		std::unique_ptr<Shader> upscale_shader_;
+		std::unique_ptr<Shader> present_shader_;
+	};
+
+} // End namespace gl.
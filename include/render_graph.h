@@ -0,0 +1,230 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gpu_resource.h"
+
+namespace gl {
+
+	// How a pass touches a resource, decides the attachment point and the
+	// glMemoryBarrier bits needed after an incoherent write (IMAGE, STORAGE).
+	enum class RenderAccessEnum {
+		COLOR_ATTACHMENT,
+		DEPTH_ATTACHMENT,
+		SAMPLED,
+		IMAGE,
+		STORAGE,
+		UNIFORM,
+		INDIRECT,
+		VERTEX,
+	};
+
+	struct RenderTextureDesc
+	{
+		int width = 0;
+		int height = 0;
+		GLenum format = GL_RGBA8;
+		// Mip levels, passes pick theirs through glBindImageTexture or
+		// textureLod. Attachments always use level 0.
+		int levels = 1;
+		// Cleared once, before the first pass writing it as an attachment.
+		// Leave it off for targets a pass fully overwrites.
+		bool clear = true;
+		glm::vec4 clear_color = glm::vec4(0.0f);
+		float clear_depth = 1.0f;
+	};
+
+	// A version of a resource. Every write returns a new one, reading a
+	// version orders the pass after the one that produced it.
+	using RenderResource = std::uint32_t;
+
+	class RenderGraph;
+
+	class RenderPassBuilder
+	{
+	public:
+		RenderPassBuilder(RenderGraph& graph, std::size_t pass) :
+			graph_(graph),
+			pass_(pass) {}
+		void Read(RenderResource resource, RenderAccessEnum access);
+		// Returns the version to hand to later passes. Throws if an older
+		// version than the latest is written.
+		RenderResource Write(RenderResource resource, RenderAccessEnum access);
+		// Never culled, for passes with effects the graph can't see.
+		void SetSideEffect();
+
+	protected:
+		RenderGraph& graph_;
+		std::size_t pass_;
+	};
+
+	class RenderPassContext
+	{
+	public:
+		RenderPassContext(const RenderGraph& graph) : graph_(graph) {}
+		GLuint GetTexture(RenderResource resource) const;
+		GLuint GetBuffer(RenderResource resource) const;
+		glm::ivec2 GetSize(RenderResource resource) const;
+
+	protected:
+		const RenderGraph& graph_;
+	};
+
+	// Frame graph, declared again every frame:
+	//
+	//     graph.Reset();
+	//     auto backbuffer = graph.ImportBackbuffer(size);
+	//     auto hdr = graph.CreateTexture("HDR", { w, h, GL_RGBA16F });
+	//     graph.AddPass("Scene",
+	//         [&](RenderPassBuilder& builder) {
+	//             hdr = builder.Write(hdr, RenderAccessEnum::COLOR_ATTACHMENT);
+	//         },
+	//         [&](const RenderPassContext& context) { ... });
+	//     ...
+	//     graph.Compile();
+	//     graph.Execute();
+	//
+	// Compile culls the passes nothing reads from (unless they write an
+	// imported resource or have side effects), sorts the rest so consumers
+	// follow their producers closely, computes the barriers and gives each
+	// transient texture a physical one. Transients whose lifetimes don't
+	// overlap share a texture when their description matches, GL can't
+	// alias memory between different formats. Physical textures and
+	// framebuffers are kept from frame to frame.
+	class RenderGraph
+	{
+	public:
+		RenderResource CreateTexture(
+			const std::string& name,
+			const RenderTextureDesc& desc);
+		RenderResource ImportTexture(
+			const std::string& name,
+			GLuint texture,
+			const RenderTextureDesc& desc);
+		RenderResource ImportBuffer(
+			const std::string& name,
+			GLuint buffer,
+			std::size_t bytes);
+		// The framebuffer bound when Execute is called, the default one or
+		// the engine's scene target. Color attachment only.
+		RenderResource ImportBackbuffer(glm::ivec2 size);
+		void AddPass(
+			const std::string& name,
+			const std::function<void(RenderPassBuilder&)>& setup,
+			std::function<void(const RenderPassContext&)> execute);
+
+		// Throws std::runtime_error if the passes form a cycle or a pass
+		// mixes the backbuffer with other attachments.
+		void Compile();
+		void Execute();
+		// Drops the passes and resources declared, keeps the textures.
+		void Reset();
+		void Destroy();
+
+		void SetAliasing(bool enabled) { aliasing_ = enabled; }
+		// Bytes the transients would take each in their own texture, and
+		// what they take once aliased.
+		std::size_t GetVirtualBytes() const { return virtual_bytes_; }
+		std::size_t GetPhysicalBytes() const { return physical_bytes_; }
+		void DrawImGui();
+
+	protected:
+		friend class RenderPassBuilder;
+		friend class RenderPassContext;
+
+		void IsError(const char* file, int line) const;
+		std::size_t AddResource(const std::string& name);
+		void AssignPhysicalTextures();
+		GLuint GetFramebuffer(
+			const std::vector<GLuint>& colors,
+			GLuint depth,
+			bool stencil);
+
+	protected:
+		struct ResourceNode
+		{
+			std::string name;
+			RenderTextureDesc desc;
+			bool is_buffer = false;
+			bool is_backbuffer = false;
+			bool imported = false;
+			GLuint id = 0;
+			std::size_t bytes = 0;
+			RenderResource latest = 0;
+			// Filled by Compile, positions in the execution order.
+			int first_use = -1;
+			int last_use = -1;
+			int physical = -1;
+		};
+		struct VersionNode
+		{
+			explicit VersionNode(
+				std::size_t resource_index,
+				int writer_pass = -1,
+				int previous_version = -1) :
+				resource(resource_index),
+				writer(writer_pass),
+				previous(previous_version)
+			{
+			}
+			std::size_t resource;
+			int writer = -1;
+			// The version this one was written over, -1 for the first.
+			int previous = -1;
+			std::vector<std::size_t> readers;
+		};
+		struct Access
+		{
+			RenderResource version;
+			RenderAccessEnum access;
+		};
+		struct PassNode
+		{
+			std::string name;
+			std::function<void(const RenderPassContext&)> execute;
+			std::vector<Access> reads;
+			std::vector<Access> writes;
+			bool side_effect = false;
+			// Filled by Compile.
+			bool culled = true;
+			GLbitfield barriers = 0;
+			GLuint framebuffer = 0;
+			bool has_attachments = false;
+			glm::ivec2 viewport = glm::ivec2(0);
+			// Resource and draw buffer, -1 for the depth attachment.
+			std::vector<std::pair<std::size_t, GLint>> clears;
+		};
+		struct PhysicalTexture
+		{
+			RenderTextureDesc desc;
+			TextureHandle texture;
+			std::size_t bytes = 0;
+			int busy_until = -1;
+			bool used = false;
+		};
+
+		std::vector<ResourceNode> resources_;
+		std::vector<VersionNode> versions_;
+		std::vector<PassNode> passes_;
+		std::vector<std::size_t> order_;
+		std::vector<PhysicalTexture> physical_textures_;
+		// Color attachments then depth, to the framebuffer using them.
+		std::map<std::vector<GLuint>, FramebufferHandle> framebuffers_;
+		bool aliasing_ = true;
+		bool compiled_ = false;
+		std::size_t virtual_bytes_ = 0;
+		std::size_t physical_bytes_ = 0;
+		std::size_t barrier_count_ = 0;
+		std::size_t clear_count_ = 0;
+	};
+
+} // End namespace gl.
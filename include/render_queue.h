@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "shader.h"
+
+namespace gl {
+
+	// Position-only copy of a mesh used by the depth pre-pass, so the
+	// pre-pass fetches 12 bytes per vertex instead of the full vertex.
+	struct DepthStream
+	{
+		VertexArrayHandle vao;
+		BufferHandle vbo;
+	};
+
+	// One opaque indexed draw.
+	struct DrawItem
+	{
+		// VAO with the full vertex format, used by the shading pass.
+		unsigned int vao = 0;
+		// VAO from a DepthStream, 0 falls back to vao for the pre-pass.
+		unsigned int depth_vao = 0;
+		GLsizei index_count = 0;
+		glm::mat4 model = glm::mat4(1.0f);
+		// Bound to unit 0 for the shading pass, 0 leaves the caller's.
+		unsigned int texture = 0;
+	};
+
+	enum class OverdrawModeEnum {
+		NONE,
+		// Shade fragment counts as a heat map instead of the scene.
+		HEATMAP
+	};
+
+	// Queue of opaque draws flushed front-to-back, with an optional
+	// depth-only pre-pass. With the pre-pass on, the shading pass runs with
+	// GL_LEQUAL and depth writes off. Both vertex shaders compute an
+	// invariant gl_Position the same way, so only the nearest surface of a
+	// pixel passes, shaded once unless surfaces are coplanar there.
+	class RenderQueue
+	{
+	public:
+		void Init(const std::string& path);
+		void Destroy();
+		// Builds a position-only stream from an interleaved vertex array
+		// whose position is the first 3 floats, sharing the index buffer.
+		DepthStream CreateDepthStream(
+			const std::vector<float>& vertices,
+			int stride_floats,
+			unsigned int ebo) const;
+		DepthStream CreateDepthStream(
+			const std::vector<glm::vec3>& positions,
+			unsigned int ebo) const;
+		void DestroyDepthStream(DepthStream& stream) const;
+		void Submit(const DrawItem& item);
+		// Draw and clear the queue. The shader gets its view/projection set
+		// by the caller; the queue sets "model" and "model_inverse".
+		void Flush(
+			const glm::mat4& view,
+			const glm::mat4& projection,
+			const Shader& shader);
+		void DrawImGui();
+
+		bool depth_prepass = true;
+		bool sort_front_to_back = true;
+		OverdrawModeEnum overdraw_mode = OverdrawModeEnum::NONE;
+
+	protected:
+		void DepthPrepass(const glm::mat4& view, const glm::mat4& projection);
+		void ShadingPass(const Shader& shader);
+		void ResizeOverdrawTarget(int width, int height);
+		void MeasureOverdraw();
+		void IsError(const char* file, int line) const;
+
+	protected:
+		struct SortedItem
+		{
+			float depth;
+			std::size_t index;
+		};
+		std::vector<DrawItem> items_;
+		std::vector<SortedItem> sorted_;
+		// Per item, computed in one batch (simd_math.h).
+		std::vector<glm::mat4> models_;
+		std::vector<glm::mat4> normal_matrices_;
+
+		std::unique_ptr<Shader> depth_shader_ = nullptr;
+		std::unique_ptr<Shader> overdraw_shader_ = nullptr;
+		std::unique_ptr<Shader> heatmap_shader_ = nullptr;
+
+		// Offscreen target counting fragments in its red channel.
+		FramebufferHandle overdraw_fbo_;
+		TextureHandle overdraw_color_;
+		RenderbufferHandle overdraw_depth_;
+		VertexArrayHandle empty_vao_;
+		glm::ivec2 overdraw_size_ = glm::ivec2(0);
+		std::vector<std::uint8_t> overdraw_pixels_;
+
+		// Last measurement.
+		float fragments_per_pixel_ = 0.0f;
+		float fragments_per_covered_pixel_ = 0.0f;
+		int max_fragments_ = 0;
+		std::size_t last_draw_count_ = 0;
+	};
+
+} // End namespace gl.
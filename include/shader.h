@@ -3,67 +3,50 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdlib>
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "file_system.h"
+#include "gpu_backend.h"
+#include "gpu_resource.h"
+#include "spirv.h"
 
 namespace gl {
 
+	// Move-only, the program is deleted with the shader.
 	class Shader
 	{
 	public:
-		unsigned int id;
 		// constructor generates the shader on the fly
 		Shader(
 			const std::string& vertexPath, 
 			const std::string& fragmentPath, 
 			const std::string& geometryPath = "")
 		{
-			// 1. retrieve the vertex/fragment source code from filePath
-			std::string vertexCode;
-			std::string fragmentCode;
-			std::string geometryCode;
-			std::ifstream vShaderFile;
-			std::ifstream fShaderFile;
-			std::ifstream gShaderFile;
-			// ensure ifstream objects can throw exceptions:
-			vShaderFile.exceptions(
-				std::ifstream::failbit | std::ifstream::badbit);
-			fShaderFile.exceptions(
-				std::ifstream::failbit | std::ifstream::badbit);
-			gShaderFile.exceptions(
-				std::ifstream::failbit | std::ifstream::badbit);
-			try
-			{
-				// open files
-				vShaderFile.open(vertexPath);
-				fShaderFile.open(fragmentPath);
-				std::stringstream vShaderStream, fShaderStream;
-				// read file's buffer contents into streams
-				vShaderStream << vShaderFile.rdbuf();
-				fShaderStream << fShaderFile.rdbuf();
-				// close file handlers
-				vShaderFile.close();
-				fShaderFile.close();
-				// convert stream into string
-				vertexCode = vShaderStream.str();
-				fragmentCode = fShaderStream.str();
-				// if geometry shader path is present, also load a geometry
-				// shader
-				if (!geometryPath.empty())
-				{
-					gShaderFile.open(geometryPath);
-					std::stringstream gShaderStream;
-					gShaderStream << gShaderFile.rdbuf();
-					gShaderFile.close();
-					geometryCode = gShaderStream.str();
-				}
-			}
-			catch (std::ifstream::failure& e)
+			// 0. SPIR-V compiled at build time when the driver takes it
+			if (geometryPath.empty() ?
+				LoadSpirv({
+					{ GL_VERTEX_SHADER, vertexPath },
+					{ GL_FRAGMENT_SHADER, fragmentPath } }) :
+				LoadSpirv({
+					{ GL_VERTEX_SHADER, vertexPath },
+					{ GL_FRAGMENT_SHADER, fragmentPath },
+					{ GL_GEOMETRY_SHADER, geometryPath } }))
 			{
-				throw std::runtime_error(e.what());
+				return;
 			}
+			// 1. retrieve the vertex/fragment source code from filePath,
+			// throws std::runtime_error if one can't be found
+			const FileSystem& fileSystem = FileSystem::GetInstance();
+			const std::string vertexCode = fileSystem.ReadText(vertexPath);
+			const std::string fragmentCode = fileSystem.ReadText(fragmentPath);
+			// if geometry shader path is present, also load a geometry shader
+			const std::string geometryCode = geometryPath.empty() ?
+				std::string() : fileSystem.ReadText(geometryPath);
 			const char* vShaderCode = vertexCode.c_str();
 			const char* fShaderCode = fragmentCode.c_str();
 			// 2. compile shaders
@@ -98,7 +81,8 @@ namespace gl {
 				CheckCompileErrors(geometry, "GEOMETRY");
 			}
 			// shader Program
-			id = glCreateProgram();
+			program_.Create(vertexPath);
+			const GLuint id = program_.Get();
 			IsError(__FILE__, __LINE__);
 			glAttachShader(id, vertex);
 			IsError(__FILE__, __LINE__);
@@ -124,89 +108,216 @@ namespace gl {
 				IsError(__FILE__, __LINE__);
 			}
 		}
+		// constructor for a compute-only program
+		explicit Shader(const std::string& computePath)
+		{
+			if (LoadSpirv({ { GL_COMPUTE_SHADER, computePath } })) return;
+			const std::string computeCode =
+				FileSystem::GetInstance().ReadText(computePath);
+			const char* cShaderCode = computeCode.c_str();
+			unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+			IsError(__FILE__, __LINE__);
+			glShaderSource(compute, 1, &cShaderCode, NULL);
+			IsError(__FILE__, __LINE__);
+			glCompileShader(compute);
+			IsError(__FILE__, __LINE__);
+			CheckCompileErrors(compute, "COMPUTE");
+			program_.Create(computePath);
+			const GLuint id = program_.Get();
+			IsError(__FILE__, __LINE__);
+			glAttachShader(id, compute);
+			IsError(__FILE__, __LINE__);
+			glLinkProgram(id);
+			IsError(__FILE__, __LINE__);
+			CheckCompileErrors(id, "PROGRAM");
+			glDeleteShader(compute);
+			IsError(__FILE__, __LINE__);
+		}
+		GLuint GetId() const { return program_.Get(); }
+		// For callers setting uniforms without the name, look it up once.
+		// SPIR-V programs answer from their own decorations first, the
+		// driver doesn't have to know the names.
+		GLint GetUniformLocation(const std::string& name) const
+		{
+			if (!spirvLocations_.empty())
+			{
+				auto it = spirvLocations_.find(name);
+				if (it != spirvLocations_.end()) return it->second;
+				// "array[i]" is i locations after the array.
+				const auto bracket = name.find('[');
+				if (bracket != std::string::npos && name.back() == ']')
+				{
+					it = spirvLocations_.find(name.substr(0, bracket));
+					if (it != spirvLocations_.end())
+					{
+						return it->second + std::atoi(name.c_str() + bracket + 1);
+					}
+				}
+			}
+			return glGetUniformLocation(program_.Get(), name.c_str());
+		}
+		bool IsSpirv() const { return isSpirv_; }
 		// activate the shader
-		void Use()
+		void Use() const
 		{
-			glUseProgram(id);
+			glUseProgram(program_.Get());
 			IsError(__FILE__, __LINE__);
 		}
-		// utility uniform functions
+		// utility uniform functions, set on this program whether it is in
+		// use or not
 		void SetBool(const std::string& name, bool value) const
 		{
-			glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, static_cast<int>(value));
 		}
 		void SetInt(const std::string& name, int value) const
 		{
-			glUniform1i(glGetUniformLocation(id, name.c_str()), value);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, value);
 		}
 		void SetFloat(const std::string& name, float value) const
 		{
-			glUniform1f(glGetUniformLocation(id, name.c_str()), value);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, value);
 		}
 		void SetVec2(const std::string& name, const glm::vec2& value) const
 		{
-			glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, value);
 		}
 		void SetVec2(const std::string& name, float x, float y) const
 		{
-			glUniform2f(glGetUniformLocation(id, name.c_str()), x, y);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, glm::vec2(x, y));
+		}
+		void SetIVec2(const std::string& name, const glm::ivec2& value) const
+		{
+			SetUniform(name, value);
+		}
+		void SetIVec3(const std::string& name, const glm::ivec3& value) const
+		{
+			SetUniform(name, value);
 		}
 		void SetVec3(const std::string& name, const glm::vec3& value) const
 		{
-			glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, value);
 		}
 		void SetVec3(const std::string& name, float x, float y, float z) const
 		{
-			glUniform3f(glGetUniformLocation(id, name.c_str()), x, y, z);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, glm::vec3(x, y, z));
 		}
 		void SetVec4(const std::string& name, const glm::vec4& value) const
 		{
-			glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, value);
 		}
 		void SetVec4(
 			const std::string& name, 
 			float x, float y, float z, float w)
 		{
-			glUniform4f(glGetUniformLocation(id, name.c_str()), x, y, z, w);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, glm::vec4(x, y, z, w));
 		}
 		void SetMat2(const std::string& name, const glm::mat2& mat) const
 		{
-			glUniformMatrix2fv(
-				glGetUniformLocation(id, name.c_str()), 
-				1, 
-				GL_FALSE, 
-				&mat[0][0]);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, mat);
 		}
 		void SetMat3(const std::string& name, const glm::mat3& mat) const
 		{
-			glUniformMatrix3fv(
-				glGetUniformLocation(id, name.c_str()), 
-				1, 
-				GL_FALSE, 
-				&mat[0][0]);
-			IsError(__FILE__, __LINE__);
+			SetUniform(name, mat);
 		}
 		void SetMat4(const std::string& name, const glm::mat4& mat) const
 		{
-			glUniformMatrix4fv(
-				glGetUniformLocation(id, name.c_str()), 
-				1, 
-				GL_FALSE, 
-				&mat[0][0]);
+			SetUniform(name, mat);
+		}
+
+	private:
+		template <typename T>
+		void SetUniform(const std::string& name, const T& value) const
+		{
+			GpuBackend::GetInstance().SetUniform(
+				program_.Get(),
+				GetUniformLocation(name),
+				value);
 			IsError(__FILE__, __LINE__);
 		}
 
 	private:
+		ProgramHandle program_;
+		std::unordered_map<std::string, GLint> spirvLocations_;
+		bool isSpirv_ = false;
+		// Every stage has to have its SPIR-V, false to compile the GLSL
+		// instead (no support, not built, or rejected by the driver).
+		bool LoadSpirv(const std::vector<std::pair<GLenum, std::string>>& stages)
+		{
+			if (!IsSpirvSupported()) return false;
+			const FileSystem& fileSystem = FileSystem::GetInstance();
+			std::vector<FileData> binaries;
+			for (const auto& [stage, path] : stages)
+			{
+				const std::string spirvPath = GetSpirvPath(path);
+				if (!fileSystem.Exists(spirvPath)) return false;
+				binaries.push_back(fileSystem.Read(spirvPath));
+				if (binaries.back().GetSize() == 0) return false;
+			}
+			program_.Create(stages.front().second);
+			const GLuint id = program_.Get();
+			IsError(__FILE__, __LINE__);
+			std::vector<GLuint> shaders;
+			GLint success = GL_TRUE;
+			for (std::size_t i = 0; i < stages.size() && success; ++i)
+			{
+				const GLuint shader = glCreateShader(stages[i].first);
+				IsError(__FILE__, __LINE__);
+				shaders.push_back(shader);
+				// A binary the driver rejects isn't fatal, the source is
+				// still there: its error falls back instead of throwing.
+				glShaderBinary(
+					1,
+					&shader,
+					GL_SHADER_BINARY_FORMAT_SPIR_V_ARB,
+					binaries[i].GetData(),
+					static_cast<GLsizei>(binaries[i].GetSize()));
+				if (glGetError() != GL_NO_ERROR)
+				{
+					success = GL_FALSE;
+					break;
+				}
+				if (GLAD_GL_VERSION_4_6)
+				{
+					glSpecializeShader(shader, "main", 0, nullptr, nullptr);
+				}
+				else
+				{
+					glSpecializeShaderARB(shader, "main", 0, nullptr, nullptr);
+				}
+				if (glGetError() != GL_NO_ERROR)
+				{
+					success = GL_FALSE;
+					break;
+				}
+				glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+				glAttachShader(id, shader);
+				IsError(__FILE__, __LINE__);
+			}
+			if (success)
+			{
+				glLinkProgram(id);
+				glGetProgramiv(id, GL_LINK_STATUS, &success);
+			}
+			for (const GLuint shader : shaders)
+			{
+				glDeleteShader(shader);
+			}
+			IsError(__FILE__, __LINE__);
+			if (!success)
+			{
+				std::cerr
+					<< "SPIR-V rejected for " << stages.front().second
+					<< ", compiling GLSL.\n";
+				program_.Reset();
+				return false;
+			}
+			for (const auto& binary : binaries)
+			{
+				spirvLocations_.merge(ReflectUniformLocations(binary.GetSpan()));
+			}
+			isSpirv_ = true;
+			return true;
+		}
 		// utility function for checking shader compilation/linking errors.
 		void CheckCompileErrors(GLuint shader, std::string type)
 		{
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <cstddef>
+
+#include "simd_math.h"
+
+// Kernels of simd_math.h written once for every instruction set, only
+// included by the src/simd_math_*.cpp built for one. V wraps the registers
+// (__m128, __m256 or __m512) as groups of 4 floats:
+//
+//     Type, Mask, WIDTH (floats per register)
+//     Set1 Zero Add Sub Mul Div FMAdd (a * b + c) Abs Sqrt
+//     Less Greater (to a Mask) Select(if_false, if_true, mask)
+//     Shuffle<I0, I1, I2, I3>(a, b)  [a[I0] a[I1] b[I2] b[I3]] per group
+//     Splat<K>(a)                    a[K] over each group
+//     Transpose4(a, b, c, d)         4x4 transpose of each group
+//     LoadGroups<STRIDE>(p)          group g from p + g * STRIDE
+//     StoreGroups<STRIDE>(p, v)
+//
+// Objects go 4 per group, transposed so each lane is one object, or one
+// per group when the work is a 4 wide column operation. The remainder of a
+// batch goes to the scalar kernels. Everything is a template on V, an
+// inline function shared with other translation units could be linked in
+// with instructions the CPU doesn't have.
+
+namespace gl {
+
+	template <typename V>
+	struct WideKernels
+	{
+		using T = typename V::Type;
+		static constexpr std::size_t WIDTH = V::WIDTH;
+		// Objects per group in the transposed kernels, groups per register.
+		static constexpr std::size_t GROUPS = V::WIDTH / 4;
+
+		// glm types as their floats, without calling into glm.
+		template <typename U>
+		static const float* Floats(const U* p)
+		{
+			return reinterpret_cast<const float*>(p);
+		}
+		template <typename U>
+		static float* Floats(U* p) { return reinterpret_cast<float*>(p); }
+
+		// WIDTH values of 4 floats, STRIDE floats apart, one per lane: x
+		// holds their first float, lane k of value k.
+		template <std::size_t STRIDE>
+		static void LoadTransposed(const float* p, T& x, T& y, T& z, T& w)
+		{
+			x = V::template LoadGroups<STRIDE * 4>(p);
+			y = V::template LoadGroups<STRIDE * 4>(p + STRIDE);
+			z = V::template LoadGroups<STRIDE * 4>(p + STRIDE * 2);
+			w = V::template LoadGroups<STRIDE * 4>(p + STRIDE * 3);
+			V::Transpose4(x, y, z, w);
+		}
+
+		template <std::size_t STRIDE>
+		static void StoreTransposed(float* p, T x, T y, T z, T w)
+		{
+			V::Transpose4(x, y, z, w);
+			V::template StoreGroups<STRIDE * 4>(p, x);
+			V::template StoreGroups<STRIDE * 4>(p + STRIDE, y);
+			V::template StoreGroups<STRIDE * 4>(p + STRIDE * 2, z);
+			V::template StoreGroups<STRIDE * 4>(p + STRIDE * 3, w);
+		}
+
+		// Lanes of x y z for consecutive vec3.
+		static void LoadVec3(const float* p, T& x, T& y, T& z)
+		{
+			const T a = V::template LoadGroups<12>(p);
+			const T b = V::template LoadGroups<12>(p + 4);
+			const T c = V::template LoadGroups<12>(p + 8);
+			// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3.
+			const T bc = V::template Shuffle<2, 3, 1, 2>(b, c);
+			x = V::template Shuffle<0, 3, 0, 2>(a, bc);
+			y = V::template Shuffle<0, 2, 1, 3>(
+				V::template Shuffle<1, 1, 0, 0>(a, b),
+				bc);
+			z = V::template Shuffle<0, 2, 0, 3>(
+				V::template Shuffle<2, 2, 1, 1>(a, b),
+				c);
+		}
+
+		// Column a = (a0 a1 a2) cross b, lanes.
+		static void Cross(
+			T a0, T a1, T a2,
+			T b0, T b1, T b2,
+			T& c0, T& c1, T& c2)
+		{
+			c0 = V::Sub(V::Mul(a1, b2), V::Mul(a2, b1));
+			c1 = V::Sub(V::Mul(a2, b0), V::Mul(a0, b2));
+			c2 = V::Sub(V::Mul(a0, b1), V::Mul(a1, b0));
+		}
+
+		// Columns 0 to 2 of 4 float matrices, the transposed cofactors of
+		// the upper 3x3 over its determinant. Rows of its inverse.
+		static void InverseRows(
+			const float* m,
+			T (&rows)[3][3],
+			T (&translation)[3])
+		{
+			T a[4];
+			T b[4];
+			T c[4];
+			T t[4];
+			LoadTransposed<16>(m, a[0], a[1], a[2], a[3]);
+			LoadTransposed<16>(m + 4, b[0], b[1], b[2], b[3]);
+			LoadTransposed<16>(m + 8, c[0], c[1], c[2], c[3]);
+			LoadTransposed<16>(m + 12, t[0], t[1], t[2], t[3]);
+			Cross(b[0], b[1], b[2], c[0], c[1], c[2], rows[0][0], rows[0][1], rows[0][2]);
+			Cross(c[0], c[1], c[2], a[0], a[1], a[2], rows[1][0], rows[1][1], rows[1][2]);
+			Cross(a[0], a[1], a[2], b[0], b[1], b[2], rows[2][0], rows[2][1], rows[2][2]);
+			const T det = V::FMAdd(
+				a[0],
+				rows[0][0],
+				V::FMAdd(a[1], rows[0][1], V::Mul(a[2], rows[0][2])));
+			const T inverse_det = V::Div(V::Set1(1.0f), det);
+			for (auto& row : rows)
+			{
+				for (auto& value : row) value = V::Mul(value, inverse_det);
+			}
+			translation[0] = t[0];
+			translation[1] = t[1];
+			translation[2] = t[2];
+		}
+
+		static void ComposeTransforms(
+			const glm::vec3* positions,
+			const glm::quat* rotations,
+			const glm::vec3* scales,
+			glm::mat4* out,
+			std::size_t count)
+		{
+			const T one = V::Set1(1.0f);
+			const T zero = V::Zero();
+			std::size_t i = 0;
+			for (; i + WIDTH <= count; i += WIDTH)
+			{
+				T x, y, z, w;
+				LoadTransposed<4>(Floats(rotations + i), x, y, z, w);
+				T sx, sy, sz;
+				LoadVec3(Floats(scales + i), sx, sy, sz);
+				T tx, ty, tz;
+				LoadVec3(Floats(positions + i), tx, ty, tz);
+
+				// glm::mat3_cast, times 2 folded in the second operand.
+				const T x2 = V::Add(x, x);
+				const T y2 = V::Add(y, y);
+				const T z2 = V::Add(z, z);
+				const T xx = V::Mul(x, x2);
+				const T yy = V::Mul(y, y2);
+				const T zz = V::Mul(z, z2);
+				const T xy = V::Mul(x, y2);
+				const T xz = V::Mul(x, z2);
+				const T yz = V::Mul(y, z2);
+				const T wx = V::Mul(w, x2);
+				const T wy = V::Mul(w, y2);
+				const T wz = V::Mul(w, z2);
+
+				float* matrix = Floats(out + i);
+				StoreTransposed<16>(
+					matrix,
+					V::Mul(V::Sub(one, V::Add(yy, zz)), sx),
+					V::Mul(V::Add(xy, wz), sx),
+					V::Mul(V::Sub(xz, wy), sx),
+					zero);
+				StoreTransposed<16>(
+					matrix + 4,
+					V::Mul(V::Sub(xy, wz), sy),
+					V::Mul(V::Sub(one, V::Add(xx, zz)), sy),
+					V::Mul(V::Add(yz, wx), sy),
+					zero);
+				StoreTransposed<16>(
+					matrix + 8,
+					V::Mul(V::Add(xz, wy), sz),
+					V::Mul(V::Sub(yz, wx), sz),
+					V::Mul(V::Sub(one, V::Add(xx, yy)), sz),
+					zero);
+				StoreTransposed<16>(matrix + 12, tx, ty, tz, one);
+			}
+			GetScalarKernels().compose_transforms(
+				positions + i,
+				rotations + i,
+				scales + i,
+				out + i,
+				count - i);
+		}
+
+		static void InverseAffine(
+			const glm::mat4* matrices,
+			glm::mat4* out,
+			std::size_t count)
+		{
+			const T one = V::Set1(1.0f);
+			const T zero = V::Zero();
+			std::size_t i = 0;
+			for (; i + WIDTH <= count; i += WIDTH)
+			{
+				T rows[3][3];
+				T t[3];
+				InverseRows(Floats(matrices + i), rows, t);
+				// -inverse(upper 3x3) * translation.
+				T new_t[3];
+				for (int r = 0; r < 3; ++r)
+				{
+					new_t[r] = V::Sub(
+						zero,
+						V::FMAdd(
+							rows[r][0],
+							t[0],
+							V::FMAdd(rows[r][1], t[1], V::Mul(rows[r][2], t[2]))));
+				}
+				float* matrix = Floats(out + i);
+				for (int c = 0; c < 3; ++c)
+				{
+					StoreTransposed<16>(
+						matrix + c * 4,
+						rows[0][c],
+						rows[1][c],
+						rows[2][c],
+						zero);
+				}
+				StoreTransposed<16>(matrix + 12, new_t[0], new_t[1], new_t[2], one);
+			}
+			GetScalarKernels().inverse_affine(matrices + i, out + i, count - i);
+		}
+
+		static void NormalMatrices(
+			const glm::mat4* models,
+			glm::mat4* out,
+			std::size_t count)
+		{
+			const T one = V::Set1(1.0f);
+			const T zero = V::Zero();
+			std::size_t i = 0;
+			for (; i + WIDTH <= count; i += WIDTH)
+			{
+				// The transpose of the inverse has its rows as columns.
+				T rows[3][3];
+				T t[3];
+				InverseRows(Floats(models + i), rows, t);
+				float* matrix = Floats(out + i);
+				for (int c = 0; c < 3; ++c)
+				{
+					StoreTransposed<16>(
+						matrix + c * 4,
+						rows[c][0],
+						rows[c][1],
+						rows[c][2],
+						zero);
+				}
+				StoreTransposed<16>(matrix + 12, zero, zero, zero, one);
+			}
+			GetScalarKernels().normal_matrices(models + i, out + i, count - i);
+		}
+
+		static void TransformAabbs(
+			const glm::mat4* transforms,
+			const Aabb* boxes,
+			Aabb* out,
+			std::size_t count)
+		{
+			static_assert(sizeof(Aabb) == 6 * sizeof(float));
+			const T half = V::Set1(0.5f);
+			std::size_t i = 0;
+			// One box per group, its columns in the group.
+			for (; i + GROUPS <= count; i += GROUPS)
+			{
+				// Both 16 byte loads stay inside the box:
+				// lo = min.x min.y min.z max.x, hi = min.z max.x max.y max.z.
+				const float* box = Floats(boxes + i);
+				const T lo = V::template LoadGroups<6>(box);
+				const T hi = V::template LoadGroups<6>(box + 2);
+				const T max = V::template Shuffle<1, 2, 3, 3>(hi, hi);
+				const T center = V::Mul(V::Add(lo, max), half);
+				const T extent = V::Mul(V::Sub(max, lo), half);
+
+				const float* matrix = Floats(transforms + i);
+				const T c0 = V::template LoadGroups<16>(matrix);
+				const T c1 = V::template LoadGroups<16>(matrix + 4);
+				const T c2 = V::template LoadGroups<16>(matrix + 8);
+				const T c3 = V::template LoadGroups<16>(matrix + 12);
+				const T new_center = V::FMAdd(
+					c0,
+					V::template Splat<0>(center),
+					V::FMAdd(
+						c1,
+						V::template Splat<1>(center),
+						V::FMAdd(c2, V::template Splat<2>(center), c3)));
+				const T new_extent = V::FMAdd(
+					V::Abs(c0),
+					V::template Splat<0>(extent),
+					V::FMAdd(
+						V::Abs(c1),
+						V::template Splat<1>(extent),
+						V::Mul(V::Abs(c2), V::template Splat<2>(extent))));
+				const T new_min = V::Sub(new_center, new_extent);
+				const T new_max = V::Add(new_center, new_extent);
+
+				// min.z twice and max.x twice, then the overlapping stores.
+				const T middle = V::template Shuffle<2, 2, 0, 0>(new_min, new_max);
+				float* result = Floats(out + i);
+				V::template StoreGroups<6>(
+					result,
+					V::template Shuffle<0, 1, 0, 2>(new_min, middle));
+				V::template StoreGroups<6>(
+					result + 2,
+					V::template Shuffle<0, 2, 1, 2>(middle, new_max));
+			}
+			GetScalarKernels().transform_aabbs(
+				transforms + i,
+				boxes + i,
+				out + i,
+				count - i);
+		}
+
+		// sin on 0 to pi / 2, Taylor to the 11th power (error under 1e-7).
+		static T Sin(T x)
+		{
+			const T x2 = V::Mul(x, x);
+			T p = V::Set1(-2.5052108e-8f);
+			p = V::FMAdd(p, x2, V::Set1(2.7557319e-6f));
+			p = V::FMAdd(p, x2, V::Set1(-1.9841270e-4f));
+			p = V::FMAdd(p, x2, V::Set1(8.3333333e-3f));
+			p = V::FMAdd(p, x2, V::Set1(-1.6666667e-1f));
+			p = V::FMAdd(p, x2, V::Set1(1.0f));
+			return V::Mul(p, x);
+		}
+
+		// acos on 0 to 1, through the Cephes asinf polynomial.
+		static T Acos(T x)
+		{
+			const T half = V::Set1(0.5f);
+			const auto large = V::Greater(x, half);
+			// Over 0.5: acos(x) = 2 asin(sqrt((1 - x) / 2)).
+			const T z_large = V::Mul(half, V::Sub(V::Set1(1.0f), x));
+			const T z = V::Select(V::Mul(x, x), z_large, large);
+			const T s = V::Select(x, V::Sqrt(z_large), large);
+			T p = V::Set1(4.2163199048e-2f);
+			p = V::FMAdd(p, z, V::Set1(2.4181311049e-2f));
+			p = V::FMAdd(p, z, V::Set1(4.5470025998e-2f));
+			p = V::FMAdd(p, z, V::Set1(7.4953002686e-2f));
+			p = V::FMAdd(p, z, V::Set1(1.6666752422e-1f));
+			const T asin = V::FMAdd(V::Mul(p, z), s, s);
+			return V::Select(
+				V::Sub(V::Set1(1.57079632679f), asin),
+				V::Add(asin, asin),
+				large);
+		}
+
+		static void Slerp(
+			const glm::quat* from,
+			const glm::quat* to,
+			float t,
+			glm::quat* out,
+			std::size_t count)
+		{
+			const T zero = V::Zero();
+			const T one = V::Set1(1.0f);
+			const T weight = V::Set1(t);
+			const T one_minus_weight = V::Set1(1.0f - t);
+			// Same cut over to a linear mix as glm.
+			const T linear_threshold = V::Set1(1.0f - 1.1920929e-7f);
+			std::size_t i = 0;
+			for (; i + WIDTH <= count; i += WIDTH)
+			{
+				T ax, ay, az, aw;
+				T bx, by, bz, bw;
+				LoadTransposed<4>(Floats(from + i), ax, ay, az, aw);
+				LoadTransposed<4>(Floats(to + i), bx, by, bz, bw);
+				T cos = V::FMAdd(
+					ax,
+					bx,
+					V::FMAdd(ay, by, V::FMAdd(az, bz, V::Mul(aw, bw))));
+				// The short way around.
+				const auto negative = V::Less(cos, zero);
+				bx = V::Select(bx, V::Sub(zero, bx), negative);
+				by = V::Select(by, V::Sub(zero, by), negative);
+				bz = V::Select(bz, V::Sub(zero, bz), negative);
+				bw = V::Select(bw, V::Sub(zero, bw), negative);
+				cos = V::Abs(cos);
+				const auto linear = V::Greater(cos, linear_threshold);
+
+				const T angle = Acos(cos);
+				const T inverse_sin = V::Div(one, Sin(angle));
+				const T w0 = V::Select(
+					V::Mul(Sin(V::Mul(one_minus_weight, angle)), inverse_sin),
+					one_minus_weight,
+					linear);
+				const T w1 = V::Select(
+					V::Mul(Sin(V::Mul(weight, angle)), inverse_sin),
+					weight,
+					linear);
+				StoreTransposed<4>(
+					Floats(out + i),
+					V::FMAdd(ax, w0, V::Mul(bx, w1)),
+					V::FMAdd(ay, w0, V::Mul(by, w1)),
+					V::FMAdd(az, w0, V::Mul(bz, w1)),
+					V::FMAdd(aw, w0, V::Mul(bw, w1)));
+			}
+			GetScalarKernels().slerp(from + i, to + i, t, out + i, count - i);
+		}
+	};
+
+} // End namespace gl.
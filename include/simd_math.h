@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <span>
+
+namespace gl {
+
+	// Axis aligned bounding box.
+	struct Aabb
+	{
+		glm::vec3 min = glm::vec3(0.0f);
+		glm::vec3 max = glm::vec3(0.0f);
+	};
+
+	enum class SimdLevelEnum {
+		SCALAR,
+		SSE4,
+		AVX2,
+		AVX512,
+	};
+
+	// Transform math over whole arrays of glm types, read and written in
+	// place (no conversion, no alignment required):
+	//
+	//     ComposeTransforms(positions, rotations, scales, models);
+	//     ComputeNormalMatrices(models, normal_matrices);
+	//
+	// Each call runs the kernel of the widest instruction set the CPU has,
+	// picked once at startup: AVX-512, AVX2 + FMA, SSE4.1 or plain glm.
+	// The wide kernels work on several objects at once, transposed to one
+	// lane per object, and finish the batch with the glm code. Results
+	// match glm to a few ulps. Every span of a call has the same size
+	// (throws std::runtime_error otherwise), out may be one of the inputs.
+	SimdLevelEnum GetSupportedSimdLevel();
+	SimdLevelEnum GetSimdLevel();
+	// Clamped to the supported level, for comparisons.
+	void SetSimdLevel(SimdLevelEnum level);
+	const char* GetSimdLevelName(SimdLevelEnum level);
+
+	// translate(position) * mat4_cast(rotation) * scale(scale).
+	void ComposeTransforms(
+		std::span<const glm::vec3> positions,
+		std::span<const glm::quat> rotations,
+		std::span<const glm::vec3> scales,
+		std::span<glm::mat4> out);
+	// out[i] = left[i] * right[i].
+	void MultiplyMatrices(
+		std::span<const glm::mat4> left,
+		std::span<const glm::mat4> right,
+		std::span<glm::mat4> out);
+	// out[i] = left * right[i], a view projection applied to models.
+	void MultiplyMatrices(
+		const glm::mat4& left,
+		std::span<const glm::mat4> right,
+		std::span<glm::mat4> out);
+	// glm::affineInverse, the last row is taken as 0 0 0 1.
+	void InverseAffineMatrices(
+		std::span<const glm::mat4> matrices,
+		std::span<glm::mat4> out);
+	// Inverse transpose of the upper 3x3 of the models, in a mat4 with the
+	// rest of the identity, what the shaders read as mat3(model_inverse).
+	void ComputeNormalMatrices(
+		std::span<const glm::mat4> models,
+		std::span<glm::mat4> out);
+	// Bounds of the transformed boxes (of their 8 corners), affine
+	// transforms.
+	void TransformAabbs(
+		std::span<const glm::mat4> transforms,
+		std::span<const Aabb> boxes,
+		std::span<Aabb> out);
+	// glm::slerp(from[i], to[i], t), t from 0 to 1.
+	void SlerpQuaternions(
+		std::span<const glm::quat> from,
+		std::span<const glm::quat> to,
+		float t,
+		std::span<glm::quat> out);
+
+	// Kernels of one instruction set, raw pointers to the glm data. The
+	// wide ones live in their own translation unit built for that
+	// instruction set (see CMakeLists.txt) and are null when it wasn't.
+	struct SimdKernels
+	{
+		void (*compose_transforms)(
+			const glm::vec3* positions,
+			const glm::quat* rotations,
+			const glm::vec3* scales,
+			glm::mat4* out,
+			std::size_t count);
+		void (*multiply_matrices)(
+			const glm::mat4* left,
+			const glm::mat4* right,
+			glm::mat4* out,
+			std::size_t count);
+		void (*multiply_matrix)(
+			const glm::mat4& left,
+			const glm::mat4* right,
+			glm::mat4* out,
+			std::size_t count);
+		void (*inverse_affine)(
+			const glm::mat4* matrices,
+			glm::mat4* out,
+			std::size_t count);
+		void (*normal_matrices)(
+			const glm::mat4* models,
+			glm::mat4* out,
+			std::size_t count);
+		void (*transform_aabbs)(
+			const glm::mat4* transforms,
+			const Aabb* boxes,
+			Aabb* out,
+			std::size_t count);
+		void (*slerp)(
+			const glm::quat* from,
+			const glm::quat* to,
+			float t,
+			glm::quat* out,
+			std::size_t count);
+	};
+
+	const SimdKernels& GetScalarKernels();
+	const SimdKernels* GetSse4Kernels();
+	const SimdKernels* GetAvx2Kernels();
+	const SimdKernels* GetAvx512Kernels();
+
+} // End namespace gl.
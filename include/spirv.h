@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace gl {
+
+	// SPIR-V built offline from a shader (see ShadersCheck), looked up
+	// through the FileSystem: "spirv/" + the normalized source path + ".spv".
+	// Empty if the shader couldn't be compiled for GL.
+	std::string GetSpirvPath(const std::string& glsl_path);
+
+	// GL 4.6 or ARB_gl_spirv.
+	bool IsSpirvSupported();
+
+	// Location of every plain uniform, by name, from the OpName and
+	// Location decorations. With SPIR-V the driver doesn't have to answer
+	// glGetUniformLocation. Throws std::runtime_error if this isn't SPIR-V.
+	std::unordered_map<std::string, GLint> ReflectUniformLocations(
+		std::span<const std::uint8_t> spirv);
+
+} // End namespace gl.
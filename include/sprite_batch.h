@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "shader.h"
+#include "stream_buffer.h"
+#include "texture_atlas.h"
+
+namespace gl {
+
+	struct Sprite
+	{
+		// Center, in the units of the projection given to Begin.
+		glm::vec2 position = glm::vec2(0.0f);
+		glm::vec2 size = glm::vec2(1.0f);
+		// Radians, around the center.
+		float rotation = 0.0f;
+		AtlasRegion region;
+		glm::vec4 color = glm::vec4(1.0f);
+		// Higher layers are drawn on top.
+		int layer = 0;
+	};
+
+	// Collects sprites between Begin and End. End sorts them by layer and
+	// texture, writes the quads straight into a StreamBuffer and issues one
+	// draw per run of the same texture, over a static index buffer shared by
+	// every quad. Layers are kept in order for blending, a run can span
+	// several layers as long as they use the same atlas page.
+	class SpriteBatch
+	{
+	public:
+		void Init(const std::string& path, std::size_t max_sprites = 128 * 1024);
+		void Destroy();
+		void Begin(const glm::mat4& projection);
+		// Sprites beyond max_sprites in a batch are dropped and counted.
+		void Draw(const Sprite& sprite);
+		void End();
+
+		std::size_t GetSpriteCount() const { return last_sprite_count_; }
+		std::size_t GetDrawCallCount() const { return last_draw_calls_; }
+		// CPU time spent in End: sort, vertex generation and submit.
+		float GetEndMilliseconds() const { return last_end_ms_; }
+		void DrawImGui() const;
+
+	protected:
+		void IsError(const char* file, int line) const;
+
+	protected:
+		struct SpriteVertex
+		{
+			glm::vec2 position;
+			glm::vec2 uv;
+			std::uint32_t color;
+		};
+
+		std::unique_ptr<Shader> shader_;
+		StreamBuffer stream_;
+		VertexArrayHandle vao_;
+		BufferHandle ebo_;
+		std::size_t max_sprites_ = 0;
+
+		glm::mat4 projection_ = glm::mat4(1.0f);
+		std::vector<Sprite> sprites_;
+		// Layer, texture and submission index packed for one integer sort.
+		std::vector<std::uint64_t> keys_;
+
+		std::size_t last_sprite_count_ = 0;
+		std::size_t last_draw_calls_ = 0;
+		std::size_t dropped_sprites_ = 0;
+		float last_end_ms_ = 0.0f;
+	};
+
+} // End namespace gl.
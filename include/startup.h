@@ -0,0 +1,134 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+	class JobSystem;
+
+	using StartupTaskId = std::size_t;
+
+	enum class StartupQueueEnum
+	{
+		// Serial step of the main thread, BeginSpan/EndSpan.
+		MAIN,
+		// Worker thread, as soon as the dependencies are done.
+		WORKER,
+		// Main thread, once the GL context is current.
+		GL,
+	};
+
+	// One span of the startup timeline, in ms since the process started.
+	struct StartupEvent
+	{
+		std::string name;
+		StartupQueueEnum queue = StartupQueueEnum::MAIN;
+		// 0 is the main thread, then the workers in order of appearance.
+		unsigned int thread = 0;
+		double begin_ms = 0.0;
+		double end_ms = 0.0;
+	};
+
+	// Loading as a dependency graph: file reads, image decoding and mesh
+	// parsing go to workers from the start of Engine::Init, before the
+	// window and the context exist, and the GL uploads depending on them
+	// are issued by the main thread as soon as both are ready. Everything
+	// is timed, the timeline is printed and saved as a Chrome trace
+	// (chrome://tracing, Perfetto) at the first frame.
+	class Startup
+	{
+	public:
+		static Startup& GetInstance();
+		~Startup();
+		Startup(const Startup&) = delete;
+		Startup& operator=(const Startup&) = delete;
+
+		// Runs task on a worker once the dependencies are done. Tasks are
+		// added from the main thread.
+		StartupTaskId AddTask(
+			const std::string& name,
+			std::function<void()> task,
+			const std::vector<StartupTaskId>& dependencies = {});
+		// Runs task on the main thread, with the context current, once the
+		// dependencies are done.
+		StartupTaskId AddGlTask(
+			const std::string& name,
+			std::function<void()> task,
+			const std::vector<StartupTaskId>& dependencies = {});
+		// Task prefetching the files of directory and of its SPIR-V
+		// counterpart (GetSpirvPath) through FileSystem::Prefetch, the
+		// blocks of the directory decompressed in parallel on the workers.
+		StartupTaskId AddPrefetch(const std::string& directory);
+		// Times serial work of the main thread, spans nest.
+		void BeginSpan(const std::string& name);
+		void EndSpan();
+		// The context is current, GL tasks may run from now on.
+		void SetContextReady();
+		// Runs the GL tasks ready now and returns, call it between the
+		// serial steps so uploads don't wait for the end.
+		void Pump();
+		// Runs the GL tasks as they become ready until every task is done,
+		// after SetContextReady. Rethrows the first exception of a task,
+		// the tasks depending on it are skipped.
+		void Finish();
+		// Prints the timeline to std::cout and writes the trace to
+		// GPR5300_STARTUP_TRACE (startup_trace.json, empty for none).
+		// Only the first call counts.
+		void MarkFirstFrame();
+		// Negative until MarkFirstFrame.
+		double GetTimeToFirstFrame() const { return first_frame_ms_; }
+		void PrintReport(std::ostream& os) const;
+		// Throws std::runtime_error if the file can't be written.
+		void WriteTrace(const std::string& path) const;
+
+	protected:
+		Startup();
+		struct Task
+		{
+			std::string name;
+			StartupQueueEnum queue = StartupQueueEnum::WORKER;
+			std::function<void()> function;
+			std::size_t remaining = 0;
+			std::vector<StartupTaskId> dependents;
+			bool done = false;
+			// A dependency failed, the task is skipped and fails too.
+			bool cancelled = false;
+		};
+		StartupTaskId Add(
+			const std::string& name,
+			StartupQueueEnum queue,
+			std::function<void()> task,
+			const std::vector<StartupTaskId>& dependencies);
+		// Under mutex_.
+		void MakeReady(StartupTaskId id);
+		unsigned int GetThreadIndex();
+		// On the thread of its queue.
+		void Run(StartupTaskId id);
+		bool RunReadyGlTask();
+
+	protected:
+		std::deque<Task> tasks_;
+		std::size_t pending_ = 0;
+		std::deque<StartupTaskId> ready_gl_;
+		bool context_ready_ = false;
+		std::exception_ptr error_;
+		std::unique_ptr<JobSystem> jobs_;
+		mutable std::mutex mutex_;
+		std::condition_variable changed_;
+		std::vector<std::thread::id> threads_;
+		std::vector<StartupEvent> events_;
+		std::vector<StartupEvent> spans_;
+		double first_frame_ms_ = -1.0;
+	};
+
+} // End namespace gl.
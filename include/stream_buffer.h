@@ -0,0 +1,123 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gpu_resource.h"
+
+namespace gl {
+
+	enum class StreamBufferModeEnum {
+		// glBufferStorage mapped persistent and coherent, one region per
+		// frame in flight, each guarded by a fence.
+		PERSISTENT,
+		// GLES without buffer storage: the buffer is orphaned every frame
+		// and Flush() uploads the written data with glBufferSubData.
+		ORPHANING
+	};
+
+	// What an allocation is bound as, decides its alignment.
+	enum class StreamUsageEnum {
+		VERTEX,
+		INDEX,
+		UNIFORM,
+		STORAGE
+	};
+
+	struct StreamAllocation
+	{
+		// Write the data here, valid until the end of the frame.
+		void* data = nullptr;
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+	};
+
+	// Ring buffer for data written every frame (instances, debug lines,
+	// sprites, per-draw uniforms) without re-specifying buffers and the
+	// implicit syncs that come with it.
+	//
+	//     stream.BeginFrame();
+	//     auto instances = stream.Push(models.data(), models.size(),
+	//         StreamUsageEnum::VERTEX);
+	//     stream.Flush();
+	//     // bind instances.buffer at instances.offset and draw
+	//     stream.EndFrame();
+	class StreamBuffer
+	{
+	public:
+		static constexpr int DEFAULT_FRAME_COUNT = 3;
+
+		// Persistent mapping when allowed and supported, orphaning else.
+		void Init(
+			std::size_t bytes_per_frame,
+			int frame_count = DEFAULT_FRAME_COUNT,
+			bool allow_persistent = true);
+		void Destroy();
+		// Waits for the GPU to be done with the region of this frame.
+		void BeginFrame();
+		// Fences the region, call once the draws using it are submitted.
+		void EndFrame();
+		// Throws std::runtime_error if the frame region is full.
+		StreamAllocation Allocate(std::size_t size, StreamUsageEnum usage);
+		StreamAllocation Allocate(std::size_t size, std::size_t alignment);
+		template <typename T>
+		StreamAllocation Push(
+			const T* data,
+			std::size_t count,
+			StreamUsageEnum usage)
+		{
+			StreamAllocation allocation = Allocate(count * sizeof(T), usage);
+			std::memcpy(allocation.data, data, count * sizeof(T));
+			return allocation;
+		}
+		// Makes the data written since the last call visible to the GL,
+		// call it before the draws reading it. Only does work when orphaning.
+		void Flush();
+		// For UNIFORM and STORAGE allocations.
+		void BindRange(
+			GLenum target,
+			GLuint index,
+			const StreamAllocation& allocation) const;
+
+		GLuint GetBuffer() const { return buffer_.Get(); }
+		StreamBufferModeEnum GetMode() const { return mode_; }
+		std::size_t GetBytesPerFrame() const { return region_size_; }
+		std::size_t GetLastFrameBytes() const { return last_frame_bytes_; }
+		std::size_t GetFenceWaitCount() const { return fence_wait_count_; }
+		void DrawImGui() const;
+
+	protected:
+		void IsError(const char* file, int line) const;
+		std::size_t GetAlignment(StreamUsageEnum usage) const;
+
+	protected:
+		StreamBufferModeEnum mode_ = StreamBufferModeEnum::PERSISTENT;
+		BufferHandle buffer_;
+		std::uint8_t* mapped_ = nullptr;
+		// CPU copy of the frame when orphaning.
+		std::vector<std::uint8_t> staging_;
+		std::vector<GLsync> fences_;
+		std::size_t region_size_ = 0;
+		int region_ = 0;
+		// Offsets inside the current region.
+		std::size_t head_ = 0;
+		std::size_t flushed_ = 0;
+		std::size_t uniform_alignment_ = 256;
+		std::size_t storage_alignment_ = 256;
+
+		std::size_t last_frame_bytes_ = 0;
+		std::size_t peak_frame_bytes_ = 0;
+		std::size_t allocation_count_ = 0;
+		std::size_t last_allocation_count_ = 0;
+		std::size_t fence_wait_count_ = 0;
+		float last_fence_wait_ms_ = 0.0f;
+		float total_fence_wait_ms_ = 0.0f;
+	};
+
+} // End namespace gl.
@@ -1,84 +1,107 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <string>
-#include <fstream>
+#include <vector>
 #include <glad/glad.h>
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "file_system.h"
+#include "gpu_backend.h"
+#include "gpu_resource.h"
+
 namespace gl {
 
+	// Pixels of an image file as stored, 3 or 4 channels of 8 bits.
+	struct ImageData
+	{
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		std::vector<std::uint8_t> pixels;
+	};
+
+	// Reads and decodes the file, no GL involved so it can run on any
+	// thread. Throws std::runtime_error if it can't be read or decoded.
+	inline ImageData DecodeImage(const std::string& file_name)
+	{
+		const FileData file = FileSystem::GetInstance().Read(file_name);
+		ImageData image;
+		unsigned char* pixels = stbi_load_from_memory(
+			file.GetData(),
+			static_cast<int>(file.GetSize()),
+			&image.width,
+			&image.height,
+			&image.channels,
+			0);
+		if (!pixels)
+		{
+			throw std::runtime_error("Could not decode image: " + file_name);
+		}
+		image.pixels.assign(
+			pixels,
+			pixels +
+			static_cast<std::size_t>(image.width) * image.height * image.channels);
+		stbi_image_free(pixels);
+		return image;
+	}
+
+	// Move-only, the texture is deleted with the object.
 	class Texture {
 	public:
-		unsigned int id;
-		Texture(const std::string& file_name)
+		Texture(const std::string& file_name) :
+			Texture(DecodeImage(file_name), file_name)
 		{
-			int width, height, nrChannels;
-			// stbi_set_flip_vertically_on_load(true);
-			unsigned char* dataDiffuse = stbi_load(
-				file_name.c_str(),
-				&width,
-				&height,
-				&nrChannels,
-				0);
-			assert(dataDiffuse);
-
-			glGenTextures(1, &id);
+		}
+		// Uploads an image decoded beforehand, label names it in the GPU
+		// resource registry.
+		Texture(const ImageData& image, const std::string& label)
+		{
+			const GpuBackend& backend = GpuBackend::GetInstance();
+			const bool rgba = image.channels == 4;
+			const GLenum internal_format = rgba ? GL_RGBA8 : GL_RGB8;
+			texture_.Create(label, GL_TEXTURE_2D);
+			texture_.SetBytes(EstimateTextureBytes(
+				internal_format,
+				image.width,
+				image.height));
 			IsError(__FILE__, __LINE__);
-			glBindTexture(GL_TEXTURE_2D, id);
+			const GLuint id = texture_.Get();
+			// Immutable, every level allocated now, 0 uploaded and the
+			// others generated from it.
+			backend.AllocateTexture2D(
+				id,
+				GetMipLevelCount(image.width, image.height),
+				internal_format,
+				image.width,
+				image.height);
 			IsError(__FILE__, __LINE__);
-			if (nrChannels == 3)
-			{
-				glTexImage2D(
-					GL_TEXTURE_2D,
-					0,
-					GL_RGB,
-					width,
-					height,
-					0,
-					GL_RGB,
-					GL_UNSIGNED_BYTE,
-					dataDiffuse);
-				IsError(__FILE__, __LINE__);
-			}
-			if (nrChannels == 4)
+			if (image.channels == 3 || rgba)
 			{
-				glTexImage2D(
-					GL_TEXTURE_2D,
-					0,
-					GL_RGBA,
-					width,
-					height,
+				backend.UpdateTexture2D(
+					id,
 					0,
-					GL_RGBA,
+					image.width,
+					image.height,
+					rgba ? GL_RGBA : GL_RGB,
 					GL_UNSIGNED_BYTE,
-					dataDiffuse);
+					image.pixels.data());
 				IsError(__FILE__, __LINE__);
 			}
-			glTexParameteri(
-				GL_TEXTURE_2D,
-				GL_TEXTURE_WRAP_S,
-				GL_MIRRORED_REPEAT);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(
-				GL_TEXTURE_2D,
-				GL_TEXTURE_WRAP_T,
-				GL_MIRRORED_REPEAT);
+			backend.SetTextureParameter(id, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
+			backend.SetTextureParameter(id, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+			backend.SetTextureParameter(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			backend.SetTextureParameter(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			IsError(__FILE__, __LINE__);
-			glBindTexture(GL_TEXTURE_2D, 0);
+			backend.GenerateMipmaps(id);
 			IsError(__FILE__, __LINE__);
 		}
+		GLuint GetId() const { return texture_.Get(); }
 		void Bind(unsigned int i = 0)
 		{
-			glActiveTexture(GL_TEXTURE0 + i);
-			IsError(__FILE__, __LINE__);
-			glBindTexture(GL_TEXTURE_2D, id);
+			GpuBackend::GetInstance().BindTexture(i, GL_TEXTURE_2D, texture_.Get());
 			IsError(__FILE__, __LINE__);
 		}
 		void UnBind()
@@ -86,6 +109,7 @@ namespace gl {
 			glBindTexture(GL_TEXTURE_2D, 0);
 		}
 	protected:
+		TextureHandle texture_;
 		void IsError(const char* file, int line) {
 			auto error_code = glGetError();
 			if (error_code != GL_NO_ERROR)
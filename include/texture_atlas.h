@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gpu_resource.h"
+
+namespace gl {
+
+	// Skyline bottom-left rectangle packer. Pure CPU, usable offline.
+	class RectanglePacker
+	{
+	public:
+		RectanglePacker(int width, int height);
+		// Finds a spot for the rectangle, false if it doesn't fit anymore.
+		bool Insert(int width, int height, glm::ivec2& position);
+		// Fraction of the area used.
+		float GetOccupancy() const;
+
+	protected:
+		struct SkylineNode
+		{
+			int x;
+			int y;
+			int width;
+		};
+		// Lowest y a rectangle can sit at starting on node index, -1 if it
+		// goes out of the page.
+		int Fit(std::size_t index, int width, int height) const;
+
+		int width_;
+		int height_;
+		std::size_t used_area_ = 0;
+		std::vector<SkylineNode> skyline_;
+	};
+
+	// Where an image ended up in the atlas.
+	struct AtlasRegion
+	{
+		GLuint texture = 0;
+		int page = 0;
+		glm::vec2 uv_min = glm::vec2(0.0f);
+		glm::vec2 uv_max = glm::vec2(1.0f);
+		// In texels.
+		glm::ivec2 size = glm::ivec2(0);
+	};
+
+	// Packs images into as few RGBA8 pages as possible at load time. Each
+	// image gets its border extruded into the padding so filtering doesn't
+	// bleed the neighbours in.
+	class TextureAtlas
+	{
+	public:
+		// Throws std::runtime_error if the file can't be read.
+		void Load(const std::string& file_name);
+		// Every .png, .jpg and .tga in the directory, named by file stem.
+		void LoadDirectory(const std::string& directory);
+		void Add(
+			const std::string& name,
+			int width,
+			int height,
+			const std::uint8_t* rgba);
+		// Packs everything added and uploads the pages. Throws if an image
+		// is larger than a page.
+		void Build(int page_size = 2048, int padding = 2);
+		void Destroy();
+
+		// Throws std::runtime_error if there is no such image.
+		const AtlasRegion& GetRegion(const std::string& name) const;
+		std::vector<std::string> GetNames() const;
+		std::size_t GetPageCount() const { return pages_.size(); }
+		float GetOccupancy() const { return occupancy_; }
+		void DrawImGui() const;
+
+	protected:
+		void IsError(const char* file, int line) const;
+
+	protected:
+		struct Image
+		{
+			std::string name;
+			int width = 0;
+			int height = 0;
+			std::vector<std::uint8_t> pixels;
+		};
+		std::vector<Image> images_;
+		std::vector<TextureHandle> pages_;
+		std::unordered_map<std::string, AtlasRegion> regions_;
+		int page_size_ = 0;
+		float occupancy_ = 0.0f;
+	};
+
+} // End namespace gl.
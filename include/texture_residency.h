@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gpu_resource.h"
+#include "shader.h"
+
+namespace gl {
+
+	enum class TextureResidencyModeEnum {
+		// Same sized RGBA8 textures share GL_TEXTURE_2D_ARRAY pages.
+		ARRAYS,
+		// Every texture gets an ARB_bindless_texture handle, with
+		// NV_gpu_shader5 to sample them from non-uniform indices.
+		BINDLESS
+	};
+
+	// Owns every material texture so draws reference them by index instead
+	// of binding them. The table of textures lives in an SSBO read by the
+	// shader with SampleTexture(index, uv), see
+	// data/shaders/hello_materials/materials.frag. With ARB_bindless_texture
+	// the table holds resident handles, otherwise it holds the page and layer
+	// of the texture and the pages are bound once to consecutive units.
+	class TextureResidency
+	{
+	public:
+		// Must match the GLSL side.
+		static constexpr GLuint TEXTURE_TABLE_BINDING = 5;
+		static constexpr int MAX_PAGES = 8;
+		static constexpr int MAX_LAYERS_PER_PAGE = 64;
+
+		// Picks bindless when allowed and supported, arrays otherwise.
+		void Init(bool allow_bindless = true);
+		void Destroy();
+		// Loads an image as RGBA8 and returns its texture index. Throws
+		// std::runtime_error if the file can't be read.
+		std::uint32_t Load(const std::string& file_name);
+		std::uint32_t Add(int width, int height, const std::uint8_t* rgba);
+		// Uploads the table and builds mipmaps of the pages touched since the
+		// last call, call it after adding textures.
+		void Commit();
+		// Sets the table binding, the mode and the page units (starting at
+		// first_unit) on the shader. Only needed once per program.
+		void Bind(const Shader& shader, int first_unit = 0) const;
+		TextureResidencyModeEnum GetMode() const { return mode_; }
+		std::size_t GetTextureCount() const { return entries_.size(); }
+		void DrawImGui() const;
+
+	protected:
+		void IsError(const char* file, int line) const;
+		std::uint32_t AddToPage(int width, int height, const std::uint8_t* rgba);
+		std::uint32_t AddBindless(int width, int height, const std::uint8_t* rgba);
+
+	protected:
+		// std430 layout of the GLSL TextureEntry.
+		struct TextureEntry
+		{
+			std::uint64_t handle = 0;
+			std::uint32_t page = 0;
+			std::uint32_t layer = 0;
+		};
+		struct Page
+		{
+			TextureHandle texture;
+			int width = 0;
+			int height = 0;
+			int layer_count = 0;
+			bool dirty = false;
+		};
+
+		TextureResidencyModeEnum mode_ = TextureResidencyModeEnum::ARRAYS;
+		std::vector<TextureEntry> entries_;
+		std::vector<Page> pages_;
+		// Bindless textures, one per entry.
+		std::vector<TextureHandle> textures_;
+		BufferHandle table_ssbo_;
+		int max_layers_ = MAX_LAYERS_PER_PAGE;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "gpu_resource.h"
+#include "job_system.h"
+
+namespace gl {
+
+	// Produces the RGBA8 pixels (width * height * 4 bytes) of one mip level.
+	// Called from worker threads.
+	using MipGenerator = std::function<std::vector<std::uint8_t>(
+		int level,
+		int width,
+		int height)>;
+
+	// RGBA8 textures whose fine mips are streamed in and out on demand.
+	//
+	// Only the mip tail (levels of TAIL_SIZE texels and below) is loaded up
+	// front. Every frame the draw list reports what it draws through
+	// Request(), which turns distance and UV density into the finest level
+	// the screen can show. Update() then schedules the next finer level of
+	// the textures that need it on the job system, uploads what finished
+	// and evicts the least recently needed levels when the budget is full.
+	//
+	// Textures use mutable storage so evicted levels really free memory.
+	// GL_TEXTURE_BASE_LEVEL points at the finest resident level, which keeps
+	// the texture complete, and GL_TEXTURE_MIN_LOD (relative to the base)
+	// fades a new level in over a few frames instead of popping.
+	class TextureStreamer
+	{
+	public:
+		static constexpr int TAIL_SIZE = 64;
+
+		TextureStreamer(JobSystem& jobs, std::size_t budget_bytes);
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// Reads the size of the image only, the pixels are decoded on
+		// workers when needed. Throws std::runtime_error if it's unreadable.
+		std::uint32_t Load(const std::string& file_name);
+		std::uint32_t Add(int width, int height, MipGenerator generator);
+		// Waits for the workers and frees every texture.
+		void Destroy();
+
+		// Call before the draw list is walked.
+		void BeginFrame(const Camera& camera, int viewport_height);
+		// Feedback from a draw using the texture: a bounding sphere and how
+		// many UV units map to one world unit on its surface.
+		void Request(
+			std::uint32_t texture,
+			const glm::vec3& center,
+			float radius,
+			float uv_density);
+		// Uploads finished levels, evicts and schedules new loads.
+		void Update(float dt);
+		void Bind(std::uint32_t texture, unsigned int unit = 0) const;
+
+		void SetBudget(std::size_t bytes) { budget_bytes_ = bytes; }
+		std::size_t GetBudget() const { return budget_bytes_; }
+		std::size_t GetResidentBytes() const { return resident_bytes_; }
+		// Bytes of every texture with all its levels resident.
+		std::size_t GetFullBytes() const;
+		std::size_t GetTextureCount() const { return textures_.size(); }
+		int GetResidentLevel(std::uint32_t texture) const
+		{
+			return textures_[texture].resident_level;
+		}
+		void DrawImGui();
+
+	protected:
+		void IsError(const char* file, int line) const;
+		static std::size_t LevelBytes(int width, int height, int level);
+
+	protected:
+		struct StreamedTexture
+		{
+			TextureHandle texture;
+			MipGenerator generator;
+			int width = 0;
+			int height = 0;
+			int level_count = 0;
+			// Levels from tail_level down are never evicted.
+			int tail_level = 0;
+			// Finest level uploaded, level_count while even the tail is
+			// still loading.
+			int resident_level = 0;
+			// Finest level wanted this frame.
+			int wanted_level = 0;
+			std::uint64_t last_needed_frame = 0;
+			bool loading = false;
+			// The generator threw, keep what is resident.
+			bool failed = false;
+			// How many levels above the base are still fading in.
+			float lod_fade = 0.0f;
+		};
+		// Levels [first_level, first_level + pixels.size()) of a texture.
+		struct LoadResult
+		{
+			std::uint32_t texture = 0;
+			int first_level = 0;
+			// Empty if the generator threw.
+			std::vector<std::vector<std::uint8_t>> pixels;
+			int failed_level_count = 0;
+		};
+
+		void ScheduleLoad(std::uint32_t index, int first_level, int last_level);
+		void Upload(LoadResult& result);
+		// Drops the finest resident level of the least recently needed
+		// texture that has one to spare, false if nothing can go.
+		bool EvictOne(bool allow_needed);
+		void SetResidentLevel(StreamedTexture& texture, int level);
+
+		JobSystem& jobs_;
+		std::vector<StreamedTexture> textures_;
+		TextureHandle fallback_;
+		std::mutex result_mutex_;
+		std::deque<LoadResult> results_;
+
+		std::size_t budget_bytes_ = 0;
+		std::size_t resident_bytes_ = 0;
+		// Reserved by the loads in flight.
+		std::size_t pending_bytes_ = 0;
+		// Client memory uploads stall the main thread, cap them per frame.
+		std::size_t upload_bytes_per_frame_ = 16 * 1024 * 1024;
+		int max_loads_in_flight_ = 8;
+		int loads_in_flight_ = 0;
+		// Levels per second for the GL_TEXTURE_MIN_LOD fade.
+		float fade_speed_ = 2.0f;
+		// Added to the computed level, positive is blurrier.
+		float lod_bias_ = 0.0f;
+
+		glm::vec3 camera_position_ = glm::vec3(0.0f);
+		float pixels_per_unit_at_one_ = 1.0f;
+		std::uint64_t frame_ = 0;
+
+		std::size_t uploaded_last_frame_ = 0;
+		std::size_t evicted_last_frame_ = 0;
+		std::size_t uploaded_total_ = 0;
+		std::size_t evicted_total_ = 0;
+	};
+
+} // End namespace gl.
@@ -0,0 +1,415 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "engine.h"
+#include "gpu_resource.h"
+#include "camera.h"
+#include "texture.h"
+#include "shader.h"
+#include "light.h"
+#include "render_queue.h"
+#include "startup.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Stress scene for the clustered lighting: a floor and a field of
+	// pillars lit by thousands of small moving point lights.
+	class HelloClustered : public Program
+	{
+	public:
+		void Preload() override;
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void CreateMesh(
+			const std::vector<float>& vertices,
+			const std::vector<std::uint32_t>& indices,
+			VertexArrayHandle& vao,
+			BufferHandle& vbo,
+			BufferHandle& ebo);
+		void GenerateLights();
+		void AnimateLights();
+
+	protected:
+		VertexArrayHandle cube_vao_;
+		BufferHandle cube_vbo_;
+		BufferHandle cube_ebo_;
+		VertexArrayHandle floor_vao_;
+		BufferHandle floor_vbo_;
+		BufferHandle floor_ebo_;
+		DepthStream cube_depth_;
+		DepthStream floor_depth_;
+
+		float time_ = 0.0f;
+		float delta_time_ = 0.0f;
+		int light_count_ = 4096;
+		bool animate_lights_ = true;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		// Decoded on a worker, freed once uploaded.
+		ImageData diffuse_image_;
+		std::unique_ptr<Texture> texture_diffuse_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<ClusteredLighting> lighting_ = nullptr;
+		std::unique_ptr<RenderQueue> render_queue_ = nullptr;
+
+		// Base position of each light, the animation circles around it.
+		std::vector<glm::vec4> light_origins_;
+		std::vector<PointLight> lights_;
+		std::vector<glm::mat4> pillar_models_;
+
+		glm::mat4 view_ = glm::mat4(1.0f);
+		glm::mat4 projection_ = glm::mat4(1.0f);
+
+		const float z_near_ = 0.1f;
+		const float z_far_ = 200.0f;
+	};
+
+	void HelloClustered::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloClustered::CreateMesh(
+		const std::vector<float>& vertices,
+		const std::vector<std::uint32_t>& indices,
+		VertexArrayHandle& vao,
+		BufferHandle& vbo,
+		BufferHandle& ebo)
+	{
+		vao.Create("HelloClustered vertex array");
+		IsError(__FILE__, __LINE__);
+		glBindVertexArray(vao.Get());
+		IsError(__FILE__, __LINE__);
+
+		ebo.Create("HelloClustered indices");
+		ebo.SetBytes(indices.size() * sizeof(std::uint32_t));
+		IsError(__FILE__, __LINE__);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo.Get());
+		IsError(__FILE__, __LINE__);
+		glBufferData(
+			GL_ELEMENT_ARRAY_BUFFER,
+			indices.size() * sizeof(std::uint32_t),
+			indices.data(),
+			GL_STATIC_DRAW);
+		IsError(__FILE__, __LINE__);
+
+		vbo.Create("HelloClustered vertices");
+		vbo.SetBytes(vertices.size() * sizeof(float));
+		IsError(__FILE__, __LINE__);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo.Get());
+		IsError(__FILE__, __LINE__);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			vertices.size() * sizeof(float),
+			vertices.data(),
+			GL_STATIC_DRAW);
+		IsError(__FILE__, __LINE__);
+
+		GLintptr vertex_normal_offset = 3 * sizeof(float);
+		GLintptr vertex_tex_offset = 6 * sizeof(float);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
+		IsError(__FILE__, __LINE__);
+		glVertexAttribPointer(
+			1,
+			3,
+			GL_FLOAT,
+			GL_FALSE,
+			8 * sizeof(float),
+			(GLvoid*)vertex_normal_offset);
+		IsError(__FILE__, __LINE__);
+		glVertexAttribPointer(
+			2,
+			2,
+			GL_FLOAT,
+			GL_FALSE,
+			8 * sizeof(float),
+			(GLvoid*)vertex_tex_offset);
+		IsError(__FILE__, __LINE__);
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		IsError(__FILE__, __LINE__);
+
+		glBindVertexArray(0);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloClustered::Preload()
+	{
+		auto& startup = Startup::GetInstance();
+		const std::string texture = "../data/textures/texture_diffuse.jpg";
+		const StartupTaskId decode = startup.AddTask(
+			"Decode " + texture,
+			[this, texture] { diffuse_image_ = DecodeImage(texture); });
+		startup.AddGlTask(
+			"Upload " + texture,
+			[this, texture] {
+				texture_diffuse_ = std::make_unique<Texture>(
+					diffuse_image_,
+					texture);
+				diffuse_image_ = ImageData();
+			},
+			{ decode });
+		startup.AddPrefetch("../data/shaders/hello_light");
+		startup.AddPrefetch("../data/shaders/clustered");
+	}
+
+	void HelloClustered::Init()
+	{
+		// Unit cube, 4 vertices per face so normals stay flat.
+		std::vector<float> cube_vertices;
+		std::vector<std::uint32_t> cube_indices;
+		const std::array<glm::vec3, 6> normals = {
+			glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0),
+			glm::vec3(0, 1, 0), glm::vec3(0, -1, 0),
+			glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+		};
+		for (const auto& n : normals)
+		{
+			const glm::vec3 u = glm::vec3(n.y, n.z, n.x);
+			const glm::vec3 v = glm::cross(n, u);
+			const auto base = static_cast<std::uint32_t>(
+				cube_vertices.size() / 8);
+			const std::array<glm::vec2, 4> corners = {
+				glm::vec2(-1, -1), glm::vec2(1, -1),
+				glm::vec2(1, 1), glm::vec2(-1, 1)
+			};
+			for (const auto& c : corners)
+			{
+				const glm::vec3 p = (n + u * c.x + v * c.y) * 0.5f;
+				cube_vertices.insert(
+					cube_vertices.end(),
+					{ p.x, p.y, p.z, n.x, n.y, n.z,
+					  c.x * 0.5f + 0.5f, c.y * 0.5f + 0.5f });
+			}
+			cube_indices.insert(
+				cube_indices.end(),
+				{ base, base + 1, base + 2, base, base + 2, base + 3 });
+		}
+		CreateMesh(cube_vertices, cube_indices, cube_vao_, cube_vbo_, cube_ebo_);
+
+		const float half = 60.0f;
+		std::vector<float> floor_vertices = {
+			-half, 0.0f, -half, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+			 half, 0.0f, -half, 0.0f, 1.0f, 0.0f, 30.0f, 0.0f,
+			 half, 0.0f,  half, 0.0f, 1.0f, 0.0f, 30.0f, 30.0f,
+			-half, 0.0f,  half, 0.0f, 1.0f, 0.0f, 0.0f, 30.0f
+		};
+		std::vector<std::uint32_t> floor_indices = { 0, 2, 1, 0, 3, 2 };
+		CreateMesh(
+			floor_vertices,
+			floor_indices,
+			floor_vao_,
+			floor_vbo_,
+			floor_ebo_);
+
+		for (int x = -8; x < 8; ++x)
+		{
+			for (int z = -8; z < 8; ++z)
+			{
+				glm::mat4 model = glm::translate(
+					glm::mat4(1.0f),
+					glm::vec3(x * 6.0f + 3.0f, 2.0f, z * 6.0f + 3.0f));
+				pillar_models_.push_back(
+					glm::scale(model, glm::vec3(1.0f, 4.0f, 1.0f)));
+			}
+		}
+
+		camera_ = std::make_unique<Camera>(glm::vec3(0.0f, 6.0f, 30.0f));
+
+		std::string path = "../";
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_light/lightShader.vert",
+			path + "data/shaders/hello_light/lightShader.frag");
+
+		lighting_ = std::make_unique<ClusteredLighting>();
+		lighting_->Init(path);
+		GenerateLights();
+
+		render_queue_ = std::make_unique<RenderQueue>();
+		render_queue_->Init(path);
+		cube_depth_ = render_queue_->CreateDepthStream(
+			cube_vertices,
+			8,
+			cube_ebo_.Get());
+		floor_depth_ = render_queue_->CreateDepthStream(
+			floor_vertices,
+			8,
+			floor_ebo_.Get());
+
+		shaders_->Use();
+		texture_diffuse_->Bind(0);
+		shaders_->SetInt("textureDiffuse", 0);
+
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloClustered::GenerateLights()
+	{
+		// Fixed seed so runs are comparable.
+		std::mt19937 rng(5300);
+		std::uniform_real_distribution<float> position(-55.0f, 55.0f);
+		std::uniform_real_distribution<float> height(0.3f, 3.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const int count = std::min<int>(light_count_, lighting_->GetMaxLights());
+		light_origins_.resize(count);
+		lights_.resize(count);
+		for (int i = 0; i < count; ++i)
+		{
+			light_origins_[i] = glm::vec4(
+				position(rng),
+				height(rng),
+				position(rng),
+				unit(rng) * glm::pi<float>() * 2.0f);
+			lights_[i].color_intensity = glm::vec4(
+				unit(rng),
+				unit(rng),
+				unit(rng),
+				6.0f);
+		}
+		AnimateLights();
+	}
+
+	void HelloClustered::AnimateLights()
+	{
+		for (std::size_t i = 0; i < lights_.size(); ++i)
+		{
+			const glm::vec4& origin = light_origins_[i];
+			const float phase = origin.w + time_;
+			lights_[i].position_radius = glm::vec4(
+				origin.x + std::cos(phase) * 1.5f,
+				origin.y,
+				origin.z + std::sin(phase) * 1.5f,
+				3.0f);
+		}
+		lighting_->SetLights(lights_);
+	}
+
+	void HelloClustered::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		camera_->ProcessKeyboardState(20.0f * delta_time_);
+		time_ += delta_time_;
+		if (animate_lights_)
+		{
+			AnimateLights();
+		}
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::vec2 screen_size(viewport[2], viewport[3]);
+		view_ = camera_->GetViewMatrix();
+		projection_ = glm::perspective(
+			glm::radians(camera_->Zoom),
+			screen_size.x / screen_size.y,
+			z_near_,
+			z_far_);
+		lighting_->Update(view_, projection_, screen_size, z_near_, z_far_);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		IsError(__FILE__, __LINE__);
+		shaders_->Use();
+		lighting_->Bind(*shaders_);
+		shaders_->SetMat4("view", view_);
+		shaders_->SetMat4("projection", projection_);
+		shaders_->SetVec3("camera_pos", camera_->position);
+		texture_diffuse_->Bind(0);
+
+		DrawItem floor_item;
+		floor_item.vao = floor_vao_.Get();
+		floor_item.depth_vao = floor_depth_.vao.Get();
+		floor_item.index_count = 6;
+		render_queue_->Submit(floor_item);
+		for (const auto& model : pillar_models_)
+		{
+			DrawItem pillar_item;
+			pillar_item.vao = cube_vao_.Get();
+			pillar_item.depth_vao = cube_depth_.vao.Get();
+			pillar_item.index_count = 36;
+			pillar_item.model = model;
+			render_queue_->Submit(pillar_item);
+		}
+		render_queue_->Flush(view_, projection_, *shaders_);
+	}
+
+	void HelloClustered::Destroy()
+	{
+		lighting_->Destroy();
+		render_queue_->DestroyDepthStream(cube_depth_);
+		render_queue_->DestroyDepthStream(floor_depth_);
+		render_queue_->Destroy();
+		cube_vao_.Reset();
+		cube_vbo_.Reset();
+		cube_ebo_.Reset();
+		floor_vao_.Reset();
+		floor_vbo_.Reset();
+		floor_ebo_.Reset();
+		shaders_.reset();
+		texture_diffuse_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloClustered::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloClustered::DrawImGui()
+	{
+		ImGui::Begin("Clustered lighting");
+		lighting_->DrawImGui();
+		ImGui::SliderInt(
+			"Light count",
+			&light_count_,
+			1,
+			static_cast<int>(lighting_->GetMaxLights()));
+		if (ImGui::Button("Regenerate lights"))
+		{
+			GenerateLights();
+		}
+		ImGui::Checkbox("Animate lights", &animate_lights_);
+		ImGui::End();
+		ImGui::Begin("Render queue");
+		render_queue_->DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloClustered program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "shader.h"
+#include "mesh.h"
+#include "command_list.h"
+#include "command_replayer.h"
+#include "job_system.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Tens of thousands of spinning cubes and spheres, one draw each,
+	// submitted either immediately (the matrix math and the GL calls
+	// interleaved on the main thread) or recorded into one command list per
+	// job in parallel and replayed on the main thread. The benchmark
+	// compares the CPU time of both at 50k draws over 8 threads.
+	class HelloCommandLists : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		// Transform and color of the object at this time.
+		glm::mat4 GetModel(int index) const;
+		glm::vec3 GetColor(int index) const;
+		void SubmitImmediate();
+		void Record(CommandList& list, int begin, int end) const;
+		void SubmitCommandLists();
+
+	protected:
+		enum class SubmitModeEnum
+		{
+			IMMEDIATE,
+			COMMAND_LISTS,
+		};
+
+		Mesh cube_;
+		Mesh sphere_;
+		std::unique_ptr<Shader> shader_ = nullptr;
+		std::unique_ptr<JobSystem> jobs_ = nullptr;
+		std::vector<CommandList> lists_;
+		CommandReplayer replayer_;
+		GLint model_location_ = -1;
+		GLint color_location_ = -1;
+
+		SubmitModeEnum mode_ = SubmitModeEnum::COMMAND_LISTS;
+		int object_count_ = 50000;
+		int list_count_ = 8;
+		int side_ = 1;
+		float time_ = 0.0f;
+		// CPU times of the last frame.
+		float submit_ms_ = 0.0f;
+		float record_ms_ = 0.0f;
+		float replay_ms_ = 0.0f;
+
+		// Benchmark, immediate then command lists, frames each.
+		static constexpr int BENCHMARK_FRAMES = 120;
+		int benchmark_frame_ = -1;
+		float benchmark_immediate_ms_ = 0.0f;
+		float benchmark_record_ms_ = 0.0f;
+		float benchmark_total_ms_ = 0.0f;
+		bool benchmark_done_ = false;
+		const glm::vec3 light_direction_ =
+			glm::normalize(glm::vec3(-1.0f, -2.0f, -1.0f));
+	};
+
+	void HelloCommandLists::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloCommandLists::Init()
+	{
+		std::string path = "../";
+
+		cube_.Init(CreateCube());
+		sphere_.Init(CreateSphere(12, 6));
+		shader_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_command_lists/scene.vert",
+			path + "data/shaders/hello_command_lists/scene.frag");
+		// Workers can't look locations up, they have no context.
+		model_location_ = shader_->GetUniformLocation("model");
+		color_location_ = shader_->GetUniformLocation("color");
+		// 7 workers and the main thread.
+		jobs_ = std::make_unique<JobSystem>(7);
+		IsError(__FILE__, __LINE__);
+	}
+
+	glm::mat4 HelloCommandLists::GetModel(int index) const
+	{
+		const float spacing = 1.5f;
+		const glm::vec3 position(
+			(index % side_ - side_ * 0.5f) * spacing,
+			0.0f,
+			(index / side_ - side_ * 0.5f) * spacing);
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		model = glm::rotate(
+			model,
+			time_ + index * 0.01f,
+			glm::normalize(glm::vec3(1.0f, 1.0f + index % 3, 0.5f)));
+		return model;
+	}
+
+	glm::vec3 HelloCommandLists::GetColor(int index) const
+	{
+		return glm::vec3(
+			0.5f + 0.5f * std::sin(index * 0.37f),
+			0.5f + 0.5f * std::sin(index * 0.11f + 2.0f),
+			0.5f + 0.5f * std::sin(index * 0.07f + 4.0f));
+	}
+
+	void HelloCommandLists::SubmitImmediate()
+	{
+		// What every demo does today, uniforms set by name.
+		for (int i = 0; i < object_count_; ++i)
+		{
+			shader_->SetMat4("model", GetModel(i));
+			shader_->SetVec3("color", GetColor(i));
+			const Mesh& mesh = (i % 8 == 0) ? sphere_ : cube_;
+			mesh.Draw();
+		}
+		glBindVertexArray(0);
+	}
+
+	void HelloCommandLists::Record(CommandList& list, int begin, int end) const
+	{
+		list.Reset();
+		list.BindProgram(shader_->GetId());
+		for (int i = begin; i < end; ++i)
+		{
+			const Mesh& mesh = (i % 8 == 0) ? sphere_ : cube_;
+			list.BindVertexArray(mesh.GetVao());
+			list.SetMat4(model_location_, GetModel(i));
+			list.SetVec3(color_location_, GetColor(i));
+			list.DrawIndexed(
+				PrimitiveEnum::TRIANGLES,
+				static_cast<std::uint32_t>(mesh.GetIndexCount()));
+		}
+	}
+
+	void HelloCommandLists::SubmitCommandLists()
+	{
+		if (static_cast<int>(lists_.size()) != list_count_)
+		{
+			lists_.resize(list_count_);
+		}
+		const auto start = std::chrono::high_resolution_clock::now();
+		const int per_list = (object_count_ + list_count_ - 1) / list_count_;
+		jobs_->ParallelFor(
+			lists_.size(),
+			1,
+			[this, per_list](std::size_t begin, std::size_t end) {
+				for (std::size_t list = begin; list < end; ++list)
+				{
+					const int first = static_cast<int>(list) * per_list;
+					Record(
+						lists_[list],
+						std::min(first, object_count_),
+						std::min(first + per_list, object_count_));
+				}
+			});
+		const auto recorded = std::chrono::high_resolution_clock::now();
+		replayer_.Begin();
+		replayer_.Replay(lists_);
+		replayer_.End();
+		const auto replayed = std::chrono::high_resolution_clock::now();
+		record_ms_ = std::chrono::duration<float, std::milli>(
+			recorded - start).count();
+		replay_ms_ = std::chrono::duration<float, std::milli>(
+			replayed - recorded).count();
+	}
+
+	void HelloCommandLists::Update(seconds dt)
+	{
+		time_ += dt.count();
+		side_ = static_cast<int>(std::ceil(std::sqrt(object_count_)));
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const float aspect =
+			static_cast<float>(std::max(viewport[2], 1)) /
+			static_cast<float>(std::max(viewport[3], 1));
+		const float extent = side_ * 1.5f;
+		const glm::mat4 view = glm::lookAt(
+			glm::vec3(0.0f, extent * 0.6f, extent * 0.7f),
+			glm::vec3(0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(45.0f),
+			aspect,
+			0.1f,
+			extent * 3.0f);
+
+		// The benchmark runs each mode for BENCHMARK_FRAMES frames.
+		if (benchmark_frame_ >= 0)
+		{
+			mode_ = benchmark_frame_ < BENCHMARK_FRAMES ?
+				SubmitModeEnum::IMMEDIATE : SubmitModeEnum::COMMAND_LISTS;
+		}
+
+		glEnable(GL_DEPTH_TEST);
+		shader_->Use();
+		shader_->SetMat4("view", view);
+		shader_->SetMat4("projection", projection);
+		shader_->SetVec3("light_direction", light_direction_);
+		const auto start = std::chrono::high_resolution_clock::now();
+		if (mode_ == SubmitModeEnum::IMMEDIATE)
+		{
+			SubmitImmediate();
+		}
+		else
+		{
+			SubmitCommandLists();
+		}
+		glUseProgram(0);
+		submit_ms_ = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+
+		if (benchmark_frame_ >= 0)
+		{
+			if (mode_ == SubmitModeEnum::IMMEDIATE)
+			{
+				benchmark_immediate_ms_ += submit_ms_ / BENCHMARK_FRAMES;
+			}
+			else
+			{
+				benchmark_record_ms_ += record_ms_ / BENCHMARK_FRAMES;
+				benchmark_total_ms_ += submit_ms_ / BENCHMARK_FRAMES;
+			}
+			if (++benchmark_frame_ == BENCHMARK_FRAMES * 2)
+			{
+				benchmark_frame_ = -1;
+				benchmark_done_ = true;
+			}
+		}
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloCommandLists::Destroy()
+	{
+		jobs_.reset();
+		lists_.clear();
+		cube_.Destroy();
+		sphere_.Destroy();
+		shader_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloCommandLists::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloCommandLists::DrawImGui()
+	{
+		ImGui::Begin("Command lists");
+		int mode = static_cast<int>(mode_);
+		ImGui::RadioButton("Immediate", &mode, 0);
+		ImGui::SameLine();
+		ImGui::RadioButton("Command lists", &mode, 1);
+		if (benchmark_frame_ < 0) mode_ = static_cast<SubmitModeEnum>(mode);
+		ImGui::SliderInt("Draws", &object_count_, 1000, 100000);
+		ImGui::SliderInt("Lists (jobs)", &list_count_, 1, 32);
+		ImGui::Text("Threads: %u workers and the main thread", jobs_->GetWorkerCount());
+		ImGui::Text("Submit CPU: %.3f ms", submit_ms_);
+		if (mode_ == SubmitModeEnum::COMMAND_LISTS)
+		{
+			ImGui::Text(
+				"Record %.3f ms, replay %.3f ms",
+				record_ms_,
+				replay_ms_);
+			std::size_t bytes = 0;
+			for (const auto& list : lists_) bytes += list.GetSize();
+			ImGui::Text(
+				"%zu commands, %zu draws, %zu binds filtered, %.1f KB",
+				replayer_.GetCommandCount(),
+				replayer_.GetDrawCount(),
+				replayer_.GetFilteredCount(),
+				bytes / 1024.0);
+		}
+		if (benchmark_frame_ >= 0)
+		{
+			ImGui::Text(
+				"Benchmark running, frame %d / %d",
+				benchmark_frame_,
+				BENCHMARK_FRAMES * 2);
+		}
+		else if (ImGui::Button("Benchmark 50k draws, 8 lists"))
+		{
+			object_count_ = 50000;
+			list_count_ = 8;
+			benchmark_frame_ = 0;
+			benchmark_immediate_ms_ = 0.0f;
+			benchmark_record_ms_ = 0.0f;
+			benchmark_total_ms_ = 0.0f;
+			benchmark_done_ = false;
+		}
+		if (benchmark_done_)
+		{
+			ImGui::Text("Immediate: %.3f ms", benchmark_immediate_ms_);
+			ImGui::Text(
+				"Command lists: record %.3f ms (%.1fx faster), with replay %.3f ms",
+				benchmark_record_ms_,
+				benchmark_immediate_ms_ / std::max(benchmark_record_ms_, 1e-3f),
+				benchmark_total_ms_);
+		}
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloCommandLists program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,274 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "shader.h"
+#include "mesh.h"
+#include "gpu_resource.h"
+#include "gpu_culling.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// A city of up to a million buildings and floating spheres, culled and
+	// turned into draws on the GPU. The camera drives down the streets, so
+	// the buildings along them hide most of the city from the Hi-Z test.
+	// The CPU time of the frame stays the same whatever the object count.
+	class HelloGpuCulling : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void GenerateCity();
+		void ResizeTarget(glm::ivec2 size);
+
+	protected:
+		enum MeshIndex : std::uint32_t
+		{
+			CUBE,
+			SPHERE,
+			GROUND,
+		};
+
+		GpuCuller culler_;
+		FramebufferHandle fbo_;
+		TextureHandle color_;
+		TextureHandle depth_;
+		glm::ivec2 target_size_ = glm::ivec2(0);
+		std::unique_ptr<Shader> scene_shader_ = nullptr;
+
+		float time_ = 0.0f;
+		bool move_camera_ = true;
+		float city_size_ = 0.0f;
+		float frame_cpu_ms_ = 0.0f;
+		int count_index_ = 2;
+		static constexpr std::array<int, 4> COUNTS = {
+			1000, 10000, 100000, 1000000 };
+		static constexpr float SPACING = 4.0f;
+		const glm::vec3 light_direction_ =
+			glm::normalize(glm::vec3(-1.0f, -2.0f, -0.5f));
+	};
+
+	void HelloGpuCulling::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloGpuCulling::Init()
+	{
+		std::string path = "../";
+
+		culler_.Init(path, COUNTS.back() + 1);
+		if (!culler_.IsSupported())
+		{
+			std::cerr << "GPU culling needs OpenGL 4.3.\n";
+			return;
+		}
+		culler_.SetMeshes({ CreateCube(), CreateSphere(16, 8), CreatePlane(1.0f) });
+		scene_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_gpu_culling/scene.vert",
+			path + "data/shaders/hello_gpu_culling/scene.frag");
+		GenerateCity();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloGpuCulling::GenerateCity()
+	{
+		culler_.ClearObjects();
+		std::mt19937 rng(5300);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const int count = COUNTS[count_index_];
+		const int side = static_cast<int>(std::ceil(std::sqrt(count)));
+		city_size_ = side * SPACING;
+		const float half = city_size_ * 0.5f;
+		culler_.AddObject(
+			GROUND,
+			glm::scale(glm::mat4(1.0f), glm::vec3(city_size_, 1.0f, city_size_)));
+		for (int i = 0; i < count; ++i)
+		{
+			const glm::vec3 cell(
+				(i % side) * SPACING - half + SPACING * 0.5f,
+				0.0f,
+				(i / side) * SPACING - half + SPACING * 0.5f);
+			// Every fourth object floats over the street corner.
+			if (i % 4 == 3)
+			{
+				const glm::vec3 position =
+					cell + glm::vec3(SPACING * 0.5f, 3.0f + unit(rng) * 4.0f, SPACING * 0.5f);
+				culler_.AddObject(
+					SPHERE,
+					glm::scale(
+						glm::translate(glm::mat4(1.0f), position),
+						glm::vec3(0.6f)));
+				continue;
+			}
+			const float height = 1.0f + unit(rng) * unit(rng) * 14.0f;
+			glm::mat4 model = glm::translate(
+				glm::mat4(1.0f),
+				cell + glm::vec3(0.0f, height * 0.5f, 0.0f));
+			model = glm::rotate(model, unit(rng) * 0.3f, glm::vec3(0.0f, 1.0f, 0.0f));
+			model = glm::scale(model, glm::vec3(2.6f, height, 2.6f));
+			culler_.AddObject(CUBE, model);
+		}
+	}
+
+	void HelloGpuCulling::ResizeTarget(glm::ivec2 size)
+	{
+		if (size == target_size_) return;
+		target_size_ = size;
+		color_.Create("HelloGpuCulling color");
+		color_.SetBytes(EstimateTextureBytes(GL_RGBA16F, size.x, size.y));
+		glBindTexture(GL_TEXTURE_2D, color_.Get());
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, size.x, size.y);
+		depth_.Create("HelloGpuCulling depth");
+		depth_.SetBytes(EstimateTextureBytes(GL_DEPTH_COMPONENT32F, size.x, size.y));
+		glBindTexture(GL_TEXTURE_2D, depth_.Get());
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		GLint framebuffer = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+		fbo_.Create("HelloGpuCulling");
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo_.Get());
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D,
+			color_.Get(),
+			0);
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_DEPTH_ATTACHMENT,
+			GL_TEXTURE_2D,
+			depth_.Get(),
+			0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << "Scene framebuffer incomplete.\n";
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloGpuCulling::Update(seconds dt)
+	{
+		if (!culler_.IsSupported()) return;
+		const auto start = std::chrono::high_resolution_clock::now();
+		if (move_camera_) time_ += dt.count();
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::ivec2 size(std::max(viewport[2], 1), std::max(viewport[3], 1));
+		ResizeTarget(size);
+
+		// Down a street between two rows of buildings, looking along it.
+		const float street = std::fmod(time_ * 6.0f, city_size_) - city_size_ * 0.5f;
+		const glm::vec3 eye(SPACING * 0.5f, 2.0f, street);
+		const glm::vec3 target =
+			eye + glm::vec3(std::sin(time_ * 0.3f) * 0.6f, 0.0f, 1.0f);
+		const glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(60.0f),
+			static_cast<float>(size.x) / static_cast<float>(size.y),
+			0.1f,
+			std::max(city_size_ * 1.5f, 100.0f));
+
+		culler_.Cull(view, projection);
+
+		GLint framebuffer = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo_.Get());
+		glClearColor(0.5f, 0.6f, 0.75f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_DEPTH_TEST);
+		scene_shader_->Use();
+		scene_shader_->SetMat4("view", view);
+		scene_shader_->SetMat4("projection", projection);
+		scene_shader_->SetVec3("light_direction", light_direction_);
+		culler_.Draw();
+		glUseProgram(0);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_.Get());
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+		glBlitFramebuffer(
+			0, 0, size.x, size.y,
+			0, 0, size.x, size.y,
+			GL_COLOR_BUFFER_BIT,
+			GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		// Occluders for the next frame.
+		culler_.UpdateDepthPyramid(depth_.Get(), size);
+		frame_cpu_ms_ = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloGpuCulling::Destroy()
+	{
+		culler_.Destroy();
+		fbo_.Reset();
+		color_.Reset();
+		depth_.Reset();
+		target_size_ = glm::ivec2(0);
+		scene_shader_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloGpuCulling::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloGpuCulling::DrawImGui()
+	{
+		ImGui::Begin("GPU culling");
+		static constexpr const char* count_names[] = {
+			"1k", "10k", "100k", "1M" };
+		if (ImGui::Combo("Objects", &count_index_, count_names, 4) &&
+			culler_.IsSupported())
+		{
+			GenerateCity();
+		}
+		ImGui::Checkbox("Move camera", &move_camera_);
+		ImGui::Text("CPU frame (cull, draw, pyramid): %.3f ms", frame_cpu_ms_);
+		culler_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloGpuCulling program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <SDL_main.h>
 #include <glad/glad.h>
+#include <algorithm>
 #include <array>
 #include <string>
 #include <iostream>
@@ -9,9 +10,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "engine.h"
+#include "gpu_resource.h"
 #include "camera.h"
 #include "texture.h"
 #include "shader.h"
+#include "light.h"
+#include "imgui.h"
 
 namespace gl {
 
@@ -32,9 +36,9 @@ namespace gl {
 		void SetUniformMatrix() const;
 
 	protected:
-		unsigned int VAO_;
-		unsigned int VBO_;
-		unsigned int EBO_;
+		VertexArrayHandle VAO_;
+		BufferHandle VBO_;
+		BufferHandle EBO_;
 		unsigned int vertex_shader_;
 		unsigned int fragment_shader_;
 		unsigned int program_;
@@ -45,6 +49,7 @@ namespace gl {
 		std::unique_ptr<Camera> camera_ = nullptr;
 		std::unique_ptr<Texture> texture_diffuse_ = nullptr;
 		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<ClusteredLighting> lighting_ = nullptr;
 
 		glm::mat4 model_ = glm::mat4(1.0f);
 		glm::mat4 view_ = glm::mat4(1.0f);
@@ -82,15 +87,16 @@ namespace gl {
 		camera_ = std::make_unique<Camera>(glm::vec3(.0f, .0f, 2.0f));
 
 		// VAO binding should be before VAO.
-		glGenVertexArrays(1, &VAO_);
+		VAO_.Create("HelloLight vertex array");
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 
 		// EBO.
-		glGenBuffers(1, &EBO_);
+		EBO_.Create("HelloLight indices");
+		EBO_.SetBytes(indices.size() * sizeof(std::uint32_t));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ELEMENT_ARRAY_BUFFER,
@@ -102,9 +108,10 @@ namespace gl {
 		IsError(__FILE__, __LINE__);
 
 		// VBO.
-		glGenBuffers(1, &VBO_);
+		VBO_.Create("HelloLight vertices");
+		VBO_.SetBytes(vertices.size() * sizeof(float));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ARRAY_BUFFER,
@@ -158,6 +165,15 @@ namespace gl {
 			path + "data/shaders/hello_light/lightShader.vert",
 			path + "data/shaders/hello_light/lightShader.frag");
 
+		lighting_ = std::make_unique<ClusteredLighting>();
+		lighting_->Init(path);
+		std::vector<PointLight> lights(2);
+		lights[0].position_radius = glm::vec4(0.0f, -1.5f, 3.0f, 10.0f);
+		lights[0].color_intensity = glm::vec4(1.0f, 1.0f, 1.0f, 4.0f);
+		lights[1].position_radius = glm::vec4(1.0f, 1.0f, 1.0f, 3.0f);
+		lights[1].color_intensity = glm::vec4(1.0f, 0.0f, 0.0f, 2.0f);
+		lighting_->SetLights(lights);
+
 		// Bind uniform to program.
 		shaders_->Use();
 		texture_diffuse_->Bind(0);
@@ -170,7 +186,8 @@ namespace gl {
 	void HelloTransform::SetModelMatrix(seconds dt)
 	{
 		model_ = glm::rotate(glm::mat4(1.0f), time_, glm::vec3(0.f, 1.f, 0.f));
-		model_inverse_ = glm::transpose(glm::inverse(model_));
+		// The inverse transpose of a pure rotation is the rotation itself.
+		model_inverse_ = model_;
 	}
 
 	void HelloTransform::SetViewMatrix(seconds dt)
@@ -180,12 +197,28 @@ namespace gl {
 
 	void HelloTransform::SetProjectionMatrix()
 	{
-		projection_ = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 100.f);
+		// The viewport follows the window and the dynamic resolution.
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		projection_ = glm::perspective(
+			45.0f,
+			static_cast<float>(viewport[2]) / static_cast<float>(std::max(viewport[3], 1)),
+			0.1f,
+			100.f);
 	}
 
 	void HelloTransform::SetUniformMatrix() const
 	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		lighting_->Update(
+			view_,
+			projection_,
+			glm::vec2(viewport[2], viewport[3]),
+			0.1f,
+			100.f);
 		shaders_->Use();
+		lighting_->Bind(*shaders_);
 		shaders_->SetMat4("model", model_);
 		shaders_->SetMat4("view", view_);
 		shaders_->SetMat4("projection", projection_);
@@ -197,15 +230,16 @@ namespace gl {
 	{
 		delta_time_ = dt.count();
 		time_ += delta_time_;
+		camera_->ProcessKeyboardState(delta_time_);
 		SetViewMatrix(dt);
 		SetModelMatrix(dt);
 		SetProjectionMatrix();
 		SetUniformMatrix();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		IsError(__FILE__, __LINE__);
@@ -213,36 +247,29 @@ namespace gl {
 
 	void HelloTransform::Destroy()
 	{
-
+		lighting_->Destroy();
+		VAO_.Reset();
+		VBO_.Reset();
+		EBO_.Reset();
+		shaders_.reset();
+		texture_diffuse_.reset();
+		IsError(__FILE__, __LINE__);
 	}
 
 	void HelloTransform::OnEvent(SDL_Event& event)
 	{
-		if (event.type == SDL_KEYDOWN)
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
 		{
-			if (event.key.keysym.sym == SDLK_ESCAPE)
-				exit(0);
-			if (event.key.keysym.sym == SDLK_w)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::FORWARD, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_s)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::BACKWARD, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_a)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::LEFT, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_d)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::RIGHT, delta_time_);
-			}
+			exit(0);
 		}
 	}
 
 	void HelloTransform::DrawImGui()
 	{
+		ImGui::Begin("Lighting");
+		lighting_->DrawImGui();
+		ImGui::End();
 	}
 
 } // End namespace gl.
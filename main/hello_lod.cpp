@@ -0,0 +1,246 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "camera.h"
+#include "texture.h"
+#include "shader.h"
+#include "mesh.h"
+#include "mesh_lod.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Large open field of instanced spheres. Each sphere picks a level of
+	// its LOD chain from its projected error and every level is drawn in a
+	// single instanced call.
+	class HelloLod : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+
+	protected:
+		float delta_time_ = 0.0f;
+		bool lod_enabled_ = true;
+		bool tint_levels_ = false;
+		std::size_t triangles_drawn_ = 0;
+		std::size_t triangles_full_ = 0;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		std::unique_ptr<Texture> texture_diffuse_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<LodMesh> lod_mesh_ = nullptr;
+		StreamBuffer instance_stream_;
+		LodSelector selector_;
+
+		std::vector<MeshLod> chain_;
+		std::vector<glm::mat4> models_;
+		std::vector<std::vector<glm::mat4>> per_level_;
+
+		glm::mat4 view_ = glm::mat4(1.0f);
+		glm::mat4 projection_ = glm::mat4(1.0f);
+
+		const float z_near_ = 0.1f;
+		const float z_far_ = 1000.0f;
+	};
+
+	void HelloLod::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloLod::Init()
+	{
+		const MeshData sphere = CreateSphere(128, 64);
+		chain_ = GenerateLodChain(sphere);
+		std::vector<float> errors;
+		for (const auto& lod : chain_)
+		{
+			errors.push_back(lod.error);
+		}
+		selector_.SetLevels(errors, ComputeBoundingRadius(sphere));
+
+		lod_mesh_ = std::make_unique<LodMesh>();
+		lod_mesh_->Init(chain_);
+		// Every sphere can end up in a single level.
+		instance_stream_.Init(128 * 128 * sizeof(glm::mat4));
+
+		// Fixed seed so runs are comparable.
+		std::mt19937 rng(5300);
+		std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> size(0.8f, 2.0f);
+		for (int x = -64; x < 64; ++x)
+		{
+			for (int z = -64; z < 64; ++z)
+			{
+				const float scale = size(rng);
+				const glm::mat4 model = glm::translate(
+					glm::mat4(1.0f),
+					glm::vec3(
+						x * 4.0f + jitter(rng),
+						scale * 0.5f,
+						z * 4.0f + jitter(rng)));
+				models_.push_back(glm::scale(model, glm::vec3(scale)));
+			}
+		}
+
+		camera_ = std::make_unique<Camera>(glm::vec3(0.0f, 4.0f, 0.0f));
+
+		std::string path = "../";
+
+		texture_diffuse_ = std::make_unique<Texture>(
+			path + "data/textures/texture_diffuse.jpg");
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_lod/lod.vert",
+			path + "data/shaders/hello_lod/lod.frag");
+
+		shaders_->Use();
+		texture_diffuse_->Bind(0);
+		shaders_->SetInt("textureDiffuse", 0);
+
+		glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloLod::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		camera_->ProcessKeyboardState(40.0f * delta_time_);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		view_ = camera_->GetViewMatrix();
+		projection_ = glm::perspective(
+			glm::radians(camera_->Zoom),
+			static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]),
+			z_near_,
+			z_far_);
+
+		if (lod_enabled_)
+		{
+			selector_.Select(
+				*camera_,
+				static_cast<float>(viewport[3]),
+				models_,
+				per_level_);
+		}
+		else
+		{
+			per_level_.assign(lod_mesh_->GetLevelCount(), {});
+			per_level_[0] = models_;
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		IsError(__FILE__, __LINE__);
+		shaders_->Use();
+		shaders_->SetMat4("view", view_);
+		shaders_->SetMat4("projection", projection_);
+		texture_diffuse_->Bind(0);
+
+		const std::array<glm::vec3, 6> tints = {
+			glm::vec3(1.0f, 1.0f, 1.0f),
+			glm::vec3(0.3f, 1.0f, 0.3f),
+			glm::vec3(0.3f, 0.3f, 1.0f),
+			glm::vec3(1.0f, 1.0f, 0.3f),
+			glm::vec3(1.0f, 0.3f, 1.0f),
+			glm::vec3(1.0f, 0.3f, 0.3f)
+		};
+		triangles_drawn_ = 0;
+		instance_stream_.BeginFrame();
+		for (int level = 0; level < lod_mesh_->GetLevelCount(); ++level)
+		{
+			shaders_->SetVec3(
+				"color",
+				tint_levels_ ? tints[level % tints.size()] : glm::vec3(1.0f));
+			triangles_drawn_ += lod_mesh_->DrawLevel(
+				level,
+				per_level_[level],
+				instance_stream_);
+		}
+		instance_stream_.EndFrame();
+		triangles_full_ =
+			static_cast<std::size_t>(lod_mesh_->GetIndexCount(0) / 3) *
+			models_.size();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloLod::Destroy()
+	{
+		lod_mesh_->Destroy();
+		instance_stream_.Destroy();
+		shaders_.reset();
+		texture_diffuse_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloLod::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloLod::DrawImGui()
+	{
+		ImGui::Begin("Mesh LOD");
+		ImGui::Checkbox("Enable LOD", &lod_enabled_);
+		ImGui::Checkbox("Tint levels", &tint_levels_);
+		ImGui::SliderFloat(
+			"Threshold (pixels)",
+			&selector_.threshold_pixels,
+			0.25f,
+			8.0f);
+		ImGui::SliderFloat("Hysteresis", &selector_.hysteresis, 0.0f, 0.9f);
+		ImGui::Text(
+			"Triangles: %zu / %zu (%.1fx fewer)",
+			triangles_drawn_,
+			triangles_full_,
+			triangles_drawn_ ?
+				static_cast<float>(triangles_full_) / triangles_drawn_ : 0.0f);
+		for (std::size_t i = 0; i < chain_.size(); ++i)
+		{
+			ImGui::Text(
+				"LOD %zu: %zu tris, error %.4f, %zu instances",
+				i,
+				chain_[i].data.indices.size() / 3,
+				chain_[i].error,
+				i < per_level_.size() ? per_level_[i].size() : 0);
+		}
+		instance_stream_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloLod program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,304 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "gpu_resource.h"
+#include "camera.h"
+#include "shader.h"
+#include "mesh.h"
+#include "stream_buffer.h"
+#include "texture_residency.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Grid of cubes and spheres, each with its own texture, drawn with a
+	// single glMultiDrawElementsIndirect. Textures are referenced by index
+	// through the TextureResidency table so no texture is bound per draw.
+	class HelloMaterials : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void GenerateTextures();
+
+	protected:
+		// Layout fixed by glMultiDrawElementsIndirect.
+		struct DrawElementsIndirectCommand
+		{
+			GLuint count;
+			GLuint instance_count;
+			GLuint first_index;
+			GLint base_vertex;
+			GLuint base_instance;
+		};
+		struct InstanceData
+		{
+			glm::mat4 model;
+			std::uint32_t texture_index;
+		};
+
+		Mesh meshes_;
+		StreamBuffer instance_stream_;
+		BufferHandle indirect_buffer_;
+		std::vector<DrawElementsIndirectCommand> commands_;
+		std::vector<InstanceData> instances_;
+		std::vector<glm::vec3> positions_;
+
+		float time_ = 0.0f;
+		float delta_time_ = 0.0f;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		TextureResidency texture_residency_;
+	};
+
+	void HelloMaterials::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloMaterials::GenerateTextures()
+	{
+		// Checkerboards of varying hue and frequency, all the same size so
+		// they end up in the same array page.
+		const int size = 128;
+		std::vector<std::uint8_t> pixels(size * size * 4);
+		for (int t = 0; t < 48; ++t)
+		{
+			const float hue = t / 48.0f * 6.2831853f;
+			const glm::vec3 color(
+				0.5f + 0.5f * std::cos(hue),
+				0.5f + 0.5f * std::cos(hue - 2.094f),
+				0.5f + 0.5f * std::cos(hue + 2.094f));
+			const int cell = 4 << (t % 4);
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const bool odd = ((x / cell) + (y / cell)) % 2 != 0;
+					const glm::vec3 c = odd ? color : color * 0.3f;
+					std::uint8_t* p = &pixels[(y * size + x) * 4];
+					p[0] = static_cast<std::uint8_t>(c.x * 255.0f);
+					p[1] = static_cast<std::uint8_t>(c.y * 255.0f);
+					p[2] = static_cast<std::uint8_t>(c.z * 255.0f);
+					p[3] = 255;
+				}
+			}
+			texture_residency_.Add(size, size, pixels.data());
+		}
+	}
+
+	void HelloMaterials::Init()
+	{
+		// Both shapes share one vertex and index buffer so every draw can
+		// go in the same multi-draw.
+		MeshData cube = CreateCube();
+		const MeshData sphere = CreateSphere(32, 16);
+		const auto cube_vertex_count = static_cast<GLint>(cube.vertices.size());
+		const auto cube_index_count = static_cast<GLuint>(cube.indices.size());
+		cube.vertices.insert(
+			cube.vertices.end(),
+			sphere.vertices.begin(),
+			sphere.vertices.end());
+		cube.indices.insert(
+			cube.indices.end(),
+			sphere.indices.begin(),
+			sphere.indices.end());
+		meshes_.Init(cube);
+
+		std::string path = "../";
+
+		texture_residency_.Init();
+		GenerateTextures();
+		texture_residency_.Load(path + "data/textures/texture_diffuse.jpg");
+		texture_residency_.Load(path + "data/textures/texture_smily.png");
+		texture_residency_.Commit();
+
+		const auto texture_count =
+			static_cast<std::uint32_t>(texture_residency_.GetTextureCount());
+		for (int x = -8; x < 8; ++x)
+		{
+			for (int z = -8; z < 8; ++z)
+			{
+				const auto instance = static_cast<GLuint>(instances_.size());
+				const bool is_cube = (x + z) % 2 == 0;
+				DrawElementsIndirectCommand command;
+				command.count = is_cube ?
+					cube_index_count :
+					static_cast<GLuint>(sphere.indices.size());
+				command.instance_count = 1;
+				command.first_index = is_cube ? 0 : cube_index_count;
+				command.base_vertex = is_cube ? 0 : cube_vertex_count;
+				command.base_instance = instance;
+				commands_.push_back(command);
+				positions_.emplace_back(x * 2.0f + 1.0f, 0.0f, z * 2.0f + 1.0f);
+				instances_.push_back({ glm::mat4(1.0f), instance % texture_count });
+			}
+		}
+
+		// Instances are rewritten every frame, the attribute pointers are
+		// set when the frame's copy is known.
+		instance_stream_.Init(instances_.size() * sizeof(InstanceData));
+		glBindVertexArray(meshes_.GetVao());
+		for (int column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(3 + column);
+			glVertexAttribDivisor(3 + column, 1);
+		}
+		glEnableVertexAttribArray(7);
+		glVertexAttribDivisor(7, 1);
+		IsError(__FILE__, __LINE__);
+		glBindVertexArray(0);
+
+		indirect_buffer_.Create("HelloMaterials indirect commands");
+		indirect_buffer_.SetBytes(
+			commands_.size() * sizeof(DrawElementsIndirectCommand));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_.Get());
+		glBufferData(
+			GL_DRAW_INDIRECT_BUFFER,
+			commands_.size() * sizeof(DrawElementsIndirectCommand),
+			commands_.data(),
+			GL_STATIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		IsError(__FILE__, __LINE__);
+
+		camera_ = std::make_unique<Camera>(glm::vec3(0.0f, 6.0f, 24.0f));
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_materials/materials.vert",
+			path + "data/shaders/hello_materials/materials.frag");
+		texture_residency_.Bind(*shaders_);
+
+		glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloMaterials::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		camera_->ProcessKeyboardState(10.0f * delta_time_);
+		time_ += delta_time_;
+
+		for (std::size_t i = 0; i < instances_.size(); ++i)
+		{
+			const glm::mat4 model = glm::translate(glm::mat4(1.0f), positions_[i]);
+			instances_[i].model = glm::rotate(
+				model,
+				time_ + static_cast<float>(i),
+				glm::vec3(0.3f, 1.0f, 0.0f));
+		}
+		instance_stream_.BeginFrame();
+		const StreamAllocation instances = instance_stream_.Push(
+			instances_.data(),
+			instances_.size(),
+			StreamUsageEnum::VERTEX);
+		instance_stream_.Flush();
+		glBindVertexArray(meshes_.GetVao());
+		glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+		for (int column = 0; column < 4; ++column)
+		{
+			glVertexAttribPointer(
+				3 + column,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				sizeof(InstanceData),
+				(GLvoid*)(instances.offset + column * sizeof(glm::vec4)));
+		}
+		glVertexAttribIPointer(
+			7,
+			1,
+			GL_UNSIGNED_INT,
+			sizeof(InstanceData),
+			(GLvoid*)(instances.offset + offsetof(InstanceData, texture_index)));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		IsError(__FILE__, __LINE__);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(camera_->Zoom),
+			static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]),
+			0.1f,
+			100.0f);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shaders_->Use();
+		shaders_->SetMat4("view", camera_->GetViewMatrix());
+		shaders_->SetMat4("projection", projection);
+		glBindVertexArray(meshes_.GetVao());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_.Get());
+		glMultiDrawElementsIndirect(
+			GL_TRIANGLES,
+			GL_UNSIGNED_INT,
+			nullptr,
+			static_cast<GLsizei>(commands_.size()),
+			0);
+		IsError(__FILE__, __LINE__);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+		instance_stream_.EndFrame();
+	}
+
+	void HelloMaterials::Destroy()
+	{
+		texture_residency_.Destroy();
+		instance_stream_.Destroy();
+		indirect_buffer_.Reset();
+		meshes_.Destroy();
+		shaders_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloMaterials::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloMaterials::DrawImGui()
+	{
+		ImGui::Begin("Materials");
+		texture_residency_.DrawImGui();
+		ImGui::Text(
+			"Objects: %zu in 1 multi-draw call",
+			commands_.size());
+		instance_stream_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloMaterials program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
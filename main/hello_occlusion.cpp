@@ -0,0 +1,311 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "camera.h"
+#include "debug_draw.h"
+#include "texture.h"
+#include "shader.h"
+#include "mesh.h"
+#include "job_system.h"
+#include "occlusion_culling.h"
+#include "render_queue.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Interior scene for the software occlusion culling: a maze of walls
+	// hiding a dense field of small crates. Walls are occluders, crates are
+	// tested against the occlusion buffer before being submitted.
+	class HelloOcclusion : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void GenerateScene();
+
+	protected:
+		Mesh cube_;
+		Mesh floor_;
+		DepthStream cube_depth_;
+		DepthStream floor_depth_;
+
+		float delta_time_ = 0.0f;
+		bool culling_enabled_ = true;
+		bool draw_boxes_ = false;
+		std::size_t drawn_count_ = 0;
+		float cull_ms_ = 0.0f;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		std::unique_ptr<Texture> texture_diffuse_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<RenderQueue> render_queue_ = nullptr;
+		std::unique_ptr<JobSystem> jobs_ = nullptr;
+		std::unique_ptr<OcclusionCuller> culler_ = nullptr;
+
+		std::vector<glm::mat4> wall_models_;
+		std::vector<glm::mat4> crate_models_;
+		std::vector<Aabb> crate_boxes_;
+		std::vector<std::uint8_t> crate_visible_;
+
+		glm::mat4 view_ = glm::mat4(1.0f);
+		glm::mat4 projection_ = glm::mat4(1.0f);
+
+		const float z_near_ = 0.1f;
+		const float z_far_ = 200.0f;
+	};
+
+	void HelloOcclusion::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloOcclusion::GenerateScene()
+	{
+		// Fixed seed so runs are comparable.
+		std::mt19937 rng(5300);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const MeshData cube_data = CreateCube();
+
+		// Grid of 10x10 rooms, each cell edge gets a wall most of the time.
+		const int rooms = 10;
+		const float room_size = 10.0f;
+		const float origin = -rooms * room_size * 0.5f;
+		for (int i = 0; i <= rooms; ++i)
+		{
+			for (int j = 0; j < rooms; ++j)
+			{
+				const float a = origin + i * room_size;
+				const float b = origin + (j + 0.5f) * room_size;
+				// Keep the outer walls closed and leave doors inside.
+				const bool outer = i == 0 || i == rooms;
+				if (outer || unit(rng) < 0.7f)
+				{
+					wall_models_.push_back(glm::scale(
+						glm::translate(glm::mat4(1.0f), glm::vec3(a, 2.0f, b)),
+						glm::vec3(0.4f, 4.0f, room_size)));
+				}
+				if (outer || unit(rng) < 0.7f)
+				{
+					wall_models_.push_back(glm::scale(
+						glm::translate(glm::mat4(1.0f), glm::vec3(b, 2.0f, a)),
+						glm::vec3(room_size, 4.0f, 0.4f)));
+				}
+			}
+		}
+		for (const auto& model : wall_models_)
+		{
+			Occluder occluder;
+			occluder.positions = cube_data.GetPositions();
+			occluder.indices = cube_data.indices;
+			occluder.model = model;
+			culler_->AddOccluder(occluder);
+		}
+
+		// 8x8 crates per room.
+		const int crates = rooms * 8;
+		const float spacing = rooms * room_size / crates;
+		for (int x = 0; x < crates; ++x)
+		{
+			for (int z = 0; z < crates; ++z)
+			{
+				const glm::vec3 center(
+					origin + (x + 0.5f) * spacing,
+					0.25f + unit(rng) * 1.5f,
+					origin + (z + 0.5f) * spacing);
+				const glm::vec3 half(0.25f);
+				crate_models_.push_back(glm::scale(
+					glm::translate(glm::mat4(1.0f), center),
+					half * 2.0f));
+				crate_boxes_.push_back({ center - half, center + half });
+			}
+		}
+	}
+
+	void HelloOcclusion::Init()
+	{
+		cube_.Init(CreateCube());
+		floor_.Init(CreatePlane(100.0f, 50.0f));
+
+		camera_ = std::make_unique<Camera>(glm::vec3(0.0f, 1.8f, 0.0f));
+
+		std::string path = "../";
+
+		texture_diffuse_ = std::make_unique<Texture>(
+			path + "data/textures/texture_diffuse.jpg");
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_occlusion/occlusion.vert",
+			path + "data/shaders/hello_occlusion/occlusion.frag");
+
+		render_queue_ = std::make_unique<RenderQueue>();
+		render_queue_->Init(path);
+		cube_depth_ = render_queue_->CreateDepthStream(
+			CreateCube().GetPositions(),
+			cube_.GetEbo());
+		floor_depth_ = render_queue_->CreateDepthStream(
+			CreatePlane(100.0f).GetPositions(),
+			floor_.GetEbo());
+
+		jobs_ = std::make_unique<JobSystem>();
+		culler_ = std::make_unique<OcclusionCuller>(*jobs_);
+		GenerateScene();
+
+		shaders_->Use();
+		texture_diffuse_->Bind(0);
+		shaders_->SetInt("textureDiffuse", 0);
+
+		glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloOcclusion::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		camera_->ProcessKeyboardState(10.0f * delta_time_);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		view_ = camera_->GetViewMatrix();
+		projection_ = glm::perspective(
+			glm::radians(camera_->Zoom),
+			static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]),
+			z_near_,
+			z_far_);
+
+		const auto cull_start = std::chrono::high_resolution_clock::now();
+		if (culling_enabled_)
+		{
+			culler_->RenderOccluders(projection_ * view_);
+			culler_->TestVisibility(crate_boxes_, crate_visible_);
+		}
+		else
+		{
+			crate_visible_.assign(crate_boxes_.size(), 1);
+		}
+		cull_ms_ = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - cull_start).count();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		IsError(__FILE__, __LINE__);
+		shaders_->Use();
+		shaders_->SetMat4("view", view_);
+		shaders_->SetMat4("projection", projection_);
+		texture_diffuse_->Bind(0);
+
+		DrawItem floor_item;
+		floor_item.vao = floor_.GetVao();
+		floor_item.depth_vao = floor_depth_.vao.Get();
+		floor_item.index_count = floor_.GetIndexCount();
+		render_queue_->Submit(floor_item);
+		DrawItem cube_item;
+		cube_item.vao = cube_.GetVao();
+		cube_item.depth_vao = cube_depth_.vao.Get();
+		cube_item.index_count = cube_.GetIndexCount();
+		for (const auto& model : wall_models_)
+		{
+			cube_item.model = model;
+			render_queue_->Submit(cube_item);
+		}
+		drawn_count_ = 0;
+		for (std::size_t i = 0; i < crate_models_.size(); ++i)
+		{
+			if (!crate_visible_[i]) continue;
+			cube_item.model = crate_models_[i];
+			render_queue_->Submit(cube_item);
+			++drawn_count_;
+		}
+		shaders_->SetVec3("color", glm::vec3(0.8f, 0.75f, 0.7f));
+		render_queue_->Flush(view_, projection_, *shaders_);
+
+		if (draw_boxes_)
+		{
+			auto& debug = DebugDraw::GetInstance();
+			debug.SetViewProjection(projection_ * view_);
+			for (std::size_t i = 0; i < crate_boxes_.size(); ++i)
+			{
+				debug.Aabb(
+					crate_boxes_[i].min,
+					crate_boxes_[i].max,
+					crate_visible_[i] ?
+						glm::vec4(0.0f, 1.0f, 0.0f, 1.0f) :
+						glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+					0.0f,
+					false);
+			}
+			debug.Axis(glm::mat4(1.0f), 2.0f);
+			debug.Text3D(glm::vec3(0.0f, 2.5f, 0.0f), "origin");
+		}
+	}
+
+	void HelloOcclusion::Destroy()
+	{
+		render_queue_->DestroyDepthStream(cube_depth_);
+		render_queue_->DestroyDepthStream(floor_depth_);
+		render_queue_->Destroy();
+		cube_.Destroy();
+		floor_.Destroy();
+		culler_.reset();
+		jobs_.reset();
+		shaders_.reset();
+		texture_diffuse_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloOcclusion::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloOcclusion::DrawImGui()
+	{
+		ImGui::Begin("Occlusion culling");
+		ImGui::Checkbox("Enable culling", &culling_enabled_);
+		ImGui::Checkbox("Draw crate boxes (culled in red)", &draw_boxes_);
+		ImGui::Text("Workers: %u", jobs_->GetWorkerCount());
+		ImGui::Text(
+			"Crates drawn: %zu / %zu",
+			drawn_count_,
+			crate_boxes_.size());
+		ImGui::Text("Cull total: %.3f ms", cull_ms_);
+		culler_->DrawImGui();
+		ImGui::End();
+		ImGui::Begin("Render queue");
+		render_queue_->DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloOcclusion program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
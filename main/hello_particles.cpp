@@ -0,0 +1,277 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "shader.h"
+#include "mesh.h"
+#include "gpu_resource.h"
+#include "particle_system.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// A fountain of up to a million particles raining on a field of cubes.
+	// They bounce off the ground plane and off the cubes through the depth
+	// buffer of a depth prepass, and are sorted back to front for blending.
+	// Everything after the prepass runs on the GPU, the counts never come
+	// back to the CPU.
+	class HelloParticles : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void InitParticles();
+		void ResizeDepth(glm::ivec2 size);
+		void DrawScene(const Shader& shader) const;
+
+	protected:
+		Mesh cube_;
+		Mesh plane_;
+		ParticleSystem particles_;
+		FramebufferHandle depth_fbo_;
+		TextureHandle depth_texture_;
+		glm::ivec2 depth_size_ = glm::ivec2(0);
+
+		std::unique_ptr<Shader> depth_shader_ = nullptr;
+		std::unique_ptr<Shader> scene_shader_ = nullptr;
+
+		float time_ = 0.0f;
+		bool orbit_ = true;
+		bool ground_plane_ = true;
+		bool depth_collisions_ = true;
+		// Index in CAPACITIES, smaller ones keep software rasterizers usable.
+		int capacity_index_ = 2;
+		static constexpr std::array<std::size_t, 4> CAPACITIES = {
+			64 * 1024, 256 * 1024, 1024 * 1024, 2 * 1024 * 1024 };
+		const glm::vec3 light_direction_ =
+			glm::normalize(glm::vec3(-1.0f, -2.0f, -1.0f));
+	};
+
+	void HelloParticles::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloParticles::Init()
+	{
+		std::string path = "../";
+
+		cube_.Init(CreateCube());
+		plane_.Init(CreatePlane(30.0f));
+		depth_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/common/depth_only.vert",
+			path + "data/shaders/common/depth_only.frag");
+		scene_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_particles/scene.vert",
+			path + "data/shaders/hello_particles/scene.frag");
+		InitParticles();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloParticles::InitParticles()
+	{
+		particles_.Destroy();
+		particles_.Init("../", CAPACITIES[capacity_index_]);
+		if (!particles_.IsSupported())
+		{
+			std::cerr << "Particles need OpenGL 4.3.\n";
+			return;
+		}
+		ParticleEmitter& emitter = particles_.GetEmitter();
+		emitter.position = glm::vec3(0.0f, 0.5f, 0.0f);
+		emitter.radius = 0.2f;
+		emitter.spread = 0.35f;
+		emitter.speed = glm::vec2(8.0f, 12.0f);
+		emitter.lifetime = glm::vec2(3.0f, 5.0f);
+		// Keeps the pool close to full at the default lifetime.
+		emitter.rate = static_cast<float>(CAPACITIES[capacity_index_]) / 5.0f;
+		particles_.GetForces().drag = 0.1f;
+	}
+
+	void HelloParticles::ResizeDepth(glm::ivec2 size)
+	{
+		if (size == depth_size_) return;
+		depth_size_ = size;
+		depth_texture_.Create("HelloParticles depth");
+		depth_texture_.SetBytes(
+			EstimateTextureBytes(GL_DEPTH_COMPONENT24, size.x, size.y));
+		glBindTexture(GL_TEXTURE_2D, depth_texture_.Get());
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, size.x, size.y);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		GLint framebuffer = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+		depth_fbo_.Create("HelloParticles depth");
+		glBindFramebuffer(GL_FRAMEBUFFER, depth_fbo_.Get());
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			GL_DEPTH_ATTACHMENT,
+			GL_TEXTURE_2D,
+			depth_texture_.Get(),
+			0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << "Depth framebuffer incomplete.\n";
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloParticles::DrawScene(const Shader& shader) const
+	{
+		shader.SetMat4("model", glm::mat4(1.0f));
+		shader.SetVec3("color", glm::vec3(0.5f));
+		plane_.Draw();
+		for (int z = -2; z <= 2; ++z)
+		{
+			for (int x = -2; x <= 2; ++x)
+			{
+				if (x == 0 && z == 0) continue;
+				const float height = 1.0f + static_cast<float>((x * x + z) & 3);
+				glm::mat4 model = glm::translate(
+					glm::mat4(1.0f),
+					glm::vec3(x * 3.0f, height * 0.5f, z * 3.0f));
+				model = glm::rotate(
+					model,
+					(x + z) * 0.4f,
+					glm::vec3(0.0f, 1.0f, 0.0f));
+				model = glm::scale(model, glm::vec3(1.5f, height, 1.5f));
+				shader.SetMat4("model", model);
+				shader.SetVec3("color", glm::vec3(0.3f, 0.5f, 0.8f));
+				cube_.Draw();
+			}
+		}
+		glBindVertexArray(0);
+	}
+
+	void HelloParticles::Update(seconds dt)
+	{
+		if (orbit_) time_ += dt.count();
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::ivec2 size(std::max(viewport[2], 1), std::max(viewport[3], 1));
+		ResizeDepth(size);
+
+		const glm::mat4 view = glm::lookAt(
+			glm::vec3(std::sin(time_ * 0.15f) * 18.0f, 9.0f, std::cos(time_ * 0.15f) * 18.0f),
+			glm::vec3(0.0f, 2.0f, 0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(45.0f),
+			static_cast<float>(size.x) / static_cast<float>(size.y),
+			0.1f,
+			100.0f);
+
+		// Depth prepass, what the particles collide with.
+		GLint framebuffer = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, depth_fbo_.Get());
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glEnable(GL_DEPTH_TEST);
+		depth_shader_->Use();
+		depth_shader_->SetMat4("view", view);
+		depth_shader_->SetMat4("projection", projection);
+		DrawScene(*depth_shader_);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		particles_.ClearCollisionPlanes();
+		if (ground_plane_)
+		{
+			particles_.AddCollisionPlane(glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+		}
+		particles_.SetDepthTexture(
+			depth_collisions_ ? depth_texture_.Get() : 0,
+			0.5f);
+		particles_.Update(dt.count(), view, projection);
+
+		scene_shader_->Use();
+		scene_shader_->SetMat4("view", view);
+		scene_shader_->SetMat4("projection", projection);
+		scene_shader_->SetVec3("light_direction", light_direction_);
+		DrawScene(*scene_shader_);
+		particles_.Draw(view, projection);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloParticles::Destroy()
+	{
+		particles_.Destroy();
+		cube_.Destroy();
+		plane_.Destroy();
+		depth_fbo_.Reset();
+		depth_texture_.Reset();
+		depth_size_ = glm::ivec2(0);
+		depth_shader_.reset();
+		scene_shader_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloParticles::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_SPACE)
+		{
+			particles_.Burst(CAPACITIES[capacity_index_] / 10);
+		}
+	}
+
+	void HelloParticles::DrawImGui()
+	{
+		ImGui::Begin("Particles");
+		static constexpr const char* capacity_names[] = {
+			"64k", "256k", "1M", "2M" };
+		if (ImGui::Combo("Capacity", &capacity_index_, capacity_names, 4))
+		{
+			InitParticles();
+		}
+		ImGui::Checkbox("Orbit camera", &orbit_);
+		ImGui::Checkbox("Collide with the ground plane", &ground_plane_);
+		ImGui::Checkbox("Collide with the depth buffer", &depth_collisions_);
+		if (ImGui::Button("Burst (space)"))
+		{
+			particles_.Burst(CAPACITIES[capacity_index_] / 10);
+		}
+		particles_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloParticles program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
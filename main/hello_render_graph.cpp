@@ -0,0 +1,354 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "shader.h"
+#include "mesh.h"
+#include "gpu_resource.h"
+#include "render_graph.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// A frame declared as a render graph: shadow map, HDR scene, a compute
+	// bright pass, a separable blur and the composite to the backbuffer.
+	// Turning the bloom off culls its passes, the half resolution targets
+	// of the bright pass and the last blur share one texture.
+	class HelloRenderGraph : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void DrawScene(const Shader& shader) const;
+		void DrawFullscreen() const;
+
+	protected:
+		Mesh cube_;
+		Mesh plane_;
+		VertexArrayHandle empty_vao_;
+		RenderGraph graph_;
+
+		std::unique_ptr<Shader> depth_shader_ = nullptr;
+		std::unique_ptr<Shader> scene_shader_ = nullptr;
+		std::unique_ptr<Shader> bright_shader_ = nullptr;
+		std::unique_ptr<Shader> blur_shader_ = nullptr;
+		std::unique_ptr<Shader> composite_shader_ = nullptr;
+
+		float time_ = 0.0f;
+		bool bloom_ = true;
+		bool unused_pass_ = true;
+		float threshold_ = 1.0f;
+		float bloom_intensity_ = 0.8f;
+		const int shadow_size_ = 2048;
+		const glm::vec3 light_direction_ =
+			glm::normalize(glm::vec3(-1.0f, -2.0f, -1.0f));
+	};
+
+	void HelloRenderGraph::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloRenderGraph::Init()
+	{
+		std::string path = "../";
+
+		cube_.Init(CreateCube());
+		plane_.Init(CreatePlane(30.0f));
+		empty_vao_.Create("HelloRenderGraph fullscreen");
+
+		depth_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/common/depth_only.vert",
+			path + "data/shaders/common/depth_only.frag");
+		scene_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_render_graph/scene.vert",
+			path + "data/shaders/hello_render_graph/scene.frag");
+		bright_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_render_graph/bright.comp");
+		blur_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/common/fullscreen.vert",
+			path + "data/shaders/hello_render_graph/blur.frag");
+		composite_shader_ = std::make_unique<Shader>(
+			path + "data/shaders/common/fullscreen.vert",
+			path + "data/shaders/hello_render_graph/composite.frag");
+
+		scene_shader_->Use();
+		scene_shader_->SetInt("shadow_map", 0);
+		bright_shader_->Use();
+		bright_shader_->SetInt("hdr", 0);
+		blur_shader_->Use();
+		blur_shader_->SetInt("source", 0);
+		composite_shader_->Use();
+		composite_shader_->SetInt("hdr", 0);
+		composite_shader_->SetInt("bloom", 1);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloRenderGraph::DrawScene(const Shader& shader) const
+	{
+		shader.SetMat4("model", glm::mat4(1.0f));
+		shader.SetVec3("color", glm::vec3(0.6f));
+		plane_.Draw();
+		for (int z = -3; z <= 3; ++z)
+		{
+			for (int x = -3; x <= 3; ++x)
+			{
+				glm::mat4 model = glm::translate(
+					glm::mat4(1.0f),
+					glm::vec3(x * 3.0f, 1.0f, z * 3.0f));
+				model = glm::rotate(
+					model,
+					time_ + (x + z) * 0.3f,
+					glm::vec3(0.0f, 1.0f, 0.0f));
+				shader.SetMat4("model", model);
+				// Every third cube glows.
+				const bool emissive = (x + z * 7) % 3 == 0;
+				shader.SetVec3(
+					"color",
+					emissive ? glm::vec3(4.0f, 2.0f, 0.5f) : glm::vec3(0.3f, 0.5f, 0.8f));
+				cube_.Draw();
+			}
+		}
+		glBindVertexArray(0);
+	}
+
+	void HelloRenderGraph::DrawFullscreen() const
+	{
+		glBindVertexArray(empty_vao_.Get());
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+	}
+
+	void HelloRenderGraph::Update(seconds dt)
+	{
+		time_ += dt.count();
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::ivec2 size(std::max(viewport[2], 1), std::max(viewport[3], 1));
+		const glm::ivec2 half = glm::max(size / 2, glm::ivec2(1));
+
+		const glm::mat4 view = glm::lookAt(
+			glm::vec3(std::sin(time_ * 0.2f) * 16.0f, 8.0f, std::cos(time_ * 0.2f) * 16.0f),
+			glm::vec3(0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(45.0f),
+			static_cast<float>(size.x) / static_cast<float>(size.y),
+			0.1f,
+			100.0f);
+		const glm::mat4 light_view = glm::lookAt(
+			-light_direction_ * 20.0f,
+			glm::vec3(0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 light_projection =
+			glm::ortho(-16.0f, 16.0f, -16.0f, 16.0f, 1.0f, 50.0f);
+		const glm::mat4 light_space = light_projection * light_view;
+
+		graph_.Reset();
+		RenderResource backbuffer = graph_.ImportBackbuffer(size);
+		RenderResource shadow = graph_.CreateTexture(
+			"Shadow map",
+			{ shadow_size_, shadow_size_, GL_DEPTH_COMPONENT24 });
+		RenderResource hdr = graph_.CreateTexture(
+			"HDR",
+			{ size.x, size.y, GL_RGBA16F, 1, true, glm::vec4(0.05f, 0.05f, 0.08f, 1.0f) });
+		RenderResource depth = graph_.CreateTexture(
+			"Depth",
+			{ size.x, size.y, GL_DEPTH_COMPONENT24 });
+		// Fully overwritten, no clear.
+		const RenderTextureDesc half_desc = { half.x, half.y, GL_RGBA16F, 1, false };
+		RenderResource bright = graph_.CreateTexture("Bright", half_desc);
+		RenderResource blur_x = graph_.CreateTexture("Blur X", half_desc);
+		RenderResource blur_y = graph_.CreateTexture("Blur Y", half_desc);
+
+		graph_.AddPass(
+			"Shadow",
+			[&](RenderPassBuilder& builder) {
+				shadow = builder.Write(shadow, RenderAccessEnum::DEPTH_ATTACHMENT);
+			},
+			[&](const RenderPassContext&) {
+				glEnable(GL_DEPTH_TEST);
+				depth_shader_->Use();
+				depth_shader_->SetMat4("view", light_view);
+				depth_shader_->SetMat4("projection", light_projection);
+				DrawScene(*depth_shader_);
+			});
+		graph_.AddPass(
+			"Scene",
+			[&](RenderPassBuilder& builder) {
+				builder.Read(shadow, RenderAccessEnum::SAMPLED);
+				hdr = builder.Write(hdr, RenderAccessEnum::COLOR_ATTACHMENT);
+				depth = builder.Write(depth, RenderAccessEnum::DEPTH_ATTACHMENT);
+			},
+			[&](const RenderPassContext& context) {
+				glEnable(GL_DEPTH_TEST);
+				scene_shader_->Use();
+				scene_shader_->SetMat4("view", view);
+				scene_shader_->SetMat4("projection", projection);
+				scene_shader_->SetMat4("light_space", light_space);
+				scene_shader_->SetVec3("light_direction", light_direction_);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, context.GetTexture(shadow));
+				DrawScene(*scene_shader_);
+			});
+		if (unused_pass_)
+		{
+			// Nothing reads it, the graph drops it.
+			RenderResource normals = graph_.CreateTexture(
+				"Normals",
+				{ size.x, size.y, GL_RGBA8 });
+			graph_.AddPass(
+				"Unused normals",
+				[&](RenderPassBuilder& builder) {
+					normals = builder.Write(
+						normals,
+						RenderAccessEnum::COLOR_ATTACHMENT);
+				},
+				[&](const RenderPassContext&) {
+					scene_shader_->Use();
+					DrawScene(*scene_shader_);
+				});
+		}
+		graph_.AddPass(
+			"Bright",
+			[&](RenderPassBuilder& builder) {
+				builder.Read(hdr, RenderAccessEnum::SAMPLED);
+				bright = builder.Write(bright, RenderAccessEnum::IMAGE);
+			},
+			[&](const RenderPassContext& context) {
+				bright_shader_->Use();
+				bright_shader_->SetFloat("threshold", threshold_);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, context.GetTexture(hdr));
+				glBindImageTexture(
+					0,
+					context.GetTexture(bright),
+					0,
+					GL_FALSE,
+					0,
+					GL_WRITE_ONLY,
+					GL_RGBA16F);
+				glDispatchCompute((half.x + 7) / 8, (half.y + 7) / 8, 1);
+			});
+		auto add_blur = [&](
+			const std::string& name,
+			RenderResource& source,
+			RenderResource& target,
+			glm::vec2 direction)
+		{
+			graph_.AddPass(
+				name,
+				[&](RenderPassBuilder& builder) {
+					builder.Read(source, RenderAccessEnum::SAMPLED);
+					target = builder.Write(target, RenderAccessEnum::COLOR_ATTACHMENT);
+				},
+				[this, source, direction](const RenderPassContext& context) {
+					glDisable(GL_DEPTH_TEST);
+					blur_shader_->Use();
+					blur_shader_->SetVec2(
+						"direction",
+						direction / glm::vec2(context.GetSize(source)));
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, context.GetTexture(source));
+					DrawFullscreen();
+				});
+		};
+		add_blur("Blur X", bright, blur_x, glm::vec2(1.0f, 0.0f));
+		add_blur("Blur Y", blur_x, blur_y, glm::vec2(0.0f, 1.0f));
+		graph_.AddPass(
+			"Composite",
+			[&](RenderPassBuilder& builder) {
+				builder.Read(hdr, RenderAccessEnum::SAMPLED);
+				if (bloom_) builder.Read(blur_y, RenderAccessEnum::SAMPLED);
+				backbuffer = builder.Write(
+					backbuffer,
+					RenderAccessEnum::COLOR_ATTACHMENT);
+			},
+			[&](const RenderPassContext& context) {
+				glDisable(GL_DEPTH_TEST);
+				composite_shader_->Use();
+				composite_shader_->SetFloat(
+					"bloom_intensity",
+					bloom_ ? bloom_intensity_ : 0.0f);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, context.GetTexture(hdr));
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(
+					GL_TEXTURE_2D,
+					bloom_ ? context.GetTexture(blur_y) : 0);
+				DrawFullscreen();
+				glBindTexture(GL_TEXTURE_2D, 0);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				glEnable(GL_DEPTH_TEST);
+			});
+
+		graph_.Compile();
+		graph_.Execute();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloRenderGraph::Destroy()
+	{
+		graph_.Destroy();
+		cube_.Destroy();
+		plane_.Destroy();
+		empty_vao_.Reset();
+		depth_shader_.reset();
+		scene_shader_.reset();
+		bright_shader_.reset();
+		blur_shader_.reset();
+		composite_shader_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloRenderGraph::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloRenderGraph::DrawImGui()
+	{
+		ImGui::Begin("Render graph");
+		ImGui::Checkbox("Bloom", &bloom_);
+		ImGui::Checkbox("Add a pass nothing reads", &unused_pass_);
+		ImGui::SliderFloat("Threshold", &threshold_, 0.0f, 4.0f);
+		ImGui::SliderFloat("Bloom intensity", &bloom_intensity_, 0.0f, 2.0f);
+		graph_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloRenderGraph program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,343 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "gpu_resource.h"
+#include "sprite_batch.h"
+#include "texture_atlas.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Tens of thousands of bouncing sprites from one atlas, with a benchmark
+	// sweeping the sprite count and reporting sprites per millisecond of CPU
+	// time (filling the batch plus End).
+	class HelloSprites : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void GenerateShapes();
+		void Resize(std::size_t count);
+
+	protected:
+		struct Particle
+		{
+			glm::vec2 velocity;
+			float spin;
+		};
+
+		TextureAtlas atlas_;
+		SpriteBatch batch_;
+		std::vector<std::string> names_;
+		std::vector<Sprite> sprites_;
+		std::vector<Particle> particles_;
+		std::mt19937 rng_{ 5300 };
+		glm::vec2 viewport_size_ = glm::vec2(1024.0f, 720.0f);
+
+		int sprite_count_ = 50000;
+		float submit_ms_ = 0.0f;
+		float gpu_ms_ = 0.0f;
+		QueryHandle timer_query_;
+		bool query_pending_ = false;
+
+		// Benchmark sweep, one entry per sprite count.
+		static constexpr std::array<int, 5> BENCHMARK_COUNTS = {
+			1000, 10000, 50000, 100000, 128000 };
+		static constexpr int BENCHMARK_FRAMES = 120;
+		int benchmark_step_ = -1;
+		int benchmark_frame_ = 0;
+		float benchmark_cpu_ms_ = 0.0f;
+		std::array<float, BENCHMARK_COUNTS.size()> benchmark_results_ = {};
+	};
+
+	void HelloSprites::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloSprites::GenerateShapes()
+	{
+		// Soft discs, rings and diamonds of a few sizes, so the packer has
+		// more than the two textures of data/textures to work with.
+		int index = 0;
+		for (const int size : { 16, 24, 32, 48, 64, 96 })
+		{
+			for (int shape = 0; shape < 3; ++shape)
+			{
+				for (int tint = 0; tint < 4; ++tint)
+				{
+					std::vector<std::uint8_t> pixels(size * size * 4);
+					const float hue = (tint + shape * 4) / 12.0f * 6.2831853f;
+					for (int y = 0; y < size; ++y)
+					{
+						for (int x = 0; x < size; ++x)
+						{
+							const glm::vec2 p =
+								(glm::vec2(x, y) + 0.5f) / static_cast<float>(size) * 2.0f -
+								1.0f;
+							const float r = glm::length(p);
+							float alpha = 0.0f;
+							if (shape == 0) alpha = 1.0f - r;
+							if (shape == 1) alpha = 1.0f - std::abs(r - 0.7f) * 5.0f;
+							if (shape == 2)
+								alpha = 1.0f - (std::abs(p.x) + std::abs(p.y));
+							alpha = std::clamp(alpha * 2.0f, 0.0f, 1.0f);
+							std::uint8_t* out = &pixels[(y * size + x) * 4];
+							out[0] = static_cast<std::uint8_t>(
+								255.0f * (0.5f + 0.5f * std::cos(hue)));
+							out[1] = static_cast<std::uint8_t>(
+								255.0f * (0.5f + 0.5f * std::cos(hue - 2.094f)));
+							out[2] = static_cast<std::uint8_t>(
+								255.0f * (0.5f + 0.5f * std::cos(hue + 2.094f)));
+							out[3] = static_cast<std::uint8_t>(alpha * 255.0f);
+						}
+					}
+					atlas_.Add(
+						"shape_" + std::to_string(index++),
+						size,
+						size,
+						pixels.data());
+				}
+			}
+		}
+	}
+
+	void HelloSprites::Resize(std::size_t count)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_int_distribution<std::size_t> pick(0, names_.size() - 1);
+		std::uniform_int_distribution<int> layer(0, 3);
+		while (sprites_.size() < count)
+		{
+			Sprite sprite;
+			sprite.region = atlas_.GetRegion(names_[pick(rng_)]);
+			// The photos are big, keep everything sprite sized.
+			const float scale = 48.0f / std::max(
+				sprite.region.size.x,
+				sprite.region.size.y);
+			sprite.size = glm::vec2(sprite.region.size) *
+				std::min(scale * (0.5f + unit(rng_)), 1.0f);
+			sprite.position = glm::vec2(unit(rng_), unit(rng_)) * viewport_size_;
+			sprite.rotation = unit(rng_) * 6.2831853f;
+			sprite.color = glm::vec4(1.0f, 1.0f, 1.0f, 0.5f + 0.5f * unit(rng_));
+			sprite.layer = layer(rng_);
+			sprites_.push_back(sprite);
+			particles_.push_back({
+				(glm::vec2(unit(rng_), unit(rng_)) - 0.5f) * 400.0f,
+				(unit(rng_) - 0.5f) * 4.0f });
+		}
+		sprites_.resize(count);
+		particles_.resize(count);
+	}
+
+	void HelloSprites::Init()
+	{
+		std::string path = "../";
+
+		atlas_.LoadDirectory(path + "data/textures/");
+		GenerateShapes();
+		atlas_.Build();
+		names_ = atlas_.GetNames();
+
+		batch_.Init(path);
+		timer_query_.Create("HelloSprites timer");
+
+		Resize(sprite_count_);
+		glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloSprites::Update(seconds dt)
+	{
+		const float delta_time = dt.count();
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		viewport_size_ = glm::vec2(viewport[2], viewport[3]);
+
+		if (benchmark_step_ >= 0)
+		{
+			sprite_count_ = BENCHMARK_COUNTS[benchmark_step_];
+		}
+		Resize(sprite_count_);
+
+		// Simulation isn't part of the measure, only the batch is.
+		for (std::size_t i = 0; i < sprites_.size(); ++i)
+		{
+			Sprite& sprite = sprites_[i];
+			Particle& particle = particles_[i];
+			sprite.position += particle.velocity * delta_time;
+			sprite.rotation += particle.spin * delta_time;
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				if (sprite.position[axis] < 0.0f ||
+					sprite.position[axis] > viewport_size_[axis])
+				{
+					particle.velocity[axis] = -particle.velocity[axis];
+					sprite.position[axis] = std::clamp(
+						sprite.position[axis],
+						0.0f,
+						viewport_size_[axis]);
+				}
+			}
+		}
+
+		// GPU time of the previous frame, if it's there yet.
+		if (query_pending_)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(
+				timer_query_.Get(),
+				GL_QUERY_RESULT_AVAILABLE,
+				&available);
+			if (available)
+			{
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(
+					timer_query_.Get(),
+					GL_QUERY_RESULT,
+					&elapsed);
+				gpu_ms_ = static_cast<float>(elapsed) / 1e6f;
+				query_pending_ = false;
+			}
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		// Y down, pixels.
+		batch_.Begin(glm::ortho(
+			0.0f,
+			viewport_size_.x,
+			viewport_size_.y,
+			0.0f));
+		for (const auto& sprite : sprites_)
+		{
+			batch_.Draw(sprite);
+		}
+		if (!query_pending_) glBeginQuery(GL_TIME_ELAPSED, timer_query_.Get());
+		batch_.End();
+		if (!query_pending_)
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			query_pending_ = true;
+		}
+		submit_ms_ = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+		IsError(__FILE__, __LINE__);
+
+		if (benchmark_step_ >= 0)
+		{
+			// Skip the first frames, the count just changed.
+			if (benchmark_frame_ >= BENCHMARK_FRAMES / 4)
+			{
+				benchmark_cpu_ms_ += submit_ms_;
+			}
+			if (++benchmark_frame_ == BENCHMARK_FRAMES)
+			{
+				const float average_ms =
+					benchmark_cpu_ms_ / (BENCHMARK_FRAMES - BENCHMARK_FRAMES / 4);
+				benchmark_results_[benchmark_step_] =
+					BENCHMARK_COUNTS[benchmark_step_] / average_ms;
+				benchmark_frame_ = 0;
+				benchmark_cpu_ms_ = 0.0f;
+				if (++benchmark_step_ == static_cast<int>(BENCHMARK_COUNTS.size()))
+				{
+					benchmark_step_ = -1;
+					for (std::size_t i = 0; i < BENCHMARK_COUNTS.size(); ++i)
+					{
+						std::cout
+							<< BENCHMARK_COUNTS[i] << " sprites: "
+							<< benchmark_results_[i] << " sprites/ms\n";
+					}
+				}
+			}
+		}
+	}
+
+	void HelloSprites::Destroy()
+	{
+		batch_.Destroy();
+		atlas_.Destroy();
+		timer_query_.Reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloSprites::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloSprites::DrawImGui()
+	{
+		ImGui::Begin("Sprites");
+		ImGui::SliderInt("Sprites", &sprite_count_, 1000, 128000);
+		ImGui::Text(
+			"CPU: %.3f ms (%.0f sprites/ms), GPU: %.3f ms",
+			submit_ms_,
+			submit_ms_ > 0.0f ? sprite_count_ / submit_ms_ : 0.0f,
+			gpu_ms_);
+		batch_.DrawImGui();
+		if (benchmark_step_ < 0)
+		{
+			if (ImGui::Button("Run benchmark"))
+			{
+				benchmark_step_ = 0;
+				benchmark_frame_ = 0;
+				benchmark_cpu_ms_ = 0.0f;
+				benchmark_results_ = {};
+			}
+		}
+		else
+		{
+			ImGui::Text(
+				"Benchmarking %d sprites...",
+				BENCHMARK_COUNTS[benchmark_step_]);
+		}
+		for (std::size_t i = 0; i < BENCHMARK_COUNTS.size(); ++i)
+		{
+			if (benchmark_results_[i] <= 0.0f) continue;
+			ImGui::Text(
+				"%6d sprites: %.0f sprites/ms",
+				BENCHMARK_COUNTS[i],
+				benchmark_results_[i]);
+		}
+		atlas_.DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloSprites program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "engine.h"
+#include "camera.h"
+#include "shader.h"
+#include "mesh.h"
+#include "job_system.h"
+#include "texture_streaming.h"
+#include "imgui.h"
+
+namespace gl {
+
+	// Avenue of crates, each with its own 2048x2048 texture. With every mip
+	// resident the set is a bit over 4 GB, the streamer keeps it in 512 MB
+	// by only loading the levels the screen can actually show.
+	class HelloStreaming : public Program
+	{
+	public:
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+
+	protected:
+		struct Crate
+		{
+			glm::mat4 model;
+			glm::vec3 center;
+			std::uint32_t texture;
+		};
+
+		Mesh cube_;
+		std::vector<Crate> crates_;
+
+		float delta_time_ = 0.0f;
+		bool show_levels_ = false;
+		std::size_t drawn_count_ = 0;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<JobSystem> jobs_ = nullptr;
+		std::unique_ptr<TextureStreamer> streamer_ = nullptr;
+
+		const int texture_size_ = 2048;
+		const float crate_size_ = 2.0f;
+		const float z_near_ = 0.1f;
+		const float z_far_ = 500.0f;
+	};
+
+	namespace {
+
+		// Detail at every scale: big colored tiles, a grid every 64 texels
+		// and a one texel hairline grid only the finest level can show.
+		MipGenerator MakeCrateGenerator(std::uint32_t seed, int size)
+		{
+			return [seed, size](int level, int width, int height) {
+				std::vector<std::uint8_t> pixels(
+					static_cast<std::size_t>(width) * height * 4);
+				const int scale = size / width;
+				const float hue = static_cast<float>(seed % 97) / 97.0f * 6.2831853f;
+				for (int y = 0; y < height; ++y)
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						const int tx = x * scale;
+						const int ty = y * scale;
+						const bool tile = ((tx / 512) + (ty / 512)) % 2 != 0;
+						float light = tile ? 0.9f : 0.5f;
+						if (tx % 64 < scale || ty % 64 < scale) light *= 0.6f;
+						if (level == 0 && (tx % 8 == 0 || ty % 8 == 0))
+							light *= 0.85f;
+						std::uint8_t* p =
+							&pixels[(static_cast<std::size_t>(y) * width + x) * 4];
+						p[0] = static_cast<std::uint8_t>(
+							255.0f * light * (0.5f + 0.5f * std::cos(hue)));
+						p[1] = static_cast<std::uint8_t>(
+							255.0f * light * (0.5f + 0.5f * std::cos(hue - 2.094f)));
+						p[2] = static_cast<std::uint8_t>(
+							255.0f * light * (0.5f + 0.5f * std::cos(hue + 2.094f)));
+						p[3] = 255;
+					}
+				}
+				return pixels;
+			};
+		}
+
+	} // End anonymous namespace.
+
+	void HelloStreaming::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	void HelloStreaming::Init()
+	{
+		cube_.Init(CreateCube());
+
+		jobs_ = std::make_unique<JobSystem>();
+		streamer_ = std::make_unique<TextureStreamer>(*jobs_, 512 * 1024 * 1024);
+
+		// 2 rows of 96 crates along -z.
+		for (int i = 0; i < 192; ++i)
+		{
+			Crate crate;
+			crate.center = glm::vec3(
+				(i % 2 == 0) ? -3.0f : 3.0f,
+				crate_size_ * 0.5f,
+				-static_cast<float>(i / 2) * 4.0f);
+			crate.model = glm::scale(
+				glm::translate(glm::mat4(1.0f), crate.center),
+				glm::vec3(crate_size_));
+			crate.texture = streamer_->Add(
+				texture_size_,
+				texture_size_,
+				MakeCrateGenerator(static_cast<std::uint32_t>(i), texture_size_));
+			crates_.push_back(crate);
+		}
+
+		camera_ = std::make_unique<Camera>(glm::vec3(0.0f, 1.8f, 4.0f));
+
+		std::string path = "../";
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_streaming/streaming.vert",
+			path + "data/shaders/hello_streaming/streaming.frag");
+		shaders_->Use();
+		shaders_->SetInt("textureDiffuse", 0);
+
+		glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloStreaming::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		camera_->ProcessKeyboardState(20.0f * delta_time_);
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::mat4 view = camera_->GetViewMatrix();
+		const glm::mat4 projection = glm::perspective(
+			glm::radians(camera_->Zoom),
+			static_cast<float>(viewport[2]) / static_cast<float>(viewport[3]),
+			z_near_,
+			z_far_);
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shaders_->Use();
+		shaders_->SetMat4("view", view);
+		shaders_->SetMat4("projection", projection);
+		shaders_->SetBool("show_levels", show_levels_);
+		glBindVertexArray(cube_.GetVao());
+
+		// The draw list is the feedback: only what gets drawn asks for mips.
+		streamer_->BeginFrame(*camera_, viewport[3]);
+		const float radius = crate_size_ * 0.87f;
+		// A cube face maps [0, 1] in UV to its edge.
+		const float uv_density = 1.0f / crate_size_;
+		drawn_count_ = 0;
+		for (const auto& crate : crates_)
+		{
+			const glm::vec3 to_crate = crate.center - camera_->position;
+			if (glm::dot(to_crate, camera_->front) < -radius) continue;
+			if (glm::length(to_crate) > z_far_ + radius) continue;
+			streamer_->Request(crate.texture, crate.center, radius, uv_density);
+			streamer_->Bind(crate.texture, 0);
+			shaders_->SetInt(
+				"base_level",
+				streamer_->GetResidentLevel(crate.texture));
+			shaders_->SetMat4("model", crate.model);
+			shaders_->SetMat4("model_inverse", glm::transpose(glm::inverse(crate.model)));
+			glDrawElements(
+				GL_TRIANGLES,
+				cube_.GetIndexCount(),
+				GL_UNSIGNED_INT,
+				0);
+			++drawn_count_;
+		}
+		glBindVertexArray(0);
+		IsError(__FILE__, __LINE__);
+		streamer_->Update(delta_time_);
+	}
+
+	void HelloStreaming::Destroy()
+	{
+		streamer_->Destroy();
+		streamer_.reset();
+		jobs_.reset();
+		cube_.Destroy();
+		shaders_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloStreaming::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloStreaming::DrawImGui()
+	{
+		ImGui::Begin("Texture streaming");
+		ImGui::Text(
+			"Crates drawn: %zu / %zu",
+			drawn_count_,
+			crates_.size());
+		ImGui::Checkbox("Show mip levels", &show_levels_);
+		streamer_->DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+int main(int argc, char** argv)
+{
+	gl::HelloStreaming program;
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
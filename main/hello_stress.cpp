@@ -0,0 +1,861 @@
+#include <SDL_main.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "engine.h"
+#include "camera.h"
+#include "input.h"
+#include "shader.h"
+#include "light.h"
+#include "mesh.h"
+#include "render_queue.h"
+#include "simd_math.h"
+#include "startup.h"
+#include "imgui.h"
+
+// Procedural stress scene, to see where each subsystem stops scaling:
+//     hello_stress [--objects N] [--meshes M] [--lights K] [--textures T]
+//         [--moving F] [--seed S] [--layout grid|random]
+//         [--sweep name=v1,v2,...]... [--warmup W] [--frames F] [--csv path]
+// Without --sweep the scene is explored from ImGui. Each --sweep (objects,
+// meshes, lights, textures, moving, seed) multiplies the points, every
+// point is generated, warmed up for W frames, timed over F frames and
+// written as a row of the CSV, then the program quits. Every row also
+// carries the time to the first frame of the run (Startup).
+namespace gl {
+
+	enum class StressLayoutEnum {
+		GRID,
+		RANDOM
+	};
+
+	// What a stress scene is generated from, the same parameters give the
+	// same scene.
+	struct StressParams
+	{
+		int object_count = 4096;
+		int mesh_count = 8;
+		int light_count = 1024;
+		int texture_count = 8;
+		// Of the objects and of the lights, animated every frame.
+		float moving_fraction = 0.1f;
+		std::uint32_t seed = 5300;
+		StressLayoutEnum layout = StressLayoutEnum::GRID;
+	};
+
+	// Milliseconds spent in each part of a frame.
+	struct StressStages
+	{
+		// Transforms of the moving objects (CPU).
+		float animate_ms = 0.0f;
+		// Bounds and frustum test (CPU).
+		float cull_ms = 0.0f;
+		// Submit and flush of the render queue (CPU).
+		float submit_ms = 0.0f;
+		// Light buffer upload (CPU).
+		float upload_ms = 0.0f;
+		// Light binning into the clusters (GPU).
+		float light_gpu_ms = 0.0f;
+		// Pre-pass and shading of the queue (GPU).
+		float draw_gpu_ms = 0.0f;
+	};
+
+	class HelloStress : public Program
+	{
+	public:
+		// No points is the interactive scene.
+		HelloStress(
+			const StressParams& params,
+			std::vector<StressParams> points,
+			int warmup_frames,
+			int measured_frames,
+			std::string csv_path);
+		void Preload() override;
+		void Init() override;
+		void Update(seconds dt) override;
+		void Destroy() override;
+		void OnEvent(SDL_Event& event) override;
+		void DrawImGui() override;
+		bool IsBenchmark() const override { return !points_.empty(); }
+
+	protected:
+		void IsError(const std::string& file, int line) const;
+		void Generate();
+		void GenerateMeshes(std::mt19937& rng);
+		void GenerateTextures(std::mt19937& rng);
+		void Animate();
+		void Cull();
+		void Submit();
+		// Sweep bookkeeping at the start of a frame, false once done.
+		bool Measure(float frame_ms);
+		void WriteRow();
+		static float Milliseconds(
+			std::chrono::steady_clock::time_point start,
+			std::chrono::steady_clock::time_point end);
+
+	protected:
+		StressParams params_;
+		std::vector<StressParams> points_;
+		std::size_t point_ = 0;
+		int point_frame_ = 0;
+		int warmup_frames_ = 60;
+		int measured_frames_ = 240;
+		std::string csv_path_;
+		std::ofstream csv_;
+
+		float time_ = 0.0f;
+		float delta_time_ = 0.0f;
+
+		std::unique_ptr<Camera> camera_ = nullptr;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		std::unique_ptr<ClusteredLighting> lighting_ = nullptr;
+		std::unique_ptr<RenderQueue> render_queue_ = nullptr;
+		GpuTimer light_timer_;
+		GpuTimer draw_timer_;
+
+		std::vector<Mesh> meshes_;
+		std::vector<DepthStream> depth_streams_;
+		std::vector<Aabb> mesh_bounds_;
+		std::vector<TextureHandle> textures_;
+
+		// Per object, the moving ones first.
+		std::size_t moving_count_ = 0;
+		std::vector<glm::vec4> origins_;
+		std::vector<glm::vec3> axes_;
+		std::vector<glm::vec3> positions_;
+		std::vector<glm::quat> rotations_;
+		std::vector<glm::vec3> scales_;
+		std::vector<glm::mat4> models_;
+		std::vector<Aabb> local_bounds_;
+		std::vector<Aabb> world_bounds_;
+		std::vector<std::uint32_t> object_meshes_;
+		std::vector<std::uint32_t> object_textures_;
+		std::vector<std::uint32_t> visible_;
+
+		std::size_t moving_light_count_ = 0;
+		std::vector<glm::vec4> light_origins_;
+		std::vector<PointLight> lights_;
+		float extent_ = 0.0f;
+
+		// This frame, and the sums over the measured frames of a point.
+		StressStages stages_;
+		StressStages stage_sums_;
+		int light_gpu_samples_ = 0;
+		int draw_gpu_samples_ = 0;
+		std::vector<float> frame_ms_;
+		std::uint64_t visible_sum_ = 0;
+
+		glm::mat4 view_ = glm::mat4(1.0f);
+		glm::mat4 projection_ = glm::mat4(1.0f);
+
+		const float spacing_ = 3.0f;
+		const float z_near_ = 0.1f;
+		const float z_far_ = 1000.0f;
+	};
+
+	HelloStress::HelloStress(
+		const StressParams& params,
+		std::vector<StressParams> points,
+		int warmup_frames,
+		int measured_frames,
+		std::string csv_path) :
+		params_(params),
+		points_(std::move(points)),
+		warmup_frames_(std::max(warmup_frames, 0)),
+		measured_frames_(std::max(measured_frames, 1)),
+		csv_path_(std::move(csv_path))
+	{
+		if (!points_.empty()) params_ = points_.front();
+	}
+
+	void HelloStress::IsError(const std::string& file, int line) const
+	{
+		auto error_code = glGetError();
+		if (error_code != GL_NO_ERROR)
+		{
+			std::cerr
+				<< error_code
+				<< " in file: " << file
+				<< " at line: " << line
+				<< "\n";
+		}
+	}
+
+	float HelloStress::Milliseconds(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	void HelloStress::Preload()
+	{
+		auto& startup = Startup::GetInstance();
+		startup.AddPrefetch("../data/shaders/hello_light");
+		startup.AddPrefetch("../data/shaders/clustered");
+	}
+
+	void HelloStress::Init()
+	{
+		std::string path = "../";
+
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_light/lightShader.vert",
+			path + "data/shaders/hello_light/lightShader.frag");
+
+		// Sized once for the largest light count of the sweep.
+		unsigned int max_lights = 8192;
+		for (const auto& point : points_)
+		{
+			max_lights = std::max<unsigned int>(max_lights, point.light_count);
+		}
+		max_lights = std::max<unsigned int>(max_lights, params_.light_count);
+		lighting_ = std::make_unique<ClusteredLighting>(
+			glm::ivec3(16, 9, 24),
+			max_lights);
+		lighting_->Init(path);
+
+		render_queue_ = std::make_unique<RenderQueue>();
+		render_queue_->Init(path);
+
+		if (!points_.empty())
+		{
+			csv_.open(csv_path_);
+			if (!csv_)
+			{
+				throw std::runtime_error("Could not write " + csv_path_ + ".");
+			}
+			csv_
+				<< "objects,meshes,lights,textures,moving,seed,layout,visible,"
+				<< "frame_ms,frame_p50_ms,frame_p95_ms,frame_p99_ms,frame_max_ms,"
+				<< "animate_ms,cull_ms,submit_ms,upload_ms,light_gpu_ms,draw_gpu_ms,"
+				<< "time_to_first_frame_ms\n";
+		}
+		Generate();
+
+		shaders_->Use();
+		shaders_->SetInt("textureDiffuse", 0);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloStress::GenerateMeshes(std::mt19937& rng)
+	{
+		for (auto& stream : depth_streams_)
+		{
+			render_queue_->DestroyDepthStream(stream);
+		}
+		for (auto& mesh : meshes_)
+		{
+			mesh.Destroy();
+		}
+		const int count = std::max(params_.mesh_count, 1);
+		meshes_ = std::vector<Mesh>(count);
+		depth_streams_.resize(count);
+		mesh_bounds_.resize(count);
+		std::uniform_int_distribution<int> slices(6, 48);
+		for (int i = 0; i < count; ++i)
+		{
+			// Cubes and spheres of every density, the vertex count varies.
+			const int slice_count = slices(rng);
+			const MeshData data = (i % 4 == 0) ?
+				CreateCube() :
+				CreateSphere(slice_count, std::max(slice_count / 2, 3));
+			meshes_[i].Init(data);
+			const std::vector<glm::vec3> positions = data.GetPositions();
+			depth_streams_[i] = render_queue_->CreateDepthStream(
+				positions,
+				meshes_[i].GetEbo());
+			Aabb bounds{ positions.front(), positions.front() };
+			for (const auto& position : positions)
+			{
+				bounds.min = glm::min(bounds.min, position);
+				bounds.max = glm::max(bounds.max, position);
+			}
+			mesh_bounds_[i] = bounds;
+		}
+	}
+
+	void HelloStress::GenerateTextures(std::mt19937& rng)
+	{
+		constexpr int size = 64;
+		const int count = std::max(params_.texture_count, 1);
+		textures_ = std::vector<TextureHandle>(count);
+		std::uniform_int_distribution<int> channel(64, 255);
+		std::uniform_int_distribution<int> checker(2, 16);
+		std::vector<std::uint8_t> pixels(size * size * 4);
+		for (int i = 0; i < count; ++i)
+		{
+			// A checker of two random colors.
+			const std::array<std::uint8_t, 8> colors = {
+				static_cast<std::uint8_t>(channel(rng)),
+				static_cast<std::uint8_t>(channel(rng)),
+				static_cast<std::uint8_t>(channel(rng)),
+				255,
+				static_cast<std::uint8_t>(channel(rng) / 2),
+				static_cast<std::uint8_t>(channel(rng) / 2),
+				static_cast<std::uint8_t>(channel(rng) / 2),
+				255 };
+			const int cell = size / checker(rng);
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const int odd = ((x / cell) + (y / cell)) % 2;
+					std::memcpy(&pixels[(y * size + x) * 4], &colors[odd * 4], 4);
+				}
+			}
+			textures_[i].Create("Stress texture");
+			textures_[i].SetBytes(EstimateTextureBytes(GL_RGBA8, size, size, 0));
+			glBindTexture(GL_TEXTURE_2D, textures_[i].Get());
+			glTexImage2D(
+				GL_TEXTURE_2D,
+				0,
+				GL_RGBA8,
+				size,
+				size,
+				0,
+				GL_RGBA,
+				GL_UNSIGNED_BYTE,
+				pixels.data());
+			glTexParameteri(
+				GL_TEXTURE_2D,
+				GL_TEXTURE_MIN_FILTER,
+				GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			IsError(__FILE__, __LINE__);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	void HelloStress::Generate()
+	{
+		std::mt19937 rng(params_.seed);
+		GenerateMeshes(rng);
+		GenerateTextures(rng);
+
+		const auto count = static_cast<std::size_t>(std::max(params_.object_count, 0));
+		const float fraction = std::clamp(params_.moving_fraction, 0.0f, 1.0f);
+		const auto side = static_cast<std::size_t>(
+			std::ceil(std::sqrt(static_cast<float>(std::max<std::size_t>(count, 1)))));
+		extent_ = side * spacing_;
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+		std::uniform_int_distribution<std::uint32_t> mesh(0, meshes_.size() - 1);
+		std::uniform_int_distribution<std::uint32_t> texture(0, textures_.size() - 1);
+		std::vector<glm::vec3> places(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (params_.layout == StressLayoutEnum::GRID)
+			{
+				places[i] = glm::vec3(
+					(i % side + 0.5f) * spacing_ - extent_ * 0.5f + jitter(rng),
+					0.0f,
+					(i / side + 0.5f) * spacing_ - extent_ * 0.5f + jitter(rng));
+			}
+			else
+			{
+				places[i] = glm::vec3(
+					(unit(rng) - 0.5f) * extent_,
+					0.0f,
+					(unit(rng) - 0.5f) * extent_);
+			}
+		}
+		// The moving objects come first, anywhere in the field.
+		std::shuffle(places.begin(), places.end(), rng);
+		moving_count_ = static_cast<std::size_t>(std::round(count * fraction));
+
+		origins_.resize(count);
+		axes_.resize(count);
+		positions_.resize(count);
+		rotations_.resize(count);
+		scales_.resize(count);
+		models_.resize(count);
+		local_bounds_.resize(count);
+		world_bounds_.resize(count);
+		object_meshes_.resize(count);
+		object_textures_.resize(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const float scale = 0.6f + unit(rng) * 1.4f;
+			places[i].y = scale * 0.5f;
+			// The phase goes in w.
+			origins_[i] = glm::vec4(places[i], unit(rng) * glm::pi<float>() * 2.0f);
+			axes_[i] = glm::normalize(glm::vec3(jitter(rng), 1.0f, jitter(rng)));
+			positions_[i] = places[i];
+			rotations_[i] = glm::angleAxis(origins_[i].w, axes_[i]);
+			scales_[i] = glm::vec3(scale);
+			object_meshes_[i] = mesh(rng);
+			object_textures_[i] = texture(rng);
+			local_bounds_[i] = mesh_bounds_[object_meshes_[i]];
+		}
+		ComposeTransforms(positions_, rotations_, scales_, models_);
+		TransformAabbs(models_, local_bounds_, world_bounds_);
+
+		const auto light_count = std::min<std::size_t>(
+			std::max(params_.light_count, 0),
+			lighting_->GetMaxLights());
+		moving_light_count_ =
+			static_cast<std::size_t>(std::round(light_count * fraction));
+		light_origins_.resize(light_count);
+		lights_.resize(light_count);
+		for (std::size_t i = 0; i < light_count; ++i)
+		{
+			light_origins_[i] = glm::vec4(
+				(unit(rng) - 0.5f) * extent_,
+				0.5f + unit(rng) * 2.5f,
+				(unit(rng) - 0.5f) * extent_,
+				unit(rng) * glm::pi<float>() * 2.0f);
+			lights_[i].position_radius = glm::vec4(
+				glm::vec3(light_origins_[i]),
+				spacing_ * 1.5f);
+			lights_[i].color_intensity = glm::vec4(unit(rng), unit(rng), unit(rng), 4.0f);
+		}
+		lighting_->SetLights(lights_);
+
+		// Looking down over the field, fixed so sweeps are comparable.
+		camera_ = std::make_unique<Camera>(
+			glm::vec3(0.0f, std::max(extent_ * 0.25f, 8.0f), extent_ * 0.5f + 10.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			-90.0f,
+			-30.0f);
+		time_ = 0.0f;
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloStress::Animate()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < moving_count_; ++i)
+		{
+			const glm::vec4& origin = origins_[i];
+			positions_[i].y = origin.y + std::sin(time_ * 2.0f + origin.w) * 0.5f;
+			rotations_[i] = glm::angleAxis(origin.w + time_, axes_[i]);
+		}
+		const std::span<const glm::vec3> positions(positions_.data(), moving_count_);
+		const std::span<const glm::quat> rotations(rotations_.data(), moving_count_);
+		const std::span<const glm::vec3> scales(scales_.data(), moving_count_);
+		const std::span<glm::mat4> models(models_.data(), moving_count_);
+		ComposeTransforms(positions, rotations, scales, models);
+		const auto animated = std::chrono::steady_clock::now();
+		stages_.animate_ms = Milliseconds(start, animated);
+
+		for (std::size_t i = 0; i < moving_light_count_; ++i)
+		{
+			const glm::vec4& origin = light_origins_[i];
+			const float phase = origin.w + time_;
+			lights_[i].position_radius.x = origin.x + std::cos(phase) * spacing_;
+			lights_[i].position_radius.z = origin.z + std::sin(phase) * spacing_;
+		}
+		if (moving_light_count_)
+		{
+			lighting_->SetLights(lights_);
+		}
+		stages_.upload_ms = Milliseconds(animated, std::chrono::steady_clock::now());
+	}
+
+	void HelloStress::Cull()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		TransformAabbs(
+			std::span<const glm::mat4>(models_.data(), moving_count_),
+			std::span<const Aabb>(local_bounds_.data(), moving_count_),
+			std::span<Aabb>(world_bounds_.data(), moving_count_));
+		// Planes of the view frustum, pointing in.
+		const glm::mat4 view_projection = projection_ * view_;
+		const glm::mat4 rows = glm::transpose(view_projection);
+		const glm::vec4 row0 = rows[0];
+		const glm::vec4 row1 = rows[1];
+		const glm::vec4 row2 = rows[2];
+		const glm::vec4 row3 = rows[3];
+		const std::array<glm::vec4, 6> planes = {
+			row3 + row0, row3 - row0,
+			row3 + row1, row3 - row1,
+			row3 + row2, row3 - row2
+		};
+		visible_.clear();
+		for (std::size_t i = 0; i < world_bounds_.size(); ++i)
+		{
+			const Aabb& box = world_bounds_[i];
+			bool inside = true;
+			for (const auto& plane : planes)
+			{
+				// Corner furthest along the plane normal.
+				const glm::vec3 corner(
+					plane.x > 0.0f ? box.max.x : box.min.x,
+					plane.y > 0.0f ? box.max.y : box.min.y,
+					plane.z > 0.0f ? box.max.z : box.min.z);
+				if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+				{
+					inside = false;
+					break;
+				}
+			}
+			if (inside) visible_.push_back(static_cast<std::uint32_t>(i));
+		}
+		stages_.cull_ms = Milliseconds(start, std::chrono::steady_clock::now());
+	}
+
+	void HelloStress::Submit()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (const auto index : visible_)
+		{
+			const std::uint32_t mesh = object_meshes_[index];
+			DrawItem item;
+			item.vao = meshes_[mesh].GetVao();
+			item.depth_vao = depth_streams_[mesh].vao.Get();
+			item.index_count = meshes_[mesh].GetIndexCount();
+			item.model = models_[index];
+			item.texture = textures_[object_textures_[index]].Get();
+			render_queue_->Submit(item);
+		}
+		draw_timer_.Begin();
+		render_queue_->Flush(view_, projection_, *shaders_);
+		draw_timer_.End();
+		stages_.submit_ms = Milliseconds(start, std::chrono::steady_clock::now());
+	}
+
+	bool HelloStress::Measure(float frame_ms)
+	{
+		if (point_ == points_.size()) return false;
+		// The time step is of the frame before, of this point once past
+		// the first.
+		if (point_frame_ > warmup_frames_)
+		{
+			frame_ms_.push_back(frame_ms);
+			stage_sums_.animate_ms += stages_.animate_ms;
+			stage_sums_.cull_ms += stages_.cull_ms;
+			stage_sums_.submit_ms += stages_.submit_ms;
+			stage_sums_.upload_ms += stages_.upload_ms;
+			visible_sum_ += visible_.size();
+		}
+		// GPU results come back a few frames late.
+		const bool measuring = point_frame_ > warmup_frames_;
+		if (light_timer_.Resolve() && measuring)
+		{
+			stage_sums_.light_gpu_ms += light_timer_.GetMilliseconds();
+			++light_gpu_samples_;
+		}
+		if (draw_timer_.Resolve() && measuring)
+		{
+			stage_sums_.draw_gpu_ms += draw_timer_.GetMilliseconds();
+			++draw_gpu_samples_;
+		}
+		if (point_frame_ < warmup_frames_ + measured_frames_)
+		{
+			return true;
+		}
+
+		WriteRow();
+		stage_sums_ = {};
+		light_gpu_samples_ = 0;
+		draw_gpu_samples_ = 0;
+		frame_ms_.clear();
+		visible_sum_ = 0;
+		point_frame_ = 0;
+		if (++point_ == points_.size())
+		{
+			csv_.close();
+			std::cout << "Wrote " << csv_path_ << "\n";
+			SDL_Event quit{};
+			quit.type = SDL_QUIT;
+			SDL_PushEvent(&quit);
+			return false;
+		}
+		params_ = points_[point_];
+		Generate();
+		return true;
+	}
+
+	void HelloStress::WriteRow()
+	{
+		std::vector<float> sorted = frame_ms_;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](float p) {
+			const auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5f);
+			return sorted[index];
+		};
+		float sum = 0.0f;
+		for (const float ms : sorted) sum += ms;
+		const auto frames = static_cast<float>(sorted.size());
+		std::ostringstream row;
+		row
+			<< params_.object_count << ","
+			<< params_.mesh_count << ","
+			<< params_.light_count << ","
+			<< params_.texture_count << ","
+			<< params_.moving_fraction << ","
+			<< params_.seed << ","
+			<< (params_.layout == StressLayoutEnum::GRID ? "grid" : "random") << ","
+			<< visible_sum_ / sorted.size() << ","
+			<< sum / frames << ","
+			<< percentile(0.5f) << ","
+			<< percentile(0.95f) << ","
+			<< percentile(0.99f) << ","
+			<< sorted.back() << ","
+			<< stage_sums_.animate_ms / frames << ","
+			<< stage_sums_.cull_ms / frames << ","
+			<< stage_sums_.submit_ms / frames << ","
+			<< stage_sums_.upload_ms / frames << ","
+			<< stage_sums_.light_gpu_ms / std::max(light_gpu_samples_, 1) << ","
+			<< stage_sums_.draw_gpu_ms / std::max(draw_gpu_samples_, 1) << ","
+			<< Startup::GetInstance().GetTimeToFirstFrame() << "\n";
+		csv_ << row.str();
+		csv_.flush();
+		std::cout
+			<< "[" << point_ + 1 << "/" << points_.size() << "] " << row.str();
+	}
+
+	void HelloStress::Update(seconds dt)
+	{
+		delta_time_ = dt.count();
+		if (!points_.empty())
+		{
+			if (!Measure(delta_time_ * 1000.0f)) return;
+			++point_frame_;
+			// Fixed step, every run animates the same.
+			time_ += 1.0f / 60.0f;
+		}
+		else
+		{
+			camera_->ProcessKeyboardState(40.0f * delta_time_);
+			time_ += delta_time_;
+			light_timer_.Resolve();
+			draw_timer_.Resolve();
+		}
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		const glm::vec2 screen_size(viewport[2], viewport[3]);
+		view_ = camera_->GetViewMatrix();
+		projection_ = glm::perspective(
+			glm::radians(camera_->Zoom),
+			screen_size.x / screen_size.y,
+			z_near_,
+			z_far_);
+
+		Animate();
+		Cull();
+		light_timer_.Begin();
+		lighting_->Update(view_, projection_, screen_size, z_near_, z_far_);
+		light_timer_.End();
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		IsError(__FILE__, __LINE__);
+		shaders_->Use();
+		lighting_->Bind(*shaders_);
+		shaders_->SetMat4("view", view_);
+		shaders_->SetMat4("projection", projection_);
+		shaders_->SetVec3("camera_pos", camera_->position);
+		Submit();
+	}
+
+	void HelloStress::Destroy()
+	{
+		for (auto& stream : depth_streams_)
+		{
+			render_queue_->DestroyDepthStream(stream);
+		}
+		depth_streams_.clear();
+		meshes_.clear();
+		textures_.clear();
+		light_timer_.Destroy();
+		draw_timer_.Destroy();
+		lighting_->Destroy();
+		render_queue_->Destroy();
+		shaders_.reset();
+		IsError(__FILE__, __LINE__);
+	}
+
+	void HelloStress::OnEvent(SDL_Event& event)
+	{
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
+		{
+			exit(0);
+		}
+	}
+
+	void HelloStress::DrawImGui()
+	{
+		ImGui::Begin("Stress scene");
+		if (!points_.empty())
+		{
+			ImGui::Text(
+				"Sweep point %d / %d, frame %d",
+				static_cast<int>(point_ + 1),
+				static_cast<int>(points_.size()),
+				point_frame_);
+		}
+		else
+		{
+			ImGui::SliderInt("Objects", &params_.object_count, 1, 100000);
+			ImGui::SliderInt("Meshes", &params_.mesh_count, 1, 256);
+			ImGui::SliderInt(
+				"Lights",
+				&params_.light_count,
+				0,
+				static_cast<int>(lighting_->GetMaxLights()));
+			ImGui::SliderInt("Textures", &params_.texture_count, 1, 1024);
+			ImGui::SliderFloat("Moving", &params_.moving_fraction, 0.0f, 1.0f);
+			int seed = static_cast<int>(params_.seed);
+			if (ImGui::InputInt("Seed", &seed))
+			{
+				params_.seed = static_cast<std::uint32_t>(seed);
+			}
+			bool random = params_.layout == StressLayoutEnum::RANDOM;
+			if (ImGui::Checkbox("Random layout", &random))
+			{
+				params_.layout = random ?
+					StressLayoutEnum::RANDOM : StressLayoutEnum::GRID;
+			}
+			if (ImGui::Button("Generate"))
+			{
+				Generate();
+			}
+		}
+		ImGui::Separator();
+		ImGui::Text(
+			"Visible %d / %d",
+			static_cast<int>(visible_.size()),
+			static_cast<int>(models_.size()));
+		ImGui::Text("Animate %.3f ms", stages_.animate_ms);
+		ImGui::Text("Cull %.3f ms", stages_.cull_ms);
+		ImGui::Text("Submit %.3f ms", stages_.submit_ms);
+		ImGui::Text("Upload %.3f ms", stages_.upload_ms);
+		ImGui::Text("Light binning (GPU) %.3f ms", light_timer_.GetMilliseconds());
+		ImGui::Text("Draw (GPU) %.3f ms", draw_timer_.GetMilliseconds());
+		ImGui::End();
+		ImGui::Begin("Render queue");
+		render_queue_->DrawImGui();
+		ImGui::End();
+	}
+
+} // End namespace gl.
+
+namespace {
+
+	void PrintUsage(const char* name)
+	{
+		std::cerr
+			<< "usage: " << name
+			<< " [--objects N] [--meshes M] [--lights K] [--textures T]"
+			<< " [--moving F] [--seed S] [--layout grid|random]"
+			<< " [--sweep name=v1,v2,...]... [--warmup W] [--frames F]"
+			<< " [--csv path]\n";
+	}
+
+	// False for an unknown name.
+	bool SetParam(gl::StressParams& params, const std::string& name, float value)
+	{
+		if (name == "objects") params.object_count = static_cast<int>(value);
+		else if (name == "meshes") params.mesh_count = static_cast<int>(value);
+		else if (name == "lights") params.light_count = static_cast<int>(value);
+		else if (name == "textures") params.texture_count = static_cast<int>(value);
+		else if (name == "moving") params.moving_fraction = value;
+		else if (name == "seed") params.seed = static_cast<std::uint32_t>(value);
+		else return false;
+		return true;
+	}
+
+} // End anonymous namespace.
+
+int main(int argc, char** argv)
+{
+	gl::StressParams params;
+	// Every combination of the swept values.
+	std::vector<gl::StressParams> points;
+	int warmup_frames = 60;
+	int measured_frames = 240;
+	std::string csv_path = "stress.csv";
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (i + 1 >= argc || arg.rfind("--", 0) != 0)
+		{
+			PrintUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		const std::string value = argv[++i];
+		if (arg == "--layout")
+		{
+			params.layout = value == "random" ?
+				gl::StressLayoutEnum::RANDOM : gl::StressLayoutEnum::GRID;
+			for (auto& point : points) point.layout = params.layout;
+		}
+		else if (arg == "--warmup")
+		{
+			warmup_frames = std::atoi(value.c_str());
+		}
+		else if (arg == "--frames")
+		{
+			measured_frames = std::atoi(value.c_str());
+		}
+		else if (arg == "--csv")
+		{
+			csv_path = value;
+		}
+		else if (arg == "--sweep")
+		{
+			const auto equal = value.find('=');
+			const std::string name = value.substr(0, equal);
+			gl::StressParams check;
+			if (equal == std::string::npos || !SetParam(check, name, 0.0f))
+			{
+				PrintUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			std::vector<float> values;
+			std::istringstream list(value.substr(equal + 1));
+			std::string item;
+			while (std::getline(list, item, ','))
+			{
+				values.push_back(std::strtof(item.c_str(), nullptr));
+			}
+			// The last sweep varies fastest.
+			if (points.empty()) points.push_back(params);
+			std::vector<gl::StressParams> swept;
+			for (auto point : points)
+			{
+				for (const float swept_value : values)
+				{
+					SetParam(point, name, swept_value);
+					swept.push_back(point);
+				}
+			}
+			points = std::move(swept);
+		}
+		else
+		{
+			const std::string name = arg.substr(2);
+			const float number = std::strtof(value.c_str(), nullptr);
+			if (!SetParam(params, name, number))
+			{
+				PrintUsage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			for (auto& point : points) SetParam(point, name, number);
+		}
+	}
+	gl::HelloStress program(params, points, warmup_frames, measured_frames, csv_path);
+	gl::Engine engine(program);
+	engine.Run();
+	return EXIT_SUCCESS;
+}
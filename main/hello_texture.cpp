@@ -3,12 +3,12 @@
 #include <array>
 #include <string>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 
 #include "engine.h"
+#include "gpu_resource.h"
+#include "shader.h"
+#include "texture_residency.h"
+#include "imgui.h"
 
 namespace gl {
 
@@ -22,14 +22,13 @@ namespace gl {
 		void DrawImGui() override;
 
 	protected:
-		unsigned int VAO_;
-		unsigned int VBO_;
-		unsigned int EBO_;
-		unsigned int vertex_shader_;
-		unsigned int fragment_shader_;
-		unsigned int program_;
-		unsigned int texture_diffuse_;
-		unsigned int texture_smily_;
+		VertexArrayHandle VAO_;
+		BufferHandle VBO_;
+		BufferHandle EBO_;
+		std::uint32_t texture_diffuse_;
+		std::uint32_t texture_smily_;
+		std::unique_ptr<Shader> shaders_ = nullptr;
+		TextureResidency texture_residency_;
 		void IsError(const std::string& file, int line);
 	};
 
@@ -61,15 +60,16 @@ namespace gl {
 		};
 
 		// VAO binding should be before VAO.
-		glGenVertexArrays(1, &VAO_);
+		VAO_.Create("HelloTexture vertex array");
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 
 		// EBO.
-		glGenBuffers(1, &EBO_);
+		EBO_.Create("HelloTexture indices");
+		EBO_.SetBytes(indices.size() * sizeof(std::uint32_t));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ELEMENT_ARRAY_BUFFER,
@@ -81,9 +81,10 @@ namespace gl {
 		IsError(__FILE__, __LINE__);
 
 		// VBO.
-		glGenBuffers(1, &VBO_);
+		VBO_.Create("HelloTexture vertices");
+		VBO_.SetBytes(vertices.size() * sizeof(float));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ARRAY_BUFFER,
@@ -129,186 +130,21 @@ namespace gl {
 		IsError(__FILE__, __LINE__);
 
 		std::string path = "../";
-		{
-			std::string jpg_file = path + "data/textures/texture_diffuse.jpg";
-			int width, height, nrChannels;
-			// stbi_set_flip_vertically_on_load(true);
-			unsigned char* dataDiffuse = stbi_load(
-				jpg_file.c_str(), 
-				&width, 
-				&height, 
-				&nrChannels, 
-				0);
-			assert(dataDiffuse);
-
-			glGenTextures(1, &texture_diffuse_);
-			IsError(__FILE__, __LINE__);
-			glBindTexture(GL_TEXTURE_2D, texture_diffuse_);
-			IsError(__FILE__, __LINE__);
-			glTexImage2D(
-				GL_TEXTURE_2D, 
-				0, 
-				GL_RGB, 
-				width, 
-				height, 
-				0, 
-				GL_RGB, 
-				GL_UNSIGNED_BYTE, 
-				dataDiffuse);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(
-				GL_TEXTURE_2D, 
-				GL_TEXTURE_WRAP_S, 
-				GL_MIRRORED_REPEAT);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(
-				GL_TEXTURE_2D, 
-				GL_TEXTURE_WRAP_T, 
-				GL_MIRRORED_REPEAT);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			IsError(__FILE__, __LINE__);
-		}
-
-		{
-			std::string png_file = path + "data/textures/texture_smily.png";
-			int width, height, nrChannels;
-			// stbi_set_flip_vertically_on_load(true);
-			unsigned char* dataSmily = stbi_load(
-				png_file.c_str(),
-				&width,
-				&height,
-				&nrChannels,
-				0);
-			assert(dataSmily);
 
-			glGenTextures(1, &texture_smily_);
-			IsError(__FILE__, __LINE__);
-			glBindTexture(GL_TEXTURE_2D, texture_smily_);
-			IsError(__FILE__, __LINE__);
-			glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				GL_RGBA,
-				width,
-				height,
-				0,
-				GL_RGBA,
-				GL_UNSIGNED_BYTE,
-				dataSmily);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(
-				GL_TEXTURE_2D, 
-				GL_TEXTURE_WRAP_S, 
-				GL_MIRRORED_REPEAT);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(
-				GL_TEXTURE_2D, 
-				GL_TEXTURE_WRAP_T, 
-				GL_MIRRORED_REPEAT);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			IsError(__FILE__, __LINE__);
-			glGenerateMipmap(GL_TEXTURE_2D);
-			IsError(__FILE__, __LINE__);
-		}
+		// Textures are referenced by index, nothing gets bound per draw.
+		texture_residency_.Init();
+		texture_diffuse_ = texture_residency_.Load(
+			path + "data/textures/texture_diffuse.jpg");
+		texture_smily_ = texture_residency_.Load(
+			path + "data/textures/texture_smily.png");
+		texture_residency_.Commit();
 
-		std::ifstream ifs_vert(
-			path + "data/shaders/hello_texture/texture.vert");
-		std::ifstream ifs_frag(
+		shaders_ = std::make_unique<Shader>(
+			path + "data/shaders/hello_texture/texture.vert",
 			path + "data/shaders/hello_texture/texture.frag");
-
-		if (!ifs_vert.is_open())
-		{
-			throw std::runtime_error("Could not open vertex file.");
-		}
-		if (!ifs_frag.is_open())
-		{
-			throw std::runtime_error("Could not open fragment file.");
-		}
-
-		std::string vertex_source{ 
-			std::istreambuf_iterator<char>(ifs_vert), 
-			{} };
-		std::string fragment_source{ 
-			std::istreambuf_iterator<char>(ifs_frag), 
-			{} };
-
-		// Vertex shader.
-		vertex_shader_ = glCreateShader(GL_VERTEX_SHADER);
-		IsError(__FILE__, __LINE__);
-		const char* ptr1 = vertex_source.c_str();
-		glShaderSource(vertex_shader_, 1, &ptr1, 0);
-		IsError(__FILE__, __LINE__);
-		glCompileShader(vertex_shader_);
-		GLint status = 0;
-		glGetShaderiv(vertex_shader_, GL_COMPILE_STATUS, &status);
-		if (status == GL_FALSE) {
-			GLint infoLogLength;
-			glGetShaderiv(vertex_shader_, GL_INFO_LOG_LENGTH, &infoLogLength);
-			GLchar* infoLog = new GLchar[infoLogLength];
-			glGetShaderInfoLog(vertex_shader_, infoLogLength, NULL, infoLog);
-			std::stringstream iss{};
-			iss << "VS> could not compile: " << infoLog;
-			throw std::runtime_error(iss.str());
-		}
-
-		// Fragment shader.
-		fragment_shader_ = glCreateShader(GL_FRAGMENT_SHADER);
-		IsError(__FILE__, __LINE__);
-		const char* ptr2 = fragment_source.c_str();
-		glShaderSource(fragment_shader_, 1, &ptr2, 0);
-		IsError(__FILE__, __LINE__);
-		glCompileShader(fragment_shader_);
-		glGetShaderiv(vertex_shader_, GL_COMPILE_STATUS, &status);
-		if (status == GL_FALSE) {
-			GLint infoLogLength;
-			glGetShaderiv(vertex_shader_, GL_INFO_LOG_LENGTH, &infoLogLength);
-			GLchar* infoLog = new GLchar[infoLogLength];
-			glGetShaderInfoLog(vertex_shader_, infoLogLength, NULL, infoLog);
-			std::stringstream iss{};
-			iss << "FS> could not compile: " << infoLog;
-			throw std::runtime_error(iss.str());
-		}
-
-		// Program.
-		program_ = glCreateProgram();
-		IsError(__FILE__, __LINE__);
-		glAttachShader(program_, vertex_shader_);
-		IsError(__FILE__, __LINE__);
-		glAttachShader(program_, fragment_shader_);
-		IsError(__FILE__, __LINE__);
-		//glBindAttribLocation(program_, 0, "aPos");
-		glLinkProgram(program_);
-		IsError(__FILE__, __LINE__);
-		assert(program_ != 0);
-
-		// Bind uniform to program.
-		glUseProgram(program_);
-		IsError(__FILE__, __LINE__);
-		glActiveTexture(GL_TEXTURE0);
-		IsError(__FILE__, __LINE__);
-		glBindTexture(GL_TEXTURE_2D, texture_diffuse_);
-		IsError(__FILE__, __LINE__);
-		int location0 = glGetUniformLocation(program_, "textureDiffuse");
-		IsError(__FILE__, __LINE__);
-		glUniform1i(location0, 0);
-		IsError(__FILE__, __LINE__);
-
-		glActiveTexture(GL_TEXTURE1);
-		IsError(__FILE__, __LINE__);
-		glBindTexture(GL_TEXTURE_2D, texture_smily_);
-		IsError(__FILE__, __LINE__);
-		int location1 = glGetUniformLocation(program_, "textureSmily");
-		IsError(__FILE__, __LINE__);
-		glUniform1i(location1, 1);
-		IsError(__FILE__, __LINE__);
+		texture_residency_.Bind(*shaders_);
+		shaders_->SetInt("textureDiffuse", texture_diffuse_);
+		shaders_->SetInt("textureSmily", texture_smily_);
 
 		glClearColor(0.3f, 0.2f, 0.1f, 1.0f);
 		IsError(__FILE__, __LINE__);
@@ -318,11 +154,10 @@ namespace gl {
 	{
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		IsError(__FILE__, __LINE__);
-		glUseProgram(program_);
-		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		shaders_->Use();
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		IsError(__FILE__, __LINE__);
@@ -330,11 +165,11 @@ namespace gl {
 
 	void HelloTexture::Destroy()
 	{
-		glDeleteProgram(program_);
-		IsError(__FILE__, __LINE__);
-		glDeleteShader(vertex_shader_);
-		IsError(__FILE__, __LINE__);
-		glDeleteShader(fragment_shader_);
+		texture_residency_.Destroy();
+		VAO_.Reset();
+		VBO_.Reset();
+		EBO_.Reset();
+		shaders_.reset();
 		IsError(__FILE__, __LINE__);
 	}
 
@@ -349,6 +184,9 @@ namespace gl {
 
 	void HelloTexture::DrawImGui()
 	{
+		ImGui::Begin("Textures");
+		texture_residency_.DrawImGui();
+		ImGui::End();
 	}
 
 } // End namespace gl.
@@ -1,5 +1,6 @@
 #include <SDL_main.h>
 #include <glad/glad.h>
+#include <algorithm>
 #include <array>
 #include <string>
 #include <iostream>
@@ -9,9 +10,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "engine.h"
+#include "gpu_resource.h"
 #include "camera.h"
+#include "input.h"
 #include "texture.h"
 #include "shader.h"
+#include "imgui.h"
 
 namespace gl {
 
@@ -25,6 +29,9 @@ namespace gl {
 		void DrawImGui() override;
 
 	protected:
+		// Back to the start, before recording or replaying a fly-through.
+		void ResetScene();
+		void UpdateCamera();
 		void SetModelMatrix(seconds dt);
 		void SetViewMatrix(seconds dt);
 		void SetProjectionMatrix();
@@ -32,9 +39,9 @@ namespace gl {
 		void SetUniformMatrix() const;
 
 	protected:
-		unsigned int VAO_;
-		unsigned int VBO_;
-		unsigned int EBO_;
+		VertexArrayHandle VAO_;
+		BufferHandle VBO_;
+		BufferHandle EBO_;
 		unsigned int vertex_shader_;
 		unsigned int fragment_shader_;
 		unsigned int program_;
@@ -79,18 +86,19 @@ namespace gl {
 			1, 2, 3
 		};
 
-		camera_ = std::make_unique<Camera>(glm::vec3(.0f, .0f, 2.0f));
+		ResetScene();
 
 		// VAO binding should be before VAO.
-		glGenVertexArrays(1, &VAO_);
+		VAO_.Create("HelloTransform vertex array");
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 
 		// EBO.
-		glGenBuffers(1, &EBO_);
+		EBO_.Create("HelloTransform indices");
+		EBO_.SetBytes(indices.size() * sizeof(std::uint32_t));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ELEMENT_ARRAY_BUFFER,
@@ -102,9 +110,10 @@ namespace gl {
 		IsError(__FILE__, __LINE__);
 
 		// VBO.
-		glGenBuffers(1, &VBO_);
+		VBO_.Create("HelloTransform vertices");
+		VBO_.SetBytes(vertices.size() * sizeof(float));
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO_.Get());
 		IsError(__FILE__, __LINE__);
 		glBufferData(
 			GL_ARRAY_BUFFER,
@@ -167,10 +176,36 @@ namespace gl {
 		IsError(__FILE__, __LINE__);
 	}
 
+	void HelloTransform::ResetScene()
+	{
+		camera_ = std::make_unique<Camera>(glm::vec3(.0f, .0f, 2.0f));
+		time_ = 0.0f;
+	}
+
+	void HelloTransform::UpdateCamera()
+	{
+		camera_->ProcessKeyboardState(delta_time_);
+		auto& input = Input::GetInstance();
+		// Mouse look while the right button is held, or the right stick.
+		input.SetRelativeMouseMode(input.IsMouseButtonDown(SDL_BUTTON_RIGHT));
+		if (input.IsMouseButtonDown(SDL_BUTTON_RIGHT))
+		{
+			camera_->ProcessMouseMovement(
+				input.GetMouseDeltaX(),
+				-input.GetMouseDeltaY());
+		}
+		// 120 degrees per second at full tilt.
+		const float stick = 120.0f / camera_->MouseSensitivity * delta_time_;
+		camera_->ProcessMouseMovement(
+			input.GetAction("look_x") * stick,
+			input.GetAction("look_y") * stick);
+	}
+
 	void HelloTransform::SetModelMatrix(seconds dt) 
 	{
 		model_ = glm::rotate(glm::mat4(1.0f), time_, glm::vec3(0.f, 1.f, 0.f));
-		model_inverse_ = glm::transpose(glm::inverse(model_));
+		// The inverse transpose of a pure rotation is the rotation itself.
+		model_inverse_ = model_;
 	}
 
 	void HelloTransform::SetViewMatrix(seconds dt) 
@@ -180,7 +215,14 @@ namespace gl {
 
 	void HelloTransform::SetProjectionMatrix()
 	{
-		projection_ = glm::perspective(45.0f, 4.0f / 3.0f, 0.1f, 100.f);
+		// The viewport follows the window and the dynamic resolution.
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		projection_ = glm::perspective(
+			45.0f,
+			static_cast<float>(viewport[2]) / static_cast<float>(std::max(viewport[3], 1)),
+			0.1f,
+			100.f);
 	}
 
 	void HelloTransform::SetUniformMatrix() const
@@ -197,15 +239,16 @@ namespace gl {
 	{
 		delta_time_ = dt.count();
 		time_ += delta_time_;
+		UpdateCamera();
 		SetViewMatrix(dt);
 		SetModelMatrix(dt);
 		SetProjectionMatrix();
 		SetUniformMatrix();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		IsError(__FILE__, __LINE__);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
 		IsError(__FILE__, __LINE__);
-		glBindVertexArray(VAO_);
+		glBindVertexArray(VAO_.Get());
 		IsError(__FILE__, __LINE__);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 		IsError(__FILE__, __LINE__);
@@ -213,36 +256,65 @@ namespace gl {
 
 	void HelloTransform::Destroy()
 	{
-		
+		VAO_.Reset();
+		VBO_.Reset();
+		EBO_.Reset();
+		shaders_.reset();
+		texture_diffuse_.reset();
+		IsError(__FILE__, __LINE__);
 	}
 
 	void HelloTransform::OnEvent(SDL_Event& event)
 	{
-		if (event.type == SDL_KEYDOWN)
+		if (event.type == SDL_KEYDOWN &&
+			event.key.keysym.sym == SDLK_ESCAPE)
 		{
-			if (event.key.keysym.sym == SDLK_ESCAPE)
-				exit(0);
-			if (event.key.keysym.sym == SDLK_w)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::FORWARD, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_s)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::BACKWARD, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_a)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::LEFT, delta_time_);
-			}
-			if (event.key.keysym.sym == SDLK_d)
-			{
-				camera_->ProcessKeyboard(CameraMovementEnum::RIGHT, delta_time_);
-			}
+			exit(0);
 		}
 	}
 
 	void HelloTransform::DrawImGui()
 	{
+		// Same start, same inputs and time steps: the same frames.
+		auto& input = Input::GetInstance();
+		const std::string file_name = "fly_through.input";
+		ImGui::Begin("Fly-through");
+		ImGui::Text("WASD or left stick, right mouse button or right stick to look");
+		if (input.IsRecording())
+		{
+			if (ImGui::Button("Stop recording")) input.StopRecording();
+		}
+		else if (ImGui::Button("Record"))
+		{
+			ResetScene();
+			input.StartRecording();
+		}
+		ImGui::SameLine();
+		if (input.IsReplaying())
+		{
+			if (ImGui::Button("Stop replay")) input.StopReplay();
+		}
+		else if (ImGui::Button("Replay") && input.GetRecordedFrameCount() > 0)
+		{
+			ResetScene();
+			input.StartReplay();
+		}
+		ImGui::SameLine();
+		try
+		{
+			if (ImGui::Button("Save")) input.SaveRecording(file_name);
+			ImGui::SameLine();
+			if (ImGui::Button("Load")) input.LoadRecording(file_name);
+		}
+		catch (const std::exception& ex)
+		{
+			std::cerr << ex.what() << "\n";
+		}
+		ImGui::Text("Camera at %.3f %.3f %.3f",
+			camera_->position.x,
+			camera_->position.y,
+			camera_->position.z);
+		ImGui::End();
 	}
 
 } // End namespace gl.
@@ -3,9 +3,10 @@
 #include <array>
 #include <string>
 #include <iostream>
-#include <fstream>
 
 #include "engine.h"
+#include "file_system.h"
+#include "gpu_resource.h"
 
 namespace gl {
 
@@ -19,9 +20,9 @@ public:
     void DrawImGui() override;
 
 protected:
-    unsigned int VBO_;
-    unsigned int VAO_[2];
-    unsigned int EBO_;
+    BufferHandle VBO_;
+    std::array<VertexArrayHandle, 2> VAO_;
+    BufferHandle EBO_;
     unsigned int vertex_shader_;
     unsigned int fragment_shader_;
     unsigned int program_;
@@ -56,16 +57,18 @@ void HelloTriangle::Init()
     };
 
     // VAO binding should be before VBO.
-    glGenVertexArrays(2, VAO_);
+    VAO_[0].Create("HelloTriangle vertex array 0");
+    VAO_[1].Create("HelloTriangle vertex array 1");
     IsError(__FILE__, __LINE__);
-    glBindVertexArray(VAO_[0]);
+    glBindVertexArray(VAO_[0].Get());
     IsError(__FILE__, __LINE__);
-    glBindVertexArray(VAO_[1]);
+    glBindVertexArray(VAO_[1].Get());
 
     // EBO.
-    glGenBuffers(1, &EBO_);
+    EBO_.Create("HelloTriangle indices");
+    EBO_.SetBytes(indices.size() * sizeof(std::uint32_t));
     IsError(__FILE__, __LINE__);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_.Get());
     IsError(__FILE__, __LINE__);
     glBufferData(
         GL_ELEMENT_ARRAY_BUFFER, 
@@ -75,9 +78,10 @@ void HelloTriangle::Init()
 	IsError(__FILE__, __LINE__);
 
     // VBO.
-    glGenBuffers(1, &VBO_);
+    VBO_.Create("HelloTriangle vertices");
+    VBO_.SetBytes(vertices.size() * sizeof(float));
     IsError(__FILE__, __LINE__);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_.Get());
     IsError(__FILE__, __LINE__);
     glBufferData(
         GL_ARRAY_BUFFER, 
@@ -110,23 +114,12 @@ void HelloTriangle::Init()
     
     std::string path = "..\\";
 
-    std::ifstream ifs_vert(
+    const FileSystem& file_system = FileSystem::GetInstance();
+    std::string vertex_source = file_system.ReadText(
         path + "data\\shaders\\hello_triangle\\triangle.vert");
-    std::ifstream ifs_frag(
+    std::string fragment_source = file_system.ReadText(
         path + "data\\shaders\\hello_triangle\\triangle.frag");
 
-    if (!ifs_vert.is_open())
-    {
-        throw std::runtime_error("Could not open vertex file.");
-    }
-    if (!ifs_frag.is_open())
-    {
-        throw std::runtime_error("Could not open fragment file.");
-    }
-
-    std::string vertex_source{ std::istreambuf_iterator<char>(ifs_vert), {} };
-    std::string fragment_source{ std::istreambuf_iterator<char>(ifs_frag), {} };
-
     // Vertex shader.
     vertex_shader_ = glCreateShader(GL_VERTEX_SHADER);
     IsError(__FILE__, __LINE__);
@@ -185,9 +178,9 @@ void HelloTriangle::Update(seconds dt)
     IsError(__FILE__, __LINE__);
     glUseProgram(program_);
     IsError(__FILE__, __LINE__);
-    glBindVertexArray(VAO_[0]);
+    glBindVertexArray(VAO_[0].Get());
     IsError(__FILE__, __LINE__);
-	glBindVertexArray(VAO_[1]);
+	glBindVertexArray(VAO_[1].Get());
 	IsError(__FILE__, __LINE__);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     IsError(__FILE__, __LINE__);
@@ -201,6 +194,10 @@ void HelloTriangle::Destroy()
     IsError(__FILE__, __LINE__);
     glDeleteShader(fragment_shader_);
     IsError(__FILE__, __LINE__);
+    VAO_[0].Reset();
+    VAO_[1].Reset();
+    VBO_.Reset();
+    EBO_.Reset();
 }
 
 void HelloTriangle::OnEvent(SDL_Event& event)
@@ -0,0 +1,54 @@
+#include <SDL_main.h>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "mesh_lod.h"
+#include "obj_loader.h"
+
+// Offline LOD chain builder:
+//     mesh_lod_tool <mesh.obj> [levels] [ratio] [max_relative_error]
+// Writes <mesh>.lod next to the input.
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr
+			<< "usage: " << argv[0]
+			<< " <mesh.obj> [levels] [ratio] [max_relative_error]\n";
+		return EXIT_FAILURE;
+	}
+	const std::string input = argv[1];
+	const int levels = argc > 2 ? std::atoi(argv[2]) : 6;
+	const float ratio = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 0.5f;
+	const float max_relative_error =
+		argc > 4 ? static_cast<float>(std::atof(argv[4])) : 0.1f;
+	try
+	{
+		const gl::MeshData mesh = gl::LoadObj(input);
+		const auto chain = gl::GenerateLodChain(
+			mesh,
+			levels,
+			ratio,
+			max_relative_error);
+		const std::string output =
+			std::filesystem::path(input).replace_extension(".lod").string();
+		gl::SaveLodChain(output, chain);
+		for (std::size_t i = 0; i < chain.size(); ++i)
+		{
+			std::cout
+				<< "LOD " << i
+				<< ": " << chain[i].data.indices.size() / 3 << " triangles"
+				<< ", " << chain[i].data.vertices.size() << " vertices"
+				<< ", error " << chain[i].error << "\n";
+		}
+		std::cout << "Wrote " << output << "\n";
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,57 @@
+#include <SDL_main.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "file_system.h"
+
+// Offline asset packer:
+//     pack_tool <archive> <directory>... [--align N] [--store]
+// Entries are named after each directory ("data/...", "spirv/data/..."
+// for the SPIR-V in the build directory), --store skips the LZ4
+// compression. The engine mounts ../data.pak when it exists.
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr
+			<< "usage: " << argv[0]
+			<< " <archive> <directory>... [--align N] [--store]\n";
+		return EXIT_FAILURE;
+	}
+	gl::PackOptions options;
+	std::vector<std::string> directories;
+	for (int i = 2; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--store") == 0)
+		{
+			options.compress = false;
+		}
+		else if (std::strcmp(argv[i], "--align") == 0 && i + 1 < argc)
+		{
+			options.alignment = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+		}
+		else
+		{
+			directories.push_back(argv[i]);
+		}
+	}
+	try
+	{
+		const gl::PackStats stats = gl::PackArchive(directories, argv[1], options);
+		std::cout
+			<< "Packed " << stats.entry_count << " files"
+			<< " (" << stats.compressed_count << " compressed)"
+			<< ", " << stats.raw_bytes << " bytes into " << stats.archive_bytes
+			<< "\n";
+		std::cout << "Wrote " << argv[1] << "\n";
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
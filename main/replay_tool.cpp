@@ -0,0 +1,174 @@
+#include <SDL.h>
+#include <SDL_main.h>
+#include <glad/glad.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "gl_replay.h"
+
+// Replays a GL capture (GPR5300_GL_CAPTURE) and times it:
+//     replay_tool <capture> [--headless] [--loops N] [--no-finish]
+//         [--per-frame] [--drop-redundant-binds] [--merge-draws]
+//         [--drop-get-error] [--compare]
+// --compare replays without the transforms first and prints the
+// difference, the transforms stay off the engine until they pay.
+namespace {
+
+	float AverageTotal(const gl::GlReplayReport& report)
+	{
+		if (report.frames.empty()) return 0.0f;
+		float sum = 0.0f;
+		for (const auto& frame : report.frames) sum += frame.total_ms;
+		return sum / report.frames.size();
+	}
+
+} // End anonymous namespace.
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr
+			<< "usage: " << argv[0]
+			<< " <capture> [--headless] [--loops N] [--no-finish] [--per-frame]"
+			<< " [--drop-redundant-binds] [--merge-draws] [--drop-get-error]"
+			<< " [--compare]\n";
+		return EXIT_FAILURE;
+	}
+	gl::GlReplayOptions options;
+	bool headless = false;
+	bool per_frame = false;
+	bool compare = false;
+	for (int i = 2; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			headless = true;
+		}
+		else if (std::strcmp(argv[i], "--loops") == 0 && i + 1 < argc)
+		{
+			options.loops = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--no-finish") == 0)
+		{
+			options.finish_frames = false;
+		}
+		else if (std::strcmp(argv[i], "--per-frame") == 0)
+		{
+			per_frame = true;
+		}
+		else if (std::strcmp(argv[i], "--drop-redundant-binds") == 0)
+		{
+			options.drop_redundant_binds = true;
+		}
+		else if (std::strcmp(argv[i], "--merge-draws") == 0)
+		{
+			options.merge_draws = true;
+		}
+		else if (std::strcmp(argv[i], "--drop-get-error") == 0)
+		{
+			options.drop_get_error = true;
+		}
+		else if (std::strcmp(argv[i], "--compare") == 0)
+		{
+			compare = true;
+		}
+		else
+		{
+			std::cerr << "Unknown option " << argv[i] << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	gl::GlReplay replay;
+	try
+	{
+		replay.Load(argv[1]);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	std::cout
+		<< argv[1] << ": " << replay.GetWidth() << "x" << replay.GetHeight()
+		<< ", " << replay.GetFrameCount() << " frames, "
+		<< replay.GetCallCount() << " calls\n";
+
+	// The context the engine asks for.
+	SDL_Init(SDL_INIT_VIDEO);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+	SDL_Window* window = SDL_CreateWindow(
+		"GPR5300 replay",
+		SDL_WINDOWPOS_UNDEFINED,
+		SDL_WINDOWPOS_UNDEFINED,
+		replay.GetWidth(),
+		replay.GetHeight(),
+		SDL_WINDOW_OPENGL | (headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN));
+	if (!window)
+	{
+		std::cerr << "Unable to create window: " << SDL_GetError() << "\n";
+		return EXIT_FAILURE;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	SDL_GL_MakeCurrent(window, context);
+	// Not bound to the display refresh.
+	SDL_GL_SetSwapInterval(0);
+	if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress))
+	{
+		std::cerr << "Failed to initialize OpenGL context\n";
+		return EXIT_FAILURE;
+	}
+	if (!headless)
+	{
+		options.end_frame = [window]() {
+			SDL_Event event;
+			while (SDL_PollEvent(&event)) {}
+			SDL_GL_SwapWindow(window);
+		};
+	}
+
+	int result = EXIT_SUCCESS;
+	try
+	{
+		float baseline_ms = 0.0f;
+		if (compare)
+		{
+			gl::GlReplayOptions plain = options;
+			plain.drop_redundant_binds = false;
+			plain.merge_draws = false;
+			plain.drop_get_error = false;
+			const gl::GlReplayReport report = replay.Run(plain);
+			std::cout << "-- Without transforms\n";
+			report.Print(std::cout, per_frame);
+			baseline_ms = AverageTotal(report);
+			std::cout << "-- With transforms\n";
+		}
+		const gl::GlReplayReport report = replay.Run(options);
+		report.Print(std::cout, per_frame);
+		if (compare && baseline_ms > 0.0f)
+		{
+			const float ms = AverageTotal(report);
+			std::cout
+				<< "Average frame: " << baseline_ms << " ms -> " << ms << " ms ("
+				<< (ms - baseline_ms) / baseline_ms * 100.0f << "%)\n";
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		result = EXIT_FAILURE;
+	}
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return result;
+}
@@ -0,0 +1,279 @@
+#include <SDL_main.h>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "simd_math.h"
+
+// Micro-benchmarks of the batched math (simd_math.h) against the plain
+// glm loop it replaces:
+//     simd_benchmark [repetitions]
+// Every operation runs on 1k, 10k and 100k items at each SIMD level the
+// CPU supports, the best of the repetitions is kept.
+namespace {
+
+	struct Data
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::quat> targets;
+		std::vector<glm::vec3> scales;
+		std::vector<glm::mat4> lefts;
+		std::vector<glm::mat4> rights;
+		std::vector<gl::Aabb> boxes;
+		std::vector<glm::mat4> matrices_out;
+		std::vector<gl::Aabb> boxes_out;
+		std::vector<glm::quat> quats_out;
+	};
+
+	glm::quat RandomQuat(std::mt19937& random)
+	{
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		return glm::normalize(
+			glm::quat(normal(random), normal(random), normal(random), normal(random)));
+	}
+
+	Data MakeData(std::size_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+		Data data;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			data.positions.emplace_back(
+				position(random), position(random), position(random));
+			data.rotations.push_back(RandomQuat(random));
+			data.targets.push_back(RandomQuat(random));
+			data.scales.emplace_back(scale(random), scale(random), scale(random));
+			const glm::vec3 corner(position(random), position(random), position(random));
+			data.boxes.push_back(
+				{ corner, corner + glm::vec3(scale(random), scale(random), scale(random)) });
+		}
+		data.lefts.resize(count);
+		data.rights.resize(count);
+		gl::GetScalarKernels().compose_transforms(
+			data.positions.data(),
+			data.rotations.data(),
+			data.scales.data(),
+			data.lefts.data(),
+			count);
+		gl::GetScalarKernels().compose_transforms(
+			data.positions.data(),
+			data.targets.data(),
+			data.scales.data(),
+			data.rights.data(),
+			count);
+		data.matrices_out.resize(count);
+		data.boxes_out.resize(count);
+		data.quats_out.resize(count);
+		return data;
+	}
+
+	// Best time of the repetitions in microseconds.
+	double BestOf(int repetitions, const std::function<void()>& run)
+	{
+		double best = 1e30;
+		for (int i = 0; i < repetitions; ++i)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			run();
+			const auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(
+				best,
+				std::chrono::duration<double, std::micro>(end - start).count());
+		}
+		return best;
+	}
+
+	template <typename T>
+	float MaxError(const std::vector<T>& expected, const std::vector<T>& actual)
+	{
+		const float* a = reinterpret_cast<const float*>(expected.data());
+		const float* b = reinterpret_cast<const float*>(actual.data());
+		const std::size_t count = expected.size() * sizeof(T) / sizeof(float);
+		float error = 0.0f;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			error = std::max(error, std::abs(a[i] - b[i]));
+		}
+		return error;
+	}
+
+	struct Operation
+	{
+		const char* name;
+		// Plain glm loop, writes the reference.
+		std::function<void(Data&)> reference;
+		// Batched call, writes the same output as the reference.
+		std::function<void(Data&)> batch;
+		// Error of the batch against the reference.
+		std::function<float(const Data&, const Data&)> error;
+	};
+
+	std::vector<Operation> MakeOperations()
+	{
+		auto matrix_error = [](const Data& expected, const Data& actual) {
+			return MaxError(expected.matrices_out, actual.matrices_out);
+		};
+		return {
+			{
+				"ComposeTransforms",
+				[](Data& d) {
+					for (std::size_t i = 0; i < d.positions.size(); ++i)
+					{
+						d.matrices_out[i] =
+							glm::translate(glm::mat4(1.0f), d.positions[i]) *
+							glm::mat4_cast(d.rotations[i]) *
+							glm::scale(glm::mat4(1.0f), d.scales[i]);
+					}
+				},
+				[](Data& d) {
+					gl::ComposeTransforms(
+						d.positions, d.rotations, d.scales, d.matrices_out);
+				},
+				matrix_error,
+			},
+			{
+				"MultiplyMatrices",
+				[](Data& d) {
+					for (std::size_t i = 0; i < d.lefts.size(); ++i)
+					{
+						d.matrices_out[i] = d.lefts[i] * d.rights[i];
+					}
+				},
+				[](Data& d) {
+					gl::MultiplyMatrices(d.lefts, d.rights, d.matrices_out);
+				},
+				matrix_error,
+			},
+			{
+				"InverseAffineMatrices",
+				[](Data& d) {
+					for (std::size_t i = 0; i < d.lefts.size(); ++i)
+					{
+						d.matrices_out[i] = glm::inverse(d.lefts[i]);
+					}
+				},
+				[](Data& d) { gl::InverseAffineMatrices(d.lefts, d.matrices_out); },
+				matrix_error,
+			},
+			{
+				"ComputeNormalMatrices",
+				[](Data& d) {
+					for (std::size_t i = 0; i < d.lefts.size(); ++i)
+					{
+						d.matrices_out[i] = glm::transpose(glm::inverse(d.lefts[i]));
+					}
+				},
+				[](Data& d) { gl::ComputeNormalMatrices(d.lefts, d.matrices_out); },
+				// Only the upper 3x3 is used by the shaders.
+				[](const Data& expected, const Data& actual) {
+					float error = 0.0f;
+					for (std::size_t i = 0; i < expected.matrices_out.size(); ++i)
+					{
+						const glm::mat3 a(expected.matrices_out[i]);
+						const glm::mat3 b(actual.matrices_out[i]);
+						for (int c = 0; c < 3; ++c)
+						{
+							for (int r = 0; r < 3; ++r)
+							{
+								error = std::max(error, std::abs(a[c][r] - b[c][r]));
+							}
+						}
+					}
+					return error;
+				},
+			},
+			{
+				"TransformAabbs",
+				[](Data& d) {
+					// The eight corners, as in most engine code.
+					for (std::size_t i = 0; i < d.boxes.size(); ++i)
+					{
+						glm::vec3 min(1e30f);
+						glm::vec3 max(-1e30f);
+						for (int corner = 0; corner < 8; ++corner)
+						{
+							const glm::vec3 p(
+								(corner & 1) ? d.boxes[i].max.x : d.boxes[i].min.x,
+								(corner & 2) ? d.boxes[i].max.y : d.boxes[i].min.y,
+								(corner & 4) ? d.boxes[i].max.z : d.boxes[i].min.z);
+							const glm::vec3 world(d.lefts[i] * glm::vec4(p, 1.0f));
+							min = glm::min(min, world);
+							max = glm::max(max, world);
+						}
+						d.boxes_out[i] = { min, max };
+					}
+				},
+				[](Data& d) { gl::TransformAabbs(d.lefts, d.boxes, d.boxes_out); },
+				[](const Data& expected, const Data& actual) {
+					return MaxError(expected.boxes_out, actual.boxes_out);
+				},
+			},
+			{
+				"SlerpQuaternions",
+				[](Data& d) {
+					for (std::size_t i = 0; i < d.rotations.size(); ++i)
+					{
+						d.quats_out[i] = glm::slerp(d.rotations[i], d.targets[i], 0.3f);
+					}
+				},
+				[](Data& d) {
+					gl::SlerpQuaternions(d.rotations, d.targets, 0.3f, d.quats_out);
+				},
+				[](const Data& expected, const Data& actual) {
+					return MaxError(expected.quats_out, actual.quats_out);
+				},
+			},
+		};
+	}
+
+} // End anonymous namespace.
+
+int main(int argc, char** argv)
+{
+	const int repetitions = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+	const gl::SimdLevelEnum supported = gl::GetSupportedSimdLevel();
+	std::cout << "Supported: " << gl::GetSimdLevelName(supported) << "\n";
+	std::cout << std::fixed << std::setprecision(2);
+	for (const Operation& operation : MakeOperations())
+	{
+		std::cout << "\n" << operation.name << "\n";
+		for (std::size_t count : { 1000, 10000, 100000 })
+		{
+			Data expected = MakeData(count);
+			const double glm_time =
+				BestOf(repetitions, [&] { operation.reference(expected); });
+			std::cout
+				<< "  " << std::setw(6) << count << "  glm loop "
+				<< std::setw(9) << glm_time << " us\n";
+			for (int level = 0; level <= static_cast<int>(supported); ++level)
+			{
+				gl::SetSimdLevel(static_cast<gl::SimdLevelEnum>(level));
+				Data actual = MakeData(count);
+				const double time =
+					BestOf(repetitions, [&] { operation.batch(actual); });
+				std::cout
+					<< "          " << std::setw(8)
+					<< gl::GetSimdLevelName(gl::GetSimdLevel())
+					<< " " << std::setw(9) << time << " us  x"
+					<< std::setw(5) << glm_time / time
+					<< "  max error " << std::scientific << std::setprecision(1)
+					<< operation.error(expected, actual)
+					<< std::fixed << std::setprecision(2) << "\n";
+			}
+		}
+	}
+	gl::SetSimdLevel(supported);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,23 @@
+#include <command_list.h>
+
+#include <algorithm>
+
+namespace gl {
+
+CommandList::CommandList(std::size_t initial_bytes)
+{
+	Grow(initial_bytes);
+}
+
+void CommandList::Grow(std::size_t minimum)
+{
+	const std::size_t capacity = std::max<std::size_t>(
+		std::max<std::size_t>(minimum, capacity_ * 2),
+		256);
+	auto data = std::make_unique<std::uint8_t[]>(capacity);
+	if (size_ > 0) std::memcpy(data.get(), data_.get(), size_);
+	data_ = std::move(data);
+	capacity_ = capacity;
+}
+
+} // End namespace gl.
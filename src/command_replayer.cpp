@@ -0,0 +1,192 @@
+#include <command_replayer.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace gl {
+
+namespace {
+
+	GLenum ToGl(PrimitiveEnum primitive)
+	{
+		switch (primitive)
+		{
+		case PrimitiveEnum::LINES: return GL_LINES;
+		case PrimitiveEnum::POINTS: return GL_POINTS;
+		case PrimitiveEnum::TRIANGLES:
+		default:
+			return GL_TRIANGLES;
+		}
+	}
+
+	template <typename T>
+	T Read(const std::uint8_t* command)
+	{
+		T payload;
+		std::memcpy(&payload, command + sizeof(CommandHeader), sizeof(T));
+		return payload;
+	}
+
+} // End anonymous namespace.
+
+void CommandReplayer::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void CommandReplayer::Begin()
+{
+	program_ = UNKNOWN;
+	vertex_array_ = UNKNOWN;
+	active_unit_ = UNKNOWN;
+	textures_.fill(UNKNOWN);
+	command_count_ = 0;
+	draw_count_ = 0;
+	filtered_count_ = 0;
+}
+
+void CommandReplayer::Replay(const CommandList& list)
+{
+	const std::uint8_t* command = list.GetData();
+	const std::uint8_t* const end = command + list.GetSize();
+	while (command < end)
+	{
+		CommandHeader header;
+		std::memcpy(&header, command, sizeof(header));
+		switch (header.type)
+		{
+		case CommandTypeEnum::BIND_PROGRAM:
+		{
+			const auto payload = Read<BindProgramCommand>(command);
+			if (payload.program == program_)
+			{
+				++filtered_count_;
+				break;
+			}
+			glUseProgram(payload.program);
+			program_ = payload.program;
+			break;
+		}
+		case CommandTypeEnum::BIND_VERTEX_ARRAY:
+		{
+			const auto payload = Read<BindVertexArrayCommand>(command);
+			if (payload.vertex_array == vertex_array_)
+			{
+				++filtered_count_;
+				break;
+			}
+			glBindVertexArray(payload.vertex_array);
+			vertex_array_ = payload.vertex_array;
+			break;
+		}
+		case CommandTypeEnum::BIND_TEXTURE:
+		{
+			const auto payload = Read<BindTextureCommand>(command);
+			if (payload.unit < MAX_TEXTURE_UNITS &&
+				textures_[payload.unit] == payload.texture)
+			{
+				++filtered_count_;
+				break;
+			}
+			if (payload.unit != active_unit_)
+			{
+				glActiveTexture(GL_TEXTURE0 + payload.unit);
+				active_unit_ = payload.unit;
+			}
+			glBindTexture(GL_TEXTURE_2D, payload.texture);
+			if (payload.unit < MAX_TEXTURE_UNITS)
+			{
+				textures_[payload.unit] = payload.texture;
+			}
+			break;
+		}
+		case CommandTypeEnum::SET_INT:
+		{
+			const auto payload = Read<SetIntCommand>(command);
+			glUniform1i(payload.location, payload.value);
+			break;
+		}
+		case CommandTypeEnum::SET_FLOAT:
+		{
+			const auto payload = Read<SetFloatCommand>(command);
+			glUniform1f(payload.location, payload.value);
+			break;
+		}
+		case CommandTypeEnum::SET_VEC3:
+		{
+			const auto payload = Read<SetVec3Command>(command);
+			glUniform3fv(payload.location, 1, &payload.value[0]);
+			break;
+		}
+		case CommandTypeEnum::SET_VEC4:
+		{
+			const auto payload = Read<SetVec4Command>(command);
+			glUniform4fv(payload.location, 1, &payload.value[0]);
+			break;
+		}
+		case CommandTypeEnum::SET_MAT4:
+		{
+			const auto payload = Read<SetMat4Command>(command);
+			glUniformMatrix4fv(payload.location, 1, GL_FALSE, &payload.value[0][0]);
+			break;
+		}
+		case CommandTypeEnum::DRAW:
+		{
+			const auto payload = Read<DrawCommand>(command);
+			glDrawArrays(
+				ToGl(payload.primitive),
+				static_cast<GLint>(payload.first),
+				static_cast<GLsizei>(payload.count));
+			++draw_count_;
+			break;
+		}
+		case CommandTypeEnum::DRAW_INDEXED:
+		{
+			const auto payload = Read<DrawIndexedCommand>(command);
+			glDrawElements(
+				ToGl(payload.primitive),
+				static_cast<GLsizei>(payload.count),
+				GL_UNSIGNED_INT,
+				reinterpret_cast<const void*>(
+					static_cast<std::size_t>(payload.first_index) *
+					sizeof(std::uint32_t)));
+			++draw_count_;
+			break;
+		}
+		default:
+			break;
+		}
+		++command_count_;
+		command += header.size;
+	}
+}
+
+void CommandReplayer::Replay(const std::vector<CommandList>& lists)
+{
+	for (const auto& list : lists)
+	{
+		Replay(list);
+	}
+}
+
+void CommandReplayer::End()
+{
+	glBindVertexArray(0);
+	glUseProgram(0);
+	if (active_unit_ != UNKNOWN) glActiveTexture(GL_TEXTURE0);
+	program_ = UNKNOWN;
+	vertex_array_ = UNKNOWN;
+	active_unit_ = UNKNOWN;
+	textures_.fill(UNKNOWN);
+	IsError(__FILE__, __LINE__);
+}
+
+} // End namespace gl.
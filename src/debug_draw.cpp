@@ -0,0 +1,374 @@
+#include <debug_draw.h>
+
+#if GL_DEBUG_DRAW
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "imgui.h"
+#include "shader.h"
+#include "stream_buffer.h"
+
+namespace gl {
+
+namespace {
+
+	std::uint32_t PackUnorm(float value)
+	{
+		return static_cast<std::uint32_t>(
+			std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	std::uint32_t PackColor(const glm::vec4& color)
+	{
+		return
+			PackUnorm(color.x) |
+			PackUnorm(color.y) << 8 |
+			PackUnorm(color.z) << 16 |
+			PackUnorm(color.w) << 24;
+	}
+
+	constexpr int SPHERE_SEGMENTS = 24;
+
+} // End anonymous namespace.
+
+DebugDraw& DebugDraw::GetInstance()
+{
+	static DebugDraw instance;
+	return instance;
+}
+
+DebugDraw::DebugDraw()
+{
+	depth_vertices_.reserve(64 * 1024);
+	overlay_vertices_.reserve(1024);
+}
+
+DebugDraw::~DebugDraw() = default;
+
+void DebugDraw::AddLine(
+	const DebugVertex& from,
+	const DebugVertex& to,
+	float duration,
+	bool depth_test)
+{
+	if (duration > 0.0f)
+	{
+		timed_lines_.push_back({ from, to, duration, depth_test });
+		return;
+	}
+	auto& vertices = depth_test ? depth_vertices_ : overlay_vertices_;
+	vertices.push_back(from);
+	vertices.push_back(to);
+}
+
+void DebugDraw::Line(
+	const glm::vec3& from,
+	const glm::vec3& to,
+	const glm::vec4& color,
+	float duration,
+	bool depth_test)
+{
+	const std::uint32_t packed = PackColor(color);
+	AddLine({ from, packed }, { to, packed }, duration, depth_test);
+}
+
+void DebugDraw::Aabb(
+	const glm::vec3& min,
+	const glm::vec3& max,
+	const glm::vec4& color,
+	float duration,
+	bool depth_test)
+{
+	const std::uint32_t packed = PackColor(color);
+	std::array<DebugVertex, 8> corners;
+	for (int i = 0; i < 8; ++i)
+	{
+		corners[i] = {
+			glm::vec3(
+				(i & 1) ? max.x : min.x,
+				(i & 2) ? max.y : min.y,
+				(i & 4) ? max.z : min.z),
+			packed };
+	}
+	// Corners differing by one bit share an edge.
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int bit = 1; bit < 8; bit <<= 1)
+		{
+			if (i & bit) continue;
+			AddLine(corners[i], corners[i | bit], duration, depth_test);
+		}
+	}
+}
+
+void DebugDraw::Sphere(
+	const glm::vec3& center,
+	float radius,
+	const glm::vec4& color,
+	float duration,
+	bool depth_test)
+{
+	const std::uint32_t packed = PackColor(color);
+	std::array<glm::vec2, SPHERE_SEGMENTS + 1> circle;
+	for (int i = 0; i <= SPHERE_SEGMENTS; ++i)
+	{
+		const float angle = 6.2831853f * i / SPHERE_SEGMENTS;
+		circle[i] = glm::vec2(std::cos(angle), std::sin(angle)) * radius;
+	}
+	// One great circle per axis.
+	for (int i = 0; i < SPHERE_SEGMENTS; ++i)
+	{
+		const glm::vec2 a = circle[i];
+		const glm::vec2 b = circle[i + 1];
+		AddLine(
+			{ center + glm::vec3(a.x, a.y, 0.0f), packed },
+			{ center + glm::vec3(b.x, b.y, 0.0f), packed },
+			duration,
+			depth_test);
+		AddLine(
+			{ center + glm::vec3(a.x, 0.0f, a.y), packed },
+			{ center + glm::vec3(b.x, 0.0f, b.y), packed },
+			duration,
+			depth_test);
+		AddLine(
+			{ center + glm::vec3(0.0f, a.x, a.y), packed },
+			{ center + glm::vec3(0.0f, b.x, b.y), packed },
+			duration,
+			depth_test);
+	}
+}
+
+void DebugDraw::Frustum(
+	const glm::mat4& view_projection,
+	const glm::vec4& color,
+	float duration,
+	bool depth_test)
+{
+	const std::uint32_t packed = PackColor(color);
+	const glm::mat4 inverse = glm::inverse(view_projection);
+	std::array<DebugVertex, 8> corners;
+	for (int i = 0; i < 8; ++i)
+	{
+		const glm::vec4 corner = inverse * glm::vec4(
+			(i & 1) ? 1.0f : -1.0f,
+			(i & 2) ? 1.0f : -1.0f,
+			(i & 4) ? 1.0f : -1.0f,
+			1.0f);
+		corners[i] = { glm::vec3(corner) / corner.w, packed };
+	}
+	for (int i = 0; i < 8; ++i)
+	{
+		for (int bit = 1; bit < 8; bit <<= 1)
+		{
+			if (i & bit) continue;
+			AddLine(corners[i], corners[i | bit], duration, depth_test);
+		}
+	}
+}
+
+void DebugDraw::Axis(
+	const glm::mat4& transform,
+	float size,
+	float duration,
+	bool depth_test)
+{
+	const glm::vec3 origin(transform[3]);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		glm::vec4 color(0.0f, 0.0f, 0.0f, 1.0f);
+		color[axis] = 1.0f;
+		const glm::vec3 direction(transform[axis]);
+		Line(origin, origin + direction * size, color, duration, depth_test);
+	}
+}
+
+void DebugDraw::Text3D(
+	const glm::vec3& position,
+	const std::string& text,
+	const glm::vec4& color,
+	float duration)
+{
+	texts_.push_back({ position, text, PackColor(color), duration });
+}
+
+void DebugDraw::SetViewProjection(const glm::mat4& view_projection)
+{
+	view_projection_ = view_projection;
+	has_view_projection_ = true;
+}
+
+void DebugDraw::Init(const std::string& path)
+{
+	shader_ = std::make_unique<Shader>(
+		path + "data/shaders/debug_draw/debug_draw.vert",
+		path + "data/shaders/debug_draw/debug_draw.frag");
+	stream_ = std::make_unique<StreamBuffer>();
+	stream_->Init(MAX_LINES * 2 * sizeof(DebugVertex));
+	vao_.Create("DebugDraw");
+	glBindVertexArray(vao_.Get());
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+}
+
+void DebugDraw::Destroy()
+{
+	if (stream_) stream_->Destroy();
+	stream_.reset();
+	shader_.reset();
+	vao_.Reset();
+	depth_vertices_.clear();
+	overlay_vertices_.clear();
+	timed_lines_.clear();
+	texts_.clear();
+}
+
+void DebugDraw::DrawTexts(float dt)
+{
+	ImDrawList* draw_list = ImGui::GetForegroundDrawList();
+	const ImVec2 size = ImGui::GetIO().DisplaySize;
+	for (auto& text : texts_)
+	{
+		const glm::vec4 clip = view_projection_ * glm::vec4(text.position, 1.0f);
+		// Behind the camera.
+		if (clip.w <= 0.0f) continue;
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		draw_list->AddText(
+			ImVec2(
+				(ndc.x * 0.5f + 0.5f) * size.x,
+				(0.5f - ndc.y * 0.5f) * size.y),
+			text.color,
+			text.text.c_str());
+	}
+	for (auto& text : texts_) text.remaining -= dt;
+	texts_.erase(
+		std::remove_if(
+			texts_.begin(),
+			texts_.end(),
+			[](const TimedText& text) { return text.remaining <= 0.0f; }),
+		texts_.end());
+}
+
+void DebugDraw::Render(float dt)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (auto& line : timed_lines_)
+	{
+		auto& vertices = line.depth_test ? depth_vertices_ : overlay_vertices_;
+		vertices.push_back(line.from);
+		vertices.push_back(line.to);
+		line.remaining -= dt;
+	}
+	timed_lines_.erase(
+		std::remove_if(
+			timed_lines_.begin(),
+			timed_lines_.end(),
+			[](const TimedLine& line) { return line.remaining <= 0.0f; }),
+		timed_lines_.end());
+
+	const std::size_t max_vertices = MAX_LINES * 2;
+	const std::size_t depth_count =
+		std::min(depth_vertices_.size(), max_vertices);
+	const std::size_t overlay_count =
+		std::min(overlay_vertices_.size(), max_vertices - depth_count);
+	dropped_lines_ =
+		(depth_vertices_.size() + overlay_vertices_.size() -
+			depth_count - overlay_count) / 2;
+	last_depth_lines_ = depth_count / 2;
+	last_overlay_lines_ = overlay_count / 2;
+
+	if (enabled_ && has_view_projection_ && shader_ &&
+		depth_count + overlay_count > 0)
+	{
+		// Both lists back to back, one attribute setup for the two draws.
+		stream_->BeginFrame();
+		const StreamAllocation allocation = stream_->Allocate(
+			(depth_count + overlay_count) * sizeof(DebugVertex),
+			StreamUsageEnum::VERTEX);
+		auto* destination = static_cast<DebugVertex*>(allocation.data);
+		std::memcpy(
+			destination,
+			depth_vertices_.data(),
+			depth_count * sizeof(DebugVertex));
+		std::memcpy(
+			destination + depth_count,
+			overlay_vertices_.data(),
+			overlay_count * sizeof(DebugVertex));
+		stream_->Flush();
+
+		shader_->Use();
+		shader_->SetMat4("view_projection", view_projection_);
+		glBindVertexArray(vao_.Get());
+		glBindBuffer(GL_ARRAY_BUFFER, allocation.buffer);
+		glVertexAttribPointer(
+			0,
+			3,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(DebugVertex),
+			(GLvoid*)(allocation.offset + offsetof(DebugVertex, position)));
+		glVertexAttribPointer(
+			1,
+			4,
+			GL_UNSIGNED_BYTE,
+			GL_TRUE,
+			sizeof(DebugVertex),
+			(GLvoid*)(allocation.offset + offsetof(DebugVertex, color)));
+		glDepthMask(GL_FALSE);
+		if (depth_count)
+		{
+			glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(depth_count));
+		}
+		if (overlay_count)
+		{
+			glDisable(GL_DEPTH_TEST);
+			glDrawArrays(
+				GL_LINES,
+				static_cast<GLint>(depth_count),
+				static_cast<GLsizei>(overlay_count));
+			glEnable(GL_DEPTH_TEST);
+		}
+		glDepthMask(GL_TRUE);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		stream_->EndFrame();
+	}
+	if (enabled_ && has_view_projection_)
+	{
+		DrawTexts(dt);
+	}
+	else
+	{
+		texts_.clear();
+	}
+
+	depth_vertices_.clear();
+	overlay_vertices_.clear();
+	last_render_ms_ = std::chrono::duration<float, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void DebugDraw::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Debug draw")) return;
+	ImGui::Checkbox("Enabled", &enabled_);
+	ImGui::Text(
+		"Lines: %zu depth tested, %zu overlay, %zu timed",
+		last_depth_lines_,
+		last_overlay_lines_,
+		timed_lines_.size());
+	if (dropped_lines_)
+	{
+		ImGui::Text("Dropped: %zu lines over the limit", dropped_lines_);
+	}
+	ImGui::Text("Render: %.3f ms", last_render_ms_);
+	if (stream_) stream_->DrawImGui();
+}
+
+} // End namespace gl.
+
+#endif
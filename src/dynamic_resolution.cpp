@@ -0,0 +1,97 @@
+#include <dynamic_resolution.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "imgui.h"
+
+namespace gl {
+
+void DynamicResolution::SetScale(float scale)
+{
+	// Snap to the steps, down from max so 1 is always reachable.
+	scale = 1.0f - std::ceil((1.0f - scale) / step_ - 1e-3f) * step_;
+	scale = std::clamp(scale, min_scale_, 1.0f);
+	if (scale == scale_) return;
+	scale_ = scale;
+	cooldown_ = COOLDOWN_FRAMES;
+	calm_frames_ = 0;
+}
+
+void DynamicResolution::Update(float gpu_milliseconds)
+{
+	if (gpu_milliseconds <= 0.0f) return;
+	filtered_ms_ = filtered_ms_ <= 0.0f ?
+		gpu_milliseconds :
+		filtered_ms_ + (gpu_milliseconds - filtered_ms_) * 0.1f;
+	ms_history_[history_index_] = gpu_milliseconds;
+	scale_history_[history_index_] = GetScale();
+	history_index_ = (history_index_ + 1) % HISTORY_SIZE;
+	if (!enabled_) return;
+	if (scale_ < min_scale_) SetScale(min_scale_);
+	if (cooldown_ > 0)
+	{
+		--cooldown_;
+		return;
+	}
+
+	// The cost goes with the pixel count, the square of the scale.
+	const float target_ms = budget_ms_ * headroom_;
+	if (gpu_milliseconds > budget_ms_)
+	{
+		SetScale(scale_ * std::sqrt(target_ms / gpu_milliseconds));
+		return;
+	}
+	const float next = std::min(scale_ + step_, 1.0f);
+	const float predicted_ms =
+		filtered_ms_ * (next * next) / (scale_ * scale_);
+	if (next > scale_ && predicted_ms < target_ms)
+	{
+		if (++calm_frames_ >= RAISE_FRAMES) SetScale(next);
+	}
+	else
+	{
+		calm_frames_ = 0;
+	}
+}
+
+glm::ivec2 DynamicResolution::GetRenderSize(glm::ivec2 output_size) const
+{
+	return glm::max(
+		glm::ivec2(glm::vec2(output_size) * GetScale() + 0.5f),
+		glm::ivec2(1));
+}
+
+void DynamicResolution::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Dynamic resolution")) return;
+	ImGui::Checkbox("Enabled", &enabled_);
+	ImGui::SliderFloat("Budget (ms)", &budget_ms_, 4.0f, 33.3f);
+	ImGui::SliderFloat("Min scale", &min_scale_, 0.25f, 1.0f);
+	ImGui::SliderFloat("Headroom", &headroom_, 0.5f, 1.0f);
+	ImGui::Text(
+		"Scale %.2f, GPU %.2f ms (filtered %.2f ms)",
+		GetScale(),
+		ms_history_[(history_index_ + HISTORY_SIZE - 1) % HISTORY_SIZE],
+		filtered_ms_);
+	ImGui::PlotLines(
+		"GPU ms",
+		ms_history_.data(),
+		static_cast<int>(HISTORY_SIZE),
+		static_cast<int>(history_index_),
+		nullptr,
+		0.0f,
+		budget_ms_ * 2.0f,
+		ImVec2(0.0f, 60.0f));
+	ImGui::PlotLines(
+		"Scale",
+		scale_history_.data(),
+		static_cast<int>(HISTORY_SIZE),
+		static_cast<int>(history_index_),
+		nullptr,
+		0.0f,
+		1.0f,
+		ImVec2(0.0f, 60.0f));
+}
+
+} // End namespace gl.
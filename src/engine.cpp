@@ -1,7 +1,17 @@
 #include <engine.h>
+#include <cstdlib>
 #include <iostream>
 #include <glad/glad.h>
 
+#include "debug_draw.h"
+#include "file_system.h"
+#include "gl_capture.h"
+#include "gl_intercept.h"
+#include "gl_stats.h"
+#include "gpu_backend.h"
+#include "gpu_resource.h"
+#include "input.h"
+#include "startup.h"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_sdl.h"
@@ -14,7 +24,41 @@ Engine::Engine(Program& program) : program_(program)
 
 void Engine::Init()
 {
-	SDL_Init(SDL_INIT_VIDEO);
+	// Reads and decoding run on workers meanwhile the window, the context
+	// and ImGui are made, the uploads are issued as soon as both are done.
+	auto& startup = Startup::GetInstance();
+	startup.BeginSpan("SDL init");
+	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER);
+	startup.EndSpan();
+	// Assets come from data.pak when it has been packed, else from the
+	// loose data/ directory. Both are also looked for next to the build
+	// directory of the executable, whatever the working directory.
+	startup.BeginSpan("Mount");
+	auto& fileSystem = FileSystem::GetInstance();
+	std::string rootPath = "../";
+	if (char* basePath = SDL_GetBasePath())
+	{
+		rootPath = std::string(basePath) + "../";
+		SDL_free(basePath);
+	}
+	fileSystem.SetLooseRoot(rootPath);
+	if (!fileSystem.Mount("../data.pak"))
+	{
+		fileSystem.Mount(rootPath + "data.pak");
+	}
+	startup.EndSpan();
+	for (const char* directory : {
+		"../data/shaders/common",
+		"../data/shaders/debug_draw",
+		"../data/shaders/post_process" })
+	{
+		startup.AddPrefetch(directory);
+	}
+	startup.BeginSpan("Program preload");
+	program_.Preload();
+	startup.EndSpan();
+
+	startup.BeginSpan("Window and context");
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
@@ -52,14 +96,57 @@ void Engine::Init()
 		return;
 	}
 	glRenderContext_ = SDL_GL_CreateContext(window_);
+	// Every engine and demo shader is GLSL 4.50, a GLES context couldn't
+	// compile any of them.
+	if (glRenderContext_ == nullptr)
+	{
+		std::cerr
+			<< "[Error] Unable to create a GL 4.5 core context, the shaders "
+			<< "need GLSL 4.50 (GLES isn't supported): " << SDL_GetError()
+			<< "\n";
+		return;
+	}
 	SDL_GL_MakeCurrent(window_, glRenderContext_);
-	SDL_GL_SetSwapInterval(1);
+	SDL_GL_SetSwapInterval(program_.IsBenchmark() ? 0 : 1);
+	startup.EndSpan();
 
-	if (!gladLoadGLES2Loader((GLADloadproc)SDL_GL_GetProcAddress))
+	startup.BeginSpan("GL load");
+	// Desktop GL first so its extensions (bindless...) are visible, GLES for
+	// drivers only exposing that.
+	if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress) &&
+		!gladLoadGLES2Loader((GLADloadproc)SDL_GL_GetProcAddress))
 	{
 		std::cerr << "Failed to initialize OpenGL context\n";
 		assert(false);
 	}
+	// GL 4.5 edits objects directly, the GLES 3 path binds them first.
+	// GPR5300_GPU_BACKEND=gles3 forces the latter to compare them.
+	const char* backendName = std::getenv("GPR5300_GPU_BACKEND");
+	const GpuBackendEnum backend =
+		backendName && std::string(backendName) == "gles3" ?
+		GpuBackendEnum::GLES3 :
+		GpuBackend::Detect();
+	GpuBackend::Select(backend);
+	std::cout << "GPU backend: " << GetGpuBackendName(backend) << "\n";
+	// glad's pointers are untouched until GlStats or GlCapture listen.
+	GlIntercept::GetInstance().Install();
+	// GPR5300_GL_CAPTURE=<file> records the loading and the first frames
+	// (GPR5300_GL_CAPTURE_FRAMES, 60) for replay_tool.
+	if (const char* capturePath = std::getenv("GPR5300_GL_CAPTURE"))
+	{
+		const char* captureFrames = std::getenv("GPR5300_GL_CAPTURE_FRAMES");
+		GlCapture::GetInstance().Start(
+			capturePath,
+			captureFrames ? std::atoi(captureFrames) : 60,
+			static_cast<int>(windowSize_.x),
+			static_cast<int>(windowSize_.y));
+	}
+	GpuResourceRegistry::GetInstance().SetContextAlive(true);
+	glEnable(GL_DEPTH_TEST);
+	startup.EndSpan();
+	startup.SetContextReady();
+
+	startup.BeginSpan("ImGui");
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO();
@@ -72,9 +159,25 @@ void Engine::Init()
 	//ImGui::StyleColorsDark();
 	ImGui::StyleColorsClassic();
 	ImGui_ImplSDL2_InitForOpenGL(window_, glRenderContext_);
-	ImGui_ImplOpenGL3_Init("#version 300 es");
+	ImGui_ImplOpenGL3_Init(GpuBackend::GetInstance().GetGlslVersion());
+	startup.EndSpan();
+	startup.Pump();
+	startup.BeginSpan("Debug draw");
+	DebugDraw::GetInstance().Init("../");
+	startup.EndSpan();
+	startup.Pump();
+	startup.BeginSpan("Post process");
+	postProcess_.Init("../");
+	dynamicResolution_.SetEnabled(!program_.IsBenchmark());
+	startup.EndSpan();
+	startup.Finish();
 
+	startup.BeginSpan("Program init");
 	program_.Init();
+	startup.EndSpan();
+	// Whatever wasn't read by now won't be.
+	fileSystem.ClearPrefetched();
+	GlCapture::GetInstance().EndSetup();
 }
 
 
@@ -84,6 +187,10 @@ void Engine::Run()
 	try 
 	{
 		Init();
+		auto& input = Input::GetInstance();
+		auto& glStats = GlStats::GetInstance();
+		auto& glCapture = GlCapture::GetInstance();
+		auto& startup = Startup::GetInstance();
 		bool isOpen = true;
 		std::chrono::time_point<std::chrono::system_clock> clock =
 			std::chrono::system_clock::now();
@@ -104,11 +211,13 @@ void Engine::Run()
 
 				if (event.type == SDL_WINDOWEVENT)
 				{
-					if (event.window.event == SDL_WINDOWEVENT_RESIZED)
+					// Maximized and programmatic changes included.
+					if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
 					{
 						windowSize_ = glm::vec2(event.window.data1, event.window.data2);
 					}
 				}
+				input.OnEvent(event);
 				program_.OnEvent(event);
 			}
 			// Start the Dear ImGui frame
@@ -116,11 +225,46 @@ void Engine::Run()
 			ImGui_ImplSDL2_NewFrame(window_);
 			ImGui::NewFrame();
 			DrawImGui();
-			ImGui::Render();
+			if (frameTimer_.Resolve())
+			{
+				dynamicResolution_.Update(frameTimer_.GetMilliseconds());
+			}
+			frameTimer_.Begin();
+			const glm::ivec2 windowSize(windowSize_);
+			const bool postProcess = postProcess_.IsEnabled();
+			if (postProcess)
+			{
+				postProcess_.BeginScene(
+					dynamicResolution_.GetRenderSize(windowSize));
+			}
+			else
+			{
+				glViewport(0, 0, windowSize.x, windowSize.y);
+			}
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			program_.Update(dt);
+			// As late as possible, right before the simulation. The time step
+			// is the recorded one when replaying.
+			const ImGuiIO& io = ImGui::GetIO();
+			const seconds simulationDt(input.Sample(
+				dt.count(),
+				io.WantCaptureKeyboard,
+				io.WantCaptureMouse));
+			program_.Update(simulationDt);
+			// Debug text goes in the ImGui foreground, render after it.
+			DebugDraw::GetInstance().Render(simulationDt.count());
+			if (postProcess)
+			{
+				postProcess_.EndScene(windowSize);
+			}
+			frameTimer_.End();
+			ImGui::Render();
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 			SDL_GL_SwapWindow(window_);
+			startup.MarkFirstFrame();
+			input.EndFrame();
+			glStats.EndFrame(std::chrono::duration<float, std::milli>(
+				std::chrono::system_clock::now() - start).count());
+			glCapture.EndFrame();
 		}
 
 		Destroy();
@@ -133,7 +277,21 @@ void Engine::Run()
 void Engine::Destroy()
 {
 	program_.Destroy();
+	DebugDraw::GetInstance().Destroy();
+	postProcess_.Destroy();
+	frameTimer_.Destroy();
+	Input::GetInstance().Destroy();
+	GlCapture::GetInstance().Stop();
+	GlStats::GetInstance().SetEnabled(false);
+	FileSystem::GetInstance().Unmount();
 	ImGui_ImplOpenGL3_Shutdown();
+	// Anything still registered here was never released by the program.
+	auto& registry = GpuResourceRegistry::GetInstance();
+	if (registry.ReportLeaks(std::cerr) == 0)
+	{
+		std::cout << "No GPU resource leaked.\n";
+	}
+	registry.SetContextAlive(false);
 	// Delete our OpengL context
 	SDL_GL_DeleteContext(glRenderContext_);
 	ImGui_ImplSDL2_Shutdown();
@@ -147,6 +305,16 @@ void Engine::DrawImGui()
 {
 	ImGui::Begin("Engine");
 	ImGui::Text("FPS: %f", 1.0f / deltaTime_);
+	GpuResourceRegistry::GetInstance().DrawImGui();
+	GlStats::GetInstance().DrawImGui();
+	GlCapture::GetInstance().DrawImGui();
+	DebugDraw::GetInstance().DrawImGui();
+	Input::GetInstance().DrawImGui();
+	postProcess_.DrawImGui();
+	if (postProcess_.IsEnabled())
+	{
+		dynamicResolution_.DrawImGui();
+	}
 	ImGui::End();
 	program_.DrawImGui();
 }
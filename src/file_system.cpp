@@ -0,0 +1,798 @@
+#include <file_system.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+
+#include <lz4.h>
+#include <lz4hc.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "job_system.h"
+
+namespace gl {
+
+// Archive layout, native byte order:
+//     header | directory sorted by hash | names | entries, each aligned
+// A compressed entry is a table of compressed block sizes followed by
+// the blocks, each BLOCK_SIZE bytes once decompressed (the last one
+// less).
+struct FileSystem::Entry
+{
+	std::uint64_t hash;
+	std::uint64_t offset;
+	// Size of the file.
+	std::uint64_t size;
+	// Bytes in the archive, block table included.
+	std::uint64_t stored_size;
+	std::uint32_t name_offset;
+	std::uint32_t name_size;
+	std::uint32_t block_count;
+	std::uint32_t flags;
+};
+
+namespace {
+
+	constexpr char ARCHIVE_MAGIC[4] = { 'G', 'P', 'A', 'K' };
+	constexpr std::uint32_t ARCHIVE_VERSION = 1;
+	constexpr std::uint32_t BLOCK_SIZE = 256 * 1024;
+	constexpr std::uint32_t FLAG_COMPRESSED = 1;
+
+	struct ArchiveHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t entry_count;
+		std::uint32_t alignment;
+		std::uint64_t directory_offset;
+		std::uint64_t names_offset;
+		std::uint64_t names_size;
+	};
+
+	static_assert(std::is_trivially_copyable_v<ArchiveHeader>);
+	static_assert(sizeof(ArchiveHeader) % alignof(std::uint64_t) == 0);
+
+	// A block to decompress, or with no source a loose file to read.
+	struct BlockTask
+	{
+		std::size_t file = 0;
+		const std::uint8_t* source = nullptr;
+		std::uint32_t source_size = 0;
+		std::uint8_t* destination = nullptr;
+		std::uint32_t destination_size = 0;
+	};
+
+	std::uint64_t Align(std::uint64_t value, std::uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	std::vector<std::uint8_t> ReadLooseFile(const std::string& file_name)
+	{
+		std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			throw std::runtime_error("Could not open file: " + file_name);
+		}
+		std::vector<std::uint8_t> bytes(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+		if (!file)
+		{
+			throw std::runtime_error("Could not read file: " + file_name);
+		}
+		return bytes;
+	}
+
+	bool DecompressBlock(const BlockTask& task)
+	{
+		return LZ4_decompress_safe(
+			reinterpret_cast<const char*>(task.source),
+			reinterpret_cast<char*>(task.destination),
+			static_cast<int>(task.source_size),
+			static_cast<int>(task.destination_size)) ==
+			static_cast<int>(task.destination_size);
+	}
+
+	const std::uint8_t* MapFile(const std::string& file_name, std::size_t& size)
+	{
+		const std::string error = "Could not map archive: " + file_name;
+#ifdef _WIN32
+		HANDLE file = CreateFileA(
+			file_name.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(error);
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(file, &file_size) ||
+			file_size.QuadPart < static_cast<LONGLONG>(sizeof(ArchiveHeader)))
+		{
+			CloseHandle(file);
+			throw std::runtime_error(error);
+		}
+		HANDLE mapping = CreateFileMappingA(
+			file,
+			nullptr,
+			PAGE_READONLY,
+			0,
+			0,
+			nullptr);
+		CloseHandle(file);
+		if (!mapping) throw std::runtime_error(error);
+		// The view keeps the mapping alive.
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!data) throw std::runtime_error(error);
+		size = static_cast<std::size_t>(file_size.QuadPart);
+		return static_cast<const std::uint8_t*>(data);
+#else
+		const int file = open(file_name.c_str(), O_RDONLY);
+		if (file < 0) throw std::runtime_error(error);
+		struct stat file_stat = {};
+		if (fstat(file, &file_stat) != 0 ||
+			file_stat.st_size < static_cast<off_t>(sizeof(ArchiveHeader)))
+		{
+			close(file);
+			throw std::runtime_error(error);
+		}
+		void* data = mmap(
+			nullptr,
+			static_cast<std::size_t>(file_stat.st_size),
+			PROT_READ,
+			MAP_PRIVATE,
+			file,
+			0);
+		// The mapping keeps the file alive.
+		close(file);
+		if (data == MAP_FAILED) throw std::runtime_error(error);
+		size = static_cast<std::size_t>(file_stat.st_size);
+		return static_cast<const std::uint8_t*>(data);
+#endif
+	}
+
+	void UnmapFile(const std::uint8_t* data, std::size_t size)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<std::uint8_t*>(data), size);
+#endif
+	}
+
+} // End anonymous namespace.
+
+PackStats PackArchive(
+	const std::vector<std::string>& directories,
+	const std::string& archive_name,
+	const PackOptions& options)
+{
+	namespace fs = std::filesystem;
+	const std::uint32_t alignment = std::max<std::uint32_t>(options.alignment, 8);
+	if ((alignment & (alignment - 1)) != 0)
+	{
+		throw std::runtime_error("Archive alignment has to be a power of two.");
+	}
+	// Entry names and the files they come from.
+	std::vector<std::pair<std::string, fs::path>> sources;
+	for (const auto& directory : directories)
+	{
+		fs::path root = fs::absolute(directory).lexically_normal();
+		if (!root.has_filename()) root = root.parent_path();
+		if (!fs::is_directory(root))
+		{
+			throw std::runtime_error("Not a directory: " + directory);
+		}
+		for (const auto& item : fs::recursive_directory_iterator(root))
+		{
+			if (!item.is_regular_file()) continue;
+			sources.emplace_back(
+				FileSystem::Normalize(
+					(root.filename() / item.path().lexically_relative(root))
+						.generic_string()),
+				item.path());
+		}
+	}
+
+	struct PackedFile
+	{
+		FileSystem::Entry entry = {};
+		std::string name;
+		std::vector<std::uint8_t> bytes;
+	};
+	std::vector<PackedFile> files;
+	PackStats stats;
+	for (const auto& [name, source] : sources)
+	{
+		PackedFile file;
+		file.name = name;
+		file.bytes = ReadLooseFile(source.string());
+		file.entry.hash = FileSystem::Hash(file.name);
+		file.entry.size = file.bytes.size();
+		file.entry.stored_size = file.bytes.size();
+		stats.raw_bytes += file.bytes.size();
+
+		if (options.compress && !file.bytes.empty())
+		{
+			const std::size_t block_count =
+				(file.bytes.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+			std::vector<std::uint32_t> table(block_count);
+			std::vector<std::uint8_t> blocks;
+			std::vector<char> block(LZ4_compressBound(BLOCK_SIZE));
+			for (std::size_t i = 0; i < block_count; ++i)
+			{
+				const std::size_t begin = i * BLOCK_SIZE;
+				const int size = static_cast<int>(
+					std::min<std::size_t>(BLOCK_SIZE, file.bytes.size() - begin));
+				const int compressed = LZ4_compress_HC(
+					reinterpret_cast<const char*>(file.bytes.data() + begin),
+					block.data(),
+					size,
+					static_cast<int>(block.size()),
+					LZ4HC_CLEVEL_MAX);
+				if (compressed <= 0)
+				{
+					throw std::runtime_error("Could not compress: " + file.name);
+				}
+				table[i] = static_cast<std::uint32_t>(compressed);
+				blocks.insert(blocks.end(), block.begin(), block.begin() + compressed);
+			}
+			const std::size_t stored_size =
+				block_count * sizeof(std::uint32_t) + blocks.size();
+			if (stored_size < file.bytes.size() * options.max_ratio)
+			{
+				file.bytes.resize(block_count * sizeof(std::uint32_t));
+				std::memcpy(file.bytes.data(), table.data(), file.bytes.size());
+				file.bytes.insert(file.bytes.end(), blocks.begin(), blocks.end());
+				file.entry.stored_size = file.bytes.size();
+				file.entry.block_count = static_cast<std::uint32_t>(block_count);
+				file.entry.flags = FLAG_COMPRESSED;
+				++stats.compressed_count;
+			}
+		}
+		files.push_back(std::move(file));
+	}
+	std::sort(
+		files.begin(),
+		files.end(),
+		[](const PackedFile& a, const PackedFile& b) {
+			return a.entry.hash != b.entry.hash ?
+				a.entry.hash < b.entry.hash :
+				a.name < b.name;
+		});
+	for (std::size_t i = 1; i < files.size(); ++i)
+	{
+		if (files[i].name == files[i - 1].name)
+		{
+			throw std::runtime_error("Packed twice: " + files[i].name);
+		}
+	}
+
+	ArchiveHeader header = {};
+	std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ARCHIVE_VERSION;
+	header.entry_count = static_cast<std::uint32_t>(files.size());
+	header.alignment = alignment;
+	header.directory_offset = sizeof(ArchiveHeader);
+	header.names_offset =
+		header.directory_offset + files.size() * sizeof(FileSystem::Entry);
+	std::string names;
+	for (auto& file : files)
+	{
+		file.entry.name_offset = static_cast<std::uint32_t>(names.size());
+		file.entry.name_size = static_cast<std::uint32_t>(file.name.size());
+		names += file.name;
+	}
+	header.names_size = names.size();
+	std::uint64_t offset = header.names_offset + names.size();
+	for (auto& file : files)
+	{
+		offset = Align(offset, alignment);
+		file.entry.offset = offset;
+		offset += file.entry.stored_size;
+	}
+
+	std::ofstream archive(archive_name, std::ios::binary);
+	if (!archive)
+	{
+		throw std::runtime_error("Could not write archive: " + archive_name);
+	}
+	archive.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const auto& file : files)
+	{
+		archive.write(
+			reinterpret_cast<const char*>(&file.entry),
+			sizeof(FileSystem::Entry));
+	}
+	archive.write(names.data(), names.size());
+	std::uint64_t position = header.names_offset + names.size();
+	const std::vector<char> padding(alignment, 0);
+	for (const auto& file : files)
+	{
+		archive.write(padding.data(), file.entry.offset - position);
+		archive.write(
+			reinterpret_cast<const char*>(file.bytes.data()),
+			file.bytes.size());
+		position = file.entry.offset + file.entry.stored_size;
+	}
+	if (!archive)
+	{
+		throw std::runtime_error("Could not write archive: " + archive_name);
+	}
+	stats.entry_count = files.size();
+	stats.archive_bytes = static_cast<std::size_t>(position);
+	return stats;
+}
+
+FileSystem& FileSystem::GetInstance()
+{
+	static FileSystem instance;
+	return instance;
+}
+
+FileSystem::~FileSystem()
+{
+	Unmount();
+}
+
+std::string FileSystem::Normalize(const std::string& path)
+{
+	std::vector<std::string_view> parts;
+	const std::string_view view(path);
+	std::size_t begin = 0;
+	while (begin <= view.size())
+	{
+		std::size_t end = view.find_first_of("/\\", begin);
+		if (end == std::string_view::npos) end = view.size();
+		const std::string_view part = view.substr(begin, end - begin);
+		if (part == "..")
+		{
+			if (!parts.empty()) parts.pop_back();
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		begin = end + 1;
+	}
+	std::string name;
+	for (const auto& part : parts)
+	{
+		if (!name.empty()) name += '/';
+		name += part;
+	}
+	return name;
+}
+
+std::uint64_t FileSystem::Hash(std::string_view name)
+{
+	// FNV-1a.
+	std::uint64_t hash = 14695981039346656037ull;
+	for (const char c : name)
+	{
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool FileSystem::Mount(const std::string& archive_name)
+{
+	std::error_code error_code;
+	if (!std::filesystem::is_regular_file(archive_name, error_code))
+	{
+		return false;
+	}
+	Unmount();
+	std::size_t size = 0;
+	const std::uint8_t* data = MapFile(archive_name, size);
+	auto fail = [&](const std::string& what) {
+		UnmapFile(data, size);
+		throw std::runtime_error(
+			"Corrupt archive " + archive_name + ": " + what);
+	};
+
+	ArchiveHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != ARCHIVE_VERSION)
+	{
+		fail("not an archive of this version");
+	}
+	if (header.directory_offset % alignof(Entry) != 0 ||
+		header.directory_offset > size ||
+		std::uint64_t(header.entry_count) * sizeof(Entry) >
+			size - header.directory_offset ||
+		header.names_offset > size ||
+		header.names_size > size - header.names_offset)
+	{
+		fail("directory out of bounds");
+	}
+	const Entry* entries =
+		reinterpret_cast<const Entry*>(data + header.directory_offset);
+	for (std::uint32_t i = 0; i < header.entry_count; ++i)
+	{
+		const Entry& entry = entries[i];
+		if (i > 0 && entries[i - 1].hash > entry.hash)
+		{
+			fail("directory not sorted");
+		}
+		if (entry.offset > size ||
+			entry.stored_size > size - entry.offset ||
+			std::uint64_t(entry.name_offset) + entry.name_size > header.names_size)
+		{
+			fail("entry out of bounds");
+		}
+		if (!(entry.flags & FLAG_COMPRESSED))
+		{
+			if (entry.stored_size != entry.size) fail("bad entry size");
+			continue;
+		}
+		// The block table has to add up to the stored size.
+		const std::uint64_t table_size =
+			std::uint64_t(entry.block_count) * sizeof(std::uint32_t);
+		if (entry.block_count != (entry.size + BLOCK_SIZE - 1) / BLOCK_SIZE ||
+			table_size > entry.stored_size)
+		{
+			fail("bad block table");
+		}
+		std::uint64_t stored = table_size;
+		for (std::uint32_t block = 0; block < entry.block_count; ++block)
+		{
+			std::uint32_t block_size;
+			std::memcpy(
+				&block_size,
+				data + entry.offset + block * sizeof(std::uint32_t),
+				sizeof(block_size));
+			stored += block_size;
+		}
+		if (stored != entry.stored_size) fail("bad block table");
+	}
+
+	archive_ = data;
+	archive_size_ = size;
+	entries_ = entries;
+	entry_count_ = header.entry_count;
+	names_ = reinterpret_cast<const char*>(data + header.names_offset);
+	return true;
+}
+
+void FileSystem::Unmount()
+{
+	if (!archive_) return;
+	UnmapFile(archive_, archive_size_);
+	archive_ = nullptr;
+	archive_size_ = 0;
+	entries_ = nullptr;
+	entry_count_ = 0;
+	names_ = nullptr;
+	ClearPrefetched();
+}
+
+const FileSystem::Entry* FileSystem::Find(const std::string& name) const
+{
+	if (!archive_) return nullptr;
+	const std::uint64_t hash = Hash(name);
+	const Entry* const end = entries_ + entry_count_;
+	const Entry* entry = std::lower_bound(
+		entries_,
+		end,
+		hash,
+		[](const Entry& entry, std::uint64_t hash) { return entry.hash < hash; });
+	// Names settle collisions.
+	for (; entry != end && entry->hash == hash; ++entry)
+	{
+		if (GetName(*entry) == name) return entry;
+	}
+	return nullptr;
+}
+
+std::string_view FileSystem::GetName(const Entry& entry) const
+{
+	return std::string_view(names_ + entry.name_offset, entry.name_size);
+}
+
+std::vector<std::uint8_t> FileSystem::PrepareBlocks(
+	const Entry& entry,
+	std::vector<std::pair<const std::uint8_t*, std::uint32_t>>& blocks) const
+{
+	const std::uint8_t* source =
+		archive_ + entry.offset + entry.block_count * sizeof(std::uint32_t);
+	blocks.resize(entry.block_count);
+	for (std::uint32_t i = 0; i < entry.block_count; ++i)
+	{
+		std::uint32_t block_size;
+		std::memcpy(
+			&block_size,
+			archive_ + entry.offset + i * sizeof(std::uint32_t),
+			sizeof(block_size));
+		blocks[i] = { source, block_size };
+		source += block_size;
+	}
+	return std::vector<std::uint8_t>(static_cast<std::size_t>(entry.size));
+}
+
+std::string FileSystem::FindLoose(
+	const std::string& path,
+	const std::string& name) const
+{
+	std::error_code error_code;
+	if (std::filesystem::is_regular_file(path, error_code)) return path;
+	if (!loose_root_.empty())
+	{
+		const std::string rooted =
+			(std::filesystem::path(loose_root_) / name).string();
+		if (std::filesystem::is_regular_file(rooted, error_code)) return rooted;
+	}
+	return {};
+}
+
+bool FileSystem::Exists(const std::string& path) const
+{
+	const std::string name = Normalize(path);
+	return Find(name) || !FindLoose(path, name).empty();
+}
+
+FileData FileSystem::Read(const std::string& path, JobSystem* jobs) const
+{
+	const std::string name = Normalize(path);
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex_);
+		if (const auto it = prefetched_.find(name); it != prefetched_.end())
+		{
+			FileData data = std::move(it->second);
+			prefetched_.erase(it);
+			return data;
+		}
+	}
+	if (const Entry* entry = Find(name))
+	{
+		if (!(entry->flags & FLAG_COMPRESSED))
+		{
+			return FileData(std::span<const std::uint8_t>(
+				archive_ + entry->offset,
+				static_cast<std::size_t>(entry->size)));
+		}
+		std::vector<std::pair<const std::uint8_t*, std::uint32_t>> blocks;
+		std::vector<std::uint8_t> bytes = PrepareBlocks(*entry, blocks);
+		std::vector<BlockTask> tasks(blocks.size());
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+		{
+			const std::size_t begin = i * BLOCK_SIZE;
+			tasks[i].source = blocks[i].first;
+			tasks[i].source_size = blocks[i].second;
+			tasks[i].destination = bytes.data() + begin;
+			tasks[i].destination_size = static_cast<std::uint32_t>(
+				std::min<std::size_t>(BLOCK_SIZE, bytes.size() - begin));
+		}
+		std::atomic<bool> failed = false;
+		auto decompress = [&tasks, &failed](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				if (!DecompressBlock(tasks[i])) failed = true;
+			}
+		};
+		if (jobs)
+		{
+			jobs->ParallelFor(tasks.size(), 1, decompress);
+		}
+		else
+		{
+			decompress(0, tasks.size());
+		}
+		if (failed)
+		{
+			throw std::runtime_error("Corrupt archive entry: " + name);
+		}
+		return FileData(std::move(bytes));
+	}
+	const std::string loose = FindLoose(path, name);
+	if (loose.empty())
+	{
+		throw std::runtime_error("Could not find file: " + path);
+	}
+	return FileData(ReadLooseFile(loose));
+}
+
+bool FileSystem::Prefetch(const std::string& path) const
+{
+	const std::string name = Normalize(path);
+	if (const Entry* entry = Find(name))
+	{
+		if (!(entry->flags & FLAG_COMPRESSED)) return true;
+	}
+	else if (FindLoose(path, name).empty())
+	{
+		return false;
+	}
+	FileData data = Read(path);
+	std::lock_guard<std::mutex> lock(prefetch_mutex_);
+	prefetched_.insert_or_assign(name, std::move(data));
+	return true;
+}
+
+void FileSystem::Prefetch(
+	const std::vector<std::string>& paths,
+	JobSystem& jobs) const
+{
+	std::vector<std::string> reads;
+	for (const std::string& path : paths)
+	{
+		const std::string name = Normalize(path);
+		if (const Entry* entry = Find(name))
+		{
+			if (entry->flags & FLAG_COMPRESSED) reads.push_back(path);
+		}
+		else if (!FindLoose(path, name).empty())
+		{
+			reads.push_back(path);
+		}
+	}
+	std::vector<FileData> files = ReadAll(reads, jobs);
+	std::lock_guard<std::mutex> lock(prefetch_mutex_);
+	for (std::size_t i = 0; i < reads.size(); ++i)
+	{
+		prefetched_.insert_or_assign(Normalize(reads[i]), std::move(files[i]));
+	}
+}
+
+void FileSystem::ClearPrefetched()
+{
+	std::lock_guard<std::mutex> lock(prefetch_mutex_);
+	prefetched_.clear();
+}
+
+std::string FileSystem::ReadText(const std::string& path) const
+{
+	return std::string(Read(path).GetText());
+}
+
+std::vector<FileData> FileSystem::ReadAll(
+	const std::vector<std::string>& paths,
+	JobSystem& jobs) const
+{
+	std::vector<FileData> files(paths.size());
+	std::vector<std::vector<std::uint8_t>> outputs(paths.size());
+	std::vector<std::string> loose(paths.size());
+	std::vector<BlockTask> tasks;
+	std::vector<std::pair<const std::uint8_t*, std::uint32_t>> blocks;
+	for (std::size_t file = 0; file < paths.size(); ++file)
+	{
+		const std::string name = Normalize(paths[file]);
+		const Entry* entry = Find(name);
+		if (entry && !(entry->flags & FLAG_COMPRESSED))
+		{
+			files[file] = Read(paths[file]);
+			continue;
+		}
+		if (entry)
+		{
+			outputs[file] = PrepareBlocks(*entry, blocks);
+			for (std::size_t i = 0; i < blocks.size(); ++i)
+			{
+				const std::size_t begin = i * BLOCK_SIZE;
+				tasks.push_back({
+					file,
+					blocks[i].first,
+					blocks[i].second,
+					outputs[file].data() + begin,
+					static_cast<std::uint32_t>(
+						std::min<std::size_t>(BLOCK_SIZE, outputs[file].size() - begin)) });
+			}
+			continue;
+		}
+		loose[file] = FindLoose(paths[file], name);
+		if (loose[file].empty())
+		{
+			throw std::runtime_error("Could not find file: " + paths[file]);
+		}
+		tasks.push_back({ file });
+	}
+
+	// Loose files are read in the same loop, jobs can't throw.
+	std::mutex error_mutex;
+	std::string error;
+	jobs.ParallelFor(
+		tasks.size(),
+		1,
+		[&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const BlockTask& task = tasks[i];
+				std::string task_error;
+				if (task.source)
+				{
+					if (!DecompressBlock(task))
+					{
+						task_error = "Corrupt archive entry: " + paths[task.file];
+					}
+				}
+				else
+				{
+					try
+					{
+						files[task.file] = FileData(ReadLooseFile(loose[task.file]));
+					}
+					catch (const std::exception& e)
+					{
+						task_error = e.what();
+					}
+				}
+				if (!task_error.empty())
+				{
+					std::lock_guard<std::mutex> lock(error_mutex);
+					if (error.empty()) error = task_error;
+				}
+			}
+		});
+	if (!error.empty()) throw std::runtime_error(error);
+	for (std::size_t file = 0; file < paths.size(); ++file)
+	{
+		if (!outputs[file].empty())
+		{
+			files[file] = FileData(std::move(outputs[file]));
+		}
+	}
+	return files;
+}
+
+std::vector<std::string> FileSystem::List(const std::string& directory) const
+{
+	std::string prefix = Normalize(directory);
+	if (!prefix.empty()) prefix += '/';
+	std::string base = directory;
+	while (!base.empty() && (base.back() == '/' || base.back() == '\\'))
+	{
+		base.pop_back();
+	}
+	if (!base.empty()) base += '/';
+
+	std::set<std::string> files;
+	for (std::size_t i = 0; i < entry_count_; ++i)
+	{
+		const std::string_view name = GetName(entries_[i]);
+		if (name.size() <= prefix.size() ||
+			name.compare(0, prefix.size(), prefix) != 0 ||
+			name.find('/', prefix.size()) != std::string_view::npos)
+		{
+			continue;
+		}
+		files.insert(base + std::string(name.substr(prefix.size())));
+	}
+	std::error_code error_code;
+	std::filesystem::path loose = directory;
+	if (!std::filesystem::is_directory(loose, error_code) && !loose_root_.empty())
+	{
+		loose = std::filesystem::path(loose_root_) / prefix;
+	}
+	if (std::filesystem::is_directory(loose, error_code))
+	{
+		for (const auto& item : std::filesystem::directory_iterator(loose))
+		{
+			if (!item.is_regular_file()) continue;
+			files.insert(base + item.path().filename().string());
+		}
+	}
+	return std::vector<std::string>(files.begin(), files.end());
+}
+
+} // End namespace gl.
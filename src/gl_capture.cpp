@@ -0,0 +1,431 @@
+#include <gl_capture.h>
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// Flushed to the file past this.
+	constexpr std::size_t FLUSH_BYTES = 1 << 20;
+	// Smaller blobs are not worth compressing.
+	constexpr std::size_t COMPRESS_MIN_BYTES = 64;
+
+	std::uint64_t Hash(const void* data, std::size_t size)
+	{
+		// FNV-1a, seeded with the size.
+		std::uint64_t hash = 14695981039346656037ull ^ size;
+		const auto* bytes = static_cast<const std::uint8_t*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	void AppendBytes(std::vector<std::uint8_t>& out, const void* data, std::size_t size)
+	{
+		const auto* bytes = static_cast<const std::uint8_t*>(data);
+		out.insert(out.end(), bytes, bytes + size);
+	}
+
+	template <typename T>
+	T As(GlSlot slot)
+	{
+		return FromGlSlot<T>(slot);
+	}
+
+	// Bytes read by glUniform*v and glProgramUniform*v per count.
+	std::size_t UniformBytes(GlEntryPointEnum entry)
+	{
+		switch (entry)
+		{
+		case GlEntryPointEnum::glUniform2fv:
+		case GlEntryPointEnum::glUniform2iv:
+		case GlEntryPointEnum::glProgramUniform2fv:
+		case GlEntryPointEnum::glProgramUniform2iv:
+			return 2 * 4;
+		case GlEntryPointEnum::glUniform3fv:
+		case GlEntryPointEnum::glUniform3iv:
+		case GlEntryPointEnum::glProgramUniform3fv:
+		case GlEntryPointEnum::glProgramUniform3iv:
+			return 3 * 4;
+		case GlEntryPointEnum::glUniform4fv:
+		case GlEntryPointEnum::glUniformMatrix2fv:
+		case GlEntryPointEnum::glProgramUniform4fv:
+		case GlEntryPointEnum::glProgramUniformMatrix2fv:
+			return 4 * 4;
+		case GlEntryPointEnum::glUniformMatrix3fv:
+		case GlEntryPointEnum::glProgramUniformMatrix3fv:
+			return 9 * 4;
+		case GlEntryPointEnum::glUniformMatrix4fv:
+		case GlEntryPointEnum::glProgramUniformMatrix4fv:
+			return 16 * 4;
+		default:
+			return 0;
+		}
+	}
+
+} // End anonymous namespace.
+
+GlCapture& GlCapture::GetInstance()
+{
+	static GlCapture instance;
+	return instance;
+}
+
+void GlCapture::Start(const std::string& path, int frame_count, int width, int height)
+{
+	if (capturing_) Stop();
+	file_.open(path, std::ios::binary | std::ios::trunc);
+	if (!file_)
+	{
+		throw std::runtime_error("Could not write the GL capture " + path + ".");
+	}
+	path_ = path;
+	pending_.clear();
+	blobs_.clear();
+	mappings_.clear();
+	unpack_alignment_ = 4;
+	unpack_buffer_bound_ = false;
+	frame_count_ = frame_count;
+	frames_done_ = 0;
+	call_count_ = 0;
+	payload_bytes_ = 0;
+	blob_bytes_ = 0;
+	file_bytes_ = 0;
+
+	AppendBytes(pending_, GL_CAPTURE_MAGIC, sizeof(GL_CAPTURE_MAGIC));
+	AppendVarint(pending_, GL_CAPTURE_VERSION);
+	AppendVarint(pending_, static_cast<std::uint64_t>(width));
+	AppendVarint(pending_, static_cast<std::uint64_t>(height));
+	// By name, so files outlive changes to the entry point list.
+	AppendVarint(pending_, GL_ENTRY_POINT_COUNT);
+	for (std::size_t i = 0; i < GL_ENTRY_POINT_COUNT; ++i)
+	{
+		const char* name = GetGlEntryPointName(static_cast<GlEntryPointEnum>(i));
+		const std::size_t length = std::strlen(name);
+		AppendVarint(pending_, length);
+		AppendBytes(pending_, name, length);
+	}
+	capturing_ = true;
+	GlIntercept::GetInstance().AddListener(this);
+}
+
+void GlCapture::EndSetup()
+{
+	if (!capturing_ || frames_done_ > 0) return;
+	pending_.push_back(static_cast<std::uint8_t>(GlCaptureTagEnum::SETUP));
+}
+
+void GlCapture::EndFrame()
+{
+	if (!capturing_) return;
+	pending_.push_back(static_cast<std::uint8_t>(GlCaptureTagEnum::FRAME));
+	if (++frames_done_ >= frame_count_)
+	{
+		Stop();
+		return;
+	}
+	if (pending_.size() >= FLUSH_BYTES) Flush();
+}
+
+void GlCapture::Stop()
+{
+	if (!capturing_) return;
+	GlIntercept::GetInstance().RemoveListener(this);
+	pending_.push_back(static_cast<std::uint8_t>(GlCaptureTagEnum::END));
+	Flush();
+	file_.close();
+	capturing_ = false;
+	std::cout
+		<< "Wrote " << path_ << ": " << frames_done_ << " frames, "
+		<< call_count_ << " calls, " << payload_bytes_ << " payload bytes stored as "
+		<< blob_bytes_ << " unique bytes, " << file_bytes_ << " bytes in total\n";
+}
+
+void GlCapture::Flush()
+{
+	file_.write(reinterpret_cast<const char*>(pending_.data()), pending_.size());
+	file_bytes_ += pending_.size();
+	pending_.clear();
+}
+
+std::uint64_t GlCapture::AddBlob(const void* data, std::size_t size)
+{
+	const std::uint64_t hash = Hash(data, size);
+	const auto it = blobs_.find(hash);
+	if (it != blobs_.end()) return it->second;
+	const std::uint64_t index = blobs_.size();
+	blobs_.emplace(hash, index);
+	blob_bytes_ += size;
+	pending_.push_back(static_cast<std::uint8_t>(GlCaptureTagEnum::BLOB));
+	AppendVarint(pending_, size);
+	if (size >= COMPRESS_MIN_BYTES)
+	{
+		std::vector<char> compressed(LZ4_compressBound(static_cast<int>(size)));
+		const int compressed_size = LZ4_compress_default(
+			static_cast<const char*>(data),
+			compressed.data(),
+			static_cast<int>(size),
+			static_cast<int>(compressed.size()));
+		if (compressed_size > 0 && static_cast<std::size_t>(compressed_size) < size)
+		{
+			AppendVarint(pending_, static_cast<std::uint64_t>(compressed_size));
+			AppendBytes(pending_, compressed.data(), compressed_size);
+			return index;
+		}
+	}
+	AppendVarint(pending_, 0);
+	AppendBytes(pending_, data, size);
+	return index;
+}
+
+void GlCapture::AddPayload(
+	GlPayloadEnum type,
+	std::size_t arg,
+	const void* data,
+	std::size_t size)
+{
+	payload_bytes_ += size;
+	payloads_.push_back({ type, arg, AddBlob(data, size) });
+}
+
+void GlCapture::BeforeCall(const GlCall& call)
+{
+	if (call.entry != GlEntryPointEnum::glUnmapBuffer) return;
+	// The pointer is gone after the call.
+	const auto it = mappings_.find(As<GLenum>(call.args[0]));
+	if (it != mappings_.end() && (it->second.access & GL_MAP_WRITE_BIT))
+	{
+		AddPayload(GlPayloadEnum::MAPPED, 0, it->second.data, it->second.size);
+	}
+}
+
+void GlCapture::AfterCall(const GlCall& call)
+{
+	GlSlot args[GL_MAX_ARGUMENTS] = {};
+	std::memcpy(args, call.args, call.arg_count * sizeof(GlSlot));
+	// Client memory read by the call, offsets into bound buffers are
+	// recorded as they are.
+	auto input = [this, &args](std::size_t arg, std::size_t size) {
+		if (args[arg] && size)
+		{
+			AddPayload(GlPayloadEnum::ARGUMENT, arg, As<const void*>(args[arg]), size);
+		}
+	};
+	auto string = [&input, &args](std::size_t arg) {
+		if (args[arg]) input(arg, std::strlen(As<const char*>(args[arg])) + 1);
+	};
+	auto count = [&args](std::size_t count_arg) {
+		return static_cast<std::size_t>(std::max(As<GLsizei>(args[count_arg]), 0));
+	};
+	auto names = [&count](std::size_t count_arg) {
+		return count(count_arg) * sizeof(GLuint);
+	};
+	switch (call.entry)
+	{
+	case GlEntryPointEnum::glBindAttribLocation:
+		string(2);
+		break;
+	case GlEntryPointEnum::glGetUniformLocation:
+		string(1);
+		break;
+	case GlEntryPointEnum::glBindBuffer:
+		if (args[0] == GL_PIXEL_UNPACK_BUFFER) unpack_buffer_bound_ = args[1] != 0;
+		break;
+	case GlEntryPointEnum::glPixelStorei:
+		if (args[0] == GL_UNPACK_ALIGNMENT) unpack_alignment_ = As<GLint>(args[1]);
+		break;
+	case GlEntryPointEnum::glBufferData:
+	case GlEntryPointEnum::glBufferStorage:
+	case GlEntryPointEnum::glNamedBufferStorage:
+		input(2, args[1]);
+		break;
+	case GlEntryPointEnum::glBufferSubData:
+	case GlEntryPointEnum::glNamedBufferSubData:
+		input(3, args[2]);
+		break;
+	case GlEntryPointEnum::glClearBufferfv:
+		input(2, args[0] == GL_COLOR ? 4 * sizeof(GLfloat) : sizeof(GLfloat));
+		break;
+	case GlEntryPointEnum::glDeleteBuffers:
+	case GlEntryPointEnum::glDeleteFramebuffers:
+	case GlEntryPointEnum::glDeleteQueries:
+	case GlEntryPointEnum::glDeleteRenderbuffers:
+	case GlEntryPointEnum::glDeleteTextures:
+	case GlEntryPointEnum::glDeleteVertexArrays:
+	case GlEntryPointEnum::glDrawBuffers:
+		input(1, names(0));
+		break;
+	case GlEntryPointEnum::glCreateBuffers:
+	case GlEntryPointEnum::glCreateVertexArrays:
+	case GlEntryPointEnum::glGenBuffers:
+	case GlEntryPointEnum::glGenFramebuffers:
+	case GlEntryPointEnum::glGenQueries:
+	case GlEntryPointEnum::glGenRenderbuffers:
+	case GlEntryPointEnum::glGenTextures:
+	case GlEntryPointEnum::glGenVertexArrays:
+		if (args[1])
+		{
+			AddPayload(
+				GlPayloadEnum::OUTPUT,
+				1,
+				As<const void*>(args[1]),
+				names(0));
+		}
+		break;
+	case GlEntryPointEnum::glCreateTextures:
+		if (args[2])
+		{
+			AddPayload(
+				GlPayloadEnum::OUTPUT,
+				2,
+				As<const void*>(args[2]),
+				names(1));
+		}
+		break;
+	case GlEntryPointEnum::glShaderBinary:
+		input(1, names(0));
+		input(3, count(4));
+		break;
+	case GlEntryPointEnum::glShaderSource:
+	{
+		// Joined into a single string.
+		const auto* strings = As<const GLchar* const*>(args[2]);
+		const auto* lengths = As<const GLint*>(args[3]);
+		std::string source;
+		for (std::size_t i = 0; i < count(1); ++i)
+		{
+			if (lengths && lengths[i] >= 0)
+			{
+				source.append(strings[i], lengths[i]);
+			}
+			else
+			{
+				source.append(strings[i]);
+			}
+		}
+		args[1] = 1;
+		args[3] = 0;
+		AddPayload(GlPayloadEnum::INDIRECT, 2, source.c_str(), source.size() + 1);
+		break;
+	}
+	case GlEntryPointEnum::glSpecializeShader:
+	case GlEntryPointEnum::glSpecializeShaderARB:
+		string(1);
+		input(3, names(2));
+		input(4, names(2));
+		break;
+	case GlEntryPointEnum::glTexImage2D:
+	case GlEntryPointEnum::glTexSubImage2D:
+	case GlEntryPointEnum::glTextureSubImage2D:
+		if (!unpack_buffer_bound_)
+		{
+			const bool sub = call.entry != GlEntryPointEnum::glTexImage2D;
+			input(8, GetGlImageBytes(
+				As<GLsizei>(args[sub ? 4 : 3]),
+				As<GLsizei>(args[sub ? 5 : 4]),
+				1,
+				As<GLenum>(args[6]),
+				As<GLenum>(args[7]),
+				unpack_alignment_));
+		}
+		break;
+	case GlEntryPointEnum::glTexSubImage3D:
+		if (!unpack_buffer_bound_)
+		{
+			input(10, GetGlImageBytes(
+				As<GLsizei>(args[5]),
+				As<GLsizei>(args[6]),
+				As<GLsizei>(args[7]),
+				As<GLenum>(args[8]),
+				As<GLenum>(args[9]),
+				unpack_alignment_));
+		}
+		break;
+	case GlEntryPointEnum::glUniform2fv:
+	case GlEntryPointEnum::glUniform2iv:
+	case GlEntryPointEnum::glUniform3fv:
+	case GlEntryPointEnum::glUniform3iv:
+	case GlEntryPointEnum::glUniform4fv:
+		input(2, count(1) * UniformBytes(call.entry));
+		break;
+	case GlEntryPointEnum::glUniformMatrix2fv:
+	case GlEntryPointEnum::glUniformMatrix3fv:
+	case GlEntryPointEnum::glUniformMatrix4fv:
+		input(3, count(1) * UniformBytes(call.entry));
+		break;
+	case GlEntryPointEnum::glProgramUniform2fv:
+	case GlEntryPointEnum::glProgramUniform2iv:
+	case GlEntryPointEnum::glProgramUniform3fv:
+	case GlEntryPointEnum::glProgramUniform3iv:
+	case GlEntryPointEnum::glProgramUniform4fv:
+		input(3, count(2) * UniformBytes(call.entry));
+		break;
+	case GlEntryPointEnum::glProgramUniformMatrix2fv:
+	case GlEntryPointEnum::glProgramUniformMatrix3fv:
+	case GlEntryPointEnum::glProgramUniformMatrix4fv:
+		input(4, count(2) * UniformBytes(call.entry));
+		break;
+	case GlEntryPointEnum::glMapBufferRange:
+		if (call.result)
+		{
+			mappings_[As<GLenum>(args[0])] = {
+				As<const void*>(call.result),
+				static_cast<std::size_t>(args[2]),
+				As<GLbitfield>(args[3]) };
+		}
+		break;
+	case GlEntryPointEnum::glUnmapBuffer:
+		mappings_.erase(As<GLenum>(args[0]));
+		break;
+	default:
+		break;
+	}
+
+	pending_.push_back(static_cast<std::uint8_t>(GlCaptureTagEnum::CALL));
+	AppendVarint(pending_, static_cast<std::uint64_t>(call.entry));
+	AppendVarint(pending_, call.arg_count << 1 | (call.has_result ? 1 : 0));
+	for (std::size_t i = 0; i < call.arg_count; ++i)
+	{
+		AppendVarint(pending_, ZigZag(args[i]));
+	}
+	if (call.has_result) AppendVarint(pending_, ZigZag(call.result));
+	AppendVarint(pending_, payloads_.size());
+	for (const auto& payload : payloads_)
+	{
+		pending_.push_back(static_cast<std::uint8_t>(payload.type));
+		AppendVarint(pending_, payload.arg);
+		AppendVarint(pending_, payload.blob);
+	}
+	payloads_.clear();
+	++call_count_;
+}
+
+void GlCapture::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("GL capture")) return;
+	if (!capturing_)
+	{
+		ImGui::Text("Set GPR5300_GL_CAPTURE to a file to capture from startup.");
+		return;
+	}
+	ImGui::Text("Capturing to %s", path_.c_str());
+	ImGui::Text("Frame %d / %d", frames_done_, frame_count_);
+	ImGui::Text(
+		"%llu calls, %.2f MB unique payloads",
+		static_cast<unsigned long long>(call_count_),
+		static_cast<double>(blob_bytes_) / (1024.0 * 1024.0));
+	if (ImGui::Button("Stop")) Stop();
+}
+
+} // End namespace gl.
@@ -0,0 +1,190 @@
+#include <gl_intercept.h>
+
+#include <algorithm>
+
+namespace gl {
+
+namespace {
+
+	const char* const entry_point_names[] = {
+#define GL_INTERCEPT_NAME(name) #name,
+		GL_INTERCEPT_ENTRY_POINTS(GL_INTERCEPT_NAME)
+#undef GL_INTERCEPT_NAME
+	};
+
+	std::size_t PixelBytes(GLenum format, GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_SHORT_5_6_5:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+			return 2;
+		case GL_UNSIGNED_INT_24_8:
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_5_9_9_9_REV:
+			return 4;
+		default:
+			break;
+		}
+		std::size_t components = 1;
+		switch (format)
+		{
+		case GL_RG:
+		case GL_RG_INTEGER:
+			components = 2;
+			break;
+		case GL_RGB:
+		case GL_BGR:
+		case GL_RGB_INTEGER:
+			components = 3;
+			break;
+		case GL_RGBA:
+		case GL_BGRA:
+		case GL_RGBA_INTEGER:
+			components = 4;
+			break;
+		default:
+			break;
+		}
+		switch (type)
+		{
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return components * 2;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return components * 4;
+		default:
+			return components;
+		}
+	}
+
+	// Read by every wrapper, GL is only called from the main thread.
+	std::vector<GlCallListener*> listeners;
+
+	// Stands in for one glad pointer, the signature taken from its type.
+	template <GlEntryPointEnum E, typename F>
+	struct Hook;
+
+	template <GlEntryPointEnum E, typename R, typename... Args>
+	struct Hook<E, R (APIENTRY*)(Args...)>
+	{
+		static inline R (APIENTRY* original)(Args...) = nullptr;
+
+		static R APIENTRY Call(Args... args)
+		{
+			// One more so there is no empty array.
+			const GlSlot slots[] = { ToGlSlot(args)..., 0 };
+			GlCall call;
+			call.entry = E;
+			call.args = slots;
+			call.arg_count = sizeof...(Args);
+			call.has_result = !std::is_void_v<R>;
+			for (auto* listener : listeners) listener->BeforeCall(call);
+			if constexpr (std::is_void_v<R>)
+			{
+				original(args...);
+				for (auto* listener : listeners) listener->AfterCall(call);
+			}
+			else
+			{
+				const R result = original(args...);
+				call.result = ToGlSlot(result);
+				for (auto* listener : listeners) listener->AfterCall(call);
+				return result;
+			}
+		}
+	};
+
+#define GL_INTERCEPT_HOOK(name) Hook<GlEntryPointEnum::name, decltype(name)>
+
+	void SaveOriginals()
+	{
+#define GL_INTERCEPT_SAVE(name) GL_INTERCEPT_HOOK(name)::original = name;
+		GL_INTERCEPT_ENTRY_POINTS(GL_INTERCEPT_SAVE)
+#undef GL_INTERCEPT_SAVE
+	}
+
+	// Entry points the driver lacks stay null, callers test them.
+	void SwapPointers(bool wrap)
+	{
+#define GL_INTERCEPT_SWAP(name) \
+		if (GL_INTERCEPT_HOOK(name)::original) \
+		{ \
+			name = wrap ? &GL_INTERCEPT_HOOK(name)::Call : GL_INTERCEPT_HOOK(name)::original; \
+		}
+		GL_INTERCEPT_ENTRY_POINTS(GL_INTERCEPT_SWAP)
+#undef GL_INTERCEPT_SWAP
+	}
+
+#undef GL_INTERCEPT_HOOK
+
+} // End anonymous namespace.
+
+const char* GetGlEntryPointName(GlEntryPointEnum entry)
+{
+	const auto index = static_cast<std::size_t>(entry);
+	return index < GL_ENTRY_POINT_COUNT ? entry_point_names[index] : "";
+}
+
+std::size_t GetGlImageBytes(
+	GLsizei width,
+	GLsizei height,
+	GLsizei depth,
+	GLenum format,
+	GLenum type,
+	int alignment)
+{
+	if (width <= 0 || height <= 0 || depth <= 0) return 0;
+	const std::size_t row = static_cast<std::size_t>(width) * PixelBytes(format, type);
+	const std::size_t align = static_cast<std::size_t>(std::max(alignment, 1));
+	const std::size_t stride = (row + align - 1) / align * align;
+	// The last row is not padded.
+	const std::size_t rows = static_cast<std::size_t>(height) * depth;
+	return stride * (rows - 1) + row;
+}
+
+GlIntercept& GlIntercept::GetInstance()
+{
+	static GlIntercept instance;
+	return instance;
+}
+
+void GlIntercept::Install()
+{
+	// Loading glad again replaced any wrapper with the new pointers.
+	wrapped_ = false;
+	SaveOriginals();
+	installed_ = true;
+	SetWrappers(!listeners.empty());
+}
+
+void GlIntercept::AddListener(GlCallListener* listener)
+{
+	if (std::find(listeners.begin(), listeners.end(), listener) == listeners.end())
+	{
+		listeners.push_back(listener);
+	}
+	SetWrappers(true);
+}
+
+void GlIntercept::RemoveListener(GlCallListener* listener)
+{
+	listeners.erase(
+		std::remove(listeners.begin(), listeners.end(), listener),
+		listeners.end());
+	SetWrappers(!listeners.empty());
+}
+
+void GlIntercept::SetWrappers(bool enabled)
+{
+	if (!installed_ || enabled == wrapped_) return;
+	SwapPointers(enabled);
+	wrapped_ = enabled;
+}
+
+} // End namespace gl.
@@ -0,0 +1,1030 @@
+#include <gl_replay.h>
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "gl_capture.h"
+
+namespace gl {
+
+namespace {
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	template <typename T>
+	T As(GlSlot slot)
+	{
+		return FromGlSlot<T>(slot);
+	}
+
+	float Milliseconds(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<float, std::milli>(end - start).count();
+	}
+
+	template <typename R, typename... Args, std::size_t... I>
+	GlSlot InvokeWith(
+		R (APIENTRY* function)(Args...),
+		const GlSlot* args,
+		std::index_sequence<I...>)
+	{
+		if constexpr (std::is_void_v<R>)
+		{
+			function(FromGlSlot<Args>(args[I])...);
+			return 0;
+		}
+		else
+		{
+			return ToGlSlot(function(FromGlSlot<Args>(args[I])...));
+		}
+	}
+
+	template <typename R, typename... Args>
+	GlSlot Invoke(R (APIENTRY* function)(Args...), const GlSlot* args)
+	{
+		return InvokeWith(function, args, std::index_sequence_for<Args...>{});
+	}
+
+	// False when the entry point is not loaded.
+	using Invoker = bool (*)(const GlSlot* args, GlSlot& result);
+
+	const Invoker invokers[] = {
+#define GL_REPLAY_INVOKER(name) \
+		[](const GlSlot* args, GlSlot& result) \
+		{ \
+			if (!name) return false; \
+			result = Invoke(name, args); \
+			return true; \
+		},
+		GL_INTERCEPT_ENTRY_POINTS(GL_REPLAY_INVOKER)
+#undef GL_REPLAY_INVOKER
+	};
+
+	// GL names live in one namespace per kind of object.
+	enum class NameEnum
+	{
+		BUFFER = 0,
+		TEXTURE,
+		VERTEX_ARRAY,
+		FRAMEBUFFER,
+		RENDERBUFFER,
+		QUERY,
+		PROGRAM,
+		SHADER,
+		SYNC,
+		TEXTURE_HANDLE,
+		COUNT,
+	};
+
+	// Kind of the names glGen*/glCreate* write and glDelete* reads, COUNT
+	// if none.
+	NameEnum GetArrayNames(GlEntryPointEnum entry)
+	{
+		switch (entry)
+		{
+		case GlEntryPointEnum::glCreateBuffers:
+		case GlEntryPointEnum::glGenBuffers:
+		case GlEntryPointEnum::glDeleteBuffers:
+			return NameEnum::BUFFER;
+		case GlEntryPointEnum::glCreateTextures:
+		case GlEntryPointEnum::glGenTextures:
+		case GlEntryPointEnum::glDeleteTextures:
+			return NameEnum::TEXTURE;
+		case GlEntryPointEnum::glCreateVertexArrays:
+		case GlEntryPointEnum::glGenVertexArrays:
+		case GlEntryPointEnum::glDeleteVertexArrays:
+			return NameEnum::VERTEX_ARRAY;
+		case GlEntryPointEnum::glGenFramebuffers:
+		case GlEntryPointEnum::glDeleteFramebuffers:
+			return NameEnum::FRAMEBUFFER;
+		case GlEntryPointEnum::glGenRenderbuffers:
+		case GlEntryPointEnum::glDeleteRenderbuffers:
+			return NameEnum::RENDERBUFFER;
+		case GlEntryPointEnum::glGenQueries:
+		case GlEntryPointEnum::glDeleteQueries:
+			return NameEnum::QUERY;
+		default:
+			return NameEnum::COUNT;
+		}
+	}
+
+	bool IsDelete(GlEntryPointEnum entry)
+	{
+		switch (entry)
+		{
+		case GlEntryPointEnum::glDeleteBuffers:
+		case GlEntryPointEnum::glDeleteTextures:
+		case GlEntryPointEnum::glDeleteVertexArrays:
+		case GlEntryPointEnum::glDeleteFramebuffers:
+		case GlEntryPointEnum::glDeleteRenderbuffers:
+		case GlEntryPointEnum::glDeleteQueries:
+		case GlEntryPointEnum::glDeleteProgram:
+		case GlEntryPointEnum::glDeleteShader:
+		case GlEntryPointEnum::glDeleteSync:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Bytes of one index of a glDrawElements type.
+	std::size_t IndexBytes(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_UNSIGNED_SHORT:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	// Primitives that stay the same when two ranges are joined.
+	bool IsListMode(GLenum mode)
+	{
+		return mode == GL_POINTS || mode == GL_LINES || mode == GL_TRIANGLES;
+	}
+
+	// Everything a replay needs besides the calls.
+	class Player
+	{
+	public:
+		Player(
+			const std::vector<std::vector<std::uint8_t>>& blobs,
+			GlReplayReport& report,
+			bool time_calls) :
+			blobs_(blobs),
+			report_(report),
+			time_calls_(time_calls)
+		{
+		}
+
+		template <typename Call, typename Payload>
+		void Execute(const Call& call, const Payload* payloads)
+		{
+			if (call.entry == GlEntryPointEnum::COUNT)
+			{
+				++report_.skipped_calls;
+				return;
+			}
+			GlSlot args[GL_MAX_ARGUMENTS] = {};
+			std::copy(call.args, call.args + call.arg_count, args);
+			const GlSlot* output = nullptr;
+			const GLchar* source = nullptr;
+			recorded_names_.clear();
+			for (std::size_t i = 0; i < call.payload_count; ++i)
+			{
+				const auto& payload = payloads[call.payload_begin + i];
+				const auto& blob = blobs_[payload.blob];
+				switch (static_cast<GlPayloadEnum>(payload.type))
+				{
+				case GlPayloadEnum::ARGUMENT:
+					args[payload.arg] = ToGlSlot(blob.data());
+					break;
+				case GlPayloadEnum::INDIRECT:
+					source = reinterpret_cast<const GLchar*>(blob.data());
+					args[payload.arg] = ToGlSlot(&source);
+					break;
+				case GlPayloadEnum::OUTPUT:
+					output = &args[payload.arg];
+					recorded_names_.resize(blob.size() / sizeof(GLuint));
+					std::memcpy(recorded_names_.data(), blob.data(), blob.size());
+					args[payload.arg] = ToGlSlot(Scratch(blob.size()));
+					break;
+				case GlPayloadEnum::MAPPED:
+				{
+					const auto it = mappings_.find(As<GLenum>(args[0]));
+					if (it != mappings_.end())
+					{
+						std::memcpy(it->second, blob.data(), blob.size());
+					}
+					break;
+				}
+				}
+			}
+			Remap(call, args);
+
+			GlSlot result = 0;
+			const auto start = time_calls_ ? Clock::now() : Clock::time_point();
+			if (!invokers[static_cast<std::size_t>(call.entry)](args, result))
+			{
+				++report_.skipped_calls;
+				return;
+			}
+			const auto index = static_cast<std::size_t>(call.entry);
+			if (time_calls_)
+			{
+				report_.ms_by_entry_point[index] += Milliseconds(start, Clock::now());
+			}
+			++report_.calls_by_entry_point[index];
+
+			Record(call, args, result, output);
+		}
+
+	protected:
+		void* Scratch(std::size_t size)
+		{
+			if (scratch_.size() < size) scratch_.resize(size);
+			return scratch_.data();
+		}
+
+		GlSlot Find(NameEnum kind, GlSlot recorded) const
+		{
+			const auto& names = names_[static_cast<std::size_t>(kind)];
+			const auto it = names.find(recorded);
+			// Made before the capture started, or 0.
+			return it == names.end() ? recorded : it->second;
+		}
+
+		void Map(NameEnum kind, GlSlot& arg) const
+		{
+			arg = Find(kind, arg);
+		}
+
+		// Names read from an array, into the names buffer, the recorded ones
+		// kept for Record.
+		void MapArray(NameEnum kind, GlSlot& arg, std::size_t count)
+		{
+			const auto* recorded = As<const GLuint*>(arg);
+			if (!recorded) return;
+			recorded_names_.assign(recorded, recorded + count);
+			array_names_.resize(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				array_names_[i] = static_cast<GLuint>(Find(kind, recorded[i]));
+			}
+			arg = ToGlSlot(array_names_.data());
+		}
+
+		// From the recorded names to the replayed ones, outputs go to the
+		// scratch memory.
+		template <typename Call>
+		void Remap(const Call& call, GlSlot* args)
+		{
+			const NameEnum array_names = GetArrayNames(call.entry);
+			if (array_names != NameEnum::COUNT && IsDelete(call.entry))
+			{
+				MapArray(array_names, args[1], As<GLsizei>(args[0]));
+				return;
+			}
+			switch (call.entry)
+			{
+			case GlEntryPointEnum::glAttachShader:
+				Map(NameEnum::PROGRAM, args[0]);
+				Map(NameEnum::SHADER, args[1]);
+				break;
+			case GlEntryPointEnum::glBeginQuery:
+				Map(NameEnum::QUERY, args[1]);
+				break;
+			case GlEntryPointEnum::glBindBuffer:
+				if (args[0] == GL_PIXEL_PACK_BUFFER) pack_buffer_bound_ = args[1] != 0;
+				Map(NameEnum::BUFFER, args[1]);
+				break;
+			case GlEntryPointEnum::glBindBufferBase:
+			case GlEntryPointEnum::glBindBufferRange:
+				Map(NameEnum::BUFFER, args[2]);
+				break;
+			case GlEntryPointEnum::glBindFramebuffer:
+				Map(NameEnum::FRAMEBUFFER, args[1]);
+				break;
+			case GlEntryPointEnum::glBindImageTexture:
+				Map(NameEnum::TEXTURE, args[1]);
+				break;
+			case GlEntryPointEnum::glBindRenderbuffer:
+				Map(NameEnum::RENDERBUFFER, args[1]);
+				break;
+			case GlEntryPointEnum::glBindTexture:
+			case GlEntryPointEnum::glBindTextureUnit:
+				Map(NameEnum::TEXTURE, args[1]);
+				break;
+			case GlEntryPointEnum::glBindVertexArray:
+			case GlEntryPointEnum::glEnableVertexArrayAttrib:
+			case GlEntryPointEnum::glVertexArrayAttribBinding:
+			case GlEntryPointEnum::glVertexArrayAttribFormat:
+				Map(NameEnum::VERTEX_ARRAY, args[0]);
+				break;
+			case GlEntryPointEnum::glVertexArrayElementBuffer:
+				Map(NameEnum::VERTEX_ARRAY, args[0]);
+				Map(NameEnum::BUFFER, args[1]);
+				break;
+			case GlEntryPointEnum::glVertexArrayVertexBuffer:
+				Map(NameEnum::VERTEX_ARRAY, args[0]);
+				Map(NameEnum::BUFFER, args[2]);
+				break;
+			case GlEntryPointEnum::glNamedBufferStorage:
+			case GlEntryPointEnum::glNamedBufferSubData:
+				Map(NameEnum::BUFFER, args[0]);
+				break;
+			case GlEntryPointEnum::glGenerateTextureMipmap:
+			case GlEntryPointEnum::glTextureParameteri:
+			case GlEntryPointEnum::glTextureStorage2D:
+			case GlEntryPointEnum::glTextureSubImage2D:
+				Map(NameEnum::TEXTURE, args[0]);
+				break;
+			case GlEntryPointEnum::glClientWaitSync:
+			case GlEntryPointEnum::glDeleteSync:
+				Map(NameEnum::SYNC, args[0]);
+				break;
+			case GlEntryPointEnum::glBindAttribLocation:
+			case GlEntryPointEnum::glDeleteProgram:
+			case GlEntryPointEnum::glLinkProgram:
+				Map(NameEnum::PROGRAM, args[0]);
+				break;
+			case GlEntryPointEnum::glCompileShader:
+			case GlEntryPointEnum::glDeleteShader:
+			case GlEntryPointEnum::glShaderSource:
+			case GlEntryPointEnum::glSpecializeShader:
+			case GlEntryPointEnum::glSpecializeShaderARB:
+				Map(NameEnum::SHADER, args[0]);
+				break;
+			case GlEntryPointEnum::glFramebufferRenderbuffer:
+				Map(NameEnum::RENDERBUFFER, args[3]);
+				break;
+			case GlEntryPointEnum::glFramebufferTexture2D:
+				Map(NameEnum::TEXTURE, args[3]);
+				break;
+			case GlEntryPointEnum::glGetBufferSubData:
+				args[3] = ToGlSlot(Scratch(args[2]));
+				break;
+			case GlEntryPointEnum::glGetFloatv:
+			case GlEntryPointEnum::glGetInteger64v:
+			case GlEntryPointEnum::glGetIntegerv:
+				args[1] = ToGlSlot(Scratch(256));
+				break;
+			case GlEntryPointEnum::glGetProgramiv:
+				Map(NameEnum::PROGRAM, args[0]);
+				args[2] = ToGlSlot(Scratch(256));
+				break;
+			case GlEntryPointEnum::glGetQueryObjectiv:
+			case GlEntryPointEnum::glGetQueryObjectui64v:
+				Map(NameEnum::QUERY, args[0]);
+				args[2] = ToGlSlot(Scratch(256));
+				break;
+			case GlEntryPointEnum::glGetShaderiv:
+				Map(NameEnum::SHADER, args[0]);
+				args[2] = ToGlSlot(Scratch(256));
+				break;
+			case GlEntryPointEnum::glGetShaderInfoLog:
+			{
+				Map(NameEnum::SHADER, args[0]);
+				// The length first, then the log.
+				auto* scratch = static_cast<std::uint8_t*>(
+					Scratch(sizeof(GLsizei) + std::max(As<GLsizei>(args[1]), 0)));
+				args[2] = ToGlSlot(scratch);
+				args[3] = ToGlSlot(scratch + sizeof(GLsizei));
+				break;
+			}
+			case GlEntryPointEnum::glGetTextureHandleARB:
+				Map(NameEnum::TEXTURE, args[0]);
+				break;
+			case GlEntryPointEnum::glGetUniformLocation:
+				Map(NameEnum::PROGRAM, args[0]);
+				break;
+			case GlEntryPointEnum::glMakeTextureHandleNonResidentARB:
+			case GlEntryPointEnum::glMakeTextureHandleResidentARB:
+				Map(NameEnum::TEXTURE_HANDLE, args[0]);
+				break;
+			case GlEntryPointEnum::glPixelStorei:
+				if (args[0] == GL_PACK_ALIGNMENT) pack_alignment_ = As<GLint>(args[1]);
+				break;
+			case GlEntryPointEnum::glQueryCounter:
+				Map(NameEnum::QUERY, args[0]);
+				break;
+			case GlEntryPointEnum::glReadPixels:
+				if (!pack_buffer_bound_)
+				{
+					args[6] = ToGlSlot(Scratch(GetGlImageBytes(
+						As<GLsizei>(args[2]),
+						As<GLsizei>(args[3]),
+						1,
+						As<GLenum>(args[4]),
+						As<GLenum>(args[5]),
+						pack_alignment_)));
+				}
+				break;
+			case GlEntryPointEnum::glShaderBinary:
+				MapArray(NameEnum::SHADER, args[1], As<GLsizei>(args[0]));
+				break;
+			case GlEntryPointEnum::glUseProgram:
+				program_ = args[0];
+				Map(NameEnum::PROGRAM, args[0]);
+				break;
+			case GlEntryPointEnum::glUniform1f:
+			case GlEntryPointEnum::glUniform1i:
+			case GlEntryPointEnum::glUniform2f:
+			case GlEntryPointEnum::glUniform2fv:
+			case GlEntryPointEnum::glUniform2iv:
+			case GlEntryPointEnum::glUniform3f:
+			case GlEntryPointEnum::glUniform3fv:
+			case GlEntryPointEnum::glUniform3iv:
+			case GlEntryPointEnum::glUniform4f:
+			case GlEntryPointEnum::glUniform4fv:
+			case GlEntryPointEnum::glUniformMatrix2fv:
+			case GlEntryPointEnum::glUniformMatrix3fv:
+			case GlEntryPointEnum::glUniformMatrix4fv:
+			{
+				// Explicit locations were not queried and stay as they are.
+				const auto it = locations_.find(LocationKey(program_, args[0]));
+				if (it != locations_.end()) args[0] = it->second;
+				break;
+			}
+			case GlEntryPointEnum::glProgramUniform1f:
+			case GlEntryPointEnum::glProgramUniform1i:
+			case GlEntryPointEnum::glProgramUniform2fv:
+			case GlEntryPointEnum::glProgramUniform2iv:
+			case GlEntryPointEnum::glProgramUniform3fv:
+			case GlEntryPointEnum::glProgramUniform3iv:
+			case GlEntryPointEnum::glProgramUniform4fv:
+			case GlEntryPointEnum::glProgramUniformMatrix2fv:
+			case GlEntryPointEnum::glProgramUniformMatrix3fv:
+			case GlEntryPointEnum::glProgramUniformMatrix4fv:
+			{
+				// Looked up with the recorded program.
+				const auto it = locations_.find(LocationKey(args[0], args[1]));
+				if (it != locations_.end()) args[1] = it->second;
+				Map(NameEnum::PROGRAM, args[0]);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		static std::uint64_t LocationKey(GlSlot program, GlSlot location)
+		{
+			return program << 32 | static_cast<std::uint32_t>(location);
+		}
+
+		// Names made by the call, and what it released.
+		template <typename Call>
+		void Record(const Call& call, const GlSlot* args, GlSlot result, const GlSlot* output)
+		{
+			auto add = [this](NameEnum kind, GlSlot recorded, GlSlot replayed) {
+				if (recorded) names_[static_cast<std::size_t>(kind)][recorded] = replayed;
+			};
+			auto remove = [this](NameEnum kind, GlSlot recorded) {
+				names_[static_cast<std::size_t>(kind)].erase(recorded);
+			};
+			const NameEnum array_names = GetArrayNames(call.entry);
+			if (array_names != NameEnum::COUNT)
+			{
+				if (IsDelete(call.entry))
+				{
+					for (const GLuint recorded : recorded_names_) remove(array_names, recorded);
+				}
+				else if (output)
+				{
+					const auto* replayed = As<const GLuint*>(*output);
+					for (std::size_t i = 0; i < recorded_names_.size(); ++i)
+					{
+						add(array_names, recorded_names_[i], replayed[i]);
+					}
+				}
+				return;
+			}
+			switch (call.entry)
+			{
+			case GlEntryPointEnum::glCreateProgram:
+				add(NameEnum::PROGRAM, call.result, result);
+				break;
+			case GlEntryPointEnum::glCreateShader:
+				add(NameEnum::SHADER, call.result, result);
+				break;
+			case GlEntryPointEnum::glFenceSync:
+				add(NameEnum::SYNC, call.result, result);
+				break;
+			case GlEntryPointEnum::glGetTextureHandleARB:
+				add(NameEnum::TEXTURE_HANDLE, call.result, result);
+				break;
+			case GlEntryPointEnum::glGetUniformLocation:
+				locations_[LocationKey(call.args[0], call.result)] = result;
+				break;
+			case GlEntryPointEnum::glDeleteProgram:
+				remove(NameEnum::PROGRAM, call.args[0]);
+				break;
+			case GlEntryPointEnum::glDeleteShader:
+				remove(NameEnum::SHADER, call.args[0]);
+				break;
+			case GlEntryPointEnum::glDeleteSync:
+				remove(NameEnum::SYNC, call.args[0]);
+				break;
+			case GlEntryPointEnum::glMapBufferRange:
+				if (result) mappings_[As<GLenum>(args[0])] = As<void*>(result);
+				break;
+			case GlEntryPointEnum::glUnmapBuffer:
+				mappings_.erase(As<GLenum>(args[0]));
+				break;
+			default:
+				break;
+			}
+		}
+
+	protected:
+		const std::vector<std::vector<std::uint8_t>>& blobs_;
+		GlReplayReport& report_;
+		bool time_calls_ = true;
+		// Recorded name to replayed name, by NameEnum.
+		std::array<std::unordered_map<GlSlot, GlSlot>, static_cast<std::size_t>(NameEnum::COUNT)>
+			names_;
+		// By recorded program and recorded location.
+		std::unordered_map<std::uint64_t, GlSlot> locations_;
+		// Recorded program in use.
+		GlSlot program_ = 0;
+		std::unordered_map<GLenum, void*> mappings_;
+		std::vector<std::uint8_t> scratch_ = std::vector<std::uint8_t>(4096);
+		std::vector<GLuint> recorded_names_;
+		std::vector<GLuint> array_names_;
+		bool pack_buffer_bound_ = false;
+		int pack_alignment_ = 4;
+	};
+
+	// Keys of the state setters tracked to drop the redundant ones.
+	enum class StateEnum : std::uint64_t
+	{
+		ACTIVE_TEXTURE = 1,
+		BUFFER,
+		INDEXED_BUFFER,
+		FRAMEBUFFER,
+		RENDERBUFFER,
+		TEXTURE,
+		// Bound by glBindTextureUnit, whatever the target.
+		TEXTURE_UNIT,
+		VERTEX_ARRAY,
+		PROGRAM,
+		CAPABILITY,
+		DEPTH_FUNC,
+		DEPTH_MASK,
+		BLEND_FUNC,
+		VIEWPORT,
+		CLEAR_COLOR,
+		COLOR_MASK,
+		PIXEL_STORE,
+	};
+
+	// State as set by the calls seen so far, from an unknown state.
+	class StateTracker
+	{
+	public:
+		using Value = std::array<GlSlot, 4>;
+
+		// True when the call changes nothing.
+		template <typename Call>
+		bool IsRedundant(const Call& call)
+		{
+			const GlSlot* args = call.args;
+			switch (call.entry)
+			{
+			case GlEntryPointEnum::glActiveTexture:
+			{
+				const bool same = Set(Key(StateEnum::ACTIVE_TEXTURE), { args[0] });
+				active_texture_ = args[0];
+				return same;
+			}
+			case GlEntryPointEnum::glBindBuffer:
+				return Set(Key(StateEnum::BUFFER, args[0]), { args[1] });
+			case GlEntryPointEnum::glBindBufferBase:
+			case GlEntryPointEnum::glBindBufferRange:
+			{
+				const bool range = call.entry == GlEntryPointEnum::glBindBufferRange;
+				// Also the generic binding.
+				const bool same_generic = Set(Key(StateEnum::BUFFER, args[0]), { args[2] });
+				const bool same_indexed = Set(
+					Key(StateEnum::INDEXED_BUFFER, args[0] << 16 | args[1]),
+					{ args[2], range ? args[3] : 0, range ? args[4] : ~GlSlot(0) });
+				return same_generic && same_indexed;
+			}
+			case GlEntryPointEnum::glBindFramebuffer:
+				if (args[0] == GL_FRAMEBUFFER)
+				{
+					const bool same_draw =
+						Set(Key(StateEnum::FRAMEBUFFER, GL_DRAW_FRAMEBUFFER), { args[1] });
+					const bool same_read =
+						Set(Key(StateEnum::FRAMEBUFFER, GL_READ_FRAMEBUFFER), { args[1] });
+					return same_draw && same_read;
+				}
+				return Set(Key(StateEnum::FRAMEBUFFER, args[0]), { args[1] });
+			case GlEntryPointEnum::glBindRenderbuffer:
+				return Set(Key(StateEnum::RENDERBUFFER), { args[1] });
+			case GlEntryPointEnum::glBindTexture:
+				// Unit unknown before the first glActiveTexture.
+				if (!active_texture_) return false;
+				state_.erase(Key(StateEnum::TEXTURE_UNIT, active_texture_ - GL_TEXTURE0));
+				return Set(
+					Key(StateEnum::TEXTURE, (active_texture_ - GL_TEXTURE0) << 32 | args[0]),
+					{ args[1] });
+			case GlEntryPointEnum::glBindTextureUnit:
+			{
+				// Binds to the target of the texture, which isn't known here.
+				const bool same = Set(Key(StateEnum::TEXTURE_UNIT, args[0]), { args[1] });
+				if (!same)
+				{
+					std::erase_if(state_, [&args](const auto& entry) {
+						return entry.first >> 56 == static_cast<std::uint64_t>(StateEnum::TEXTURE) &&
+							(entry.first & ((std::uint64_t(1) << 56) - 1)) >> 32 == args[0];
+					});
+				}
+				return same;
+			}
+			case GlEntryPointEnum::glBindVertexArray:
+			{
+				const bool same = Set(Key(StateEnum::VERTEX_ARRAY), { args[0] });
+				// The element buffer is state of the vertex array.
+				if (!same) state_.erase(Key(StateEnum::BUFFER, GL_ELEMENT_ARRAY_BUFFER));
+				return same;
+			}
+			case GlEntryPointEnum::glUseProgram:
+				return Set(Key(StateEnum::PROGRAM), { args[0] });
+			case GlEntryPointEnum::glVertexArrayElementBuffer:
+				// Maybe the vertex array bound.
+				state_.erase(Key(StateEnum::BUFFER, GL_ELEMENT_ARRAY_BUFFER));
+				return false;
+			case GlEntryPointEnum::glEnable:
+				return Set(Key(StateEnum::CAPABILITY, args[0]), { 1 });
+			case GlEntryPointEnum::glDisable:
+				return Set(Key(StateEnum::CAPABILITY, args[0]), { 0 });
+			case GlEntryPointEnum::glDepthFunc:
+				return Set(Key(StateEnum::DEPTH_FUNC), { args[0] });
+			case GlEntryPointEnum::glDepthMask:
+				return Set(Key(StateEnum::DEPTH_MASK), { args[0] });
+			case GlEntryPointEnum::glBlendFunc:
+				return Set(Key(StateEnum::BLEND_FUNC), { args[0], args[1] });
+			case GlEntryPointEnum::glViewport:
+				return Set(Key(StateEnum::VIEWPORT), { args[0], args[1], args[2], args[3] });
+			case GlEntryPointEnum::glClearColor:
+				return Set(Key(StateEnum::CLEAR_COLOR), { args[0], args[1], args[2], args[3] });
+			case GlEntryPointEnum::glColorMask:
+				return Set(Key(StateEnum::COLOR_MASK), { args[0], args[1], args[2], args[3] });
+			case GlEntryPointEnum::glPixelStorei:
+				return Set(Key(StateEnum::PIXEL_STORE, args[0]), { args[1] });
+			default:
+				// A deleted name bound somewhere reverts to 0.
+				if (IsDelete(call.entry))
+				{
+					state_.clear();
+					active_texture_ = 0;
+				}
+				return false;
+			}
+		}
+
+	protected:
+		static std::uint64_t Key(StateEnum state, std::uint64_t index = 0)
+		{
+			return static_cast<std::uint64_t>(state) << 56 | index;
+		}
+
+		bool Set(std::uint64_t key, const Value& value)
+		{
+			const auto [it, inserted] = state_.try_emplace(key, value);
+			if (inserted) return false;
+			if (it->second == value) return true;
+			it->second = value;
+			return false;
+		}
+
+	protected:
+		std::unordered_map<std::uint64_t, Value> state_;
+		GlSlot active_texture_ = 0;
+	};
+
+} // End anonymous namespace.
+
+void GlReplay::Load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Could not open the GL capture " + path + ".");
+	}
+	const std::vector<std::uint8_t> data(
+		(std::istreambuf_iterator<char>(file)),
+		std::istreambuf_iterator<char>());
+	auto malformed = [&path]() {
+		return std::runtime_error("Malformed GL capture " + path + ".");
+	};
+	const std::uint8_t* it = data.data();
+	const std::uint8_t* const end = data.data() + data.size();
+	if (data.size() < sizeof(GL_CAPTURE_MAGIC) ||
+		std::memcmp(it, GL_CAPTURE_MAGIC, sizeof(GL_CAPTURE_MAGIC)) != 0)
+	{
+		throw malformed();
+	}
+	it += sizeof(GL_CAPTURE_MAGIC);
+	std::uint64_t version = 0;
+	std::uint64_t width = 0;
+	std::uint64_t height = 0;
+	std::uint64_t entry_count = 0;
+	if (!ReadVarint(it, end, version) || version != GL_CAPTURE_VERSION)
+	{
+		throw std::runtime_error(
+			"GL capture " + path + " is not version " +
+			std::to_string(GL_CAPTURE_VERSION) + ".");
+	}
+	if (!ReadVarint(it, end, width) ||
+		!ReadVarint(it, end, height) ||
+		!ReadVarint(it, end, entry_count))
+	{
+		throw malformed();
+	}
+	width_ = static_cast<int>(width);
+	height_ = static_cast<int>(height);
+	// Entry points of the file to ours, COUNT when unknown here.
+	std::vector<GlEntryPointEnum> entries;
+	for (std::uint64_t i = 0; i < entry_count; ++i)
+	{
+		std::uint64_t length = 0;
+		if (!ReadVarint(it, end, length) || length > std::uint64_t(end - it))
+		{
+			throw malformed();
+		}
+		const std::string name(reinterpret_cast<const char*>(it), length);
+		it += length;
+		GlEntryPointEnum entry = GlEntryPointEnum::COUNT;
+		for (std::size_t j = 0; j < GL_ENTRY_POINT_COUNT; ++j)
+		{
+			if (name == GetGlEntryPointName(static_cast<GlEntryPointEnum>(j)))
+			{
+				entry = static_cast<GlEntryPointEnum>(j);
+				break;
+			}
+		}
+		entries.push_back(entry);
+	}
+
+	calls_.clear();
+	payloads_.clear();
+	blobs_.clear();
+	setup_end_ = 0;
+	frame_ends_.clear();
+	// False on a record cut short, the rest of the file is lost then.
+	auto read_record = [&]() -> bool {
+		const auto tag = static_cast<GlCaptureTagEnum>(*it++);
+		switch (tag)
+		{
+		case GlCaptureTagEnum::BLOB:
+		{
+			std::uint64_t size = 0;
+			std::uint64_t stored = 0;
+			if (!ReadVarint(it, end, size) || !ReadVarint(it, end, stored)) return false;
+			const std::uint64_t bytes = stored ? stored : size;
+			if (bytes > std::uint64_t(end - it)) return false;
+			std::vector<std::uint8_t> blob(size);
+			if (stored)
+			{
+				const int decompressed = LZ4_decompress_safe(
+					reinterpret_cast<const char*>(it),
+					reinterpret_cast<char*>(blob.data()),
+					static_cast<int>(stored),
+					static_cast<int>(size));
+				if (decompressed != static_cast<int>(size)) throw malformed();
+			}
+			else
+			{
+				std::copy(it, it + size, blob.begin());
+			}
+			it += bytes;
+			blobs_.push_back(std::move(blob));
+			return true;
+		}
+		case GlCaptureTagEnum::CALL:
+		{
+			Call call;
+			std::uint64_t entry = 0;
+			std::uint64_t arguments = 0;
+			std::uint64_t payload_count = 0;
+			if (!ReadVarint(it, end, entry) || !ReadVarint(it, end, arguments)) return false;
+			if (entry >= entries.size() || (arguments >> 1) > GL_MAX_ARGUMENTS)
+			{
+				throw malformed();
+			}
+			call.entry = entries[entry];
+			call.arg_count = static_cast<std::uint8_t>(arguments >> 1);
+			call.has_result = arguments & 1;
+			for (std::size_t i = 0; i < call.arg_count; ++i)
+			{
+				std::uint64_t value = 0;
+				if (!ReadVarint(it, end, value)) return false;
+				call.args[i] = UnZigZag(value);
+			}
+			if (call.has_result)
+			{
+				std::uint64_t value = 0;
+				if (!ReadVarint(it, end, value)) return false;
+				call.result = UnZigZag(value);
+			}
+			if (!ReadVarint(it, end, payload_count)) return false;
+			call.payload_begin = payloads_.size();
+			call.payload_count = payload_count;
+			for (std::uint64_t i = 0; i < payload_count; ++i)
+			{
+				Payload payload;
+				std::uint64_t arg = 0;
+				std::uint64_t blob = 0;
+				if (it == end) return false;
+				payload.type = *it++;
+				if (!ReadVarint(it, end, arg) || !ReadVarint(it, end, blob)) return false;
+				if (payload.type > static_cast<std::uint8_t>(GlPayloadEnum::MAPPED) ||
+					arg >= call.arg_count ||
+					blob >= blobs_.size())
+				{
+					throw malformed();
+				}
+				payload.arg = arg;
+				payload.blob = blob;
+				payloads_.push_back(payload);
+			}
+			calls_.push_back(call);
+			return true;
+		}
+		case GlCaptureTagEnum::FRAME:
+			frame_ends_.push_back(calls_.size());
+			return true;
+		case GlCaptureTagEnum::SETUP:
+			setup_end_ = calls_.size();
+			return true;
+		default:
+			throw malformed();
+		}
+	};
+	bool ended = false;
+	while (it < end && !ended)
+	{
+		if (*it == static_cast<std::uint8_t>(GlCaptureTagEnum::END))
+		{
+			ended = true;
+		}
+		else if (!read_record())
+		{
+			break;
+		}
+	}
+	// An application stopped while capturing leaves a partial frame.
+	if (frame_ends_.empty())
+	{
+		throw std::runtime_error("GL capture " + path + " has no complete frame.");
+	}
+	calls_.resize(frame_ends_.back());
+}
+
+std::vector<GlReplay::Call> GlReplay::Transform(
+	std::size_t begin,
+	std::size_t end,
+	const GlReplayOptions& options,
+	GlReplayReport& report) const
+{
+	std::vector<Call> calls;
+	calls.reserve(end - begin);
+	StateTracker state;
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		const Call& call = calls_[i];
+		if (options.drop_get_error && call.entry == GlEntryPointEnum::glGetError)
+		{
+			++report.dropped_calls;
+			continue;
+		}
+		if (options.drop_redundant_binds && state.IsRedundant(call))
+		{
+			++report.dropped_calls;
+			continue;
+		}
+		if (options.merge_draws && !calls.empty() && calls.back().entry == call.entry)
+		{
+			Call& last = calls.back();
+			const GlSlot* a = last.args;
+			const GlSlot* b = call.args;
+			if (call.entry == GlEntryPointEnum::glDrawArrays &&
+				IsListMode(As<GLenum>(a[0])) && a[0] == b[0] &&
+				As<GLint>(a[1]) + As<GLsizei>(a[2]) == As<GLint>(b[1]))
+			{
+				last.args[2] = ToGlSlot(As<GLsizei>(a[2]) + As<GLsizei>(b[2]));
+				++report.merged_draws;
+				continue;
+			}
+			if (call.entry == GlEntryPointEnum::glDrawElements &&
+				IsListMode(As<GLenum>(a[0])) && a[0] == b[0] && a[2] == b[2] &&
+				a[3] + As<GLsizei>(a[1]) * IndexBytes(As<GLenum>(a[2])) == b[3])
+			{
+				last.args[1] = ToGlSlot(As<GLsizei>(a[1]) + As<GLsizei>(b[1]));
+				++report.merged_draws;
+				continue;
+			}
+		}
+		calls.push_back(call);
+	}
+	return calls;
+}
+
+GlReplayReport GlReplay::Run(const GlReplayOptions& options) const
+{
+	GlReplayReport report;
+	report.calls_by_entry_point.assign(GL_ENTRY_POINT_COUNT, 0);
+	report.ms_by_entry_point.assign(GL_ENTRY_POINT_COUNT, 0.0);
+	// Transformed once, replayed as many times as asked.
+	const std::vector<Call> setup = Transform(0, setup_end_, options, report);
+	std::vector<std::vector<Call>> frames;
+	std::size_t begin = setup_end_;
+	for (const std::size_t frame_end : frame_ends_)
+	{
+		frames.push_back(Transform(begin, frame_end, options, report));
+		begin = frame_end;
+	}
+
+	Player player(blobs_, report, options.time_calls);
+	const auto setup_start = Clock::now();
+	for (const Call& call : setup) player.Execute(call, payloads_.data());
+	glFinish();
+	report.setup_ms = Milliseconds(setup_start, Clock::now());
+	for (int loop = 0; loop < std::max(options.loops, 1); ++loop)
+	{
+		for (const auto& frame : frames)
+		{
+			const auto start = Clock::now();
+			for (const Call& call : frame) player.Execute(call, payloads_.data());
+			const auto submitted = Clock::now();
+			if (options.end_frame) options.end_frame();
+			if (options.finish_frames) glFinish();
+			GlReplayFrame stats;
+			stats.submit_ms = Milliseconds(start, submitted);
+			stats.total_ms = Milliseconds(start, Clock::now());
+			stats.calls = frame.size();
+			report.frames.push_back(stats);
+		}
+	}
+	return report;
+}
+
+void GlReplayReport::Print(std::ostream& os, bool per_frame) const
+{
+	os << std::fixed << std::setprecision(3);
+	os << "Setup: " << setup_ms << " ms\n";
+	if (per_frame)
+	{
+		for (std::size_t i = 0; i < frames.size(); ++i)
+		{
+			os
+				<< "Frame " << i << ": " << frames[i].calls << " calls, "
+				<< frames[i].submit_ms << " ms submit, "
+				<< frames[i].total_ms << " ms total\n";
+		}
+	}
+	if (!frames.empty())
+	{
+		auto print = [this, &os](const char* label, float GlReplayFrame::* member) {
+			float sum = 0.0f;
+			float min = frames.front().*member;
+			float max = min;
+			for (const auto& frame : frames)
+			{
+				sum += frame.*member;
+				min = std::min(min, frame.*member);
+				max = std::max(max, frame.*member);
+			}
+			os
+				<< label << ": " << sum / frames.size() << " ms average, "
+				<< min << " min, " << max << " max\n";
+		};
+		os << "Frames: " << frames.size() << "\n";
+		print("Submit", &GlReplayFrame::submit_ms);
+		print("Total", &GlReplayFrame::total_ms);
+	}
+	os
+		<< "Dropped calls: " << dropped_calls
+		<< ", merged draws: " << merged_draws
+		<< ", skipped calls: " << skipped_calls << "\n";
+
+	std::vector<std::size_t> order;
+	for (std::size_t i = 0; i < calls_by_entry_point.size(); ++i)
+	{
+		if (calls_by_entry_point[i]) order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+		return ms_by_entry_point[a] != ms_by_entry_point[b] ?
+			ms_by_entry_point[a] > ms_by_entry_point[b] :
+			calls_by_entry_point[a] > calls_by_entry_point[b];
+	});
+	constexpr std::size_t top = 15;
+	os << "Entry point, calls, ms:\n";
+	for (std::size_t i = 0; i < std::min(order.size(), top); ++i)
+	{
+		const auto entry = static_cast<GlEntryPointEnum>(order[i]);
+		os
+			<< "    " << std::left << std::setw(36) << GetGlEntryPointName(entry)
+			<< std::right << std::setw(10) << calls_by_entry_point[order[i]]
+			<< std::setw(12) << ms_by_entry_point[order[i]] << "\n";
+	}
+}
+
+} // End namespace gl.
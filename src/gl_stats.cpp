@@ -0,0 +1,359 @@
+#include <gl_stats.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	std::int64_t Signed(GlSlot slot)
+	{
+		return static_cast<std::int64_t>(slot);
+	}
+
+	std::uint64_t Primitives(GlSlot mode, GlSlot count)
+	{
+		const std::int64_t n = Signed(count);
+		if (n <= 0) return 0;
+		switch (static_cast<GLenum>(mode))
+		{
+		case GL_TRIANGLES: return n / 3;
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			return n > 2 ? n - 2 : 0;
+		case GL_LINES: return n / 2;
+		case GL_LINE_STRIP: return n - 1;
+		default: return n;
+		}
+	}
+
+	// Calls f(name, value) for every counter of a frame.
+	template <typename F>
+	void ForEachCounter(const GlFrameStats& stats, F&& f)
+	{
+		f("calls", stats.calls);
+		f("draw_calls", stats.draw_calls);
+		f("primitives", stats.primitives);
+		f("dispatches", stats.dispatches);
+		f("program_binds", stats.program_binds);
+		f("texture_binds", stats.texture_binds);
+		f("buffer_binds", stats.buffer_binds);
+		f("vertex_array_binds", stats.vertex_array_binds);
+		f("framebuffer_binds", stats.framebuffer_binds);
+		f("state_changes", stats.state_changes);
+		f("uniform_updates", stats.uniform_updates);
+		f("buffer_bytes", stats.buffer_bytes);
+		f("texture_bytes", stats.texture_bytes);
+	}
+
+	// Entry point indices by decreasing calls.
+	std::vector<std::size_t> SortByCalls(const std::vector<std::uint64_t>& calls)
+	{
+		std::vector<std::size_t> order(calls.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(
+			order.begin(),
+			order.end(),
+			[&calls](std::size_t a, std::size_t b) { return calls[a] > calls[b]; });
+		return order;
+	}
+
+} // End anonymous namespace.
+
+GlStats& GlStats::GetInstance()
+{
+	static GlStats instance;
+	return instance;
+}
+
+void GlStats::SetEnabled(bool enabled)
+{
+	if (enabled == enabled_) return;
+	auto& intercept = GlIntercept::GetInstance();
+	if (enabled && !intercept.IsInstalled()) return;
+	if (enabled)
+	{
+		intercept.AddListener(this);
+	}
+	else
+	{
+		intercept.RemoveListener(this);
+	}
+	enabled_ = enabled;
+	ResetFrame();
+}
+
+void GlStats::ResetFrame()
+{
+	frame_ = GlFrameStats{};
+	std::fill(frame_calls_.begin(), frame_calls_.end(), 0);
+}
+
+void GlStats::AfterCall(const GlCall& call)
+{
+	const GlSlot* args = call.args;
+	++frame_.calls;
+	++frame_calls_[static_cast<std::size_t>(call.entry)];
+	switch (call.entry)
+	{
+	case GlEntryPointEnum::glDrawArrays:
+		++frame_.draw_calls;
+		frame_.primitives += Primitives(args[0], args[2]);
+		break;
+	case GlEntryPointEnum::glDrawElements:
+		++frame_.draw_calls;
+		frame_.primitives += Primitives(args[0], args[1]);
+		break;
+	case GlEntryPointEnum::glDrawElementsInstanced:
+		++frame_.draw_calls;
+		frame_.primitives +=
+			Primitives(args[0], args[1]) * std::max<std::int64_t>(Signed(args[4]), 0);
+		break;
+	case GlEntryPointEnum::glMultiDrawElementsIndirect:
+		frame_.draw_calls += std::max<std::int64_t>(Signed(args[3]), 0);
+		break;
+	case GlEntryPointEnum::glDrawArraysIndirect:
+	case GlEntryPointEnum::glMultiDrawElementsIndirectCount:
+	case GlEntryPointEnum::glMultiDrawElementsIndirectCountARB:
+		// The draw count is read on the GPU, one submission.
+		++frame_.draw_calls;
+		break;
+	case GlEntryPointEnum::glDispatchCompute:
+	case GlEntryPointEnum::glDispatchComputeIndirect:
+		++frame_.dispatches;
+		break;
+	case GlEntryPointEnum::glUseProgram:
+		++frame_.program_binds;
+		break;
+	case GlEntryPointEnum::glBindTexture:
+	case GlEntryPointEnum::glBindTextureUnit:
+	case GlEntryPointEnum::glBindImageTexture:
+		++frame_.texture_binds;
+		break;
+	case GlEntryPointEnum::glBindBuffer:
+		++frame_.buffer_binds;
+		if (args[0] == GL_PIXEL_UNPACK_BUFFER) unpack_buffer_bound_ = args[1] != 0;
+		break;
+	case GlEntryPointEnum::glBindBufferBase:
+	case GlEntryPointEnum::glBindBufferRange:
+		++frame_.buffer_binds;
+		break;
+	case GlEntryPointEnum::glBindVertexArray:
+		++frame_.vertex_array_binds;
+		break;
+	case GlEntryPointEnum::glBindFramebuffer:
+		++frame_.framebuffer_binds;
+		break;
+	case GlEntryPointEnum::glActiveTexture:
+	case GlEntryPointEnum::glBlendFunc:
+	case GlEntryPointEnum::glClearColor:
+	case GlEntryPointEnum::glColorMask:
+	case GlEntryPointEnum::glDepthFunc:
+	case GlEntryPointEnum::glDepthMask:
+	case GlEntryPointEnum::glDisable:
+	case GlEntryPointEnum::glEnable:
+	case GlEntryPointEnum::glViewport:
+		++frame_.state_changes;
+		break;
+	case GlEntryPointEnum::glUniform1f:
+	case GlEntryPointEnum::glUniform1i:
+	case GlEntryPointEnum::glUniform2f:
+	case GlEntryPointEnum::glUniform2fv:
+	case GlEntryPointEnum::glUniform2iv:
+	case GlEntryPointEnum::glUniform3f:
+	case GlEntryPointEnum::glUniform3fv:
+	case GlEntryPointEnum::glUniform3iv:
+	case GlEntryPointEnum::glUniform4f:
+	case GlEntryPointEnum::glUniform4fv:
+	case GlEntryPointEnum::glUniformMatrix2fv:
+	case GlEntryPointEnum::glUniformMatrix3fv:
+	case GlEntryPointEnum::glUniformMatrix4fv:
+	case GlEntryPointEnum::glProgramUniform1f:
+	case GlEntryPointEnum::glProgramUniform1i:
+	case GlEntryPointEnum::glProgramUniform2fv:
+	case GlEntryPointEnum::glProgramUniform2iv:
+	case GlEntryPointEnum::glProgramUniform3fv:
+	case GlEntryPointEnum::glProgramUniform3iv:
+	case GlEntryPointEnum::glProgramUniform4fv:
+	case GlEntryPointEnum::glProgramUniformMatrix2fv:
+	case GlEntryPointEnum::glProgramUniformMatrix3fv:
+	case GlEntryPointEnum::glProgramUniformMatrix4fv:
+		++frame_.uniform_updates;
+		break;
+	case GlEntryPointEnum::glBufferData:
+	case GlEntryPointEnum::glBufferStorage:
+	case GlEntryPointEnum::glNamedBufferStorage:
+		if (args[2]) frame_.buffer_bytes += args[1];
+		break;
+	case GlEntryPointEnum::glBufferSubData:
+	case GlEntryPointEnum::glNamedBufferSubData:
+		frame_.buffer_bytes += args[2];
+		break;
+	case GlEntryPointEnum::glTexImage2D:
+		if (args[8] || unpack_buffer_bound_)
+		{
+			frame_.texture_bytes += GetGlImageBytes(args[3], args[4], 1, args[6], args[7]);
+		}
+		break;
+	case GlEntryPointEnum::glTexSubImage2D:
+	case GlEntryPointEnum::glTextureSubImage2D:
+		if (args[8] || unpack_buffer_bound_)
+		{
+			frame_.texture_bytes += GetGlImageBytes(args[4], args[5], 1, args[6], args[7]);
+		}
+		break;
+	case GlEntryPointEnum::glTexSubImage3D:
+		if (args[10] || unpack_buffer_bound_)
+		{
+			frame_.texture_bytes +=
+				GetGlImageBytes(args[5], args[6], args[7], args[8], args[9]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void GlStats::EndFrame(float frame_ms)
+{
+	if (!enabled_) return;
+	frame_.frame_ms = frame_ms;
+	frame_.calls_by_entry_point = frame_calls_;
+	last_frame_ = frame_;
+	ResetFrame();
+	if (capture_remaining_ > 0)
+	{
+		captured_.push_back(last_frame_);
+		if (--capture_remaining_ == 0) FinishCapture();
+	}
+}
+
+void GlStats::StartCapture(int frame_count, const std::string& path)
+{
+	if (frame_count <= 0 || IsCapturing()) return;
+	enabled_before_capture_ = enabled_;
+	SetEnabled(true);
+	if (!enabled_) return;
+	captured_.clear();
+	capture_path_ = path;
+	capture_remaining_ = frame_count;
+}
+
+void GlStats::FinishCapture()
+{
+	std::ofstream file(capture_path_);
+	if (file)
+	{
+		WriteJson(file, captured_);
+		std::cout << "Wrote " << capture_path_ << "\n";
+	}
+	else
+	{
+		std::cerr << "Could not write " << capture_path_ << "\n";
+	}
+	captured_.clear();
+	SetEnabled(enabled_before_capture_);
+}
+
+void GlStats::WriteJson(std::ostream& os, const std::vector<GlFrameStats>& frames)
+{
+	const double count = frames.empty() ? 1.0 : static_cast<double>(frames.size());
+	// Sums of every counter, in ForEachCounter order.
+	std::size_t counter_count = 0;
+	ForEachCounter(GlFrameStats{}, [&](const char*, std::uint64_t) { ++counter_count; });
+	std::vector<double> sums(counter_count, 0.0);
+	double frame_ms = 0.0;
+	std::vector<std::uint64_t> calls(GL_ENTRY_POINT_COUNT, 0);
+	for (const auto& stats : frames)
+	{
+		std::size_t i = 0;
+		ForEachCounter(stats, [&](const char*, std::uint64_t value) {
+			sums[i++] += static_cast<double>(value);
+		});
+		frame_ms += stats.frame_ms;
+		for (std::size_t e = 0; e < stats.calls_by_entry_point.size(); ++e)
+		{
+			calls[e] += stats.calls_by_entry_point[e];
+		}
+	}
+	os << "{\n";
+	os << "  \"frame_count\": " << frames.size() << ",\n";
+	os << "  \"average\": {\n";
+	os << "    \"frame_ms\": " << frame_ms / count;
+	std::size_t i = 0;
+	ForEachCounter(GlFrameStats{}, [&](const char* name, std::uint64_t) {
+		os << ",\n    \"" << name << "\": " << sums[i++] / count;
+	});
+	os << "\n  },\n";
+	// Averages per frame, the busiest first, unused ones left out.
+	os << "  \"calls_by_entry_point\": {";
+	bool first = true;
+	for (std::size_t e : SortByCalls(calls))
+	{
+		if (!calls[e]) break;
+		os << (first ? "\n" : ",\n")
+			<< "    \"" << GetGlEntryPointName(static_cast<GlEntryPointEnum>(e)) << "\": "
+			<< static_cast<double>(calls[e]) / count;
+		first = false;
+	}
+	os << "\n  },\n";
+	os << "  \"frames\": [";
+	for (std::size_t f = 0; f < frames.size(); ++f)
+	{
+		os << (f ? ",\n" : "\n") << "    { \"frame_ms\": " << frames[f].frame_ms;
+		ForEachCounter(frames[f], [&os](const char* name, std::uint64_t value) {
+			os << ", \"" << name << "\": " << value;
+		});
+		os << " }";
+	}
+	os << "\n  ]\n";
+	os << "}\n";
+}
+
+void GlStats::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("GL calls")) return;
+	if (!GlIntercept::GetInstance().IsInstalled())
+	{
+		ImGui::Text("Not installed.");
+		return;
+	}
+	bool enabled = enabled_;
+	if (ImGui::Checkbox("Count calls", &enabled))
+	{
+		SetEnabled(enabled);
+	}
+	if (IsCapturing())
+	{
+		ImGui::Text("Capturing, %d frames left", capture_remaining_);
+	}
+	else if (ImGui::Button("Capture 300 frames to gl_stats.json"))
+	{
+		StartCapture(300, "gl_stats.json");
+	}
+	if (!enabled_) return;
+	ForEachCounter(last_frame_, [](const char* name, std::uint64_t value) {
+		ImGui::Text("%s: %llu", name, static_cast<unsigned long long>(value));
+	});
+	if (last_frame_.calls_by_entry_point.empty()) return;
+	const std::vector<std::uint64_t> calls(
+		last_frame_.calls_by_entry_point.begin(),
+		last_frame_.calls_by_entry_point.end());
+	ImGui::Separator();
+	int shown = 0;
+	for (std::size_t e : SortByCalls(calls))
+	{
+		if (!calls[e] || shown++ == 12) break;
+		ImGui::Text(
+			"%6llu %s",
+			static_cast<unsigned long long>(calls[e]),
+			GetGlEntryPointName(static_cast<GlEntryPointEnum>(e)));
+	}
+}
+
+} // End namespace gl.
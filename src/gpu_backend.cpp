@@ -0,0 +1,452 @@
+#include <gpu_backend.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace gl {
+
+namespace {
+
+	// Names only, the object is made by its first bind.
+	GLuint GenerateObject(GpuResourceTypeEnum type)
+	{
+		GLuint id = 0;
+		switch (type)
+		{
+		case GpuResourceTypeEnum::BUFFER: glGenBuffers(1, &id); break;
+		case GpuResourceTypeEnum::TEXTURE: glGenTextures(1, &id); break;
+		case GpuResourceTypeEnum::VERTEX_ARRAY: glGenVertexArrays(1, &id); break;
+		case GpuResourceTypeEnum::PROGRAM: id = glCreateProgram(); break;
+		case GpuResourceTypeEnum::FRAMEBUFFER: glGenFramebuffers(1, &id); break;
+		case GpuResourceTypeEnum::RENDERBUFFER: glGenRenderbuffers(1, &id); break;
+		case GpuResourceTypeEnum::QUERY: glGenQueries(1, &id); break;
+		default: break;
+		}
+		return id;
+	}
+
+	// Binds object for the lifetime of the scope and puts back what the
+	// caller had bound, so editing through binds leaves the state as DSA
+	// would. query reads the current binding, bind(id) binds.
+	template <typename Bind>
+	class ScopedBinding
+	{
+	public:
+		ScopedBinding(GLenum query, GLuint object, Bind bind) :
+			bind_(bind),
+			object_(object)
+		{
+			GLint previous = 0;
+			glGetIntegerv(query, &previous);
+			previous_ = static_cast<GLuint>(previous);
+			if (previous_ != object_) bind_(object_);
+		}
+		~ScopedBinding()
+		{
+			if (previous_ != object_) bind_(previous_);
+		}
+		ScopedBinding(const ScopedBinding&) = delete;
+		ScopedBinding& operator=(const ScopedBinding&) = delete;
+
+	private:
+		Bind bind_;
+		GLuint object_;
+		GLuint previous_ = 0;
+	};
+
+	auto BindTexture2D(GLuint texture)
+	{
+		return ScopedBinding(GL_TEXTURE_BINDING_2D, texture, [](GLuint id) {
+			glBindTexture(GL_TEXTURE_2D, id);
+		});
+	}
+
+	auto BindProgram(GLuint program)
+	{
+		return ScopedBinding(GL_CURRENT_PROGRAM, program, [](GLuint id) {
+			glUseProgram(id);
+		});
+	}
+
+	auto BindVertexArray(GLuint vertex_array)
+	{
+		return ScopedBinding(GL_VERTEX_ARRAY_BINDING, vertex_array, [](GLuint id) {
+			glBindVertexArray(id);
+		});
+	}
+
+	auto BindBuffer(GLenum target, GLenum query, GLuint buffer)
+	{
+		return ScopedBinding(query, buffer, [target](GLuint id) {
+			glBindBuffer(target, id);
+		});
+	}
+
+	class Gl45Backend : public GpuBackend
+	{
+	public:
+		GpuBackendEnum GetType() const override { return GpuBackendEnum::GL45; }
+		const char* GetGlslVersion() const override { return "#version 450"; }
+
+		GLuint CreateObject(GpuResourceTypeEnum type, GLenum target) const override
+		{
+			GLuint id = 0;
+			switch (type)
+			{
+			case GpuResourceTypeEnum::BUFFER:
+				glCreateBuffers(1, &id);
+				return id;
+			case GpuResourceTypeEnum::VERTEX_ARRAY:
+				glCreateVertexArrays(1, &id);
+				return id;
+			case GpuResourceTypeEnum::TEXTURE:
+				if (!target) break;
+				glCreateTextures(target, 1, &id);
+				return id;
+			default:
+				break;
+			}
+			return GenerateObject(type);
+		}
+
+		void AllocateBuffer(
+			GLuint buffer,
+			GLsizeiptr size,
+			const void* data,
+			GLbitfield flags) const override
+		{
+			glNamedBufferStorage(buffer, size, data, flags);
+		}
+		void UpdateBuffer(
+			GLuint buffer,
+			GLintptr offset,
+			GLsizeiptr size,
+			const void* data) const override
+		{
+			glNamedBufferSubData(buffer, offset, size, data);
+		}
+		void AllocateTexture2D(
+			GLuint texture,
+			GLsizei levels,
+			GLenum internal_format,
+			GLsizei width,
+			GLsizei height) const override
+		{
+			glTextureStorage2D(texture, levels, internal_format, width, height);
+		}
+		void UpdateTexture2D(
+			GLuint texture,
+			GLint level,
+			GLsizei width,
+			GLsizei height,
+			GLenum format,
+			GLenum type,
+			const void* pixels) const override
+		{
+			glTextureSubImage2D(
+				texture,
+				level,
+				0,
+				0,
+				width,
+				height,
+				format,
+				type,
+				pixels);
+		}
+		void SetTextureParameter(
+			GLuint texture,
+			GLenum name,
+			GLint value) const override
+		{
+			glTextureParameteri(texture, name, value);
+		}
+		void GenerateMipmaps(GLuint texture) const override
+		{
+			glGenerateTextureMipmap(texture);
+		}
+		void BindTexture(GLuint unit, GLenum, GLuint texture) const override
+		{
+			glBindTextureUnit(unit, texture);
+		}
+
+		void SetVertexAttribute(
+			GLuint vertex_array,
+			GLuint attribute,
+			GLuint buffer,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			GLintptr offset) const override
+		{
+			glVertexArrayVertexBuffer(vertex_array, attribute, buffer, offset, stride);
+			glVertexArrayAttribFormat(vertex_array, attribute, size, type, GL_FALSE, 0);
+			glVertexArrayAttribBinding(vertex_array, attribute, attribute);
+			glEnableVertexArrayAttrib(vertex_array, attribute);
+		}
+		void SetIndexBuffer(GLuint vertex_array, GLuint buffer) const override
+		{
+			glVertexArrayElementBuffer(vertex_array, buffer);
+		}
+
+		void SetUniform(GLuint program, GLint location, int value) const override
+		{
+			glProgramUniform1i(program, location, value);
+		}
+		void SetUniform(GLuint program, GLint location, float value) const override
+		{
+			glProgramUniform1f(program, location, value);
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec2& value) const override
+		{
+			glProgramUniform2fv(program, location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec3& value) const override
+		{
+			glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec4& value) const override
+		{
+			glProgramUniform4fv(program, location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::ivec2& value) const override
+		{
+			glProgramUniform2iv(program, location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::ivec3& value) const override
+		{
+			glProgramUniform3iv(program, location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat2& value) const override
+		{
+			glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat3& value) const override
+		{
+			glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat4& value) const override
+		{
+			glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+	};
+
+	class Gles3Backend : public GpuBackend
+	{
+	public:
+		GpuBackendEnum GetType() const override { return GpuBackendEnum::GLES3; }
+		const char* GetGlslVersion() const override { return "#version 300 es"; }
+
+		GLuint CreateObject(GpuResourceTypeEnum type, GLenum) const override
+		{
+			return GenerateObject(type);
+		}
+
+		// Through the copy target, the element buffer of the bound vertex
+		// array stays as it is.
+		void AllocateBuffer(
+			GLuint buffer,
+			GLsizeiptr size,
+			const void* data,
+			GLbitfield flags) const override
+		{
+			const auto binding = BindBuffer(
+				GL_COPY_WRITE_BUFFER,
+				GL_COPY_WRITE_BUFFER_BINDING,
+				buffer);
+			glBufferData(
+				GL_COPY_WRITE_BUFFER,
+				size,
+				data,
+				(flags & GL_DYNAMIC_STORAGE_BIT) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		}
+		void UpdateBuffer(
+			GLuint buffer,
+			GLintptr offset,
+			GLsizeiptr size,
+			const void* data) const override
+		{
+			const auto binding = BindBuffer(
+				GL_COPY_WRITE_BUFFER,
+				GL_COPY_WRITE_BUFFER_BINDING,
+				buffer);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+		}
+		void AllocateTexture2D(
+			GLuint texture,
+			GLsizei levels,
+			GLenum internal_format,
+			GLsizei width,
+			GLsizei height) const override
+		{
+			const auto binding = BindTexture2D(texture);
+			glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height);
+		}
+		void UpdateTexture2D(
+			GLuint texture,
+			GLint level,
+			GLsizei width,
+			GLsizei height,
+			GLenum format,
+			GLenum type,
+			const void* pixels) const override
+		{
+			const auto binding = BindTexture2D(texture);
+			glTexSubImage2D(
+				GL_TEXTURE_2D,
+				level,
+				0,
+				0,
+				width,
+				height,
+				format,
+				type,
+				pixels);
+		}
+		void SetTextureParameter(
+			GLuint texture,
+			GLenum name,
+			GLint value) const override
+		{
+			const auto binding = BindTexture2D(texture);
+			glTexParameteri(GL_TEXTURE_2D, name, value);
+		}
+		void GenerateMipmaps(GLuint texture) const override
+		{
+			const auto binding = BindTexture2D(texture);
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		void BindTexture(GLuint unit, GLenum target, GLuint texture) const override
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(target, texture);
+		}
+
+		void SetVertexAttribute(
+			GLuint vertex_array,
+			GLuint attribute,
+			GLuint buffer,
+			GLint size,
+			GLenum type,
+			GLsizei stride,
+			GLintptr offset) const override
+		{
+			const auto vertex_array_binding = BindVertexArray(vertex_array);
+			const auto buffer_binding = BindBuffer(
+				GL_ARRAY_BUFFER,
+				GL_ARRAY_BUFFER_BINDING,
+				buffer);
+			glVertexAttribPointer(
+				attribute,
+				size,
+				type,
+				GL_FALSE,
+				stride,
+				reinterpret_cast<const void*>(offset));
+			glEnableVertexAttribArray(attribute);
+		}
+		void SetIndexBuffer(GLuint vertex_array, GLuint buffer) const override
+		{
+			// The element buffer is state of the vertex array.
+			const auto binding = BindVertexArray(vertex_array);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+		}
+
+		void SetUniform(GLuint program, GLint location, int value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform1i(location, value);
+		}
+		void SetUniform(GLuint program, GLint location, float value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform1f(location, value);
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec2& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform2fv(location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec3& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform3fv(location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::vec4& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform4fv(location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::ivec2& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform2iv(location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::ivec3& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniform3iv(location, 1, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat2& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat3& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+		void SetUniform(GLuint program, GLint location, const glm::mat4& value) const override
+		{
+			const auto binding = BindProgram(program);
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+		}
+	};
+
+	Gl45Backend gl45_backend;
+	Gles3Backend gles3_backend;
+	GpuBackend* selected_backend = &gles3_backend;
+
+} // End anonymous namespace.
+
+const char* GetGpuBackendName(GpuBackendEnum backend)
+{
+	switch (backend)
+	{
+	case GpuBackendEnum::GL45: return "GL 4.5 DSA";
+	case GpuBackendEnum::GLES3: return "GLES 3";
+	default: return "Unknown";
+	}
+}
+
+GpuBackend& GpuBackend::GetInstance()
+{
+	return *selected_backend;
+}
+
+GpuBackendEnum GpuBackend::Detect()
+{
+	// glad's desktop loader also accepts a GLES context.
+	const auto* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	const bool es = version && std::strncmp(version, "OpenGL ES", 9) == 0;
+	return !es && GLAD_GL_VERSION_4_5 ? GpuBackendEnum::GL45 : GpuBackendEnum::GLES3;
+}
+
+void GpuBackend::Select(GpuBackendEnum backend)
+{
+	selected_backend = backend == GpuBackendEnum::GL45 ?
+		static_cast<GpuBackend*>(&gl45_backend) :
+		static_cast<GpuBackend*>(&gles3_backend);
+}
+
+GLsizei GetMipLevelCount(GLsizei width, GLsizei height)
+{
+	GLsizei levels = 1;
+	for (GLsizei size = std::max(width, height); size > 1; size /= 2) ++levels;
+	return levels;
+}
+
+} // End namespace gl.
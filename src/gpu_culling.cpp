@@ -0,0 +1,559 @@
+#include <gpu_culling.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// Largest power of two not above value, at least 1.
+	int FloorPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result * 2 <= value) result *= 2;
+		return result;
+	}
+
+} // End anonymous namespace.
+
+void GpuCuller::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void GpuCuller::Init(const std::string& path, std::size_t max_objects)
+{
+	supported_ = GLAD_GL_VERSION_4_3;
+	if (!supported_) return;
+	has_indirect_count_ =
+		(GLAD_GL_VERSION_4_6 && glMultiDrawElementsIndirectCount) ||
+		(GLAD_GL_ARB_indirect_parameters && glMultiDrawElementsIndirectCountARB);
+	max_objects_ = std::max<std::size_t>(max_objects, 1);
+
+	const std::string shaders = path + "data/shaders/gpu_culling/";
+	reset_shader_ = std::make_unique<Shader>(shaders + "reset.comp");
+	cull_shader_ = std::make_unique<Shader>(shaders + "cull.comp");
+	compact_shader_ = std::make_unique<Shader>(shaders + "compact.comp");
+	pyramid_shader_ = std::make_unique<Shader>(shaders + "depth_pyramid.comp");
+	cull_shader_->Use();
+	cull_shader_->SetInt("pyramid", 0);
+	pyramid_shader_->Use();
+	pyramid_shader_->SetInt("depth", 0);
+	glUseProgram(0);
+
+	auto create = [](
+		BufferHandle& buffer,
+		const char* label,
+		std::size_t bytes,
+		GLenum usage)
+	{
+		buffer.Create(label);
+		buffer.SetBytes(bytes);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+		glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, usage);
+	};
+	create(
+		objects_ssbo_,
+		"GpuCuller objects",
+		max_objects_ * sizeof(GpuObject),
+		GL_DYNAMIC_DRAW);
+	create(
+		meshes_ssbo_,
+		"GpuCuller meshes",
+		MAX_MESHES * sizeof(GpuMesh),
+		GL_DYNAMIC_DRAW);
+	create(
+		visible_,
+		"GpuCuller visible",
+		max_objects_ * sizeof(GLuint),
+		GL_DYNAMIC_COPY);
+	create(
+		commands_,
+		"GpuCuller commands",
+		MAX_MESHES * sizeof(DrawElementsIndirectCommand),
+		GL_DYNAMIC_COPY);
+	create(
+		draws_,
+		"GpuCuller draws",
+		sizeof(DrawCounters) + MAX_MESHES * sizeof(DrawElementsIndirectCommand),
+		GL_DYNAMIC_COPY);
+	create(stats_, "GpuCuller stats", sizeof(DrawCounters), GL_STREAM_READ);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+void GpuCuller::Destroy()
+{
+	if (stats_fence_)
+	{
+		glDeleteSync(stats_fence_);
+		stats_fence_ = nullptr;
+	}
+	vbo_.Reset();
+	ebo_.Reset();
+	vao_.Reset();
+	objects_ssbo_.Reset();
+	meshes_ssbo_.Reset();
+	visible_.Reset();
+	commands_.Reset();
+	draws_.Reset();
+	pyramid_.Reset();
+	stats_.Reset();
+	pyramid_size_ = glm::ivec2(0);
+	pyramid_valid_ = false;
+	cull_timer_.Destroy();
+	pyramid_timer_.Destroy();
+	draw_timer_.Destroy();
+	reset_shader_.reset();
+	cull_shader_.reset();
+	compact_shader_.reset();
+	pyramid_shader_.reset();
+	meshes_.clear();
+	mesh_object_counts_.clear();
+	objects_.clear();
+	supported_ = false;
+}
+
+void GpuCuller::SetMeshes(const std::vector<MeshData>& meshes)
+{
+	if (!supported_) return;
+	if (meshes.size() > MAX_MESHES)
+	{
+		throw std::runtime_error("Too many meshes for the GPU culler.");
+	}
+	ClearObjects();
+	meshes_.clear();
+	std::vector<Vertex> vertices;
+	std::vector<std::uint32_t> indices;
+	for (const auto& data : meshes)
+	{
+		GpuMesh mesh = {};
+		glm::vec3 bounds_min(0.0f);
+		glm::vec3 bounds_max(0.0f);
+		if (!data.vertices.empty())
+		{
+			bounds_min = bounds_max = data.vertices.front().position;
+		}
+		for (const auto& vertex : data.vertices)
+		{
+			bounds_min = glm::min(bounds_min, vertex.position);
+			bounds_max = glm::max(bounds_max, vertex.position);
+		}
+		mesh.bounds_min = glm::vec4(bounds_min, 0.0f);
+		mesh.bounds_max = glm::vec4(bounds_max, 0.0f);
+		mesh.index_count = static_cast<std::uint32_t>(data.indices.size());
+		mesh.first_index = static_cast<std::uint32_t>(indices.size());
+		mesh.base_vertex = static_cast<std::int32_t>(vertices.size());
+		meshes_.push_back(mesh);
+		vertices.insert(vertices.end(), data.vertices.begin(), data.vertices.end());
+		indices.insert(indices.end(), data.indices.begin(), data.indices.end());
+	}
+	mesh_object_counts_.assign(meshes_.size(), 0);
+	meshes_dirty_ = true;
+
+	vao_.Create("GpuCuller vertex array");
+	glBindVertexArray(vao_.Get());
+	vbo_.Create("GpuCuller vertices");
+	vbo_.SetBytes(vertices.size() * sizeof(Vertex));
+	glBindBuffer(GL_ARRAY_BUFFER, vbo_.Get());
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		vertices.size() * sizeof(Vertex),
+		vertices.data(),
+		GL_STATIC_DRAW);
+	ebo_.Create("GpuCuller indices");
+	ebo_.SetBytes(indices.size() * sizeof(std::uint32_t));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_.Get());
+	glBufferData(
+		GL_ELEMENT_ARRAY_BUFFER,
+		indices.size() * sizeof(std::uint32_t),
+		indices.data(),
+		GL_STATIC_DRAW);
+	glVertexAttribPointer(
+		0,
+		3,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(Vertex),
+		(GLvoid*)offsetof(Vertex, position));
+	glVertexAttribPointer(
+		1,
+		3,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(Vertex),
+		(GLvoid*)offsetof(Vertex, normal));
+	glVertexAttribPointer(
+		2,
+		2,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(Vertex),
+		(GLvoid*)offsetof(Vertex, tex));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	// Object index per instance, baseInstance selects the mesh's range.
+	glBindBuffer(GL_ARRAY_BUFFER, visible_.Get());
+	glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(3);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+std::uint32_t GpuCuller::AddObject(std::uint32_t mesh, const glm::mat4& model)
+{
+	if (objects_.size() >= max_objects_)
+	{
+		throw std::runtime_error("Too many objects for the GPU culler.");
+	}
+	if (mesh >= meshes_.size())
+	{
+		throw std::runtime_error("Unknown mesh for the GPU culler.");
+	}
+	const auto index = static_cast<std::uint32_t>(objects_.size());
+	objects_.push_back({ model, mesh, {} });
+	++mesh_object_counts_[mesh];
+	meshes_dirty_ = true;
+	if (dirty_begin_ >= dirty_end_) dirty_begin_ = index;
+	dirty_end_ = objects_.size();
+	return index;
+}
+
+void GpuCuller::SetTransform(std::uint32_t object, const glm::mat4& model)
+{
+	objects_[object].model = model;
+	if (dirty_begin_ >= dirty_end_)
+	{
+		dirty_begin_ = object;
+		dirty_end_ = object + 1;
+		return;
+	}
+	dirty_begin_ = std::min<std::size_t>(dirty_begin_, object);
+	dirty_end_ = std::max<std::size_t>(dirty_end_, object + 1);
+}
+
+void GpuCuller::ClearObjects()
+{
+	objects_.clear();
+	std::fill(mesh_object_counts_.begin(), mesh_object_counts_.end(), 0);
+	meshes_dirty_ = true;
+	dirty_begin_ = dirty_end_ = 0;
+}
+
+void GpuCuller::UploadObjects()
+{
+	if (meshes_dirty_)
+	{
+		// Each mesh owns a range of the visible list as long as its count.
+		std::uint32_t offset = 0;
+		for (std::size_t i = 0; i < meshes_.size(); ++i)
+		{
+			meshes_[i].object_offset = offset;
+			offset += mesh_object_counts_[i];
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, meshes_ssbo_.Get());
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			0,
+			meshes_.size() * sizeof(GpuMesh),
+			meshes_.data());
+		meshes_dirty_ = false;
+	}
+	if (dirty_begin_ < dirty_end_)
+	{
+		// One range, scattered updates upload what lies between them.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, objects_ssbo_.Get());
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			dirty_begin_ * sizeof(GpuObject),
+			(dirty_end_ - dirty_begin_) * sizeof(GpuObject),
+			objects_.data() + dirty_begin_);
+		dirty_begin_ = dirty_end_ = 0;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GpuCuller::Cull(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (!supported_ || meshes_.empty()) return;
+	const auto start = std::chrono::high_resolution_clock::now();
+	cull_timer_.Resolve();
+	pyramid_timer_.Resolve();
+	draw_timer_.Resolve();
+	ReadStats();
+	UploadObjects();
+	view_projection_ = projection * view;
+
+	// Gribb and Hartmann, rows of the view projection.
+	const glm::mat4 m = glm::transpose(view_projection_);
+	const glm::vec4 planes[6] = {
+		m[3] + m[0], m[3] - m[0],
+		m[3] + m[1], m[3] - m[1],
+		m[3] + m[2], m[3] - m[2],
+	};
+	const int mesh_count = static_cast<int>(meshes_.size());
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECTS_BINDING, objects_ssbo_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESHES_BINDING, meshes_ssbo_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, visible_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMANDS_BINDING, commands_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAWS_BINDING, draws_.Get());
+
+	cull_timer_.Begin();
+	reset_shader_->Use();
+	reset_shader_->SetInt("mesh_count", mesh_count);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	cull_shader_->Use();
+	cull_shader_->SetInt("object_count", static_cast<int>(objects_.size()));
+	cull_shader_->SetInt("mesh_count", mesh_count);
+	cull_shader_->SetBool("frustum_enabled", frustum_culling_);
+	for (int i = 0; i < 6; ++i)
+	{
+		cull_shader_->SetVec4(
+			"frustum_planes[" + std::to_string(i) + "]",
+			planes[i]);
+	}
+	const bool occlusion = occlusion_culling_ && pyramid_valid_;
+	cull_shader_->SetBool("occlusion_enabled", occlusion);
+	cull_shader_->SetInt("pyramid_levels", pyramid_levels_);
+	cull_shader_->SetMat4("pyramid_view_projection", pyramid_view_projection_);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, occlusion ? pyramid_.Get() : 0);
+	if (!objects_.empty())
+	{
+		glDispatchCompute(
+			static_cast<GLuint>((objects_.size() + 255) / 256),
+			1,
+			1);
+	}
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	compact_shader_->Use();
+	compact_shader_->SetInt("mesh_count", mesh_count);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(
+		GL_COMMAND_BARRIER_BIT |
+		GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+		GL_SHADER_STORAGE_BARRIER_BIT);
+	cull_timer_.End();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	cpu_ms_ = std::chrono::duration<float, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	IsError(__FILE__, __LINE__);
+}
+
+void GpuCuller::Draw() const
+{
+	if (!supported_ || meshes_.empty()) return;
+	draw_timer_.Begin();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECTS_BINDING, objects_ssbo_.Get());
+	glBindVertexArray(vao_.Get());
+	const auto mesh_count = static_cast<GLsizei>(meshes_.size());
+	if (has_indirect_count_ && use_indirect_count_)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, draws_.Get());
+		glBindBuffer(GL_PARAMETER_BUFFER, draws_.Get());
+		const void* commands =
+			reinterpret_cast<const void*>(sizeof(DrawCounters));
+		if (GLAD_GL_VERSION_4_6)
+		{
+			glMultiDrawElementsIndirectCount(
+				GL_TRIANGLES,
+				GL_UNSIGNED_INT,
+				commands,
+				offsetof(DrawCounters, draw_count),
+				mesh_count,
+				0);
+		}
+		else
+		{
+			glMultiDrawElementsIndirectCountARB(
+				GL_TRIANGLES,
+				GL_UNSIGNED_INT,
+				commands,
+				offsetof(DrawCounters, draw_count),
+				mesh_count,
+				0);
+		}
+		glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	}
+	else
+	{
+		// Meshes without visible objects draw zero instances.
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_.Get());
+		glMultiDrawElementsIndirect(
+			GL_TRIANGLES,
+			GL_UNSIGNED_INT,
+			nullptr,
+			mesh_count,
+			0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+	draw_timer_.End();
+	IsError(__FILE__, __LINE__);
+}
+
+void GpuCuller::UpdateDepthPyramid(GLuint depth_texture, glm::ivec2 size)
+{
+	if (!supported_) return;
+	const glm::ivec2 pyramid_size(
+		FloorPowerOfTwo(size.x),
+		FloorPowerOfTwo(size.y));
+	if (pyramid_size != pyramid_size_)
+	{
+		pyramid_size_ = pyramid_size;
+		pyramid_levels_ = 1;
+		while ((std::max(pyramid_size.x, pyramid_size.y) >> pyramid_levels_) > 0)
+		{
+			++pyramid_levels_;
+		}
+		pyramid_.Create("GpuCuller depth pyramid");
+		pyramid_.SetBytes(EstimateTextureBytes(
+			GL_R32F,
+			pyramid_size.x,
+			pyramid_size.y,
+			1,
+			pyramid_levels_));
+		glBindTexture(GL_TEXTURE_2D, pyramid_.Get());
+		glTexStorage2D(
+			GL_TEXTURE_2D,
+			pyramid_levels_,
+			GL_R32F,
+			pyramid_size.x,
+			pyramid_size.y);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	pyramid_timer_.Begin();
+	pyramid_shader_->Use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, depth_texture);
+	for (int level = 0; level < pyramid_levels_; ++level)
+	{
+		const glm::ivec2 level_size = glm::max(
+			glm::ivec2(pyramid_size_.x >> level, pyramid_size_.y >> level),
+			glm::ivec2(1));
+		pyramid_shader_->SetBool("from_depth", level == 0);
+		glBindImageTexture(
+			0,
+			pyramid_.Get(),
+			level,
+			GL_FALSE,
+			0,
+			GL_WRITE_ONLY,
+			GL_R32F);
+		if (level > 0)
+		{
+			glBindImageTexture(
+				1,
+				pyramid_.Get(),
+				level - 1,
+				GL_FALSE,
+				0,
+				GL_READ_ONLY,
+				GL_R32F);
+		}
+		glDispatchCompute((level_size.x + 7) / 8, (level_size.y + 7) / 8, 1);
+		glMemoryBarrier(
+			GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	pyramid_timer_.End();
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	pyramid_view_projection_ = view_projection_;
+	pyramid_valid_ = true;
+	IsError(__FILE__, __LINE__);
+}
+
+void GpuCuller::ReadStats()
+{
+	if (stats_fence_)
+	{
+		const GLenum result = glClientWaitSync(stats_fence_, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) return;
+		glDeleteSync(stats_fence_);
+		stats_fence_ = nullptr;
+		DrawCounters counters = {};
+		glBindBuffer(GL_COPY_READ_BUFFER, stats_.Get());
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(DrawCounters), &counters);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		stats_visible_ = counters.visible_count;
+		stats_draws_ = counters.draw_count;
+	}
+	// Last frame's counters, the cull of this frame is not issued yet.
+	glBindBuffer(GL_COPY_READ_BUFFER, draws_.Get());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, stats_.Get());
+	glCopyBufferSubData(
+		GL_COPY_READ_BUFFER,
+		GL_COPY_WRITE_BUFFER,
+		0,
+		0,
+		sizeof(DrawCounters));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	stats_fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void GpuCuller::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("GPU culling")) return;
+	if (!supported_)
+	{
+		ImGui::Text("Needs OpenGL 4.3.");
+		return;
+	}
+	ImGui::Text(
+		"Objects: %zu, visible: %u in %u draws",
+		objects_.size(),
+		stats_visible_,
+		stats_draws_);
+	ImGui::Text("CPU cull: %.3f ms", cpu_ms_);
+	ImGui::Text(
+		"GPU cull %.3f ms, depth pyramid %.3f ms, draw %.3f ms",
+		cull_timer_.GetMilliseconds(),
+		pyramid_timer_.GetMilliseconds(),
+		draw_timer_.GetMilliseconds());
+	ImGui::Checkbox("Frustum culling", &frustum_culling_);
+	ImGui::Checkbox("Hi-Z occlusion culling", &occlusion_culling_);
+	if (has_indirect_count_)
+	{
+		ImGui::Checkbox("glMultiDrawElementsIndirectCount", &use_indirect_count_);
+	}
+	else
+	{
+		ImGui::Text("No indirect count, every mesh gets a command.");
+	}
+	if (pyramid_valid_)
+	{
+		ImGui::Text(
+			"Depth pyramid %dx%d, %d levels",
+			pyramid_size_.x,
+			pyramid_size_.y,
+			pyramid_levels_);
+	}
+}
+
+} // End namespace gl.
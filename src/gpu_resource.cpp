@@ -0,0 +1,229 @@
+#include <gpu_resource.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "gpu_backend.h"
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	std::size_t BytesPerTexel(GLenum internal_format)
+	{
+		switch (internal_format)
+		{
+		case GL_R8:
+		case GL_RED:
+			return 1;
+		case GL_RG8:
+		case GL_R16F:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_RGBA16F:
+		case GL_RG32F:
+			return 8;
+		case GL_RGBA32F:
+		case GL_RGBA32UI:
+			return 16;
+		// RGB8 and friends are padded to 4 bytes by every driver we know.
+		default:
+			return 4;
+		}
+	}
+
+	double ToMegabytes(std::size_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+} // End anonymous namespace.
+
+const char* GetGpuResourceTypeName(GpuResourceTypeEnum type)
+{
+	switch (type)
+	{
+	case GpuResourceTypeEnum::BUFFER: return "Buffers";
+	case GpuResourceTypeEnum::TEXTURE: return "Textures";
+	case GpuResourceTypeEnum::VERTEX_ARRAY: return "Vertex arrays";
+	case GpuResourceTypeEnum::PROGRAM: return "Programs";
+	case GpuResourceTypeEnum::FRAMEBUFFER: return "Framebuffers";
+	case GpuResourceTypeEnum::RENDERBUFFER: return "Renderbuffers";
+	case GpuResourceTypeEnum::QUERY: return "Queries";
+	default: return "Unknown";
+	}
+}
+
+std::size_t EstimateTextureBytes(
+	GLenum internal_format,
+	int width,
+	int height,
+	int layers,
+	int levels)
+{
+	std::size_t texels = 0;
+	for (int level = 0; levels == 0 || level < levels; ++level)
+	{
+		texels += static_cast<std::size_t>(width) * height;
+		if (width == 1 && height == 1) break;
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return texels * layers * BytesPerTexel(internal_format);
+}
+
+GLuint CreateGpuObject(GpuResourceTypeEnum type, GLenum target)
+{
+	if (!GpuResourceRegistry::GetInstance().IsContextAlive())
+	{
+		throw std::runtime_error("Creating a GL object without a context.");
+	}
+	const GLuint id = GpuBackend::GetInstance().CreateObject(type, target);
+	if (!id)
+	{
+		throw std::runtime_error(
+			std::string("Could not create GL object: ") +
+			GetGpuResourceTypeName(type));
+	}
+	return id;
+}
+
+void DeleteGpuObject(GpuResourceTypeEnum type, GLuint id)
+{
+	// The context and everything in it is already gone.
+	if (!GpuResourceRegistry::GetInstance().IsContextAlive()) return;
+	switch (type)
+	{
+	case GpuResourceTypeEnum::BUFFER: glDeleteBuffers(1, &id); break;
+	case GpuResourceTypeEnum::TEXTURE: glDeleteTextures(1, &id); break;
+	case GpuResourceTypeEnum::VERTEX_ARRAY: glDeleteVertexArrays(1, &id); break;
+	case GpuResourceTypeEnum::PROGRAM: glDeleteProgram(id); break;
+	case GpuResourceTypeEnum::FRAMEBUFFER: glDeleteFramebuffers(1, &id); break;
+	case GpuResourceTypeEnum::RENDERBUFFER: glDeleteRenderbuffers(1, &id); break;
+	case GpuResourceTypeEnum::QUERY: glDeleteQueries(1, &id); break;
+	default: break;
+	}
+}
+
+GpuResourceRegistry& GpuResourceRegistry::GetInstance()
+{
+	static GpuResourceRegistry instance;
+	return instance;
+}
+
+void GpuResourceRegistry::Register(
+	GpuResourceTypeEnum type,
+	GLuint id,
+	const std::string& label)
+{
+	entries_[static_cast<std::size_t>(type)][id] = Entry{ 0, label };
+}
+
+void GpuResourceRegistry::Unregister(GpuResourceTypeEnum type, GLuint id)
+{
+	const auto index = static_cast<std::size_t>(type);
+	auto it = entries_[index].find(id);
+	if (it == entries_[index].end()) return;
+	bytes_[index] -= it->second.bytes;
+	total_bytes_ -= it->second.bytes;
+	entries_[index].erase(it);
+}
+
+void GpuResourceRegistry::SetBytes(
+	GpuResourceTypeEnum type,
+	GLuint id,
+	std::size_t bytes)
+{
+	const auto index = static_cast<std::size_t>(type);
+	auto it = entries_[index].find(id);
+	if (it == entries_[index].end())
+	{
+		throw std::runtime_error("Setting the size of an unregistered object.");
+	}
+	const std::size_t new_total = total_bytes_ - it->second.bytes + bytes;
+	if (budget_bytes_ && bytes > it->second.bytes && new_total > budget_bytes_)
+	{
+		throw std::runtime_error(
+			"GPU memory budget exceeded by " +
+			(it->second.label.empty() ? std::string("unnamed object") : it->second.label) +
+			": " + std::to_string(new_total) +
+			" > " + std::to_string(budget_bytes_) + " bytes");
+	}
+	bytes_[index] = bytes_[index] - it->second.bytes + bytes;
+	total_bytes_ = new_total;
+	peak_bytes_ = std::max(peak_bytes_, total_bytes_);
+	it->second.bytes = bytes;
+}
+
+std::size_t GpuResourceRegistry::GetBytes(GpuResourceTypeEnum type) const
+{
+	return bytes_[static_cast<std::size_t>(type)];
+}
+
+std::size_t GpuResourceRegistry::GetCount(GpuResourceTypeEnum type) const
+{
+	return entries_[static_cast<std::size_t>(type)].size();
+}
+
+std::size_t GpuResourceRegistry::ReportLeaks(std::ostream& os) const
+{
+	std::size_t leaks = 0;
+	for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+	{
+		if (entries_[type].empty()) continue;
+		leaks += entries_[type].size();
+		os
+			<< "[GPU leak] " << entries_[type].size() << " "
+			<< GetGpuResourceTypeName(static_cast<GpuResourceTypeEnum>(type))
+			<< " (" << bytes_[type] << " bytes)\n";
+		// Largest first, that's what creeps.
+		std::vector<std::pair<GLuint, const Entry*>> sorted;
+		for (const auto& [id, entry] : entries_[type])
+			sorted.emplace_back(id, &entry);
+		std::sort(
+			sorted.begin(),
+			sorted.end(),
+			[](const auto& a, const auto& b) {
+				return a.second->bytes > b.second->bytes;
+			});
+		for (const auto& [id, entry] : sorted)
+		{
+			os
+				<< "    id " << id << " "
+				<< (entry->label.empty() ? "<unnamed>" : entry->label)
+				<< ", " << entry->bytes << " bytes\n";
+		}
+	}
+	return leaks;
+}
+
+void GpuResourceRegistry::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("GPU memory")) return;
+	ImGui::Text(
+		"Total: %.2f MB (peak %.2f MB)",
+		ToMegabytes(total_bytes_),
+		ToMegabytes(peak_bytes_));
+	for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+	{
+		ImGui::Text(
+			"%s: %zu, %.2f MB",
+			GetGpuResourceTypeName(static_cast<GpuResourceTypeEnum>(type)),
+			entries_[type].size(),
+			ToMegabytes(bytes_[type]));
+	}
+	int budget_mb = static_cast<int>(budget_bytes_ / (1024 * 1024));
+	if (ImGui::SliderInt("Budget (MB, 0 = none)", &budget_mb, 0, 8192))
+	{
+		budget_bytes_ = static_cast<std::size_t>(budget_mb) * 1024 * 1024;
+	}
+	if (budget_bytes_)
+	{
+		ImGui::ProgressBar(
+			static_cast<float>(total_bytes_) / static_cast<float>(budget_bytes_));
+	}
+}
+
+} // End namespace gl.
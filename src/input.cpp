@@ -0,0 +1,392 @@
+#include <input.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// Recording file: header, then the frames as in memory.
+	struct RecordingHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t frame_size;
+		std::uint32_t frame_count;
+	};
+
+	constexpr char RECORDING_MAGIC[4] = { 'G', 'I', 'N', 'P' };
+	constexpr std::uint32_t RECORDING_VERSION = 1;
+
+	float ApplyDeadZone(float value, float dead_zone)
+	{
+		const float magnitude = std::abs(value);
+		if (magnitude < dead_zone) return 0.0f;
+		return std::copysign(
+			std::min((magnitude - dead_zone) / (1.0f - dead_zone), 1.0f),
+			value);
+	}
+
+} // End anonymous namespace.
+
+Input& Input::GetInstance()
+{
+	static Input instance;
+	return instance;
+}
+
+Input::Input()
+{
+	BindAction("move_forward", { InputSourceEnum::KEY, SDL_SCANCODE_W });
+	BindAction("move_forward", { InputSourceEnum::KEY, SDL_SCANCODE_S, -1.0f });
+	BindAction(
+		"move_forward",
+		{ InputSourceEnum::GAMEPAD_AXIS, SDL_CONTROLLER_AXIS_LEFTY, -1.0f });
+	BindAction("move_right", { InputSourceEnum::KEY, SDL_SCANCODE_D });
+	BindAction("move_right", { InputSourceEnum::KEY, SDL_SCANCODE_A, -1.0f });
+	BindAction(
+		"move_right",
+		{ InputSourceEnum::GAMEPAD_AXIS, SDL_CONTROLLER_AXIS_LEFTX });
+	BindAction(
+		"look_x",
+		{ InputSourceEnum::GAMEPAD_AXIS, SDL_CONTROLLER_AXIS_RIGHTX });
+	BindAction(
+		"look_y",
+		{ InputSourceEnum::GAMEPAD_AXIS, SDL_CONTROLLER_AXIS_RIGHTY, -1.0f });
+}
+
+void Input::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void Input::OnEvent(const SDL_Event& event)
+{
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		// Repeats aren't new input.
+		if (event.key.repeat) break;
+		if (oldest_event_ticks_ == 0) oldest_event_ticks_ = event.key.timestamp;
+		break;
+	case SDL_MOUSEMOTION:
+		if (oldest_event_ticks_ == 0) oldest_event_ticks_ = event.motion.timestamp;
+		break;
+	case SDL_MOUSEWHEEL:
+		wheel_ += static_cast<float>(event.wheel.y);
+		break;
+	case SDL_CONTROLLERDEVICEADDED:
+		if (!gamepad_) OpenGamepad();
+		break;
+	case SDL_CONTROLLERDEVICEREMOVED:
+		if (gamepad_ && !SDL_GameControllerGetAttached(gamepad_))
+		{
+			SDL_GameControllerClose(gamepad_);
+			gamepad_ = nullptr;
+			OpenGamepad();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void Input::OpenGamepad()
+{
+	for (int i = 0; i < SDL_NumJoysticks(); ++i)
+	{
+		if (!SDL_IsGameController(i)) continue;
+		gamepad_ = SDL_GameControllerOpen(i);
+		if (gamepad_) return;
+	}
+}
+
+void Input::SampleDevices(InputFrame& frame, bool keyboard, bool mouse)
+{
+	int key_count = 0;
+	const Uint8* keys = SDL_GetKeyboardState(&key_count);
+	if (keyboard)
+	{
+		key_count = std::min(key_count, static_cast<int>(SDL_NUM_SCANCODES));
+		for (int i = 0; i < key_count; ++i)
+		{
+			if (keys[i]) frame.keys[i / 64] |= std::uint64_t(1) << (i % 64);
+		}
+	}
+	// Read even when unused, the motion accumulates until then.
+	int dx = 0;
+	int dy = 0;
+	SDL_GetRelativeMouseState(&dx, &dy);
+	const Uint32 buttons = SDL_GetMouseState(&frame.mouse_x, &frame.mouse_y);
+	if (mouse)
+	{
+		frame.mouse_buttons = buttons;
+		frame.mouse_dx = static_cast<float>(dx);
+		frame.mouse_dy = static_cast<float>(dy);
+		frame.wheel = wheel_;
+	}
+	wheel_ = 0.0f;
+	if (!gamepad_) return;
+	for (int i = 0; i < SDL_CONTROLLER_BUTTON_MAX; ++i)
+	{
+		if (SDL_GameControllerGetButton(
+			gamepad_,
+			static_cast<SDL_GameControllerButton>(i)))
+		{
+			frame.gamepad_buttons |= 1u << i;
+		}
+	}
+	for (int i = 0; i < SDL_CONTROLLER_AXIS_MAX; ++i)
+	{
+		const Sint16 value = SDL_GameControllerGetAxis(
+			gamepad_,
+			static_cast<SDL_GameControllerAxis>(i));
+		frame.gamepad_axes[i] = ApplyDeadZone(
+			std::max(value / 32767.0f, -1.0f),
+			dead_zone_);
+	}
+}
+
+float Input::Sample(float delta_time, bool keyboard_captured, bool mouse_captured)
+{
+	// Whatever came in since the events were polled, the state functions
+	// only see what has been pumped.
+	SDL_PumpEvents();
+	if (GLAD_GL_VERSION_3_3) glGetInteger64v(GL_TIMESTAMP, &sample_time_);
+	if (oldest_event_ticks_ != 0)
+	{
+		const float age = static_cast<float>(SDL_GetTicks() - oldest_event_ticks_);
+		event_age_ms_ += (age - event_age_ms_) * 0.1f;
+		oldest_event_ticks_ = 0;
+	}
+
+	InputFrame frame;
+	// Sampled when replaying too, so nothing piles up until it ends. A
+	// hidden mouse belongs to the program whatever ImGui thinks.
+	SampleDevices(
+		frame,
+		!keyboard_captured,
+		!mouse_captured || relative_mouse_);
+	frame.delta_time = delta_time;
+	if (replaying_)
+	{
+		frame = recorded_[replay_index_++];
+		replaying_ = replay_index_ < recorded_.size();
+	}
+	else if (recording_)
+	{
+		recorded_.push_back(frame);
+	}
+	previous_ = current_;
+	current_ = frame;
+	return current_.delta_time;
+}
+
+void Input::EndFrame()
+{
+	if (wait_for_gpu_) glFinish();
+	if (sample_time_ < 0) return;
+	for (auto& latency : queries_)
+	{
+		if (!latency.pending) continue;
+		GLint available = 0;
+		glGetQueryObjectiv(
+			latency.query.Get(),
+			GL_QUERY_RESULT_AVAILABLE,
+			&available);
+		if (!available) continue;
+		GLuint64 done = 0;
+		glGetQueryObjectui64v(latency.query.Get(), GL_QUERY_RESULT, &done);
+		const float ms =
+			static_cast<float>(static_cast<GLint64>(done) - latency.sample_time) /
+			1e6f;
+		latency_ms_ = latency_ms_ <= 0.0f ? ms : latency_ms_ + (ms - latency_ms_) * 0.1f;
+		latency.pending = false;
+	}
+	auto& latency = queries_[query_index_];
+	if (latency.pending) return;
+	if (!latency.query) latency.query.Create("Input latency");
+	glQueryCounter(latency.query.Get(), GL_TIMESTAMP);
+	latency.sample_time = sample_time_;
+	latency.pending = true;
+	query_index_ = (query_index_ + 1) % LATENCY_QUERIES;
+	IsError(__FILE__, __LINE__);
+}
+
+void Input::Destroy()
+{
+	for (auto& latency : queries_)
+	{
+		latency.query.Reset();
+		latency.pending = false;
+	}
+	if (gamepad_)
+	{
+		SDL_GameControllerClose(gamepad_);
+		gamepad_ = nullptr;
+	}
+	SetRelativeMouseMode(false);
+}
+
+void Input::SetRelativeMouseMode(bool relative)
+{
+	if (relative == relative_mouse_) return;
+	SDL_SetRelativeMouseMode(relative ? SDL_TRUE : SDL_FALSE);
+	relative_mouse_ = relative;
+	// Drop the jump from wherever the cursor was.
+	SDL_GetRelativeMouseState(nullptr, nullptr);
+}
+
+bool Input::IsKeyDown(const InputFrame& frame, SDL_Scancode key)
+{
+	const int index = static_cast<int>(key);
+	if (index < 0 || index >= SDL_NUM_SCANCODES) return false;
+	return (frame.keys[index / 64] >> (index % 64)) & 1;
+}
+
+void Input::BindAction(const std::string& action, const InputBinding& binding)
+{
+	actions_[action].push_back(binding);
+}
+
+float Input::GetValue(const InputFrame& frame, const InputBinding& binding) const
+{
+	switch (binding.source)
+	{
+	case InputSourceEnum::KEY:
+		return IsKeyDown(frame, static_cast<SDL_Scancode>(binding.code)) ?
+			1.0f : 0.0f;
+	case InputSourceEnum::MOUSE_BUTTON:
+		if (binding.code < 1 || binding.code > 32) return 0.0f;
+		return (frame.mouse_buttons & SDL_BUTTON(binding.code)) ? 1.0f : 0.0f;
+	case InputSourceEnum::GAMEPAD_BUTTON:
+		if (binding.code < 0 || binding.code >= 32) return 0.0f;
+		return (frame.gamepad_buttons >> binding.code) & 1 ? 1.0f : 0.0f;
+	case InputSourceEnum::GAMEPAD_AXIS:
+		if (binding.code < 0 || binding.code >= SDL_CONTROLLER_AXIS_MAX)
+		{
+			return 0.0f;
+		}
+		return frame.gamepad_axes[binding.code];
+	default:
+		return 0.0f;
+	}
+}
+
+float Input::GetAction(const InputFrame& frame, const std::string& action) const
+{
+	auto it = actions_.find(action);
+	if (it == actions_.end()) return 0.0f;
+	float value = 0.0f;
+	for (const auto& binding : it->second)
+	{
+		value += GetValue(frame, binding) * binding.scale;
+	}
+	return std::clamp(value, -1.0f, 1.0f);
+}
+
+void Input::StartRecording()
+{
+	replaying_ = false;
+	recorded_.clear();
+	recording_ = true;
+}
+
+void Input::StartReplay()
+{
+	recording_ = false;
+	replay_index_ = 0;
+	replaying_ = !recorded_.empty();
+}
+
+void Input::SaveRecording(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Could not open " + path + " for writing");
+	}
+	RecordingHeader header = {};
+	std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+	header.version = RECORDING_VERSION;
+	header.frame_size = sizeof(InputFrame);
+	header.frame_count = static_cast<std::uint32_t>(recorded_.size());
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(
+		reinterpret_cast<const char*>(recorded_.data()),
+		recorded_.size() * sizeof(InputFrame));
+	if (!file)
+	{
+		throw std::runtime_error("Could not write " + path);
+	}
+}
+
+void Input::LoadRecording(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Could not open " + path);
+	}
+	RecordingHeader header = {};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file ||
+		std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != RECORDING_VERSION ||
+		header.frame_size != sizeof(InputFrame))
+	{
+		throw std::runtime_error(path + " is not an input recording of this build");
+	}
+	std::vector<InputFrame> frames(header.frame_count);
+	file.read(
+		reinterpret_cast<char*>(frames.data()),
+		frames.size() * sizeof(InputFrame));
+	if (!file)
+	{
+		throw std::runtime_error("Truncated input recording " + path);
+	}
+	recording_ = false;
+	replaying_ = false;
+	replay_index_ = 0;
+	recorded_ = std::move(frames);
+}
+
+void Input::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Input")) return;
+	ImGui::Text("Gamepad: %s", gamepad_ ? "connected" : "none");
+	ImGui::Checkbox("Wait for the GPU after swap", &wait_for_gpu_);
+	if (sample_time_ >= 0)
+	{
+		ImGui::Text("Sample to GPU done: %.2f ms", latency_ms_);
+	}
+	ImGui::Text("Event to sample: %.2f ms", event_age_ms_);
+	if (recording_)
+	{
+		ImGui::Text("Recording, %zu frames", recorded_.size());
+	}
+	else if (replaying_)
+	{
+		ImGui::Text("Replaying, frame %zu / %zu", replay_index_, recorded_.size());
+	}
+	else
+	{
+		ImGui::Text("%zu frames recorded", recorded_.size());
+	}
+}
+
+} // End namespace gl.
@@ -0,0 +1,162 @@
+#include <job_system.h>
+
+#include <algorithm>
+
+namespace gl {
+
+JobSystem::JobSystem(unsigned int worker_count)
+{
+	if (worker_count == 0)
+	{
+		const unsigned int hardware = std::thread::hardware_concurrency();
+		worker_count = hardware > 1 ? hardware - 1 : 1;
+	}
+	workers_.reserve(worker_count);
+	for (unsigned int i = 0; i < worker_count; ++i)
+	{
+		workers_.emplace_back([this] { WorkerLoop(); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	job_available_.notify_all();
+	for (auto& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Schedule(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(job));
+		++pending_;
+	}
+	job_available_.notify_one();
+}
+
+bool JobSystem::RunPendingJob()
+{
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (jobs_.empty()) return false;
+		job = std::move(jobs_.front());
+		jobs_.pop_front();
+	}
+	job();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		--pending_;
+	}
+	job_done_.notify_all();
+	return true;
+}
+
+void JobSystem::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			job_available_.wait(lock, [this] {
+				return stop_ || !jobs_.empty();
+			});
+			if (stop_ && jobs_.empty()) return;
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			--pending_;
+		}
+		job_done_.notify_all();
+	}
+}
+
+void JobSystem::Wait()
+{
+	while (RunPendingJob()) {}
+	std::unique_lock<std::mutex> lock(mutex_);
+	job_done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void JobSystem::ParallelFor(
+	std::size_t count,
+	std::size_t batch_size,
+	const std::function<void(std::size_t, std::size_t)>& func)
+{
+	if (count == 0) return;
+	batch_size = std::max<std::size_t>(batch_size, 1);
+	const std::size_t batch_count = (count + batch_size - 1) / batch_size;
+	if (batch_count == 1 || workers_.empty())
+	{
+		func(0, count);
+		return;
+	}
+
+	// Batches are claimed through a shared counter so fast threads take
+	// more of them; the caller takes part as well.
+	std::atomic<std::size_t> next_batch{ 0 };
+	std::atomic<std::size_t> done_batches{ 0 };
+	std::mutex done_mutex;
+	std::condition_variable all_done;
+	auto run_batches = [&] {
+		std::size_t batch;
+		while ((batch = next_batch.fetch_add(1)) < batch_count)
+		{
+			const std::size_t begin = batch * batch_size;
+			func(begin, std::min(begin + batch_size, count));
+			if (done_batches.fetch_add(1) + 1 == batch_count)
+			{
+				std::lock_guard<std::mutex> lock(done_mutex);
+				all_done.notify_all();
+			}
+		}
+	};
+
+	const std::size_t helpers = std::min<std::size_t>(
+		workers_.size(),
+		batch_count - 1);
+	std::atomic<std::size_t> helpers_running{ helpers };
+	for (std::size_t i = 0; i < helpers; ++i)
+	{
+		Schedule([&] {
+			run_batches();
+			// Decrement under the lock so the caller cannot return while
+			// this helper still touches the mutex.
+			std::lock_guard<std::mutex> lock(done_mutex);
+			if (helpers_running.fetch_sub(1) == 1)
+			{
+				all_done.notify_all();
+			}
+		});
+	}
+	run_batches();
+
+	// Wait for the batches and for the helpers to stop touching our stack.
+	// Called from a job, the helpers may be queued behind jobs no worker is
+	// free to take, so queued jobs run here until the queue is empty: from
+	// then on every helper has been taken by a running thread.
+	const auto finished = [&] {
+		return done_batches.load() == batch_count &&
+			helpers_running.load() == 0;
+	};
+	while (RunPendingJob())
+	{
+		std::lock_guard<std::mutex> lock(done_mutex);
+		if (finished()) return;
+	}
+	std::unique_lock<std::mutex> lock(done_mutex);
+	all_done.wait(lock, finished);
+}
+
+} // End namespace gl.
@@ -0,0 +1,281 @@
+#include <light.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// std430 layout of a cluster bounding box in view space.
+	struct ClusterAabb
+	{
+		glm::vec4 min_point;
+		glm::vec4 max_point;
+	};
+
+	constexpr unsigned int CLUSTER_LOCAL_SIZE = 128;
+
+	BufferHandle CreateStorageBuffer(
+		const std::string& label,
+		GLsizeiptr size,
+		GLenum usage)
+	{
+		BufferHandle ssbo(label);
+		ssbo.SetBytes(size);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo.Get());
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, usage);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return ssbo;
+	}
+
+} // End anonymous namespace.
+
+ClusteredLighting::ClusteredLighting(
+	glm::ivec3 grid,
+	unsigned int max_lights,
+	unsigned int max_lights_per_cluster) :
+	grid_(grid),
+	cluster_count_(grid.x * grid.y * grid.z),
+	max_lights_(max_lights),
+	max_lights_per_cluster_(max_lights_per_cluster)
+{
+}
+
+void ClusteredLighting::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void ClusteredLighting::Init(const std::string& path)
+{
+	cluster_aabb_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/clustered/cluster_aabb.comp");
+	cluster_cull_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/clustered/cluster_cull.comp");
+
+	light_ssbo_ = CreateStorageBuffer(
+		"Lights",
+		max_lights_ * sizeof(PointLight),
+		GL_DYNAMIC_DRAW);
+	IsError(__FILE__, __LINE__);
+	cluster_aabb_ssbo_ = CreateStorageBuffer(
+		"Cluster AABBs",
+		cluster_count_ * sizeof(ClusterAabb),
+		GL_STATIC_COPY);
+	IsError(__FILE__, __LINE__);
+	light_grid_ssbo_ = CreateStorageBuffer(
+		"Light grid",
+		cluster_count_ * sizeof(glm::uvec2),
+		GL_DYNAMIC_COPY);
+	IsError(__FILE__, __LINE__);
+	light_index_ssbo_ = CreateStorageBuffer(
+		"Light indices",
+		cluster_count_ * max_lights_per_cluster_ * sizeof(GLuint),
+		GL_DYNAMIC_COPY);
+	IsError(__FILE__, __LINE__);
+	index_counter_ssbo_ = CreateStorageBuffer(
+		"Light index counter",
+		sizeof(GLuint),
+		GL_DYNAMIC_COPY);
+	IsError(__FILE__, __LINE__);
+}
+
+void ClusteredLighting::Destroy()
+{
+	light_ssbo_.Reset();
+	cluster_aabb_ssbo_.Reset();
+	light_grid_ssbo_.Reset();
+	light_index_ssbo_.Reset();
+	index_counter_ssbo_.Reset();
+	cluster_aabb_shader_.reset();
+	cluster_cull_shader_.reset();
+}
+
+void ClusteredLighting::SetLights(const std::vector<PointLight>& lights)
+{
+	if (lights.size() > max_lights_)
+	{
+		throw std::runtime_error(
+			"Too many lights: " + std::to_string(lights.size()) +
+			" (max " + std::to_string(max_lights_) + ")");
+	}
+	light_count_ = static_cast<unsigned int>(lights.size());
+	if (lights.empty()) return;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+	glBufferSubData(
+		GL_SHADER_STORAGE_BUFFER,
+		0,
+		lights.size() * sizeof(PointLight),
+		lights.data());
+	IsError(__FILE__, __LINE__);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+void ClusteredLighting::BuildClusterAabbs(const glm::mat4& projection)
+{
+	cluster_aabb_shader_->Use();
+	cluster_aabb_shader_->SetMat4(
+		"inverse_projection",
+		glm::inverse(projection));
+	cluster_aabb_shader_->SetIVec3("cluster_grid", grid_);
+	cluster_aabb_shader_->SetVec2("screen_size", screen_size_);
+	cluster_aabb_shader_->SetVec2("tile_size", tile_size_);
+	cluster_aabb_shader_->SetFloat("z_near", z_near_);
+	cluster_aabb_shader_->SetFloat("z_far", z_far_);
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::CLUSTER_AABBS),
+		cluster_aabb_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+	glDispatchCompute(
+		(cluster_count_ + CLUSTER_LOCAL_SIZE - 1) / CLUSTER_LOCAL_SIZE,
+		1,
+		1);
+	IsError(__FILE__, __LINE__);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	IsError(__FILE__, __LINE__);
+}
+
+void ClusteredLighting::Update(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec2 screen_size,
+	float z_near,
+	float z_far)
+{
+	if (projection != cached_projection_ || screen_size != screen_size_)
+	{
+		cached_projection_ = projection;
+		screen_size_ = screen_size;
+		z_near_ = z_near;
+		z_far_ = z_far;
+		tile_size_ = glm::vec2(
+			std::ceil(screen_size.x / grid_.x),
+			std::ceil(screen_size.y / grid_.y));
+		BuildClusterAabbs(projection);
+	}
+
+	// Reset the global light index counter.
+	const GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, index_counter_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+	IsError(__FILE__, __LINE__);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+
+	cluster_cull_shader_->Use();
+	cluster_cull_shader_->SetMat4("view", view);
+	cluster_cull_shader_->SetInt("light_count", light_count_);
+	cluster_cull_shader_->SetInt("cluster_count", cluster_count_);
+	cluster_cull_shader_->SetInt(
+		"max_lights_per_cluster",
+		max_lights_per_cluster_);
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHTS),
+		light_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::CLUSTER_AABBS),
+		cluster_aabb_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHT_GRID),
+		light_grid_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHT_INDICES),
+		light_index_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::INDEX_COUNTER),
+		index_counter_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+	glDispatchCompute(
+		(cluster_count_ + CLUSTER_LOCAL_SIZE - 1) / CLUSTER_LOCAL_SIZE,
+		1,
+		1);
+	IsError(__FILE__, __LINE__);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	IsError(__FILE__, __LINE__);
+
+	if (read_back_stats_)
+	{
+		// This stalls the pipeline, only meant for inspection.
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, index_counter_ssbo_.Get());
+		const void* ptr = glMapBufferRange(
+			GL_SHADER_STORAGE_BUFFER,
+			0,
+			sizeof(GLuint),
+			GL_MAP_READ_BIT);
+		if (ptr)
+		{
+			last_index_count_ = *static_cast<const GLuint*>(ptr);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		IsError(__FILE__, __LINE__);
+	}
+}
+
+void ClusteredLighting::Bind(const Shader& shader) const
+{
+	// Exponential depth slicing: slice = log(z) * scale + bias.
+	const float log_ratio = std::log(z_far_ / z_near_);
+	shader.SetIVec3("cluster_grid", grid_);
+	shader.SetVec2("cluster_tile_size", tile_size_);
+	shader.SetFloat("cluster_slice_scale", grid_.z / log_ratio);
+	shader.SetFloat(
+		"cluster_slice_bias",
+		-grid_.z * std::log(z_near_) / log_ratio);
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHTS),
+		light_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHT_GRID),
+		light_grid_ssbo_.Get());
+	glBindBufferBase(
+		GL_SHADER_STORAGE_BUFFER,
+		static_cast<GLuint>(LightBindingEnum::LIGHT_INDICES),
+		light_index_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+}
+
+void ClusteredLighting::DrawImGui()
+{
+	ImGui::Text(
+		"Clusters: %d x %d x %d (%u)",
+		grid_.x,
+		grid_.y,
+		grid_.z,
+		cluster_count_);
+	ImGui::Text("Lights: %u / %u", light_count_, max_lights_);
+	ImGui::Checkbox("Read back cluster stats (stalls)", &read_back_stats_);
+	if (read_back_stats_)
+	{
+		ImGui::Text("Light indices written: %u", last_index_count_);
+		ImGui::Text(
+			"Average lights per cluster: %.2f",
+			static_cast<float>(last_index_count_) / cluster_count_);
+	}
+}
+
+} // End namespace gl.
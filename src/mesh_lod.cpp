@@ -0,0 +1,825 @@
+#include <mesh_lod.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "file_system.h"
+
+namespace gl {
+
+namespace {
+
+	// Symmetric 4x4 matrix of the sum of squared distances to a set of
+	// planes, divided by weight to get an average squared distance.
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+
+		Quadric& operator+=(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02;
+			a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+			return *this;
+		}
+	};
+
+	Quadric MakePlaneQuadric(const glm::vec3& n, const glm::vec3& p, double w)
+	{
+		const double a = n.x, b = n.y, c = n.z;
+		const double d = -(a * p.x + b * p.y + c * p.z);
+		Quadric q;
+		q.a00 = w * a * a; q.a01 = w * a * b; q.a02 = w * a * c;
+		q.a11 = w * b * b; q.a12 = w * b * c; q.a22 = w * c * c;
+		q.b0 = w * a * d; q.b1 = w * b * d; q.b2 = w * c * d;
+		q.c = w * d * d;
+		q.weight = w;
+		return q;
+	}
+
+	// Mean squared distance from p to the planes of q.
+	double EvaluateQuadric(const Quadric& q, const glm::vec3& p)
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double r =
+			q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+			2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+			2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) +
+			q.c;
+		return q.weight > 0.0 ? std::max(r, 0.0) / q.weight : 0.0;
+	}
+
+	enum class VertexKindEnum : std::uint8_t {
+		MANIFOLD,
+		BORDER,
+		SEAM,
+		LOCKED
+	};
+
+	// Edge in position space as seen from one triangle.
+	struct EdgeRef
+	{
+		std::uint32_t p0, p1;
+		std::uint32_t v0, v1;
+	};
+
+	struct Edge
+	{
+		std::uint32_t p0, p1;
+		std::uint32_t triangle_count;
+		bool seam;
+	};
+
+	struct Collapse
+	{
+		std::uint32_t from, to;
+		double cost;
+	};
+
+	// Borders are weighted up so silhouettes are the last thing to go.
+	constexpr double BORDER_WEIGHT = 10.0;
+
+	float AttributeDistance(const Vertex& a, const Vertex& b)
+	{
+		const glm::vec3 dn = a.normal - b.normal;
+		const glm::vec2 dt = a.tex - b.tex;
+		return glm::dot(dn, dn) + glm::dot(dt, dt);
+	}
+
+	class Simplifier
+	{
+	public:
+		explicit Simplifier(const MeshData& mesh) : mesh_(mesh)
+		{
+			WeldPositions();
+			indices_ = mesh.indices;
+			BuildEdges();
+			BuildQuadrics();
+		}
+
+		MeshData Run(
+			std::size_t target_index_count,
+			float max_error,
+			float* result_error)
+		{
+			const double max_cost =
+				static_cast<double>(max_error) * static_cast<double>(max_error);
+			double reached = 0.0;
+			while (indices_.size() > target_index_count)
+			{
+				const std::size_t collapsed = CollapsePass(
+					target_index_count,
+					max_cost,
+					reached);
+				if (collapsed == 0) break;
+				ApplyRemap();
+				BuildEdges();
+			}
+			if (result_error)
+			{
+				*result_error = static_cast<float>(std::sqrt(reached));
+			}
+			return Compact();
+		}
+
+	protected:
+		void WeldPositions()
+		{
+			const std::size_t count = mesh_.vertices.size();
+			std::vector<std::uint32_t> order(count);
+			std::iota(order.begin(), order.end(), 0u);
+			auto less = [this](std::uint32_t a, std::uint32_t b) {
+				const glm::vec3& pa = mesh_.vertices[a].position;
+				const glm::vec3& pb = mesh_.vertices[b].position;
+				if (pa.x != pb.x) return pa.x < pb.x;
+				if (pa.y != pb.y) return pa.y < pb.y;
+				return pa.z < pb.z;
+			};
+			std::sort(order.begin(), order.end(), less);
+			position_of_.resize(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (i == 0 || less(order[i - 1], order[i]))
+				{
+					positions_.push_back(mesh_.vertices[order[i]].position);
+					wedges_.emplace_back();
+				}
+				const auto p = static_cast<std::uint32_t>(positions_.size() - 1);
+				position_of_[order[i]] = p;
+				wedges_[p].push_back(order[i]);
+			}
+			vertex_remap_.resize(count);
+			std::iota(vertex_remap_.begin(), vertex_remap_.end(), 0u);
+		}
+
+		// Classify the edges and vertices of the current triangles.
+		void BuildEdges()
+		{
+			std::vector<EdgeRef> refs;
+			refs.reserve(indices_.size());
+			for (std::size_t t = 0; t < indices_.size(); t += 3)
+			{
+				for (int e = 0; e < 3; ++e)
+				{
+					std::uint32_t v0 = indices_[t + e];
+					std::uint32_t v1 = indices_[t + (e + 1) % 3];
+					std::uint32_t p0 = position_of_[v0];
+					std::uint32_t p1 = position_of_[v1];
+					if (p0 > p1)
+					{
+						std::swap(p0, p1);
+						std::swap(v0, v1);
+					}
+					refs.push_back({ p0, p1, v0, v1 });
+				}
+			}
+			std::sort(
+				refs.begin(),
+				refs.end(),
+				[](const EdgeRef& a, const EdgeRef& b) {
+					return a.p0 != b.p0 ? a.p0 < b.p0 : a.p1 < b.p1;
+				});
+
+			edges_.clear();
+			const std::size_t position_count = positions_.size();
+			std::vector<std::uint8_t> border_count(position_count, 0);
+			std::vector<std::uint8_t> seam_count(position_count, 0);
+			for (std::size_t i = 0; i < refs.size();)
+			{
+				std::size_t j = i + 1;
+				bool seam = false;
+				while (j < refs.size() &&
+					refs[j].p0 == refs[i].p0 &&
+					refs[j].p1 == refs[i].p1)
+				{
+					seam |= refs[j].v0 != refs[i].v0 || refs[j].v1 != refs[i].v1;
+					++j;
+				}
+				const auto triangle_count = static_cast<std::uint32_t>(j - i);
+				edges_.push_back({ refs[i].p0, refs[i].p1, triangle_count, seam });
+				auto bump = [](std::uint8_t& c) { c = std::min(c + 1, 255); };
+				// Non-manifold edges lock their vertices.
+				if (triangle_count > 2)
+				{
+					border_count[refs[i].p0] = 255;
+					border_count[refs[i].p1] = 255;
+				}
+				if (triangle_count == 1)
+				{
+					bump(border_count[refs[i].p0]);
+					bump(border_count[refs[i].p1]);
+				}
+				if (seam)
+				{
+					bump(seam_count[refs[i].p0]);
+					bump(seam_count[refs[i].p1]);
+				}
+				i = j;
+			}
+
+			// Live attribute variants per position.
+			std::vector<std::uint8_t> used(mesh_.vertices.size(), 0);
+			std::vector<std::uint8_t> wedge_count(position_count, 0);
+			for (const auto index : indices_)
+			{
+				if (!used[index])
+				{
+					used[index] = 1;
+					auto& c = wedge_count[position_of_[index]];
+					c = static_cast<std::uint8_t>(std::min(c + 1, 255));
+				}
+			}
+
+			kinds_.assign(position_count, VertexKindEnum::LOCKED);
+			for (std::size_t p = 0; p < position_count; ++p)
+			{
+				const int borders = border_count[p];
+				const int seams = seam_count[p];
+				const int wedges = wedge_count[p];
+				if (borders == 0 && seams == 0 && wedges == 1)
+					kinds_[p] = VertexKindEnum::MANIFOLD;
+				else if (borders == 2 && seams == 0 && wedges == 1)
+					kinds_[p] = VertexKindEnum::BORDER;
+				else if (borders == 0 && seams == 2 && wedges == 2)
+					kinds_[p] = VertexKindEnum::SEAM;
+			}
+
+			// Triangles around each position.
+			adjacency_offsets_.assign(position_count + 1, 0);
+			for (const auto index : indices_)
+				++adjacency_offsets_[position_of_[index] + 1];
+			for (std::size_t p = 0; p < position_count; ++p)
+				adjacency_offsets_[p + 1] += adjacency_offsets_[p];
+			adjacency_.resize(indices_.size());
+			std::vector<std::uint32_t> fill(
+				adjacency_offsets_.begin(),
+				adjacency_offsets_.end() - 1);
+			for (std::size_t i = 0; i < indices_.size(); ++i)
+			{
+				const std::uint32_t p = position_of_[indices_[i]];
+				adjacency_[fill[p]++] = static_cast<std::uint32_t>(i / 3);
+			}
+		}
+
+		void BuildQuadrics()
+		{
+			quadrics_.assign(positions_.size(), Quadric{});
+			for (std::size_t t = 0; t < indices_.size(); t += 3)
+			{
+				const std::uint32_t p0 = position_of_[indices_[t]];
+				const std::uint32_t p1 = position_of_[indices_[t + 1]];
+				const std::uint32_t p2 = position_of_[indices_[t + 2]];
+				const glm::vec3 n = glm::cross(
+					positions_[p1] - positions_[p0],
+					positions_[p2] - positions_[p0]);
+				const float length = glm::length(n);
+				if (length <= 0.0f) continue;
+				const Quadric q = MakePlaneQuadric(
+					n / length,
+					positions_[p0],
+					length * 0.5);
+				quadrics_[p0] += q;
+				quadrics_[p1] += q;
+				quadrics_[p2] += q;
+
+				// Planes through open and seam edges, perpendicular to the
+				// triangle, keep them from sliding.
+				const std::uint32_t corners[3] = { p0, p1, p2 };
+				for (int e = 0; e < 3; ++e)
+				{
+					const std::uint32_t a = corners[e];
+					const std::uint32_t b = corners[(e + 1) % 3];
+					const Edge* edge = FindEdge(a, b);
+					if (!edge || (edge->triangle_count != 1 && !edge->seam))
+						continue;
+					const glm::vec3 direction = positions_[b] - positions_[a];
+					const glm::vec3 side = glm::cross(direction, n / length);
+					const float side_length = glm::length(side);
+					if (side_length <= 0.0f) continue;
+					const Quadric border = MakePlaneQuadric(
+						side / side_length,
+						positions_[a],
+						glm::dot(direction, direction) * BORDER_WEIGHT);
+					quadrics_[a] += border;
+					quadrics_[b] += border;
+				}
+			}
+		}
+
+		const Edge* FindEdge(std::uint32_t a, std::uint32_t b) const
+		{
+			if (a > b) std::swap(a, b);
+			auto it = std::lower_bound(
+				edges_.begin(),
+				edges_.end(),
+				std::make_pair(a, b),
+				[](const Edge& e, const std::pair<std::uint32_t, std::uint32_t>& k) {
+					return e.p0 != k.first ? e.p0 < k.first : e.p1 < k.second;
+				});
+			if (it == edges_.end() || it->p0 != a || it->p1 != b) return nullptr;
+			return &*it;
+		}
+
+		bool CanCollapse(std::uint32_t from, std::uint32_t to, const Edge& edge) const
+		{
+			switch (kinds_[from])
+			{
+			case VertexKindEnum::MANIFOLD:
+				return true;
+			case VertexKindEnum::BORDER:
+				return edge.triangle_count == 1 &&
+					kinds_[to] != VertexKindEnum::MANIFOLD;
+			case VertexKindEnum::SEAM:
+				return edge.seam &&
+					edge.triangle_count == 2 &&
+					kinds_[to] != VertexKindEnum::MANIFOLD;
+			default:
+				return false;
+			}
+		}
+
+		std::uint32_t Resolve(std::uint32_t position) const
+		{
+			while (position_remap_[position] != position)
+				position = position_remap_[position];
+			return position;
+		}
+
+		// Rejects collapses that would turn a surviving triangle over.
+		bool FlipsTriangles(std::uint32_t from, std::uint32_t to) const
+		{
+			for (std::uint32_t i = adjacency_offsets_[from];
+				i < adjacency_offsets_[from + 1];
+				++i)
+			{
+				const std::uint32_t t = adjacency_[i] * 3;
+				std::uint32_t p[3];
+				bool has_to = false;
+				for (int k = 0; k < 3; ++k)
+				{
+					p[k] = Resolve(position_of_[indices_[t + k]]);
+					has_to |= p[k] == to;
+				}
+				// Triangles on the edge disappear.
+				if (has_to) continue;
+				const glm::vec3 before = glm::cross(
+					positions_[p[1]] - positions_[p[0]],
+					positions_[p[2]] - positions_[p[0]]);
+				for (auto& c : p)
+				{
+					if (c == from) c = to;
+				}
+				const glm::vec3 after = glm::cross(
+					positions_[p[1]] - positions_[p[0]],
+					positions_[p[2]] - positions_[p[0]]);
+				const float before_length = glm::length(before);
+				const float after_length = glm::length(after);
+				if (before_length <= 0.0f) continue;
+				if (after_length <= 0.0f) return true;
+				if (glm::dot(before, after) < 0.25f * before_length * after_length)
+					return true;
+			}
+			return false;
+		}
+
+		std::size_t CollapsePass(
+			std::size_t target_index_count,
+			double max_cost,
+			double& reached)
+		{
+			std::vector<Collapse> collapses;
+			collapses.reserve(edges_.size());
+			for (const auto& edge : edges_)
+			{
+				Quadric q = quadrics_[edge.p0];
+				q += quadrics_[edge.p1];
+				Collapse best{ 0, 0, std::numeric_limits<double>::max() };
+				if (CanCollapse(edge.p0, edge.p1, edge))
+				{
+					best = { edge.p0, edge.p1, EvaluateQuadric(q, positions_[edge.p1]) };
+				}
+				if (CanCollapse(edge.p1, edge.p0, edge))
+				{
+					const double cost = EvaluateQuadric(q, positions_[edge.p0]);
+					if (cost < best.cost) best = { edge.p1, edge.p0, cost };
+				}
+				if (best.cost <= max_cost) collapses.push_back(best);
+			}
+			std::sort(
+				collapses.begin(),
+				collapses.end(),
+				[](const Collapse& a, const Collapse& b) {
+					return a.cost < b.cost;
+				});
+
+			position_remap_.resize(positions_.size());
+			std::iota(position_remap_.begin(), position_remap_.end(), 0u);
+			std::vector<std::uint8_t> touched(positions_.size(), 0);
+			std::size_t index_count = indices_.size();
+			std::size_t collapsed = 0;
+			// Only collapse the cheapest part of the list per pass so that
+			// costs don't go too stale before they are recomputed.
+			const std::size_t budget = std::max<std::size_t>(
+				collapses.size() / 3,
+				1);
+			for (const auto& collapse : collapses)
+			{
+				if (index_count <= target_index_count || collapsed >= budget)
+					break;
+				if (touched[collapse.from] || touched[collapse.to]) continue;
+				if (FlipsTriangles(collapse.from, collapse.to)) continue;
+
+				const Edge* edge = FindEdge(collapse.from, collapse.to);
+				CollapseEdge(collapse.from, collapse.to);
+				touched[collapse.from] = 1;
+				touched[collapse.to] = 1;
+				index_count -= edge->triangle_count * 3;
+				reached = std::max(reached, collapse.cost);
+				++collapsed;
+			}
+			return collapsed;
+		}
+
+		void CollapseEdge(std::uint32_t from, std::uint32_t to)
+		{
+			position_remap_[from] = to;
+			quadrics_[to] += quadrics_[from];
+			// Each attribute variant of from goes to the closest variant
+			// of to, which on a seam is the one on the same side.
+			for (const auto wedge : wedges_[from])
+			{
+				std::uint32_t best = wedges_[to].front();
+				float best_distance = std::numeric_limits<float>::max();
+				for (const auto candidate : wedges_[to])
+				{
+					const float distance = AttributeDistance(
+						mesh_.vertices[wedge],
+						mesh_.vertices[candidate]);
+					if (distance < best_distance)
+					{
+						best_distance = distance;
+						best = candidate;
+					}
+				}
+				vertex_remap_[wedge] = best;
+			}
+			wedges_[from].clear();
+		}
+
+		std::uint32_t ResolveVertex(std::uint32_t vertex) const
+		{
+			while (vertex_remap_[vertex] != vertex)
+				vertex = vertex_remap_[vertex];
+			return vertex;
+		}
+
+		void ApplyRemap()
+		{
+			std::size_t write = 0;
+			for (std::size_t t = 0; t < indices_.size(); t += 3)
+			{
+				const std::uint32_t a = ResolveVertex(indices_[t]);
+				const std::uint32_t b = ResolveVertex(indices_[t + 1]);
+				const std::uint32_t c = ResolveVertex(indices_[t + 2]);
+				const std::uint32_t pa = position_of_[a];
+				const std::uint32_t pb = position_of_[b];
+				const std::uint32_t pc = position_of_[c];
+				if (pa == pb || pb == pc || pa == pc) continue;
+				indices_[write++] = a;
+				indices_[write++] = b;
+				indices_[write++] = c;
+			}
+			indices_.resize(write);
+		}
+
+		MeshData Compact() const
+		{
+			MeshData result;
+			std::vector<std::uint32_t> remap(
+				mesh_.vertices.size(),
+				std::numeric_limits<std::uint32_t>::max());
+			result.indices.reserve(indices_.size());
+			for (const auto index : indices_)
+			{
+				if (remap[index] == std::numeric_limits<std::uint32_t>::max())
+				{
+					remap[index] = static_cast<std::uint32_t>(result.vertices.size());
+					result.vertices.push_back(mesh_.vertices[index]);
+				}
+				result.indices.push_back(remap[index]);
+			}
+			return result;
+		}
+
+	protected:
+		const MeshData& mesh_;
+		std::vector<std::uint32_t> indices_;
+		// Welded positions and the vertices sharing each of them.
+		std::vector<glm::vec3> positions_;
+		std::vector<std::uint32_t> position_of_;
+		std::vector<std::vector<std::uint32_t>> wedges_;
+		std::vector<Quadric> quadrics_;
+		std::vector<VertexKindEnum> kinds_;
+		std::vector<Edge> edges_;
+		std::vector<std::uint32_t> adjacency_offsets_;
+		std::vector<std::uint32_t> adjacency_;
+		std::vector<std::uint32_t> position_remap_;
+		std::vector<std::uint32_t> vertex_remap_;
+	};
+
+	constexpr char LOD_MAGIC[4] = { 'G', 'L', 'O', 'D' };
+	constexpr std::uint32_t LOD_VERSION = 1;
+
+	float MaxScale(const glm::mat4& model)
+	{
+		return std::sqrt(std::max({
+			glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+			glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+			glm::dot(glm::vec3(model[2]), glm::vec3(model[2])) }));
+	}
+
+} // End anonymous namespace.
+
+MeshData SimplifyMesh(
+	const MeshData& mesh,
+	std::size_t target_index_count,
+	float max_error,
+	float* result_error)
+{
+	Simplifier simplifier(mesh);
+	return simplifier.Run(target_index_count, max_error, result_error);
+}
+
+float ComputeBoundingRadius(const MeshData& mesh)
+{
+	float radius_squared = 0.0f;
+	for (const auto& vertex : mesh.vertices)
+	{
+		radius_squared = std::max(
+			radius_squared,
+			glm::dot(vertex.position, vertex.position));
+	}
+	return std::sqrt(radius_squared);
+}
+
+std::vector<MeshLod> GenerateLodChain(
+	const MeshData& mesh,
+	int max_levels,
+	float ratio,
+	float max_relative_error)
+{
+	const float max_error = ComputeBoundingRadius(mesh) * max_relative_error;
+	std::vector<MeshLod> chain;
+	chain.push_back({ mesh, 0.0f });
+	for (int level = 1; level < max_levels; ++level)
+	{
+		const std::size_t previous = chain.back().data.indices.size();
+		const auto target = static_cast<std::size_t>(previous * ratio) / 3 * 3;
+		// Always simplify from the original so errors don't accumulate.
+		float error = 0.0f;
+		MeshData data = SimplifyMesh(mesh, target, max_error, &error);
+		// Less than 10% fewer triangles is not worth a level.
+		if (data.indices.empty() || data.indices.size() * 10 > previous * 9)
+			break;
+		chain.push_back({ std::move(data), std::max(error, chain.back().error) });
+	}
+	return chain;
+}
+
+void SaveLodChain(const std::string& file_name, const std::vector<MeshLod>& chain)
+{
+	std::ofstream file(file_name, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Could not write LOD file: " + file_name);
+	}
+	auto write_u32 = [&file](std::uint32_t value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	};
+	file.write(LOD_MAGIC, sizeof(LOD_MAGIC));
+	write_u32(LOD_VERSION);
+	write_u32(static_cast<std::uint32_t>(chain.size()));
+	for (const auto& lod : chain)
+	{
+		file.write(reinterpret_cast<const char*>(&lod.error), sizeof(float));
+		write_u32(static_cast<std::uint32_t>(lod.data.vertices.size()));
+		write_u32(static_cast<std::uint32_t>(lod.data.indices.size()));
+		file.write(
+			reinterpret_cast<const char*>(lod.data.vertices.data()),
+			lod.data.vertices.size() * sizeof(Vertex));
+		file.write(
+			reinterpret_cast<const char*>(lod.data.indices.data()),
+			lod.data.indices.size() * sizeof(std::uint32_t));
+	}
+	if (!file)
+	{
+		throw std::runtime_error("Could not write LOD file: " + file_name);
+	}
+}
+
+std::vector<MeshLod> LoadLodChain(const std::string& file_name)
+{
+	const FileData file = FileSystem::GetInstance().Read(file_name);
+	std::size_t position = 0;
+	auto read = [&](void* destination, std::size_t size) {
+		if (size > file.GetSize() - position)
+		{
+			throw std::runtime_error("Truncated LOD file: " + file_name);
+		}
+		std::memcpy(destination, file.GetData() + position, size);
+		position += size;
+	};
+	auto read_u32 = [&read]() {
+		std::uint32_t value = 0;
+		read(&value, sizeof(value));
+		return value;
+	};
+	char magic[4] = {};
+	read(magic, sizeof(magic));
+	if (std::memcmp(magic, LOD_MAGIC, sizeof(magic)) != 0 ||
+		read_u32() != LOD_VERSION)
+	{
+		throw std::runtime_error("Not a LOD file: " + file_name);
+	}
+	std::vector<MeshLod> chain(read_u32());
+	for (auto& lod : chain)
+	{
+		read(&lod.error, sizeof(float));
+		const std::uint32_t vertex_count = read_u32();
+		const std::uint32_t index_count = read_u32();
+		if (vertex_count * sizeof(Vertex) + index_count * sizeof(std::uint32_t) >
+			file.GetSize() - position)
+		{
+			throw std::runtime_error("Truncated LOD file: " + file_name);
+		}
+		lod.data.vertices.resize(vertex_count);
+		lod.data.indices.resize(index_count);
+		read(lod.data.vertices.data(), vertex_count * sizeof(Vertex));
+		read(lod.data.indices.data(), index_count * sizeof(std::uint32_t));
+	}
+	return chain;
+}
+
+void LodSelector::SetLevels(const std::vector<float>& errors, float radius)
+{
+	errors_ = errors;
+	radius_ = radius;
+	current_.clear();
+}
+
+float LodSelector::ComputeScreenError(
+	float error,
+	float distance,
+	float fov_y,
+	float viewport_height) const
+{
+	// Pixels per world unit at distance 1.
+	const float projection_scale =
+		viewport_height / (2.0f * std::tan(fov_y * 0.5f));
+	return error * projection_scale / std::max(distance, 1e-3f);
+}
+
+void LodSelector::Select(
+	const Camera& camera,
+	float viewport_height,
+	const std::vector<glm::mat4>& models,
+	std::vector<std::vector<glm::mat4>>& per_level)
+{
+	const int level_count = GetLevelCount();
+	per_level.resize(level_count);
+	for (auto& list : per_level) list.clear();
+	if (level_count == 0) return;
+	current_.resize(models.size(), 0);
+
+	const float fov_y = glm::radians(camera.Zoom);
+	const float coarsen_threshold = threshold_pixels * (1.0f - hysteresis);
+	for (std::size_t i = 0; i < models.size(); ++i)
+	{
+		const glm::mat4& model = models[i];
+		const float scale = MaxScale(model);
+		const float distance = glm::length(
+			glm::vec3(model[3]) - camera.position) - radius_ * scale;
+		auto pixels = [&](int level) {
+			return ComputeScreenError(
+				errors_[level] * scale,
+				distance,
+				fov_y,
+				viewport_height);
+		};
+		int level = std::min(current_[i], level_count - 1);
+		// Refine as soon as the current level is too coarse...
+		while (level > 0 && pixels(level) > threshold_pixels) --level;
+		// ...but only coarsen once comfortably below the threshold.
+		while (level + 1 < level_count && pixels(level + 1) <= coarsen_threshold)
+			++level;
+		current_[i] = level;
+		per_level[level].push_back(model);
+	}
+}
+
+void LodMesh::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void LodMesh::Init(const std::vector<MeshLod>& chain)
+{
+	levels_.resize(chain.size());
+	for (std::size_t i = 0; i < chain.size(); ++i)
+	{
+		Level& level = levels_[i];
+		level.mesh.Init(chain[i].data);
+		glBindVertexArray(level.mesh.GetVao());
+		IsError(__FILE__, __LINE__);
+		// A mat4 takes 4 attribute slots, one column each. The pointers
+		// are set at draw time, the instances move in the stream buffer.
+		for (int column = 0; column < 4; ++column)
+		{
+			glEnableVertexAttribArray(3 + column);
+			IsError(__FILE__, __LINE__);
+			glVertexAttribDivisor(3 + column, 1);
+			IsError(__FILE__, __LINE__);
+		}
+		glBindVertexArray(0);
+		IsError(__FILE__, __LINE__);
+	}
+}
+
+void LodMesh::Destroy()
+{
+	for (auto& level : levels_)
+	{
+		level.mesh.Destroy();
+	}
+	IsError(__FILE__, __LINE__);
+	levels_.clear();
+}
+
+std::size_t LodMesh::Draw(
+	const std::vector<std::vector<glm::mat4>>& per_level,
+	StreamBuffer& stream)
+{
+	std::size_t triangles = 0;
+	const std::size_t count = std::min(per_level.size(), levels_.size());
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		triangles += DrawLevel(static_cast<int>(i), per_level[i], stream);
+	}
+	return triangles;
+}
+
+std::size_t LodMesh::DrawLevel(
+	int index,
+	const std::vector<glm::mat4>& models,
+	StreamBuffer& stream)
+{
+	if (models.empty()) return 0;
+	Level& level = levels_[index];
+	const StreamAllocation instances = stream.Push(
+		models.data(),
+		models.size(),
+		StreamUsageEnum::VERTEX);
+	stream.Flush();
+	glBindVertexArray(level.mesh.GetVao());
+	glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+	for (int column = 0; column < 4; ++column)
+	{
+		glVertexAttribPointer(
+			3 + column,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(glm::mat4),
+			(GLvoid*)(instances.offset + column * sizeof(glm::vec4)));
+	}
+	IsError(__FILE__, __LINE__);
+	glDrawElementsInstanced(
+		GL_TRIANGLES,
+		level.mesh.GetIndexCount(),
+		GL_UNSIGNED_INT,
+		0,
+		static_cast<GLsizei>(models.size()));
+	IsError(__FILE__, __LINE__);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return level.mesh.GetIndexCount() / 3 * models.size();
+}
+
+} // End namespace gl.
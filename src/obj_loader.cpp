@@ -0,0 +1,124 @@
+#include <obj_loader.h>
+
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "file_system.h"
+
+namespace gl {
+
+namespace {
+
+	// OBJ indices are 1 based, negative ones count from the end.
+	int ResolveIndex(int index, std::size_t count)
+	{
+		if (index > 0) return index - 1;
+		if (index < 0) return static_cast<int>(count) + index;
+		return -1;
+	}
+
+} // End anonymous namespace.
+
+MeshData LoadObj(const std::string& file_name)
+{
+	if (!FileSystem::GetInstance().Exists(file_name))
+	{
+		throw std::runtime_error("Could not open OBJ file: " + file_name);
+	}
+	std::istringstream file(FileSystem::GetInstance().ReadText(file_name));
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> tex_coords;
+	std::map<std::tuple<int, int, int>, std::uint32_t> vertex_map;
+	MeshData data;
+
+	std::string line;
+	std::vector<std::uint32_t> polygon;
+	while (std::getline(file, line))
+	{
+		std::istringstream iss(line);
+		std::string type;
+		iss >> type;
+		if (type == "v")
+		{
+			glm::vec3 p(0.0f);
+			iss >> p.x >> p.y >> p.z;
+			positions.push_back(p);
+		}
+		else if (type == "vn")
+		{
+			glm::vec3 n(0.0f);
+			iss >> n.x >> n.y >> n.z;
+			normals.push_back(n);
+		}
+		else if (type == "vt")
+		{
+			glm::vec2 t(0.0f);
+			iss >> t.x >> t.y;
+			tex_coords.push_back(t);
+		}
+		else if (type == "f")
+		{
+			polygon.clear();
+			std::string corner;
+			while (iss >> corner)
+			{
+				// v, v/vt, v//vn or v/vt/vn.
+				int v = 0, vt = 0, vn = 0;
+				const auto first = corner.find('/');
+				v = std::stoi(corner.substr(0, first));
+				if (first != std::string::npos)
+				{
+					const auto second = corner.find('/', first + 1);
+					const std::string t = corner.substr(
+						first + 1,
+						second == std::string::npos ?
+							std::string::npos : second - first - 1);
+					if (!t.empty()) vt = std::stoi(t);
+					if (second != std::string::npos)
+						vn = std::stoi(corner.substr(second + 1));
+				}
+				const auto key = std::make_tuple(
+					ResolveIndex(v, positions.size()),
+					ResolveIndex(vt, tex_coords.size()),
+					ResolveIndex(vn, normals.size()));
+				const int p = std::get<0>(key);
+				if (p < 0 || p >= static_cast<int>(positions.size()))
+				{
+					throw std::runtime_error(
+						"Invalid vertex index in OBJ file: " + file_name);
+				}
+				auto it = vertex_map.find(key);
+				if (it == vertex_map.end())
+				{
+					const int t = std::get<1>(key);
+					const int n = std::get<2>(key);
+					Vertex vertex;
+					vertex.position = positions[p];
+					vertex.tex = (t >= 0 && t < static_cast<int>(tex_coords.size())) ?
+						tex_coords[t] : glm::vec2(0.0f);
+					vertex.normal = (n >= 0 && n < static_cast<int>(normals.size())) ?
+						normals[n] : glm::vec3(0.0f);
+					const auto index =
+						static_cast<std::uint32_t>(data.vertices.size());
+					data.vertices.push_back(vertex);
+					it = vertex_map.emplace(key, index).first;
+				}
+				polygon.push_back(it->second);
+			}
+			for (std::size_t i = 2; i < polygon.size(); ++i)
+			{
+				data.indices.insert(
+					data.indices.end(),
+					{ polygon[0], polygon[i - 1], polygon[i] });
+			}
+		}
+	}
+	return data;
+}
+
+} // End namespace gl.
@@ -0,0 +1,452 @@
+#include <occlusion_culling.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define GL_OCCLUSION_SSE 1
+#endif
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// Anything closer to the eye than this is treated as crossing the near
+	// plane: occluders skip the triangle, boxes are reported visible.
+	constexpr float NEAR_W = 1e-4f;
+
+	using clock = std::chrono::high_resolution_clock;
+
+	float ElapsedMs(clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(
+			clock::now() - start).count();
+	}
+
+} // End anonymous namespace.
+
+OcclusionCuller::OcclusionCuller(JobSystem& jobs, int width, int height) :
+	jobs_(jobs),
+	width_((width + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE),
+	height_((height + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE)
+{
+	tiles_x_ = width_ / TILE_SIZE;
+	tiles_y_ = height_ / TILE_SIZE;
+	depth_.assign(static_cast<std::size_t>(width_) * height_, 1.0f);
+	tile_max_.assign(static_cast<std::size_t>(tiles_x_) * tiles_y_, 1.0f);
+}
+
+void OcclusionCuller::AddOccluder(const Occluder& occluder)
+{
+	occluders_.push_back(occluder);
+}
+
+void OcclusionCuller::RenderOccluders(const glm::mat4& view_projection)
+{
+	const auto start = clock::now();
+	view_projection_ = view_projection;
+
+	// Transform the occluder vertices in parallel.
+	clip_positions_.resize(occluders_.size());
+	jobs_.ParallelFor(
+		occluders_.size(),
+		4,
+		[this](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const Occluder& occluder = occluders_[i];
+				const glm::mat4 mvp = view_projection_ * occluder.model;
+				auto& clip = clip_positions_[i];
+				clip.resize(occluder.positions.size());
+				for (std::size_t v = 0; v < clip.size(); ++v)
+				{
+					clip[v] = mvp * glm::vec4(occluder.positions[v], 1.0f);
+				}
+			}
+		});
+
+	// Project to pixels, anything touching the near plane is skipped which
+	// only makes the buffer less occluding, never wrong.
+	triangles_.clear();
+	const glm::vec2 half_size(width_ * 0.5f, height_ * 0.5f);
+	for (std::size_t i = 0; i < occluders_.size(); ++i)
+	{
+		const auto& indices = occluders_[i].indices;
+		const auto& clip = clip_positions_[i];
+		for (std::size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			ScreenTriangle tri;
+			bool valid = true;
+			float min_y = static_cast<float>(height_);
+			float max_y = 0.0f;
+			for (int k = 0; k < 3; ++k)
+			{
+				const glm::vec4& c = clip[indices[t + k]];
+				if (c.w <= NEAR_W)
+				{
+					valid = false;
+					break;
+				}
+				const float inv_w = 1.0f / c.w;
+				tri.v[k].x = (c.x * inv_w + 1.0f) * half_size.x;
+				tri.v[k].y = (c.y * inv_w + 1.0f) * half_size.y;
+				tri.v[k].z = c.z * inv_w * 0.5f + 0.5f;
+				min_y = std::min(min_y, tri.v[k].y);
+				max_y = std::max(max_y, tri.v[k].y);
+			}
+			if (!valid) continue;
+			tri.min_y = std::max(static_cast<int>(std::floor(min_y)), 0);
+			tri.max_y = std::min(static_cast<int>(std::ceil(max_y)), height_);
+			if (tri.min_y >= tri.max_y) continue;
+			triangles_.push_back(tri);
+		}
+	}
+	triangle_count_ = triangles_.size();
+
+	// Each band is one row of tiles, bands never share pixels.
+	jobs_.ParallelFor(
+		tiles_y_,
+		1,
+		[this](std::size_t begin, std::size_t end) {
+			for (std::size_t band = begin; band < end; ++band)
+			{
+				RasterizeBand(static_cast<int>(band));
+				UpdateTileMax(static_cast<int>(band));
+			}
+		});
+	render_ms_ = ElapsedMs(start);
+}
+
+void OcclusionCuller::RasterizeBand(int band)
+{
+	const int row_begin = band * TILE_SIZE;
+	const int row_end = row_begin + TILE_SIZE;
+	std::fill(
+		depth_.begin() + static_cast<std::size_t>(row_begin) * width_,
+		depth_.begin() + static_cast<std::size_t>(row_end) * width_,
+		1.0f);
+	for (const auto& tri : triangles_)
+	{
+		if (tri.max_y <= row_begin || tri.min_y >= row_end) continue;
+		RasterizeTriangle(tri, row_begin, row_end);
+	}
+}
+
+void OcclusionCuller::RasterizeTriangle(
+	const ScreenTriangle& tri,
+	int row_begin,
+	int row_end)
+{
+	ScreenVertex v0 = tri.v[0];
+	ScreenVertex v1 = tri.v[1];
+	ScreenVertex v2 = tri.v[2];
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (std::abs(area) < 1e-6f) return;
+	// Occluders are two sided, just fix the winding.
+	if (area < 0.0f)
+	{
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	// Edge functions E(x, y) = a * x + b * y + c, positive inside, sampled
+	// at pixel centers. Pixels exactly on an edge belong to it only if it is
+	// a top-left edge, so triangles sharing an edge leave no cracks.
+	const std::array<const ScreenVertex*, 3> from = { &v1, &v2, &v0 };
+	const std::array<const ScreenVertex*, 3> to = { &v2, &v0, &v1 };
+	std::array<float, 3> ea;
+	std::array<float, 3> eb;
+	std::array<float, 3> ec;
+	std::array<bool, 3> top_left;
+	for (int e = 0; e < 3; ++e)
+	{
+		ea[e] = from[e]->y - to[e]->y;
+		eb[e] = to[e]->x - from[e]->x;
+		ec[e] = -(ea[e] * from[e]->x + eb[e] * from[e]->y);
+		top_left[e] = ea[e] > 0.0f || (ea[e] == 0.0f && eb[e] > 0.0f);
+	}
+
+	// Depth plane z(x, y) = za * x + zb * y + zc from the barycentrics
+	// (edge e is the weight of the vertex opposite to it). Biased to the
+	// farthest depth reached inside the pixel.
+	const float inv_area = 1.0f / area;
+	const float dz1 = v1.z - v0.z;
+	const float dz2 = v2.z - v0.z;
+	const float za = (ea[1] * dz1 + ea[2] * dz2) * inv_area;
+	const float zb = (eb[1] * dz1 + eb[2] * dz2) * inv_area;
+	const float zc = v0.z - za * v0.x - zb * v0.y +
+		0.5f * (std::abs(za) + std::abs(zb));
+
+	const float min_x = std::min({ v0.x, v1.x, v2.x });
+	const float max_x = std::max({ v0.x, v1.x, v2.x });
+	const int x_begin = std::max(static_cast<int>(std::floor(min_x)), 0) & ~3;
+	const int x_end = std::min(static_cast<int>(std::ceil(max_x)), width_);
+	const int y_begin = std::max(tri.min_y, row_begin);
+	const int y_end = std::min(tri.max_y, row_end);
+
+	for (int y = y_begin; y < y_end; ++y)
+	{
+		const float py = y + 0.5f;
+		float* row = &depth_[static_cast<std::size_t>(y) * width_];
+#if defined(GL_OCCLUSION_SSE)
+		const __m128 step = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 a0 = _mm_set1_ps(ea[0]);
+		const __m128 a1 = _mm_set1_ps(ea[1]);
+		const __m128 a2 = _mm_set1_ps(ea[2]);
+		const __m128 za4 = _mm_set1_ps(za);
+		const __m128 r0 = _mm_set1_ps(eb[0] * py + ec[0]);
+		const __m128 r1 = _mm_set1_ps(eb[1] * py + ec[1]);
+		const __m128 r2 = _mm_set1_ps(eb[2] * py + ec[2]);
+		const __m128 rz = _mm_set1_ps(zb * py + zc);
+		// All ones for top-left edges, where E == 0 counts as inside.
+		const __m128 tl0 = _mm_castsi128_ps(_mm_set1_epi32(top_left[0] ? -1 : 0));
+		const __m128 tl1 = _mm_castsi128_ps(_mm_set1_epi32(top_left[1] ? -1 : 0));
+		const __m128 tl2 = _mm_castsi128_ps(_mm_set1_epi32(top_left[2] ? -1 : 0));
+		auto edge_inside = [zero](__m128 edge, __m128 tl) {
+			return _mm_or_ps(
+				_mm_cmpgt_ps(edge, zero),
+				_mm_and_ps(_mm_cmpeq_ps(edge, zero), tl));
+		};
+		for (int x = x_begin; x < x_end; x += 4)
+		{
+			const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), step);
+			const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), r0);
+			const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), r1);
+			const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), r2);
+			const __m128 inside = _mm_and_ps(
+				edge_inside(e0, tl0),
+				_mm_and_ps(edge_inside(e1, tl1), edge_inside(e2, tl2)));
+			if (_mm_movemask_ps(inside) == 0) continue;
+			const __m128 z = _mm_add_ps(_mm_mul_ps(za4, px), rz);
+			const __m128 old = _mm_loadu_ps(row + x);
+			const __m128 nearest = _mm_min_ps(old, z);
+			_mm_storeu_ps(
+				row + x,
+				_mm_or_ps(
+					_mm_and_ps(inside, nearest),
+					_mm_andnot_ps(inside, old)));
+		}
+#else
+		for (int x = x_begin; x < x_end; ++x)
+		{
+			const float px = x + 0.5f;
+			bool inside = true;
+			for (int e = 0; e < 3; ++e)
+			{
+				const float edge = ea[e] * px + eb[e] * py + ec[e];
+				inside &= edge > 0.0f || (edge == 0.0f && top_left[e]);
+			}
+			if (!inside) continue;
+			row[x] = std::min(row[x], za * px + zb * py + zc);
+		}
+#endif
+	}
+}
+
+void OcclusionCuller::UpdateTileMax(int band)
+{
+	for (int tile_x = 0; tile_x < tiles_x_; ++tile_x)
+	{
+		float farthest = 0.0f;
+		for (int y = band * TILE_SIZE; y < (band + 1) * TILE_SIZE; ++y)
+		{
+			const float* row = &depth_[static_cast<std::size_t>(y) * width_];
+			for (int x = tile_x * TILE_SIZE; x < (tile_x + 1) * TILE_SIZE; ++x)
+			{
+				farthest = std::max(farthest, row[x]);
+			}
+		}
+		tile_max_[band * tiles_x_ + tile_x] = farthest;
+	}
+}
+
+bool OcclusionCuller::IsRectVisible(
+	int x0,
+	int y0,
+	int x1,
+	int y1,
+	float min_z) const
+{
+	// Coarse level first: a tile whose farthest depth is in front of the
+	// box hides its part of the box entirely.
+	for (int tile_y = y0 / TILE_SIZE; tile_y <= (y1 - 1) / TILE_SIZE; ++tile_y)
+	{
+		for (int tile_x = x0 / TILE_SIZE; tile_x <= (x1 - 1) / TILE_SIZE; ++tile_x)
+		{
+			if (min_z > tile_max_[tile_y * tiles_x_ + tile_x]) continue;
+			const int py0 = std::max(y0, tile_y * TILE_SIZE);
+			const int py1 = std::min(y1, (tile_y + 1) * TILE_SIZE);
+			const int px0 = std::max(x0, tile_x * TILE_SIZE);
+			const int px1 = std::min(x1, (tile_x + 1) * TILE_SIZE);
+			for (int y = py0; y < py1; ++y)
+			{
+				const float* row = &depth_[static_cast<std::size_t>(y) * width_];
+				int x = px0;
+#if defined(GL_OCCLUSION_SSE)
+				const __m128 box_z = _mm_set1_ps(min_z);
+				for (; x + 4 <= px1; x += 4)
+				{
+					if (_mm_movemask_ps(
+						_mm_cmple_ps(box_z, _mm_loadu_ps(row + x))))
+					{
+						return true;
+					}
+				}
+#endif
+				for (; x < px1; ++x)
+				{
+					if (min_z <= row[x]) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+BoxVisibilityEnum OcclusionCuller::ClassifyBox(const Aabb& box) const
+{
+	float min_x = static_cast<float>(width_);
+	float min_y = static_cast<float>(height_);
+	float max_x = 0.0f;
+	float max_y = 0.0f;
+	// Past the far plane when it stays above 1.
+	float min_z = std::numeric_limits<float>::max();
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const glm::vec4 world(
+			(corner & 1) ? box.max.x : box.min.x,
+			(corner & 2) ? box.max.y : box.min.y,
+			(corner & 4) ? box.max.z : box.min.z,
+			1.0f);
+		const glm::vec4 clip = view_projection_ * world;
+		if (clip.w <= NEAR_W) return BoxVisibilityEnum::VISIBLE;
+		const float inv_w = 1.0f / clip.w;
+		const float x = (clip.x * inv_w + 1.0f) * width_ * 0.5f;
+		const float y = (clip.y * inv_w + 1.0f) * height_ * 0.5f;
+		min_x = std::min(min_x, x);
+		max_x = std::max(max_x, x);
+		min_y = std::min(min_y, y);
+		max_y = std::max(max_y, y);
+		min_z = std::min(min_z, clip.z * inv_w * 0.5f + 0.5f);
+	}
+	const int x0 = std::max(static_cast<int>(std::floor(min_x)), 0);
+	const int y0 = std::max(static_cast<int>(std::floor(min_y)), 0);
+	const int x1 = std::min(static_cast<int>(std::ceil(max_x)), width_);
+	const int y1 = std::min(static_cast<int>(std::ceil(max_y)), height_);
+	if (x0 >= x1 || y0 >= y1 || min_z > 1.0f)
+	{
+		return BoxVisibilityEnum::OUTSIDE;
+	}
+	return IsRectVisible(x0, y0, x1, y1, std::max(min_z, 0.0f)) ?
+		BoxVisibilityEnum::VISIBLE :
+		BoxVisibilityEnum::OCCLUDED;
+}
+
+void OcclusionCuller::TestVisibility(
+	const std::vector<Aabb>& boxes,
+	std::vector<std::uint8_t>& visible)
+{
+	const auto start = clock::now();
+	visible.resize(boxes.size());
+	std::atomic<std::size_t> occluded{ 0 };
+	std::atomic<std::size_t> outside{ 0 };
+	jobs_.ParallelFor(
+		boxes.size(),
+		256,
+		[&](std::size_t begin, std::size_t end) {
+			std::size_t local_occluded = 0;
+			std::size_t local_outside = 0;
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const BoxVisibilityEnum visibility = ClassifyBox(boxes[i]);
+				visible[i] = visibility == BoxVisibilityEnum::VISIBLE ? 1 : 0;
+				local_occluded += visibility == BoxVisibilityEnum::OCCLUDED;
+				local_outside += visibility == BoxVisibilityEnum::OUTSIDE;
+			}
+			occluded += local_occluded;
+			outside += local_outside;
+		});
+	tested_count_ = boxes.size();
+	occluded_count_ = occluded.load();
+	outside_count_ = outside.load();
+	test_ms_ = ElapsedMs(start);
+}
+
+void OcclusionCuller::DrawImGui()
+{
+	ImGui::Text(
+		"Buffer: %d x %d (%d jobs threads)",
+		width_,
+		height_,
+		jobs_.GetWorkerCount());
+	ImGui::Text("Occluder triangles: %zu", triangle_count_);
+	ImGui::Text("Tested: %zu", tested_count_);
+	ImGui::Text("Outside view: %zu", outside_count_);
+	ImGui::Text("Occluded: %zu", occluded_count_);
+	ImGui::Text("Rasterize: %.3f ms, test: %.3f ms", render_ms_, test_ms_);
+	ImGui::SliderFloat("Debug contrast", &debug_contrast_, 1.0f, 500.0f);
+
+	// Near is bright; depth is hyperbolic so stretch what is left from 1.
+	debug_pixels_.resize(depth_.size() * 4);
+	for (std::size_t i = 0; i < depth_.size(); ++i)
+	{
+		const float value = std::clamp(
+			(1.0f - depth_[i]) * debug_contrast_,
+			0.0f,
+			1.0f);
+		const auto gray = static_cast<std::uint8_t>(value * 255.0f);
+		debug_pixels_[i * 4 + 0] = gray;
+		debug_pixels_[i * 4 + 1] = gray;
+		debug_pixels_[i * 4 + 2] = gray;
+		debug_pixels_[i * 4 + 3] = 255;
+	}
+	if (!debug_texture_)
+	{
+		debug_texture_.Create("OcclusionCuller debug view");
+		debug_texture_.SetBytes(EstimateTextureBytes(GL_RGBA8, width_, height_, 1, 1));
+		glBindTexture(GL_TEXTURE_2D, debug_texture_.Get());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_RGBA8,
+			width_,
+			height_,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			nullptr);
+	}
+	glBindTexture(GL_TEXTURE_2D, debug_texture_.Get());
+	glTexSubImage2D(
+		GL_TEXTURE_2D,
+		0,
+		0,
+		0,
+		width_,
+		height_,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		debug_pixels_.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	// Row 0 is the bottom of the screen, flip for ImGui.
+	ImGui::Image(
+		(ImTextureID)(std::intptr_t)debug_texture_.Get(),
+		ImVec2(width_ * 2.0f, height_ * 2.0f),
+		ImVec2(0.0f, 1.0f),
+		ImVec2(1.0f, 0.0f));
+}
+
+} // End namespace gl.
@@ -0,0 +1,403 @@
+#include <particle_system.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	// Simulate, emit and reset run 256 invocations per group.
+	constexpr GLuint GROUP_SIZE = 256;
+
+	GLuint GroupCount(std::size_t invocations)
+	{
+		return static_cast<GLuint>((invocations + GROUP_SIZE - 1) / GROUP_SIZE);
+	}
+
+	// 32 bytes, position and age then velocity and lifetime.
+	constexpr std::size_t PARTICLE_BYTES = 2 * sizeof(glm::vec4);
+
+} // End anonymous namespace.
+
+void ParticleSystem::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void ParticleSystem::Init(const std::string& path, std::size_t capacity)
+{
+	// Compute and storage buffers in the vertex shader, GLES 3.1 doesn't
+	// guarantee the latter.
+	supported_ = GLAD_GL_VERSION_4_3;
+	if (!supported_) return;
+	capacity_ = std::max<std::size_t>(capacity, 1);
+	sort_capacity_ = SORT_GROUP_SIZE;
+	while (sort_capacity_ < capacity_) sort_capacity_ <<= 1;
+
+	const std::string shaders = path + "data/shaders/particles/";
+	reset_shader_ = std::make_unique<Shader>(shaders + "reset.comp");
+	emit_shader_ = std::make_unique<Shader>(shaders + "emit.comp");
+	prepare_shader_ = std::make_unique<Shader>(shaders + "prepare.comp");
+	simulate_shader_ = std::make_unique<Shader>(shaders + "simulate.comp");
+	finish_shader_ = std::make_unique<Shader>(shaders + "finish.comp");
+	sort_local_shader_ = std::make_unique<Shader>(shaders + "sort_local.comp");
+	sort_step_shader_ = std::make_unique<Shader>(shaders + "sort_step.comp");
+	draw_shader_ = std::make_unique<Shader>(
+		shaders + "particle.vert",
+		shaders + "particle.frag");
+	simulate_shader_->Use();
+	simulate_shader_->SetInt("depth_texture", 0);
+	glUseProgram(0);
+
+	auto create = [](BufferHandle& buffer, const char* label, std::size_t bytes)
+	{
+		buffer.Create(label);
+		buffer.SetBytes(bytes);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.Get());
+		glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+	};
+	create(particles_, "Particles", capacity_ * PARTICLE_BYTES);
+	create(dead_, "Particles dead list", capacity_ * sizeof(GLuint));
+	create(alive_[0], "Particles alive list", capacity_ * sizeof(GLuint));
+	create(alive_[1], "Particles alive list", capacity_ * sizeof(GLuint));
+	create(
+		sort_,
+		"Particles sort",
+		static_cast<std::size_t>(sort_capacity_) * 2 * sizeof(GLuint));
+	create(counters_, "Particles counters", sizeof(Counters));
+	stats_.Create("Particles stats");
+	stats_.SetBytes(sizeof(Counters));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, stats_.Get());
+	glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Counters), nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	empty_vao_.Create("Particles draw");
+	IsError(__FILE__, __LINE__);
+
+	Reset();
+}
+
+void ParticleSystem::Destroy()
+{
+	if (stats_fence_)
+	{
+		glDeleteSync(stats_fence_);
+		stats_fence_ = nullptr;
+	}
+	particles_.Reset();
+	dead_.Reset();
+	alive_[0].Reset();
+	alive_[1].Reset();
+	sort_.Reset();
+	counters_.Reset();
+	stats_.Reset();
+	empty_vao_.Reset();
+	emit_timer_.Destroy();
+	simulate_timer_.Destroy();
+	sort_timer_.Destroy();
+	draw_timer_.Destroy();
+	reset_shader_.reset();
+	emit_shader_.reset();
+	prepare_shader_.reset();
+	simulate_shader_.reset();
+	finish_shader_.reset();
+	sort_local_shader_.reset();
+	sort_step_shader_.reset();
+	draw_shader_.reset();
+	supported_ = false;
+}
+
+void ParticleSystem::Reset()
+{
+	if (!supported_) return;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEAD_BINDING, dead_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTERS_BINDING, counters_.Get());
+	reset_shader_->Use();
+	reset_shader_->SetInt("capacity", static_cast<int>(capacity_));
+	glDispatchCompute(GroupCount(capacity_), 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+	glUseProgram(0);
+	emit_carry_ = 0.0f;
+	burst_ = 0;
+	IsError(__FILE__, __LINE__);
+}
+
+void ParticleSystem::AddCollisionPlane(const glm::vec4& plane)
+{
+	if (planes_.size() >= MAX_PLANES)
+	{
+		throw std::runtime_error("Too many particle collision planes.");
+	}
+	const float length = glm::length(glm::vec3(plane));
+	planes_.push_back(plane / length);
+}
+
+void ParticleSystem::SetDepthTexture(GLuint texture, float thickness)
+{
+	depth_texture_ = texture;
+	depth_thickness_ = thickness;
+}
+
+float ParticleSystem::GetSimulationMilliseconds() const
+{
+	return emit_timer_.GetMilliseconds() + simulate_timer_.GetMilliseconds();
+}
+
+void ParticleSystem::Update(
+	float dt,
+	const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	if (!supported_) return;
+	emit_timer_.Resolve();
+	simulate_timer_.Resolve();
+	sort_timer_.Resolve();
+	draw_timer_.Resolve();
+	ReadStats();
+	if (paused_) return;
+	dt *= time_scale_;
+	// Keeps a hitch from emitting or integrating a whole second at once.
+	dt = std::min(dt, 0.1f);
+
+	// The emission count is the only thing the CPU decides, anything the
+	// dead list can't provide is dropped on the GPU.
+	const float wanted = emitter_.rate * dt + emit_carry_;
+	std::size_t emit_count = static_cast<std::size_t>(wanted);
+	emit_carry_ = wanted - static_cast<float>(emit_count);
+	emit_count = std::min(emit_count + burst_, capacity_);
+	burst_ = 0;
+	++frame_;
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLES_BINDING, particles_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEAD_BINDING, dead_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ALIVE_BINDING, alive_[0].Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, ALIVE_NEXT_BINDING, alive_[1].Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SORT_BINDING, sort_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTERS_BINDING, counters_.Get());
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counters_.Get());
+
+	emit_timer_.Begin();
+	if (emit_count > 0)
+	{
+		emit_shader_->Use();
+		emit_shader_->SetInt("emit_count", static_cast<int>(emit_count));
+		emit_shader_->SetInt("seed", static_cast<int>(frame_));
+		emit_shader_->SetVec3("emitter_position", emitter_.position);
+		emit_shader_->SetFloat("emitter_radius", emitter_.radius);
+		emit_shader_->SetVec3("emitter_direction", emitter_.direction);
+		emit_shader_->SetFloat("emitter_spread", emitter_.spread);
+		emit_shader_->SetVec2("emitter_speed", emitter_.speed);
+		emit_shader_->SetVec2("emitter_lifetime", emitter_.lifetime);
+		glDispatchCompute(GroupCount(emit_count), 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	emit_timer_.End();
+
+	simulate_timer_.Begin();
+	prepare_shader_->Use();
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	simulate_shader_->Use();
+	simulate_shader_->SetFloat("dt", dt);
+	simulate_shader_->SetVec3("gravity", forces_.gravity);
+	simulate_shader_->SetFloat("drag", forces_.drag);
+	simulate_shader_->SetVec3("wind", forces_.wind);
+	simulate_shader_->SetVec3("attractor", forces_.attractor);
+	simulate_shader_->SetFloat("attractor_strength", forces_.attractor_strength);
+	simulate_shader_->SetFloat("restitution", forces_.restitution);
+	simulate_shader_->SetFloat("friction", forces_.friction);
+	simulate_shader_->SetInt("plane_count", static_cast<int>(planes_.size()));
+	for (std::size_t i = 0; i < planes_.size(); ++i)
+	{
+		simulate_shader_->SetVec4(
+			"planes[" + std::to_string(i) + "]",
+			planes_[i]);
+	}
+	simulate_shader_->SetBool("depth_enabled", depth_texture_ != 0);
+	simulate_shader_->SetFloat("depth_thickness", depth_thickness_);
+	simulate_shader_->SetMat4("view", view);
+	simulate_shader_->SetMat4("projection", projection);
+	simulate_shader_->SetMat4("inverse_projection", glm::inverse(projection));
+	simulate_shader_->SetVec3(
+		"camera_position",
+		glm::vec3(glm::inverse(view)[3]));
+	if (depth_texture_)
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depth_texture_);
+	}
+	glDispatchComputeIndirect(offsetof(Counters, simulate_dispatch));
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	finish_shader_->Use();
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+	simulate_timer_.End();
+	// Survivors are next frame's particles to simulate.
+	std::swap(alive_[0], alive_[1]);
+
+	sort_timer_.Begin();
+	if (sorting_) Sort();
+	sort_timer_.End();
+
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glUseProgram(0);
+	IsError(__FILE__, __LINE__);
+}
+
+void ParticleSystem::Sort()
+{
+	// Bitonic sort over the next power of two of the live count, padded
+	// with keys that go last. Steps are issued for the capacity and the
+	// ones wider than the live count return at once, so the CPU never
+	// needs the count. Steps within 512 elements run in shared memory.
+	sort_local_shader_->Use();
+	sort_local_shader_->SetInt("mode", 0);
+	glDispatchComputeIndirect(offsetof(Counters, sort_dispatch));
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	for (std::uint32_t k = SORT_GROUP_SIZE * 2; k <= sort_capacity_; k <<= 1)
+	{
+		sort_step_shader_->Use();
+		sort_step_shader_->SetInt("block", static_cast<int>(k));
+		for (std::uint32_t j = k / 2; j >= SORT_GROUP_SIZE; j >>= 1)
+		{
+			sort_step_shader_->SetInt("span", static_cast<int>(j));
+			glDispatchComputeIndirect(offsetof(Counters, sort_dispatch));
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+		sort_local_shader_->Use();
+		sort_local_shader_->SetInt("mode", 1);
+		sort_local_shader_->SetInt("block", static_cast<int>(k));
+		glDispatchComputeIndirect(offsetof(Counters, sort_dispatch));
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+}
+
+void ParticleSystem::Draw(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (!supported_) return;
+	draw_timer_.Begin();
+	draw_shader_->Use();
+	draw_shader_->SetMat4("view", view);
+	draw_shader_->SetMat4("projection", projection);
+	draw_shader_->SetVec4("color_begin", emitter_.color_begin);
+	draw_shader_->SetVec4("color_end", emitter_.color_end);
+	draw_shader_->SetVec2("size", emitter_.size);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLES_BINDING, particles_.Get());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SORT_BINDING, sort_.Get());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, counters_.Get());
+	glBindVertexArray(empty_vao_.Get());
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glDrawArraysIndirect(
+		GL_TRIANGLES,
+		reinterpret_cast<const void*>(offsetof(Counters, draw)));
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glUseProgram(0);
+	draw_timer_.End();
+	IsError(__FILE__, __LINE__);
+}
+
+void ParticleSystem::ReadStats()
+{
+	if (stats_fence_)
+	{
+		const GLenum result = glClientWaitSync(stats_fence_, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) return;
+		glDeleteSync(stats_fence_);
+		stats_fence_ = nullptr;
+		Counters counters = {};
+		glBindBuffer(GL_COPY_READ_BUFFER, stats_.Get());
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(Counters), &counters);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		stats_alive_ = counters.alive_count;
+		stats_dead_ = counters.dead_count;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, counters_.Get());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, stats_.Get());
+	glCopyBufferSubData(
+		GL_COPY_READ_BUFFER,
+		GL_COPY_WRITE_BUFFER,
+		0,
+		0,
+		sizeof(Counters));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	stats_fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void ParticleSystem::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Particles")) return;
+	if (!supported_)
+	{
+		ImGui::Text("Needs OpenGL 4.3.");
+		return;
+	}
+	ImGui::Text(
+		"Alive: %u / %zu (dead list %d)",
+		stats_alive_,
+		capacity_,
+		stats_dead_);
+	ImGui::Text(
+		"GPU emit %.3f ms, simulate %.3f ms, sort %.3f ms, draw %.3f ms",
+		emit_timer_.GetMilliseconds(),
+		simulate_timer_.GetMilliseconds(),
+		sort_timer_.GetMilliseconds(),
+		draw_timer_.GetMilliseconds());
+	ImGui::Checkbox("Pause", &paused_);
+	ImGui::SameLine();
+	ImGui::Checkbox("Sort back to front", &sorting_);
+	ImGui::SameLine();
+	if (ImGui::Button("Kill all")) Reset();
+	ImGui::SliderFloat("Time scale", &time_scale_, 0.0f, 2.0f);
+
+	ImGui::SliderFloat("Rate", &emitter_.rate, 0.0f, 1000000.0f, "%.0f");
+	ImGui::SliderFloat3("Position", &emitter_.position.x, -5.0f, 5.0f);
+	ImGui::SliderFloat("Radius", &emitter_.radius, 0.0f, 2.0f);
+	ImGui::SliderFloat3("Direction", &emitter_.direction.x, -1.0f, 1.0f);
+	ImGui::SliderFloat("Spread", &emitter_.spread, 0.0f, 3.1415926f);
+	ImGui::SliderFloat2("Speed", &emitter_.speed.x, 0.0f, 20.0f);
+	ImGui::SliderFloat2("Lifetime", &emitter_.lifetime.x, 0.1f, 10.0f);
+	ImGui::SliderFloat2("Size", &emitter_.size.x, 0.001f, 0.5f);
+	ImGui::ColorEdit4("Color begin", &emitter_.color_begin.x);
+	ImGui::ColorEdit4("Color end", &emitter_.color_end.x);
+
+	ImGui::SliderFloat3("Gravity", &forces_.gravity.x, -20.0f, 20.0f);
+	ImGui::SliderFloat3("Wind", &forces_.wind.x, -10.0f, 10.0f);
+	ImGui::SliderFloat("Drag", &forces_.drag, 0.0f, 5.0f);
+	ImGui::SliderFloat3("Attractor", &forces_.attractor.x, -5.0f, 5.0f);
+	ImGui::SliderFloat(
+		"Attractor strength",
+		&forces_.attractor_strength,
+		-50.0f,
+		50.0f);
+	ImGui::SliderFloat("Restitution", &forces_.restitution, 0.0f, 1.0f);
+	ImGui::SliderFloat("Friction", &forces_.friction, 0.0f, 1.0f);
+	ImGui::Text(
+		"Collision planes: %zu, depth buffer: %s",
+		planes_.size(),
+		depth_texture_ ? "on" : "off");
+}
+
+} // End namespace gl.
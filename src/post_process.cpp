@@ -0,0 +1,625 @@
+#include <post_process.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	glm::ivec2 ScaleSize(glm::ivec2 size, float scale)
+	{
+		return glm::max(
+			glm::ivec2(glm::vec2(size) * scale + 0.5f),
+			glm::ivec2(1));
+	}
+
+	glm::ivec2 LevelSize(glm::ivec2 base, int level)
+	{
+		return glm::max(
+			glm::ivec2(base.x >> level, base.y >> level),
+			glm::ivec2(1));
+	}
+
+	void Dispatch(glm::ivec2 size)
+	{
+		// 8x8 groups in every post-process shader.
+		glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+	}
+
+} // End anonymous namespace.
+
+void GpuTimer::Begin()
+{
+	started_ = false;
+	// Timestamps are core in 3.3, GLES only has them as an extension.
+	if (!GLAD_GL_VERSION_3_3 || pending_) return;
+	if (!begin_)
+	{
+		begin_.Create("GpuTimer begin");
+		end_.Create("GpuTimer end");
+	}
+	glQueryCounter(begin_.Get(), GL_TIMESTAMP);
+	started_ = true;
+}
+
+void GpuTimer::End()
+{
+	if (!started_) return;
+	glQueryCounter(end_.Get(), GL_TIMESTAMP);
+	started_ = false;
+	pending_ = true;
+}
+
+bool GpuTimer::Resolve()
+{
+	if (!pending_) return false;
+	GLint available = 0;
+	glGetQueryObjectiv(end_.Get(), GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) return false;
+	GLuint64 begin = 0;
+	GLuint64 end = 0;
+	glGetQueryObjectui64v(begin_.Get(), GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(end_.Get(), GL_QUERY_RESULT, &end);
+	milliseconds_ = static_cast<float>(end - begin) / 1e6f;
+	pending_ = false;
+	return true;
+}
+
+void GpuTimer::Destroy()
+{
+	begin_.Reset();
+	end_.Reset();
+	pending_ = false;
+	started_ = false;
+}
+
+void PostProcess::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void PostProcess::Init(const std::string& path)
+{
+	// The compute shaders are GLSL 4.50, GLES 3.1 can't compile them.
+	supported_ = GLAD_GL_VERSION_4_3;
+	if (!supported_) return;
+	bloom_down_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/post_process/bloom_down.comp");
+	bloom_up_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/post_process/bloom_up.comp");
+	per_pixel_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/post_process/per_pixel.comp");
+	fxaa_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/post_process/fxaa.comp");
+	upscale_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/post_process/upscale.comp");
+	present_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/common/fullscreen.vert",
+		path + "data/shaders/post_process/present.frag");
+	empty_vao_.Create("PostProcess fullscreen");
+
+	bloom_down_shader_->Use();
+	bloom_down_shader_->SetInt("source", 0);
+	bloom_up_shader_->Use();
+	bloom_up_shader_->SetInt("source", 0);
+	per_pixel_shader_->Use();
+	per_pixel_shader_->SetInt("source", 0);
+	per_pixel_shader_->SetInt("bloom", 1);
+	fxaa_shader_->Use();
+	fxaa_shader_->SetInt("source", 0);
+	upscale_shader_->Use();
+	upscale_shader_->SetInt("source", 0);
+	present_shader_->Use();
+	present_shader_->SetInt("source", 0);
+	glUseProgram(0);
+	IsError(__FILE__, __LINE__);
+}
+
+void PostProcess::Destroy()
+{
+	graph_.Destroy();
+	for (auto& effect : effects_)
+	{
+		effect.timer.Destroy();
+	}
+	total_timer_.Destroy();
+	upscale_timer_.Destroy();
+	scene_fbo_.Reset();
+	scene_color_.Reset();
+	scene_depth_.Reset();
+	empty_vao_.Reset();
+	scene_size_ = glm::ivec2(0);
+	bloom_down_shader_.reset();
+	bloom_up_shader_.reset();
+	per_pixel_shader_.reset();
+	fxaa_shader_.reset();
+	upscale_shader_.reset();
+	present_shader_.reset();
+}
+
+void PostProcess::ResizeScene(glm::ivec2 size)
+{
+	size = glm::max(size, glm::ivec2(1));
+	if (size == scene_size_) return;
+	scene_size_ = size;
+
+	scene_color_.Create("PostProcess scene color");
+	scene_color_.SetBytes(
+		EstimateTextureBytes(GL_RGBA16F, size.x, size.y, 1, 1));
+	glBindTexture(GL_TEXTURE_2D, scene_color_.Get());
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, size.x, size.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	scene_depth_.Create("PostProcess scene depth");
+	scene_depth_.SetBytes(
+		EstimateTextureBytes(GL_DEPTH24_STENCIL8, size.x, size.y, 1, 1));
+	glBindRenderbuffer(GL_RENDERBUFFER, scene_depth_.Get());
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	scene_fbo_.Create("PostProcess scene");
+	glBindFramebuffer(GL_FRAMEBUFFER, scene_fbo_.Get());
+	glFramebufferTexture2D(
+		GL_FRAMEBUFFER,
+		GL_COLOR_ATTACHMENT0,
+		GL_TEXTURE_2D,
+		scene_color_.Get(),
+		0);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_DEPTH_STENCIL_ATTACHMENT,
+		GL_RENDERBUFFER,
+		scene_depth_.Get());
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		throw std::runtime_error("Post-process scene framebuffer is incomplete.");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+void PostProcess::BeginScene(glm::ivec2 size)
+{
+	ResizeScene(size);
+	glBindFramebuffer(GL_FRAMEBUFFER, scene_fbo_.Get());
+	glViewport(0, 0, scene_size_.x, scene_size_.y);
+}
+
+void PostProcess::AddBloom(RenderResource scene, RenderResource& chain)
+{
+	Effect& effect = effects_[static_cast<std::size_t>(PostEffectEnum::BLOOM)];
+	const glm::ivec2 base = ScaleSize(scene_size_, effect.scale);
+	// Stop before the smallest level gets under 2 texels.
+	int levels = std::max(bloom_levels_, 1);
+	while (levels > 1 && std::min(base.x, base.y) >> (levels - 1) < 2)
+	{
+		--levels;
+	}
+	bloom_levels_used_ = levels;
+	chain = graph_.CreateTexture(
+		"Bloom chain",
+		{ base.x, base.y, GL_RGBA16F, levels, false });
+
+	// Down: threshold into level 0, then each level from the one above.
+	for (int level = 0; level < levels; ++level)
+	{
+		// Without an up pass the chain ends here.
+		const bool last = levels == 1;
+		graph_.AddPass(
+			"Bloom down " + std::to_string(level),
+			[&](RenderPassBuilder& builder) {
+				builder.Read(level == 0 ? scene : chain, RenderAccessEnum::SAMPLED);
+				chain = builder.Write(chain, RenderAccessEnum::IMAGE);
+			},
+			[this, &effect, scene, chain, level, base, last](
+				const RenderPassContext& context)
+			{
+				if (level == 0) effect.timer.Begin();
+				bloom_down_shader_->Use();
+				bloom_down_shader_->SetInt("source_lod", std::max(level - 1, 0));
+				bloom_down_shader_->SetBool("prefilter", level == 0);
+				bloom_down_shader_->SetFloat("threshold", bloom_threshold_);
+				bloom_down_shader_->SetFloat("knee", bloom_knee_);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(
+					GL_TEXTURE_2D,
+					context.GetTexture(level == 0 ? scene : chain));
+				glBindImageTexture(
+					0,
+					context.GetTexture(chain),
+					level,
+					GL_FALSE,
+					0,
+					GL_WRITE_ONLY,
+					GL_RGBA16F);
+				Dispatch(LevelSize(base, level));
+				++dispatch_count_;
+				if (last) effect.timer.End();
+			});
+	}
+	// Up: each level adds a tent filtered copy of the one below it.
+	for (int level = levels - 2; level >= 0; --level)
+	{
+		graph_.AddPass(
+			"Bloom up " + std::to_string(level),
+			[&](RenderPassBuilder& builder) {
+				builder.Read(chain, RenderAccessEnum::SAMPLED);
+				chain = builder.Write(chain, RenderAccessEnum::IMAGE);
+			},
+			[this, &effect, chain, level, base](const RenderPassContext& context)
+			{
+				bloom_up_shader_->Use();
+				bloom_up_shader_->SetInt("source_lod", level + 1);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, context.GetTexture(chain));
+				glBindImageTexture(
+					0,
+					context.GetTexture(chain),
+					level,
+					GL_FALSE,
+					0,
+					GL_READ_WRITE,
+					GL_RGBA16F);
+				Dispatch(LevelSize(base, level));
+				++dispatch_count_;
+				if (level == 0) effect.timer.End();
+			});
+	}
+}
+
+RenderResource PostProcess::AddPerPixel(
+	const std::vector<PostEffectEnum>& effects,
+	float scale,
+	RenderResource source,
+	RenderResource bloom)
+{
+	auto has = [&effects](PostEffectEnum effect) {
+		return std::find(effects.begin(), effects.end(), effect) != effects.end();
+	};
+	const bool apply_bloom = has(PostEffectEnum::BLOOM);
+	const bool apply_tonemap = has(PostEffectEnum::TONEMAP);
+	const bool apply_grading = has(PostEffectEnum::COLOR_GRADING);
+
+	// The bloom chain has its own timer, the dispatch is timed by the
+	// first other effect in it.
+	auto owner = std::find_if(
+		effects.begin(),
+		effects.end(),
+		[](PostEffectEnum effect) { return effect != PostEffectEnum::BLOOM; });
+	std::string name;
+	for (const auto effect : effects)
+	{
+		name += (name.empty() ? "" : " + ") +
+			std::string(effects_[static_cast<std::size_t>(effect)].name);
+		if (owner != effects.end() && effect != *owner)
+		{
+			effects_[static_cast<std::size_t>(effect)].fused_into =
+				static_cast<int>(*owner);
+		}
+	}
+	GpuTimer* timer = owner == effects.end() ?
+		nullptr :
+		&effects_[static_cast<std::size_t>(*owner)].timer;
+
+	const glm::ivec2 size = ScaleSize(scene_size_, scale);
+	RenderResource target = graph_.CreateTexture(
+		name,
+		{ size.x, size.y, GL_RGBA16F, 1, false });
+	graph_.AddPass(
+		name,
+		[&](RenderPassBuilder& builder) {
+			builder.Read(source, RenderAccessEnum::SAMPLED);
+			if (apply_bloom) builder.Read(bloom, RenderAccessEnum::SAMPLED);
+			target = builder.Write(target, RenderAccessEnum::IMAGE);
+		},
+		[=, this](const RenderPassContext& context)
+		{
+			if (timer) timer->Begin();
+			per_pixel_shader_->Use();
+			per_pixel_shader_->SetBool("apply_bloom", apply_bloom);
+			per_pixel_shader_->SetFloat(
+				"bloom_intensity",
+				bloom_intensity_ / static_cast<float>(bloom_levels_used_));
+			per_pixel_shader_->SetBool("apply_tonemap", apply_tonemap);
+			per_pixel_shader_->SetInt(
+				"tonemap_operator",
+				static_cast<int>(operator_));
+			per_pixel_shader_->SetFloat("exposure", exposure_);
+			per_pixel_shader_->SetBool("apply_grading", apply_grading);
+			per_pixel_shader_->SetVec3("lift", lift_);
+			per_pixel_shader_->SetVec3("gamma", gamma_);
+			per_pixel_shader_->SetVec3("gain", gain_);
+			per_pixel_shader_->SetFloat("saturation", saturation_);
+			per_pixel_shader_->SetFloat("contrast", contrast_);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, context.GetTexture(source));
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(
+				GL_TEXTURE_2D,
+				apply_bloom ? context.GetTexture(bloom) : 0);
+			glActiveTexture(GL_TEXTURE0);
+			glBindImageTexture(
+				0,
+				context.GetTexture(target),
+				0,
+				GL_FALSE,
+				0,
+				GL_WRITE_ONLY,
+				GL_RGBA16F);
+			Dispatch(size);
+			++dispatch_count_;
+			if (timer) timer->End();
+		});
+	return target;
+}
+
+RenderResource PostProcess::AddFxaa(RenderResource source)
+{
+	Effect& effect = effects_[static_cast<std::size_t>(PostEffectEnum::FXAA)];
+	const glm::ivec2 size = ScaleSize(scene_size_, effect.scale);
+	RenderResource target = graph_.CreateTexture(
+		"FXAA",
+		{ size.x, size.y, GL_RGBA16F, 1, false });
+	graph_.AddPass(
+		"FXAA",
+		[&](RenderPassBuilder& builder) {
+			builder.Read(source, RenderAccessEnum::SAMPLED);
+			target = builder.Write(target, RenderAccessEnum::IMAGE);
+		},
+		[this, &effect, source, target, size](const RenderPassContext& context)
+		{
+			effect.timer.Begin();
+			fxaa_shader_->Use();
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, context.GetTexture(source));
+			glBindImageTexture(
+				0,
+				context.GetTexture(target),
+				0,
+				GL_FALSE,
+				0,
+				GL_WRITE_ONLY,
+				GL_RGBA16F);
+			Dispatch(size);
+			++dispatch_count_;
+			effect.timer.End();
+		});
+	return target;
+}
+
+RenderResource PostProcess::AddUpscale(
+	RenderResource source,
+	glm::ivec2 output_size)
+{
+	RenderResource target = graph_.CreateTexture(
+		"Upscale",
+		{ output_size.x, output_size.y, GL_RGBA16F, 1, false });
+	graph_.AddPass(
+		"Upscale",
+		[&](RenderPassBuilder& builder) {
+			builder.Read(source, RenderAccessEnum::SAMPLED);
+			target = builder.Write(target, RenderAccessEnum::IMAGE);
+		},
+		[this, source, target, output_size](const RenderPassContext& context)
+		{
+			upscale_timer_.Begin();
+			upscale_shader_->Use();
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, context.GetTexture(source));
+			glBindImageTexture(
+				0,
+				context.GetTexture(target),
+				0,
+				GL_FALSE,
+				0,
+				GL_WRITE_ONLY,
+				GL_RGBA16F);
+			Dispatch(output_size);
+			++dispatch_count_;
+			upscale_timer_.End();
+		});
+	return target;
+}
+
+void PostProcess::EndScene(glm::ivec2 output_size)
+{
+	for (auto& effect : effects_)
+	{
+		effect.timer.Resolve();
+		effect.fused_into = -1;
+	}
+	total_timer_.Resolve();
+	upscale_timer_.Resolve();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, output_size.x, output_size.y);
+	total_timer_.Begin();
+	dispatch_count_ = 0;
+
+	auto& bloom = effects_[static_cast<std::size_t>(PostEffectEnum::BLOOM)];
+	auto& tonemap = effects_[static_cast<std::size_t>(PostEffectEnum::TONEMAP)];
+	auto& grading =
+		effects_[static_cast<std::size_t>(PostEffectEnum::COLOR_GRADING)];
+	auto& fxaa = effects_[static_cast<std::size_t>(PostEffectEnum::FXAA)];
+
+	graph_.Reset();
+	RenderResource backbuffer = graph_.ImportBackbuffer(output_size);
+	RenderResource current = graph_.ImportTexture(
+		"Scene",
+		scene_color_.Get(),
+		{ scene_size_.x, scene_size_.y, GL_RGBA16F });
+	glm::ivec2 current_size = scene_size_;
+	RenderResource chain = current;
+	if (bloom.enabled) AddBloom(current, chain);
+
+	// Per-pixel effects in order with their scale. The bloom composite
+	// takes the scale of the effect after it so it always fuses.
+	std::vector<std::pair<PostEffectEnum, float>> per_pixel;
+	if (tonemap.enabled)
+	{
+		per_pixel.push_back({ PostEffectEnum::TONEMAP, tonemap.scale });
+	}
+	if (grading.enabled)
+	{
+		per_pixel.push_back({ PostEffectEnum::COLOR_GRADING, grading.scale });
+	}
+	if (bloom.enabled)
+	{
+		per_pixel.insert(
+			per_pixel.begin(),
+			{
+				PostEffectEnum::BLOOM,
+				per_pixel.empty() ? 1.0f : per_pixel.front().second
+			});
+	}
+	std::vector<PostEffectEnum> group;
+	float group_scale = 1.0f;
+	for (const auto& [effect, scale] : per_pixel)
+	{
+		if (!group.empty() && (!fuse_ || scale != group_scale))
+		{
+			current = AddPerPixel(group, group_scale, current, chain);
+			current_size = ScaleSize(scene_size_, group_scale);
+			group.clear();
+		}
+		if (group.empty()) group_scale = scale;
+		group.push_back(effect);
+	}
+	if (!group.empty())
+	{
+		current = AddPerPixel(group, group_scale, current, chain);
+		current_size = ScaleSize(scene_size_, group_scale);
+	}
+	if (fxaa.enabled)
+	{
+		current = AddFxaa(current);
+		current_size = ScaleSize(scene_size_, fxaa.scale);
+	}
+	// Effects at a reduced scale are upscaled along with the scene.
+	const bool upscale =
+		upscale_ == UpscaleFilterEnum::EDGE_ADAPTIVE &&
+		current_size != output_size;
+	if (upscale) current = AddUpscale(current, output_size);
+
+	graph_.AddPass(
+		"Present",
+		[&](RenderPassBuilder& builder) {
+			builder.Read(current, RenderAccessEnum::SAMPLED);
+			backbuffer = builder.Write(
+				backbuffer,
+				RenderAccessEnum::COLOR_ATTACHMENT);
+		},
+		[this, current, upscale](const RenderPassContext& context)
+		{
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_BLEND);
+			present_shader_->Use();
+			present_shader_->SetBool("sharpen", upscale);
+			present_shader_->SetFloat("sharpness", sharpness_);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, context.GetTexture(current));
+			glBindVertexArray(empty_vao_.Get());
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glBindVertexArray(0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glEnable(GL_DEPTH_TEST);
+		});
+	graph_.Compile();
+	graph_.Execute();
+	total_timer_.End();
+	IsError(__FILE__, __LINE__);
+}
+
+void PostProcess::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Post-process")) return;
+	if (!supported_)
+	{
+		ImGui::Text("Needs compute shaders (desktop GL 4.3).");
+		return;
+	}
+	ImGui::Checkbox("Enabled", &enabled_);
+	ImGui::Checkbox("Fuse per-pixel effects", &fuse_);
+	ImGui::Text(
+		"GPU: %.3f ms in %zu dispatches",
+		total_timer_.GetMilliseconds(),
+		dispatch_count_);
+	for (std::size_t i = 0; i < EFFECT_COUNT; ++i)
+	{
+		Effect& effect = effects_[i];
+		const auto type = static_cast<PostEffectEnum>(i);
+		ImGui::PushID(static_cast<int>(i));
+		ImGui::Checkbox(effect.name, &effect.enabled);
+		ImGui::SameLine();
+		if (effect.fused_into >= 0 && type != PostEffectEnum::BLOOM)
+		{
+			ImGui::Text("fused into %s", effects_[effect.fused_into].name);
+		}
+		else
+		{
+			ImGui::Text("%.3f ms", effect.timer.GetMilliseconds());
+		}
+		ImGui::SliderFloat("Scale", &effect.scale, 0.25f, 1.0f);
+		switch (type)
+		{
+		case PostEffectEnum::BLOOM:
+			ImGui::SliderFloat("Threshold", &bloom_threshold_, 0.0f, 4.0f);
+			ImGui::SliderFloat("Knee", &bloom_knee_, 0.0f, 1.0f);
+			ImGui::SliderFloat("Intensity", &bloom_intensity_, 0.0f, 4.0f);
+			ImGui::SliderInt("Levels", &bloom_levels_, 1, 8);
+			break;
+		case PostEffectEnum::TONEMAP:
+		{
+			const char* operators[] = { "Reinhard", "ACES" };
+			int current = static_cast<int>(operator_);
+			if (ImGui::Combo("Operator", &current, operators, 2))
+			{
+				operator_ = static_cast<TonemapOperatorEnum>(current);
+			}
+			ImGui::SliderFloat("Exposure", &exposure_, 0.1f, 8.0f);
+			break;
+		}
+		case PostEffectEnum::COLOR_GRADING:
+			ImGui::SliderFloat3("Lift", &lift_[0], -0.5f, 0.5f);
+			ImGui::SliderFloat3("Gamma", &gamma_[0], 0.25f, 4.0f);
+			ImGui::SliderFloat3("Gain", &gain_[0], 0.0f, 2.0f);
+			ImGui::SliderFloat("Saturation", &saturation_, 0.0f, 2.0f);
+			ImGui::SliderFloat("Contrast", &contrast_, 0.0f, 2.0f);
+			break;
+		default:
+			break;
+		}
+		ImGui::PopID();
+	}
+	const char* filters[] = { "Bilinear", "Edge adaptive + sharpen" };
+	int filter = static_cast<int>(upscale_);
+	if (ImGui::Combo("Upscale", &filter, filters, 2))
+	{
+		upscale_ = static_cast<UpscaleFilterEnum>(filter);
+	}
+	if (upscale_ == UpscaleFilterEnum::EDGE_ADAPTIVE)
+	{
+		ImGui::SliderFloat("Sharpness (stops)", &sharpness_, 0.0f, 2.0f);
+		ImGui::Text(
+			"Upscale %dx%d: %.3f ms",
+			scene_size_.x,
+			scene_size_.y,
+			upscale_timer_.GetMilliseconds());
+	}
+	graph_.DrawImGui();
+}
+
+} // End namespace gl.
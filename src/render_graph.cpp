@@ -0,0 +1,790 @@
+#include <render_graph.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	bool IsDepthFormat(GLenum format)
+	{
+		switch (format)
+		{
+		case GL_DEPTH_COMPONENT16:
+		case GL_DEPTH_COMPONENT24:
+		case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH24_STENCIL8:
+		case GL_DEPTH32F_STENCIL8:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool IsStencilFormat(GLenum format)
+	{
+		return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+	}
+
+	bool IsAttachment(RenderAccessEnum access)
+	{
+		return access == RenderAccessEnum::COLOR_ATTACHMENT ||
+			access == RenderAccessEnum::DEPTH_ATTACHMENT;
+	}
+
+	// Writes that need a glMemoryBarrier before anything else sees them.
+	bool IsIncoherent(RenderAccessEnum access)
+	{
+		return access == RenderAccessEnum::IMAGE ||
+			access == RenderAccessEnum::STORAGE;
+	}
+
+	GLbitfield GetBarrierBits(RenderAccessEnum access)
+	{
+		switch (access)
+		{
+		case RenderAccessEnum::COLOR_ATTACHMENT:
+		case RenderAccessEnum::DEPTH_ATTACHMENT:
+			return GL_FRAMEBUFFER_BARRIER_BIT;
+		case RenderAccessEnum::SAMPLED:
+			return GL_TEXTURE_FETCH_BARRIER_BIT;
+		case RenderAccessEnum::IMAGE:
+			return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+		case RenderAccessEnum::STORAGE:
+			return GL_SHADER_STORAGE_BARRIER_BIT;
+		case RenderAccessEnum::UNIFORM:
+			return GL_UNIFORM_BARRIER_BIT;
+		case RenderAccessEnum::INDIRECT:
+			return GL_COMMAND_BARRIER_BIT;
+		case RenderAccessEnum::VERTEX:
+			return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+				GL_ELEMENT_ARRAY_BARRIER_BIT;
+		default:
+			return 0;
+		}
+	}
+
+	bool IsSameTexture(const RenderTextureDesc& a, const RenderTextureDesc& b)
+	{
+		return a.width == b.width &&
+			a.height == b.height &&
+			a.format == b.format;
+	}
+
+	double ToMegabytes(std::size_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+} // End anonymous namespace.
+
+void RenderPassBuilder::Read(RenderResource resource, RenderAccessEnum access)
+{
+	if (resource >= graph_.versions_.size())
+	{
+		throw std::runtime_error(
+			"Pass " + graph_.passes_[pass_].name + " reads an unknown resource.");
+	}
+	graph_.passes_[pass_].reads.push_back({ resource, access });
+	graph_.versions_[resource].readers.push_back(pass_);
+}
+
+RenderResource RenderPassBuilder::Write(
+	RenderResource resource,
+	RenderAccessEnum access)
+{
+	if (resource >= graph_.versions_.size())
+	{
+		throw std::runtime_error(
+			"Pass " + graph_.passes_[pass_].name + " writes an unknown resource.");
+	}
+	const std::size_t index = graph_.versions_[resource].resource;
+	auto& node = graph_.resources_[index];
+	if (node.latest != resource)
+	{
+		throw std::runtime_error(
+			"Pass " + graph_.passes_[pass_].name + " writes an old version of " +
+			node.name + ".");
+	}
+	const auto version = static_cast<RenderResource>(graph_.versions_.size());
+	graph_.versions_.emplace_back(
+		index,
+		static_cast<int>(pass_),
+		static_cast<int>(resource));
+	node.latest = version;
+	graph_.passes_[pass_].writes.push_back({ version, access });
+	return version;
+}
+
+void RenderPassBuilder::SetSideEffect()
+{
+	graph_.passes_[pass_].side_effect = true;
+}
+
+GLuint RenderPassContext::GetTexture(RenderResource resource) const
+{
+	const auto& node = graph_.resources_[graph_.versions_[resource].resource];
+	if (node.imported) return node.id;
+	if (node.physical < 0)
+	{
+		throw std::runtime_error(node.name + " has no texture, is it used?");
+	}
+	return graph_.physical_textures_[node.physical].texture.Get();
+}
+
+GLuint RenderPassContext::GetBuffer(RenderResource resource) const
+{
+	return graph_.resources_[graph_.versions_[resource].resource].id;
+}
+
+glm::ivec2 RenderPassContext::GetSize(RenderResource resource) const
+{
+	const auto& desc =
+		graph_.resources_[graph_.versions_[resource].resource].desc;
+	return glm::ivec2(desc.width, desc.height);
+}
+
+void RenderGraph::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+std::size_t RenderGraph::AddResource(const std::string& name)
+{
+	const auto version = static_cast<RenderResource>(versions_.size());
+	ResourceNode node;
+	node.name = name;
+	node.latest = version;
+	resources_.push_back(node);
+	versions_.emplace_back(resources_.size() - 1);
+	compiled_ = false;
+	return version;
+}
+
+RenderResource RenderGraph::CreateTexture(
+	const std::string& name,
+	const RenderTextureDesc& desc)
+{
+	const auto version = static_cast<RenderResource>(AddResource(name));
+	auto& node = resources_.back();
+	node.desc = desc;
+	node.bytes = EstimateTextureBytes(
+		desc.format,
+		desc.width,
+		desc.height,
+		1,
+		desc.levels);
+	return version;
+}
+
+RenderResource RenderGraph::ImportTexture(
+	const std::string& name,
+	GLuint texture,
+	const RenderTextureDesc& desc)
+{
+	const auto version = static_cast<RenderResource>(AddResource(name));
+	auto& node = resources_.back();
+	node.desc = desc;
+	node.imported = true;
+	node.id = texture;
+	return version;
+}
+
+RenderResource RenderGraph::ImportBuffer(
+	const std::string& name,
+	GLuint buffer,
+	std::size_t bytes)
+{
+	const auto version = static_cast<RenderResource>(AddResource(name));
+	auto& node = resources_.back();
+	node.is_buffer = true;
+	node.imported = true;
+	node.id = buffer;
+	node.bytes = bytes;
+	return version;
+}
+
+RenderResource RenderGraph::ImportBackbuffer(glm::ivec2 size)
+{
+	const auto version = static_cast<RenderResource>(AddResource("Backbuffer"));
+	auto& node = resources_.back();
+	node.desc.width = size.x;
+	node.desc.height = size.y;
+	// The engine clears it every frame already.
+	node.desc.clear = false;
+	node.is_backbuffer = true;
+	node.imported = true;
+	return version;
+}
+
+void RenderGraph::AddPass(
+	const std::string& name,
+	const std::function<void(RenderPassBuilder&)>& setup,
+	std::function<void(const RenderPassContext&)> execute)
+{
+	PassNode pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+	passes_.push_back(std::move(pass));
+	RenderPassBuilder builder(*this, passes_.size() - 1);
+	setup(builder);
+	compiled_ = false;
+}
+
+void RenderGraph::Compile()
+{
+	// Cull: start from the passes with visible results and walk back to
+	// the producers of what they read or write over.
+	std::vector<std::size_t> stack;
+	for (std::size_t i = 0; i < passes_.size(); ++i)
+	{
+		auto& pass = passes_[i];
+		pass.culled = true;
+		bool root = pass.side_effect;
+		for (const auto& write : pass.writes)
+		{
+			root |= resources_[versions_[write.version].resource].imported;
+		}
+		if (root)
+		{
+			pass.culled = false;
+			stack.push_back(i);
+		}
+	}
+	auto keep_writer = [this, &stack](int version) {
+		if (version < 0) return;
+		const int writer = versions_[version].writer;
+		if (writer < 0 || !passes_[writer].culled) return;
+		passes_[writer].culled = false;
+		stack.push_back(writer);
+	};
+	while (!stack.empty())
+	{
+		const std::size_t index = stack.back();
+		stack.pop_back();
+		for (const auto& read : passes_[index].reads)
+		{
+			keep_writer(static_cast<int>(read.version));
+		}
+		for (const auto& write : passes_[index].writes)
+		{
+			keep_writer(versions_[write.version].previous);
+		}
+	}
+
+	// Edges: read after write, write after write, and write after read so
+	// a version isn't overwritten before every reader is done with it.
+	std::vector<std::vector<std::size_t>> dependents(passes_.size());
+	std::vector<std::size_t> in_degree(passes_.size(), 0);
+	auto add_edge = [this, &dependents, &in_degree](int from, std::size_t to) {
+		if (from < 0 || static_cast<std::size_t>(from) == to) return;
+		if (passes_[from].culled) return;
+		dependents[from].push_back(to);
+		++in_degree[to];
+	};
+	std::size_t alive_count = 0;
+	for (std::size_t i = 0; i < passes_.size(); ++i)
+	{
+		const auto& pass = passes_[i];
+		if (pass.culled) continue;
+		++alive_count;
+		for (const auto& read : pass.reads)
+		{
+			add_edge(versions_[read.version].writer, i);
+		}
+		for (const auto& write : pass.writes)
+		{
+			const int previous = versions_[write.version].previous;
+			if (previous < 0) continue;
+			add_edge(versions_[previous].writer, i);
+			for (const std::size_t reader : versions_[previous].readers)
+			{
+				add_edge(static_cast<int>(reader), i);
+			}
+		}
+	}
+
+	// Kahn, picking among the ready passes the one whose latest producer
+	// ran last, so results are consumed soon and lifetimes stay short.
+	order_.clear();
+	std::vector<int> latest_producer(passes_.size(), -1);
+	std::vector<std::size_t> ready;
+	for (std::size_t i = 0; i < passes_.size(); ++i)
+	{
+		if (!passes_[i].culled && in_degree[i] == 0) ready.push_back(i);
+	}
+	while (!ready.empty())
+	{
+		auto best = ready.begin();
+		for (auto it = ready.begin(); it != ready.end(); ++it)
+		{
+			if (latest_producer[*it] > latest_producer[*best] ||
+				(latest_producer[*it] == latest_producer[*best] && *it < *best))
+			{
+				best = it;
+			}
+		}
+		const std::size_t index = *best;
+		ready.erase(best);
+		const int position = static_cast<int>(order_.size());
+		order_.push_back(index);
+		for (const std::size_t dependent : dependents[index])
+		{
+			latest_producer[dependent] = position;
+			if (--in_degree[dependent] == 0) ready.push_back(dependent);
+		}
+	}
+	if (order_.size() != alive_count)
+	{
+		throw std::runtime_error("Render graph has a cycle.");
+	}
+
+	// Lifetimes, in execution order.
+	for (auto& node : resources_)
+	{
+		node.first_use = -1;
+		node.last_use = -1;
+		node.physical = -1;
+	}
+	for (std::size_t position = 0; position < order_.size(); ++position)
+	{
+		const auto& pass = passes_[order_[position]];
+		auto touch = [this, position](RenderResource version) {
+			auto& node = resources_[versions_[version].resource];
+			if (node.first_use < 0) node.first_use = static_cast<int>(position);
+			node.last_use = static_cast<int>(position);
+		};
+		for (const auto& read : pass.reads) touch(read.version);
+		for (const auto& write : pass.writes) touch(write.version);
+	}
+	AssignPhysicalTextures();
+
+	// Barriers, attachments and clears.
+	auto write_access = [this](int version, RenderAccessEnum& access) {
+		if (version < 0) return false;
+		const int writer = versions_[version].writer;
+		if (writer < 0) return false;
+		for (const auto& write : passes_[writer].writes)
+		{
+			if (write.version != static_cast<RenderResource>(version)) continue;
+			access = write.access;
+			return true;
+		}
+		return false;
+	};
+	std::vector<bool> cleared(resources_.size(), false);
+	barrier_count_ = 0;
+	clear_count_ = 0;
+	for (const std::size_t index : order_)
+	{
+		auto& pass = passes_[index];
+		pass.barriers = 0;
+		RenderAccessEnum access;
+		for (const auto& read : pass.reads)
+		{
+			if (write_access(static_cast<int>(read.version), access) &&
+				IsIncoherent(access))
+			{
+				pass.barriers |= GetBarrierBits(read.access);
+			}
+		}
+		for (const auto& write : pass.writes)
+		{
+			if (write_access(versions_[write.version].previous, access) &&
+				IsIncoherent(access))
+			{
+				pass.barriers |= GetBarrierBits(write.access);
+			}
+		}
+		if (pass.barriers) ++barrier_count_;
+
+		std::vector<std::size_t> colors;
+		int depth = -1;
+		auto attach = [this, &colors, &depth](const Access& entry) {
+			if (!IsAttachment(entry.access)) return;
+			const std::size_t resource = versions_[entry.version].resource;
+			if (entry.access == RenderAccessEnum::DEPTH_ATTACHMENT)
+			{
+				depth = static_cast<int>(resource);
+			}
+			else if (std::find(colors.begin(), colors.end(), resource) ==
+				colors.end())
+			{
+				colors.push_back(resource);
+			}
+		};
+		for (const auto& read : pass.reads) attach(read);
+		for (const auto& write : pass.writes) attach(write);
+		pass.has_attachments = !colors.empty() || depth >= 0;
+		pass.clears.clear();
+		if (!pass.has_attachments) continue;
+
+		const auto& first = resources_[colors.empty() ? depth : colors.front()];
+		pass.viewport = glm::ivec2(first.desc.width, first.desc.height);
+		const bool backbuffer = std::any_of(
+			colors.begin(),
+			colors.end(),
+			[this](std::size_t resource) {
+				return resources_[resource].is_backbuffer;
+			});
+		if (backbuffer)
+		{
+			if (colors.size() > 1 || depth >= 0)
+			{
+				throw std::runtime_error(
+					"Pass " + pass.name +
+					" mixes the backbuffer with other attachments.");
+			}
+			pass.framebuffer = 0;
+		}
+		else
+		{
+			std::vector<GLuint> ids;
+			for (const std::size_t resource : colors)
+			{
+				ids.push_back(RenderPassContext(*this).GetTexture(
+					resources_[resource].latest));
+			}
+			const GLuint depth_id = depth < 0 ? 0 :
+				RenderPassContext(*this).GetTexture(resources_[depth].latest);
+			pass.framebuffer = GetFramebuffer(
+				ids,
+				depth_id,
+				depth >= 0 && IsStencilFormat(resources_[depth].desc.format));
+		}
+
+		// Only the first writer clears, and only if asked.
+		for (const auto& write : pass.writes)
+		{
+			if (!IsAttachment(write.access)) continue;
+			const std::size_t resource = versions_[write.version].resource;
+			const auto& node = resources_[resource];
+			if (cleared[resource] || node.imported || !node.desc.clear) continue;
+			cleared[resource] = true;
+			const auto it = std::find(colors.begin(), colors.end(), resource);
+			pass.clears.push_back({
+				resource,
+				it == colors.end() ? -1 : static_cast<GLint>(it - colors.begin()) });
+			++clear_count_;
+		}
+	}
+	compiled_ = true;
+}
+
+void RenderGraph::AssignPhysicalTextures()
+{
+	for (auto& physical : physical_textures_)
+	{
+		physical.busy_until = -1;
+		physical.used = false;
+	}
+	std::vector<std::size_t> transients;
+	for (std::size_t i = 0; i < resources_.size(); ++i)
+	{
+		const auto& node = resources_[i];
+		if (node.imported || node.is_buffer || node.first_use < 0) continue;
+		transients.push_back(i);
+	}
+	std::sort(
+		transients.begin(),
+		transients.end(),
+		[this](std::size_t a, std::size_t b) {
+			return resources_[a].first_use < resources_[b].first_use;
+		});
+
+	virtual_bytes_ = 0;
+	for (const std::size_t index : transients)
+	{
+		auto& node = resources_[index];
+		virtual_bytes_ += node.bytes;
+		auto it = std::find_if(
+			physical_textures_.begin(),
+			physical_textures_.end(),
+			[this, &node](const PhysicalTexture& physical) {
+				if (!IsSameTexture(physical.desc, node.desc)) return false;
+				return aliasing_ ?
+					physical.busy_until < node.first_use :
+					!physical.used;
+			});
+		if (it == physical_textures_.end())
+		{
+			PhysicalTexture physical;
+			physical.desc = node.desc;
+			physical.bytes = node.bytes;
+			physical.texture.Create("RenderGraph " + node.name);
+			physical.texture.SetBytes(physical.bytes);
+			glBindTexture(GL_TEXTURE_2D, physical.texture.Get());
+			glTexStorage2D(
+				GL_TEXTURE_2D,
+				node.desc.levels,
+				node.desc.format,
+				node.desc.width,
+				node.desc.height);
+			const GLint filter =
+				IsDepthFormat(node.desc.format) ? GL_NEAREST : GL_LINEAR;
+			glTexParameteri(
+				GL_TEXTURE_2D,
+				GL_TEXTURE_MIN_FILTER,
+				node.desc.levels > 1 ? GL_LINEAR_MIPMAP_NEAREST : filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			IsError(__FILE__, __LINE__);
+			physical_textures_.push_back(std::move(physical));
+			it = physical_textures_.end() - 1;
+		}
+		it->busy_until = node.last_use;
+		it->used = true;
+		node.physical = static_cast<int>(it - physical_textures_.begin());
+	}
+
+	// Textures this frame didn't need go, the framebuffers pointing at
+	// them too as GL may hand the names out again.
+	const bool all_used = std::all_of(
+		physical_textures_.begin(),
+		physical_textures_.end(),
+		[](const PhysicalTexture& physical) { return physical.used; });
+	if (!all_used)
+	{
+		std::vector<int> remap(physical_textures_.size(), -1);
+		std::vector<PhysicalTexture> kept;
+		for (std::size_t i = 0; i < physical_textures_.size(); ++i)
+		{
+			if (!physical_textures_[i].used) continue;
+			remap[i] = static_cast<int>(kept.size());
+			kept.push_back(std::move(physical_textures_[i]));
+		}
+		framebuffers_.clear();
+		physical_textures_ = std::move(kept);
+		for (const std::size_t index : transients)
+		{
+			resources_[index].physical = remap[resources_[index].physical];
+		}
+	}
+	physical_bytes_ = 0;
+	for (const auto& physical : physical_textures_)
+	{
+		physical_bytes_ += physical.bytes;
+	}
+}
+
+GLuint RenderGraph::GetFramebuffer(
+	const std::vector<GLuint>& colors,
+	GLuint depth,
+	bool stencil)
+{
+	std::vector<GLuint> key = colors;
+	key.push_back(depth);
+	auto it = framebuffers_.find(key);
+	if (it != framebuffers_.end()) return it->second.Get();
+
+	FramebufferHandle framebuffer("RenderGraph framebuffer");
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.Get());
+	std::vector<GLenum> draw_buffers;
+	for (std::size_t i = 0; i < colors.size(); ++i)
+	{
+		const auto attachment = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i);
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			attachment,
+			GL_TEXTURE_2D,
+			colors[i],
+			0);
+		draw_buffers.push_back(attachment);
+	}
+	if (depth)
+	{
+		glFramebufferTexture2D(
+			GL_FRAMEBUFFER,
+			stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+			GL_TEXTURE_2D,
+			depth,
+			0);
+	}
+	if (draw_buffers.empty())
+	{
+		// Depth only.
+		const GLenum none = GL_NONE;
+		glDrawBuffers(1, &none);
+		glReadBuffer(GL_NONE);
+	}
+	else
+	{
+		glDrawBuffers(
+			static_cast<GLsizei>(draw_buffers.size()),
+			draw_buffers.data());
+	}
+	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		throw std::runtime_error(
+			"Render graph framebuffer incomplete: " + std::to_string(status));
+	}
+	IsError(__FILE__, __LINE__);
+	const GLuint id = framebuffer.Get();
+	framebuffers_.emplace(std::move(key), std::move(framebuffer));
+	return id;
+}
+
+void RenderGraph::Execute()
+{
+	if (!compiled_) Compile();
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	// Graph framebuffers are never 0, passes on the backbuffer get this.
+	GLint backbuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &backbuffer);
+	const RenderPassContext context(*this);
+	for (const std::size_t index : order_)
+	{
+		const auto& pass = passes_[index];
+		if (pass.barriers) glMemoryBarrier(pass.barriers);
+		if (pass.has_attachments)
+		{
+			glBindFramebuffer(
+				GL_FRAMEBUFFER,
+				pass.framebuffer ? pass.framebuffer : backbuffer);
+			glViewport(0, 0, pass.viewport.x, pass.viewport.y);
+		}
+		for (const auto& [resource, draw_buffer] : pass.clears)
+		{
+			const auto& desc = resources_[resource].desc;
+			if (draw_buffer < 0)
+			{
+				glDepthMask(GL_TRUE);
+				glClearBufferfv(GL_DEPTH, 0, &desc.clear_depth);
+			}
+			else
+			{
+				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+				glClearBufferfv(GL_COLOR, draw_buffer, &desc.clear_color[0]);
+			}
+		}
+		pass.execute(context);
+		IsError(__FILE__, __LINE__);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, backbuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void RenderGraph::Reset()
+{
+	resources_.clear();
+	versions_.clear();
+	passes_.clear();
+	order_.clear();
+	compiled_ = false;
+}
+
+void RenderGraph::Destroy()
+{
+	Reset();
+	framebuffers_.clear();
+	physical_textures_.clear();
+	virtual_bytes_ = 0;
+	physical_bytes_ = 0;
+}
+
+void RenderGraph::DrawImGui()
+{
+	if (!ImGui::CollapsingHeader("Render graph")) return;
+	ImGui::Checkbox("Alias transient targets", &aliasing_);
+	ImGui::Text(
+		"Passes: %zu run, %zu culled, %zu barriers, %zu clears",
+		order_.size(),
+		passes_.size() - order_.size(),
+		barrier_count_,
+		clear_count_);
+	ImGui::Text(
+		"Transients: %.2f MB in %zu textures, %.2f MB unaliased (%.0f%% saved)",
+		ToMegabytes(physical_bytes_),
+		physical_textures_.size(),
+		ToMegabytes(virtual_bytes_),
+		virtual_bytes_ ?
+			100.0 * (1.0 - static_cast<double>(physical_bytes_) / virtual_bytes_) :
+			0.0);
+
+	auto version_name = [this](RenderResource version) {
+		return resources_[versions_[version].resource].name;
+	};
+	for (std::size_t position = 0; position < order_.size(); ++position)
+	{
+		const auto& pass = passes_[order_[position]];
+		std::string reads;
+		for (const auto& read : pass.reads)
+		{
+			reads += (reads.empty() ? "" : ", ") + version_name(read.version);
+		}
+		std::string writes;
+		for (const auto& write : pass.writes)
+		{
+			writes += (writes.empty() ? "" : ", ") + version_name(write.version);
+		}
+		ImGui::BulletText(
+			"%zu. %s%s: %s -> %s",
+			position,
+			pass.name.c_str(),
+			pass.barriers ? " (barrier)" : "",
+			reads.empty() ? "-" : reads.c_str(),
+			writes.empty() ? "-" : writes.c_str());
+	}
+	for (const auto& pass : passes_)
+	{
+		if (!pass.culled) continue;
+		ImGui::TextColored(
+			ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
+			"  %s (culled)",
+			pass.name.c_str());
+	}
+
+	// Lifetimes: a bar per transient over the passes using it, colored by
+	// the texture it got, bars of one color never overlap.
+	if (order_.empty()) return;
+	const float row_height = 18.0f;
+	const float label_width = 160.0f;
+	const float width = std::max(
+		ImGui::GetContentRegionAvail().x - label_width,
+		static_cast<float>(order_.size()) * 8.0f);
+	const float column = width / static_cast<float>(order_.size());
+	ImDrawList* draw_list = ImGui::GetWindowDrawList();
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	std::size_t rows = 0;
+	for (const auto& node : resources_)
+	{
+		if (node.imported || node.physical < 0) continue;
+		const float y = origin.y + rows * row_height;
+		const std::string label =
+			node.name + " #" + std::to_string(node.physical);
+		draw_list->AddText(
+			ImVec2(origin.x, y),
+			IM_COL32(255, 255, 255, 255),
+			label.c_str());
+		const unsigned hue = static_cast<unsigned>(node.physical) * 97u;
+		draw_list->AddRectFilled(
+			ImVec2(origin.x + label_width + node.first_use * column, y + 2.0f),
+			ImVec2(
+				origin.x + label_width + (node.last_use + 1) * column - 2.0f,
+				y + row_height - 2.0f),
+			IM_COL32(
+				80 + hue % 160,
+				80 + (hue * 3) % 160,
+				80 + (hue * 7) % 160,
+				255));
+		++rows;
+	}
+	ImGui::Dummy(ImVec2(label_width + width, rows * row_height));
+}
+
+} // End namespace gl.
@@ -0,0 +1,373 @@
+#include <render_queue.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "gpu_backend.h"
+#include "imgui.h"
+#include "simd_math.h"
+
+namespace gl {
+
+void RenderQueue::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void RenderQueue::Init(const std::string& path)
+{
+	depth_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/common/depth_only.vert",
+		path + "data/shaders/common/depth_only.frag");
+	overdraw_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/common/depth_only.vert",
+		path + "data/shaders/common/overdraw.frag");
+	heatmap_shader_ = std::make_unique<Shader>(
+		path + "data/shaders/common/fullscreen.vert",
+		path + "data/shaders/common/overdraw_heatmap.frag");
+	// Core profile needs a VAO bound even for attribute-less draws.
+	empty_vao_.Create("RenderQueue empty vertex array");
+	IsError(__FILE__, __LINE__);
+}
+
+void RenderQueue::Destroy()
+{
+	empty_vao_.Reset();
+	overdraw_fbo_.Reset();
+	overdraw_color_.Reset();
+	overdraw_depth_.Reset();
+	overdraw_size_ = glm::ivec2(0);
+	depth_shader_.reset();
+	overdraw_shader_.reset();
+	heatmap_shader_.reset();
+}
+
+DepthStream RenderQueue::CreateDepthStream(
+	const std::vector<float>& vertices,
+	int stride_floats,
+	unsigned int ebo) const
+{
+	std::vector<glm::vec3> positions;
+	positions.reserve(vertices.size() / stride_floats);
+	for (std::size_t i = 0; i + 2 < vertices.size(); i += stride_floats)
+	{
+		positions.emplace_back(vertices[i], vertices[i + 1], vertices[i + 2]);
+	}
+	return CreateDepthStream(positions, ebo);
+}
+
+DepthStream RenderQueue::CreateDepthStream(
+	const std::vector<glm::vec3>& positions,
+	unsigned int ebo) const
+{
+	const GpuBackend& backend = GpuBackend::GetInstance();
+	DepthStream stream;
+	stream.vao.Create("Depth stream vertex array");
+	IsError(__FILE__, __LINE__);
+	stream.vbo.Create("Depth stream positions");
+	stream.vbo.SetBytes(positions.size() * sizeof(glm::vec3));
+	backend.AllocateBuffer(
+		stream.vbo.Get(),
+		positions.size() * sizeof(glm::vec3),
+		positions.data(),
+		0);
+	IsError(__FILE__, __LINE__);
+	backend.SetIndexBuffer(stream.vao.Get(), ebo);
+	backend.SetVertexAttribute(
+		stream.vao.Get(),
+		0,
+		stream.vbo.Get(),
+		3,
+		GL_FLOAT,
+		sizeof(glm::vec3),
+		0);
+	IsError(__FILE__, __LINE__);
+	return stream;
+}
+
+void RenderQueue::DestroyDepthStream(DepthStream& stream) const
+{
+	stream.vao.Reset();
+	stream.vbo.Reset();
+}
+
+void RenderQueue::Submit(const DrawItem& item)
+{
+	items_.push_back(item);
+}
+
+void RenderQueue::ResizeOverdrawTarget(int width, int height)
+{
+	if (overdraw_size_ == glm::ivec2(width, height)) return;
+	overdraw_size_ = glm::ivec2(width, height);
+	if (!overdraw_fbo_)
+	{
+		overdraw_fbo_.Create("Overdraw framebuffer");
+		overdraw_color_.Create("Overdraw counts");
+		overdraw_depth_.Create("Overdraw depth");
+		IsError(__FILE__, __LINE__);
+	}
+	overdraw_color_.SetBytes(EstimateTextureBytes(GL_RGBA8, width, height, 1, 1));
+	glBindTexture(GL_TEXTURE_2D, overdraw_color_.Get());
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		0,
+		GL_RGBA8,
+		width,
+		height,
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+	overdraw_depth_.SetBytes(
+		EstimateTextureBytes(GL_DEPTH_COMPONENT24, width, height, 1, 1));
+	glBindRenderbuffer(GL_RENDERBUFFER, overdraw_depth_.Get());
+	glRenderbufferStorage(
+		GL_RENDERBUFFER,
+		GL_DEPTH_COMPONENT24,
+		width,
+		height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	IsError(__FILE__, __LINE__);
+	glBindFramebuffer(GL_FRAMEBUFFER, overdraw_fbo_.Get());
+	glFramebufferTexture2D(
+		GL_FRAMEBUFFER,
+		GL_COLOR_ATTACHMENT0,
+		GL_TEXTURE_2D,
+		overdraw_color_.Get(),
+		0);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_DEPTH_ATTACHMENT,
+		GL_RENDERBUFFER,
+		overdraw_depth_.Get());
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		throw std::runtime_error("Overdraw framebuffer is incomplete.");
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	IsError(__FILE__, __LINE__);
+	overdraw_pixels_.resize(static_cast<std::size_t>(width) * height * 4);
+}
+
+void RenderQueue::DepthPrepass(
+	const glm::mat4& view,
+	const glm::mat4& projection)
+{
+	depth_shader_->Use();
+	depth_shader_->SetMat4("view", view);
+	depth_shader_->SetMat4("projection", projection);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	IsError(__FILE__, __LINE__);
+	for (const auto& sorted : sorted_)
+	{
+		const DrawItem& item = items_[sorted.index];
+		depth_shader_->SetMat4("model", item.model);
+		glBindVertexArray(item.depth_vao ? item.depth_vao : item.vao);
+		glDrawElements(GL_TRIANGLES, item.index_count, GL_UNSIGNED_INT, 0);
+	}
+	IsError(__FILE__, __LINE__);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	// Only fragments matching the pre-pass depth get shaded. Both vertex
+	// shaders declare gl_Position invariant, LEQUAL still forgives a last
+	// bit of difference between the two programs.
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+	IsError(__FILE__, __LINE__);
+}
+
+void RenderQueue::ShadingPass(const Shader& shader)
+{
+	const GpuBackend& backend = GpuBackend::GetInstance();
+	unsigned int bound_texture = 0;
+	for (const auto& sorted : sorted_)
+	{
+		const DrawItem& item = items_[sorted.index];
+		if (item.texture && item.texture != bound_texture)
+		{
+			backend.BindTexture(0, GL_TEXTURE_2D, item.texture);
+			bound_texture = item.texture;
+		}
+		shader.SetMat4("model", item.model);
+		shader.SetMat4("model_inverse", normal_matrices_[sorted.index]);
+		glBindVertexArray(item.vao);
+		glDrawElements(GL_TRIANGLES, item.index_count, GL_UNSIGNED_INT, 0);
+	}
+	IsError(__FILE__, __LINE__);
+}
+
+void RenderQueue::Flush(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const Shader& shader)
+{
+	// Sort on view space depth of the object origin, nearest first so the
+	// early depth test rejects as much as possible.
+	sorted_.resize(items_.size());
+	models_.resize(items_.size());
+	for (std::size_t i = 0; i < items_.size(); ++i)
+	{
+		const glm::vec4 view_pos = view * items_[i].model[3];
+		sorted_[i] = { -view_pos.z, i };
+		models_[i] = items_[i].model;
+	}
+	normal_matrices_.resize(items_.size());
+	ComputeNormalMatrices(models_, normal_matrices_);
+	if (sort_front_to_back)
+	{
+		std::sort(
+			sorted_.begin(),
+			sorted_.end(),
+			[](const SortedItem& a, const SortedItem& b) {
+				return a.depth < b.depth;
+			});
+	}
+
+	const bool heatmap = overdraw_mode == OverdrawModeEnum::HEATMAP;
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	// The engine's scene target when post-processing, not always 0.
+	GLint target_framebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target_framebuffer);
+	if (heatmap)
+	{
+		ResizeOverdrawTarget(viewport[2], viewport[3]);
+		glBindFramebuffer(GL_FRAMEBUFFER, overdraw_fbo_.Get());
+		glViewport(0, 0, viewport[2], viewport[3]);
+		GLfloat clear_color[4];
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClearColor(
+			clear_color[0],
+			clear_color[1],
+			clear_color[2],
+			clear_color[3]);
+		IsError(__FILE__, __LINE__);
+	}
+
+	glEnable(GL_DEPTH_TEST);
+	if (depth_prepass)
+	{
+		DepthPrepass(view, projection);
+	}
+	else
+	{
+		glDepthFunc(GL_LESS);
+	}
+
+	if (heatmap)
+	{
+		// Every shaded fragment adds 1/255 to the red channel.
+		overdraw_shader_->Use();
+		overdraw_shader_->SetMat4("view", view);
+		overdraw_shader_->SetMat4("projection", projection);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		for (const auto& sorted : sorted_)
+		{
+			const DrawItem& item = items_[sorted.index];
+			overdraw_shader_->SetMat4("model", item.model);
+			glBindVertexArray(item.vao);
+			glDrawElements(GL_TRIANGLES, item.index_count, GL_UNSIGNED_INT, 0);
+		}
+		glDisable(GL_BLEND);
+		IsError(__FILE__, __LINE__);
+	}
+	else
+	{
+		shader.Use();
+		ShadingPass(shader);
+	}
+
+	// Restore default depth state, glClear ignores a disabled depth mask.
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glBindVertexArray(0);
+	IsError(__FILE__, __LINE__);
+
+	if (heatmap)
+	{
+		MeasureOverdraw();
+		glBindFramebuffer(GL_FRAMEBUFFER, target_framebuffer);
+		glDisable(GL_DEPTH_TEST);
+		heatmap_shader_->Use();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, overdraw_color_.Get());
+		heatmap_shader_->SetInt("overdraw", 0);
+		glBindVertexArray(empty_vao_.Get());
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+		glEnable(GL_DEPTH_TEST);
+		IsError(__FILE__, __LINE__);
+	}
+
+	last_draw_count_ = items_.size();
+	items_.clear();
+}
+
+void RenderQueue::MeasureOverdraw()
+{
+	// Stalls on the GPU, only done while the heat map is shown.
+	glReadPixels(
+		0,
+		0,
+		overdraw_size_.x,
+		overdraw_size_.y,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		overdraw_pixels_.data());
+	IsError(__FILE__, __LINE__);
+	std::uint64_t total = 0;
+	std::uint64_t covered = 0;
+	int max_count = 0;
+	for (std::size_t i = 0; i < overdraw_pixels_.size(); i += 4)
+	{
+		const int count = overdraw_pixels_[i];
+		total += count;
+		covered += count ? 1 : 0;
+		max_count = std::max(max_count, count);
+	}
+	const std::uint64_t pixels =
+		static_cast<std::uint64_t>(overdraw_size_.x) * overdraw_size_.y;
+	fragments_per_pixel_ = pixels ? static_cast<float>(total) / pixels : 0.0f;
+	fragments_per_covered_pixel_ =
+		covered ? static_cast<float>(total) / covered : 0.0f;
+	max_fragments_ = max_count;
+}
+
+void RenderQueue::DrawImGui()
+{
+	ImGui::Checkbox("Depth pre-pass", &depth_prepass);
+	ImGui::Checkbox("Sort front to back", &sort_front_to_back);
+	bool heatmap = overdraw_mode == OverdrawModeEnum::HEATMAP;
+	if (ImGui::Checkbox("Overdraw heat map", &heatmap))
+	{
+		overdraw_mode =
+			heatmap ? OverdrawModeEnum::HEATMAP : OverdrawModeEnum::NONE;
+	}
+	ImGui::Text("Opaque draws: %zu", last_draw_count_);
+	if (heatmap)
+	{
+		ImGui::Text("Shaded fragments / pixel: %.3f", fragments_per_pixel_);
+		ImGui::Text(
+			"Shaded fragments / covered pixel: %.3f",
+			fragments_per_covered_pixel_);
+		ImGui::Text("Max fragments on a pixel: %d", max_fragments_);
+	}
+}
+
+} // End namespace gl.
@@ -0,0 +1,328 @@
+#include <simd_math.h>
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#include <intrin.h>
+#define GL_SIMD_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+#define GL_SIMD_X86 1
+#endif
+
+namespace gl {
+
+namespace {
+
+	void ComposeTransformsScalar(
+		const glm::vec3* positions,
+		const glm::quat* rotations,
+		const glm::vec3* scales,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			glm::mat4 model = glm::mat4_cast(rotations[i]);
+			model[0] *= scales[i].x;
+			model[1] *= scales[i].y;
+			model[2] *= scales[i].z;
+			model[3] = glm::vec4(positions[i], 1.0f);
+			out[i] = model;
+		}
+	}
+
+	void MultiplyMatricesScalar(
+		const glm::mat4* left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out[i] = left[i] * right[i];
+		}
+	}
+
+	void MultiplyMatrixScalar(
+		const glm::mat4& left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		// Left may be in out.
+		const glm::mat4 copy = left;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out[i] = copy * right[i];
+		}
+	}
+
+	void InverseAffineScalar(
+		const glm::mat4* matrices,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out[i] = glm::affineInverse(matrices[i]);
+		}
+	}
+
+	void NormalMatricesScalar(
+		const glm::mat4* models,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out[i] = glm::mat4(glm::inverseTranspose(glm::mat3(models[i])));
+		}
+	}
+
+	void TransformAabbsScalar(
+		const glm::mat4* transforms,
+		const Aabb* boxes,
+		Aabb* out,
+		std::size_t count)
+	{
+		// Center and half extent, the extent of the result sums the
+		// absolute values of the matrix (Arvo).
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const glm::mat4& m = transforms[i];
+			const glm::vec3 center = (boxes[i].min + boxes[i].max) * 0.5f;
+			const glm::vec3 extent = (boxes[i].max - boxes[i].min) * 0.5f;
+			const glm::vec3 new_center = glm::vec3(m * glm::vec4(center, 1.0f));
+			const glm::vec3 new_extent =
+				glm::abs(glm::vec3(m[0])) * extent.x +
+				glm::abs(glm::vec3(m[1])) * extent.y +
+				glm::abs(glm::vec3(m[2])) * extent.z;
+			out[i] = { new_center - new_extent, new_center + new_extent };
+		}
+	}
+
+	void SlerpScalar(
+		const glm::quat* from,
+		const glm::quat* to,
+		float t,
+		glm::quat* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			out[i] = glm::slerp(from[i], to[i], t);
+		}
+	}
+
+	const SimdKernels* GetKernels(SimdLevelEnum level)
+	{
+		switch (level)
+		{
+		case SimdLevelEnum::AVX512: return GetAvx512Kernels();
+		case SimdLevelEnum::AVX2: return GetAvx2Kernels();
+		case SimdLevelEnum::SSE4: return GetSse4Kernels();
+		case SimdLevelEnum::SCALAR:
+		default:
+			return &GetScalarKernels();
+		}
+	}
+
+	SimdLevelEnum DetectSimdLevel()
+	{
+#if defined(GL_SIMD_X86) && defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		const int max_leaf = info[0];
+		__cpuid(info, 1);
+		const bool sse4 = (info[2] & (1 << 19)) != 0;
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		// The OS has to save the wide registers too.
+		const bool os_xsave = (info[2] & (1 << 27)) != 0;
+		const unsigned long long xcr0 = os_xsave ? _xgetbv(0) : 0;
+		const bool os_avx = (xcr0 & 0x6) == 0x6;
+		const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+		bool avx2 = false;
+		bool avx512 = false;
+		if (max_leaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+			avx512 = (info[1] & (1 << 16)) != 0;
+		}
+		if (avx512 && avx2 && fma && os_avx512) return SimdLevelEnum::AVX512;
+		if (avx2 && fma && os_avx) return SimdLevelEnum::AVX2;
+		if (sse4) return SimdLevelEnum::SSE4;
+#elif defined(GL_SIMD_X86)
+		// Checks the OS support of the wide registers as well.
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f") &&
+			__builtin_cpu_supports("avx2") &&
+			__builtin_cpu_supports("fma"))
+		{
+			return SimdLevelEnum::AVX512;
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return SimdLevelEnum::AVX2;
+		}
+		if (__builtin_cpu_supports("sse4.1")) return SimdLevelEnum::SSE4;
+#endif
+		return SimdLevelEnum::SCALAR;
+	}
+
+	// The widest level both the CPU has and was built.
+	SimdLevelEnum ClampToSupported(SimdLevelEnum level)
+	{
+		static const SimdLevelEnum cpu_level = DetectSimdLevel();
+		if (level > cpu_level) level = cpu_level;
+		while (level != SimdLevelEnum::SCALAR && !GetKernels(level))
+		{
+			level = static_cast<SimdLevelEnum>(static_cast<int>(level) - 1);
+		}
+		return level;
+	}
+
+	std::atomic<SimdLevelEnum>& CurrentLevel()
+	{
+		static std::atomic<SimdLevelEnum> level(
+			ClampToSupported(SimdLevelEnum::AVX512));
+		return level;
+	}
+
+	const SimdKernels& Kernels()
+	{
+		return *GetKernels(CurrentLevel().load(std::memory_order_relaxed));
+	}
+
+	void CheckSizes(std::size_t expected, std::size_t size, const char* function)
+	{
+		if (size != expected)
+		{
+			throw std::runtime_error(
+				std::string(function) + ": spans of different sizes.");
+		}
+	}
+
+} // End anonymous namespace.
+
+const SimdKernels& GetScalarKernels()
+{
+	static const SimdKernels kernels = {
+		ComposeTransformsScalar,
+		MultiplyMatricesScalar,
+		MultiplyMatrixScalar,
+		InverseAffineScalar,
+		NormalMatricesScalar,
+		TransformAabbsScalar,
+		SlerpScalar,
+	};
+	return kernels;
+}
+
+SimdLevelEnum GetSupportedSimdLevel()
+{
+	return ClampToSupported(SimdLevelEnum::AVX512);
+}
+
+SimdLevelEnum GetSimdLevel()
+{
+	return CurrentLevel().load(std::memory_order_relaxed);
+}
+
+void SetSimdLevel(SimdLevelEnum level)
+{
+	CurrentLevel().store(ClampToSupported(level), std::memory_order_relaxed);
+}
+
+const char* GetSimdLevelName(SimdLevelEnum level)
+{
+	switch (level)
+	{
+	case SimdLevelEnum::AVX512: return "AVX-512";
+	case SimdLevelEnum::AVX2: return "AVX2";
+	case SimdLevelEnum::SSE4: return "SSE4.1";
+	case SimdLevelEnum::SCALAR:
+	default:
+		return "Scalar";
+	}
+}
+
+void ComposeTransforms(
+	std::span<const glm::vec3> positions,
+	std::span<const glm::quat> rotations,
+	std::span<const glm::vec3> scales,
+	std::span<glm::mat4> out)
+{
+	CheckSizes(out.size(), positions.size(), "ComposeTransforms");
+	CheckSizes(out.size(), rotations.size(), "ComposeTransforms");
+	CheckSizes(out.size(), scales.size(), "ComposeTransforms");
+	Kernels().compose_transforms(
+		positions.data(),
+		rotations.data(),
+		scales.data(),
+		out.data(),
+		out.size());
+}
+
+void MultiplyMatrices(
+	std::span<const glm::mat4> left,
+	std::span<const glm::mat4> right,
+	std::span<glm::mat4> out)
+{
+	CheckSizes(out.size(), left.size(), "MultiplyMatrices");
+	CheckSizes(out.size(), right.size(), "MultiplyMatrices");
+	Kernels().multiply_matrices(left.data(), right.data(), out.data(), out.size());
+}
+
+void MultiplyMatrices(
+	const glm::mat4& left,
+	std::span<const glm::mat4> right,
+	std::span<glm::mat4> out)
+{
+	CheckSizes(out.size(), right.size(), "MultiplyMatrices");
+	Kernels().multiply_matrix(left, right.data(), out.data(), out.size());
+}
+
+void InverseAffineMatrices(
+	std::span<const glm::mat4> matrices,
+	std::span<glm::mat4> out)
+{
+	CheckSizes(out.size(), matrices.size(), "InverseAffineMatrices");
+	Kernels().inverse_affine(matrices.data(), out.data(), out.size());
+}
+
+void ComputeNormalMatrices(
+	std::span<const glm::mat4> models,
+	std::span<glm::mat4> out)
+{
+	CheckSizes(out.size(), models.size(), "ComputeNormalMatrices");
+	Kernels().normal_matrices(models.data(), out.data(), out.size());
+}
+
+void TransformAabbs(
+	std::span<const glm::mat4> transforms,
+	std::span<const Aabb> boxes,
+	std::span<Aabb> out)
+{
+	CheckSizes(out.size(), transforms.size(), "TransformAabbs");
+	CheckSizes(out.size(), boxes.size(), "TransformAabbs");
+	Kernels().transform_aabbs(transforms.data(), boxes.data(), out.data(), out.size());
+}
+
+void SlerpQuaternions(
+	std::span<const glm::quat> from,
+	std::span<const glm::quat> to,
+	float t,
+	std::span<glm::quat> out)
+{
+	CheckSizes(out.size(), from.size(), "SlerpQuaternions");
+	CheckSizes(out.size(), to.size(), "SlerpQuaternions");
+	Kernels().slerp(from.data(), to.data(), t, out.data(), out.size());
+}
+
+} // End namespace gl.
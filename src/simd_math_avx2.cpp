@@ -0,0 +1,183 @@
+#include <simd_math.h>
+
+// Built with AVX2 and FMA enabled (CMakeLists.txt).
+#if defined(__AVX2__)
+#define GL_SIMD_AVX2 1
+#include <immintrin.h>
+
+#include "simd_kernels.h"
+#endif
+
+namespace gl {
+
+#if defined(GL_SIMD_AVX2)
+
+namespace {
+
+	struct Avx2
+	{
+		using Type = __m256;
+		using Mask = __m256;
+		static constexpr std::size_t WIDTH = 8;
+
+		static Type Set1(float value) { return _mm256_set1_ps(value); }
+		static Type Zero() { return _mm256_setzero_ps(); }
+		static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+		static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+		static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+		static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+		static Type FMAdd(Type a, Type b, Type c) { return _mm256_fmadd_ps(a, b, c); }
+		static Type Abs(Type a)
+		{
+			return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+		}
+		static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+		static Mask Less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static Mask Greater(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		static Type Select(Type if_false, Type if_true, Mask mask)
+		{
+			return _mm256_blendv_ps(if_false, if_true, mask);
+		}
+		template <int I0, int I1, int I2, int I3>
+		static Type Shuffle(Type a, Type b)
+		{
+			return _mm256_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+		}
+		template <int K>
+		static Type Splat(Type a)
+		{
+			return _mm256_permute_ps(a, _MM_SHUFFLE(K, K, K, K));
+		}
+		static void Transpose4(Type& a, Type& b, Type& c, Type& d)
+		{
+			const Type ab_low = _mm256_unpacklo_ps(a, b);
+			const Type cd_low = _mm256_unpacklo_ps(c, d);
+			const Type ab_high = _mm256_unpackhi_ps(a, b);
+			const Type cd_high = _mm256_unpackhi_ps(c, d);
+			a = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(1, 0, 1, 0));
+			b = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(3, 2, 3, 2));
+			c = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(1, 0, 1, 0));
+			d = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+		template <std::size_t STRIDE>
+		static Type LoadGroups(const float* p)
+		{
+			if constexpr (STRIDE == 4)
+			{
+				return _mm256_loadu_ps(p);
+			}
+			else
+			{
+				return _mm256_insertf128_ps(
+					_mm256_castps128_ps256(_mm_loadu_ps(p)),
+					_mm_loadu_ps(p + STRIDE),
+					1);
+			}
+		}
+		template <std::size_t STRIDE>
+		static void StoreGroups(float* p, Type value)
+		{
+			if constexpr (STRIDE == 4)
+			{
+				_mm256_storeu_ps(p, value);
+			}
+			else
+			{
+				_mm_storeu_ps(p, _mm256_castps256_ps128(value));
+				_mm_storeu_ps(p + STRIDE, _mm256_extractf128_ps(value, 1));
+			}
+		}
+	};
+
+	using Kernels = WideKernels<Avx2>;
+
+	// Two columns of the product per register, the left columns in both
+	// halves and each half weighted by its own column of the right one.
+	void MultiplyColumns(
+		const __m256 (&left)[4],
+		const float* right,
+		float* out)
+	{
+		const __m256 right_01 = _mm256_loadu_ps(right);
+		const __m256 right_23 = _mm256_loadu_ps(right + 8);
+		__m256 out_01 = _mm256_mul_ps(left[0], _mm256_permute_ps(right_01, 0x00));
+		__m256 out_23 = _mm256_mul_ps(left[0], _mm256_permute_ps(right_23, 0x00));
+		out_01 = _mm256_fmadd_ps(left[1], _mm256_permute_ps(right_01, 0x55), out_01);
+		out_23 = _mm256_fmadd_ps(left[1], _mm256_permute_ps(right_23, 0x55), out_23);
+		out_01 = _mm256_fmadd_ps(left[2], _mm256_permute_ps(right_01, 0xAA), out_01);
+		out_23 = _mm256_fmadd_ps(left[2], _mm256_permute_ps(right_23, 0xAA), out_23);
+		out_01 = _mm256_fmadd_ps(left[3], _mm256_permute_ps(right_01, 0xFF), out_01);
+		out_23 = _mm256_fmadd_ps(left[3], _mm256_permute_ps(right_23, 0xFF), out_23);
+		_mm256_storeu_ps(out, out_01);
+		_mm256_storeu_ps(out + 8, out_23);
+	}
+
+	void LoadLeft(const float* left, __m256 (&columns)[4])
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			const __m128 column = _mm_loadu_ps(left + k * 4);
+			columns[k] = _mm256_set_m128(column, column);
+		}
+	}
+
+	void MultiplyMatrices(
+		const glm::mat4* left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			__m256 columns[4];
+			LoadLeft(reinterpret_cast<const float*>(left + i), columns);
+			MultiplyColumns(
+				columns,
+				reinterpret_cast<const float*>(right + i),
+				reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	void MultiplyMatrix(
+		const glm::mat4& left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		__m256 columns[4];
+		LoadLeft(reinterpret_cast<const float*>(&left), columns);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			MultiplyColumns(
+				columns,
+				reinterpret_cast<const float*>(right + i),
+				reinterpret_cast<float*>(out + i));
+		}
+	}
+
+} // End anonymous namespace.
+
+const SimdKernels* GetAvx2Kernels()
+{
+	static const SimdKernels kernels = {
+		Kernels::ComposeTransforms,
+		MultiplyMatrices,
+		MultiplyMatrix,
+		Kernels::InverseAffine,
+		Kernels::NormalMatrices,
+		Kernels::TransformAabbs,
+		Kernels::Slerp,
+	};
+	return &kernels;
+}
+
+#else
+
+const SimdKernels* GetAvx2Kernels()
+{
+	return nullptr;
+}
+
+#endif
+
+} // End namespace gl.
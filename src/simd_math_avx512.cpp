@@ -0,0 +1,173 @@
+#include <simd_math.h>
+
+// Built with AVX-512F, AVX2 and FMA enabled (CMakeLists.txt).
+#if defined(__AVX512F__)
+#define GL_SIMD_AVX512 1
+#include <immintrin.h>
+
+#include "simd_kernels.h"
+#endif
+
+namespace gl {
+
+#if defined(GL_SIMD_AVX512)
+
+namespace {
+
+	struct Avx512
+	{
+		using Type = __m512;
+		using Mask = __mmask16;
+		static constexpr std::size_t WIDTH = 16;
+
+		static Type Set1(float value) { return _mm512_set1_ps(value); }
+		static Type Zero() { return _mm512_setzero_ps(); }
+		static Type Add(Type a, Type b) { return _mm512_add_ps(a, b); }
+		static Type Sub(Type a, Type b) { return _mm512_sub_ps(a, b); }
+		static Type Mul(Type a, Type b) { return _mm512_mul_ps(a, b); }
+		static Type Div(Type a, Type b) { return _mm512_div_ps(a, b); }
+		static Type FMAdd(Type a, Type b, Type c) { return _mm512_fmadd_ps(a, b, c); }
+		static Type Abs(Type a) { return _mm512_abs_ps(a); }
+		static Type Sqrt(Type a) { return _mm512_sqrt_ps(a); }
+		static Mask Less(Type a, Type b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static Mask Greater(Type a, Type b)
+		{
+			return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+		}
+		static Type Select(Type if_false, Type if_true, Mask mask)
+		{
+			return _mm512_mask_blend_ps(mask, if_false, if_true);
+		}
+		template <int I0, int I1, int I2, int I3>
+		static Type Shuffle(Type a, Type b)
+		{
+			return _mm512_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+		}
+		template <int K>
+		static Type Splat(Type a)
+		{
+			return _mm512_permute_ps(a, _MM_SHUFFLE(K, K, K, K));
+		}
+		static void Transpose4(Type& a, Type& b, Type& c, Type& d)
+		{
+			const Type ab_low = _mm512_unpacklo_ps(a, b);
+			const Type cd_low = _mm512_unpacklo_ps(c, d);
+			const Type ab_high = _mm512_unpackhi_ps(a, b);
+			const Type cd_high = _mm512_unpackhi_ps(c, d);
+			a = _mm512_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(1, 0, 1, 0));
+			b = _mm512_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(3, 2, 3, 2));
+			c = _mm512_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(1, 0, 1, 0));
+			d = _mm512_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+		template <std::size_t STRIDE>
+		static Type LoadGroups(const float* p)
+		{
+			if constexpr (STRIDE == 4)
+			{
+				return _mm512_loadu_ps(p);
+			}
+			else
+			{
+				Type value = _mm512_castps128_ps512(_mm_loadu_ps(p));
+				value = _mm512_insertf32x4(value, _mm_loadu_ps(p + STRIDE), 1);
+				value = _mm512_insertf32x4(value, _mm_loadu_ps(p + STRIDE * 2), 2);
+				return _mm512_insertf32x4(value, _mm_loadu_ps(p + STRIDE * 3), 3);
+			}
+		}
+		template <std::size_t STRIDE>
+		static void StoreGroups(float* p, Type value)
+		{
+			if constexpr (STRIDE == 4)
+			{
+				_mm512_storeu_ps(p, value);
+			}
+			else
+			{
+				_mm_storeu_ps(p, _mm512_castps512_ps128(value));
+				_mm_storeu_ps(p + STRIDE, _mm512_extractf32x4_ps(value, 1));
+				_mm_storeu_ps(p + STRIDE * 2, _mm512_extractf32x4_ps(value, 2));
+				_mm_storeu_ps(p + STRIDE * 3, _mm512_extractf32x4_ps(value, 3));
+			}
+		}
+	};
+
+	using Kernels = WideKernels<Avx512>;
+
+	// The whole product in one register: left column k in every group,
+	// each group weighted by its own column of the right one.
+	__m512 MultiplyColumns(const __m512 (&left)[4], const float* right)
+	{
+		const __m512 columns = _mm512_loadu_ps(right);
+		__m512 out = _mm512_mul_ps(left[0], _mm512_permute_ps(columns, 0x00));
+		out = _mm512_fmadd_ps(left[1], _mm512_permute_ps(columns, 0x55), out);
+		out = _mm512_fmadd_ps(left[2], _mm512_permute_ps(columns, 0xAA), out);
+		return _mm512_fmadd_ps(left[3], _mm512_permute_ps(columns, 0xFF), out);
+	}
+
+	void LoadLeft(const float* left, __m512 (&columns)[4])
+	{
+		const __m512 matrix = _mm512_loadu_ps(left);
+		columns[0] = _mm512_shuffle_f32x4(matrix, matrix, 0x00);
+		columns[1] = _mm512_shuffle_f32x4(matrix, matrix, 0x55);
+		columns[2] = _mm512_shuffle_f32x4(matrix, matrix, 0xAA);
+		columns[3] = _mm512_shuffle_f32x4(matrix, matrix, 0xFF);
+	}
+
+	void MultiplyMatrices(
+		const glm::mat4* left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			__m512 columns[4];
+			LoadLeft(reinterpret_cast<const float*>(left + i), columns);
+			_mm512_storeu_ps(
+				reinterpret_cast<float*>(out + i),
+				MultiplyColumns(columns, reinterpret_cast<const float*>(right + i)));
+		}
+	}
+
+	void MultiplyMatrix(
+		const glm::mat4& left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		__m512 columns[4];
+		LoadLeft(reinterpret_cast<const float*>(&left), columns);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			_mm512_storeu_ps(
+				reinterpret_cast<float*>(out + i),
+				MultiplyColumns(columns, reinterpret_cast<const float*>(right + i)));
+		}
+	}
+
+} // End anonymous namespace.
+
+const SimdKernels* GetAvx512Kernels()
+{
+	static const SimdKernels kernels = {
+		Kernels::ComposeTransforms,
+		MultiplyMatrices,
+		MultiplyMatrix,
+		Kernels::InverseAffine,
+		Kernels::NormalMatrices,
+		Kernels::TransformAabbs,
+		Kernels::Slerp,
+	};
+	return &kernels;
+}
+
+#else
+
+const SimdKernels* GetAvx512Kernels()
+{
+	return nullptr;
+}
+
+#endif
+
+} // End namespace gl.
@@ -0,0 +1,153 @@
+#include <simd_math.h>
+
+// Built with SSE4.1 enabled (CMakeLists.txt), x64 MSVC always has it.
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(_M_X64))
+#define GL_SIMD_SSE4 1
+#include <smmintrin.h>
+
+#include "simd_kernels.h"
+#endif
+
+namespace gl {
+
+#if defined(GL_SIMD_SSE4)
+
+namespace {
+
+	struct Sse4
+	{
+		using Type = __m128;
+		using Mask = __m128;
+		static constexpr std::size_t WIDTH = 4;
+
+		static Type Set1(float value) { return _mm_set1_ps(value); }
+		static Type Zero() { return _mm_setzero_ps(); }
+		static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+		static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+		static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+		static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+		// No FMA before AVX2.
+		static Type FMAdd(Type a, Type b, Type c)
+		{
+			return _mm_add_ps(_mm_mul_ps(a, b), c);
+		}
+		static Type Abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+		static Mask Less(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+		static Mask Greater(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+		static Type Select(Type if_false, Type if_true, Mask mask)
+		{
+			return _mm_blendv_ps(if_false, if_true, mask);
+		}
+		template <int I0, int I1, int I2, int I3>
+		static Type Shuffle(Type a, Type b)
+		{
+			return _mm_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+		}
+		template <int K>
+		static Type Splat(Type a)
+		{
+			return _mm_shuffle_ps(a, a, _MM_SHUFFLE(K, K, K, K));
+		}
+		static void Transpose4(Type& a, Type& b, Type& c, Type& d)
+		{
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+		}
+		template <std::size_t STRIDE>
+		static Type LoadGroups(const float* p) { return _mm_loadu_ps(p); }
+		template <std::size_t STRIDE>
+		static void StoreGroups(float* p, Type value) { _mm_storeu_ps(p, value); }
+	};
+
+	using Kernels = WideKernels<Sse4>;
+
+	// Column j of the product is the left columns weighted by column j of
+	// the right one.
+	void MultiplyColumns(
+		const __m128 (&left)[4],
+		const float* right,
+		float* out)
+	{
+		__m128 columns[4];
+		for (int j = 0; j < 4; ++j)
+		{
+			const float* column = right + j * 4;
+			columns[j] = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(left[0], _mm_set1_ps(column[0])),
+					_mm_mul_ps(left[1], _mm_set1_ps(column[1]))),
+				_mm_add_ps(
+					_mm_mul_ps(left[2], _mm_set1_ps(column[2])),
+					_mm_mul_ps(left[3], _mm_set1_ps(column[3]))));
+		}
+		for (int j = 0; j < 4; ++j) _mm_storeu_ps(out + j * 4, columns[j]);
+	}
+
+	void MultiplyMatrices(
+		const glm::mat4* left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const float* l = reinterpret_cast<const float*>(left + i);
+			const __m128 columns[4] = {
+				_mm_loadu_ps(l),
+				_mm_loadu_ps(l + 4),
+				_mm_loadu_ps(l + 8),
+				_mm_loadu_ps(l + 12) };
+			MultiplyColumns(
+				columns,
+				reinterpret_cast<const float*>(right + i),
+				reinterpret_cast<float*>(out + i));
+		}
+	}
+
+	void MultiplyMatrix(
+		const glm::mat4& left,
+		const glm::mat4* right,
+		glm::mat4* out,
+		std::size_t count)
+	{
+		const float* l = reinterpret_cast<const float*>(&left);
+		const __m128 columns[4] = {
+			_mm_loadu_ps(l),
+			_mm_loadu_ps(l + 4),
+			_mm_loadu_ps(l + 8),
+			_mm_loadu_ps(l + 12) };
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			MultiplyColumns(
+				columns,
+				reinterpret_cast<const float*>(right + i),
+				reinterpret_cast<float*>(out + i));
+		}
+	}
+
+} // End anonymous namespace.
+
+const SimdKernels* GetSse4Kernels()
+{
+	static const SimdKernels kernels = {
+		Kernels::ComposeTransforms,
+		MultiplyMatrices,
+		MultiplyMatrix,
+		Kernels::InverseAffine,
+		Kernels::NormalMatrices,
+		Kernels::TransformAabbs,
+		Kernels::Slerp,
+	};
+	return &kernels;
+}
+
+#else
+
+const SimdKernels* GetSse4Kernels()
+{
+	return nullptr;
+}
+
+#endif
+
+} // End namespace gl.
@@ -0,0 +1,93 @@
+#include <spirv.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "file_system.h"
+
+namespace gl {
+
+namespace {
+
+	constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+	constexpr std::uint32_t HEADER_WORDS = 5;
+	constexpr std::uint32_t OP_NAME = 5;
+	constexpr std::uint32_t OP_VARIABLE = 59;
+	constexpr std::uint32_t OP_DECORATE = 71;
+	constexpr std::uint32_t DECORATION_LOCATION = 30;
+	constexpr std::uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+
+} // End anonymous namespace.
+
+std::string GetSpirvPath(const std::string& glsl_path)
+{
+	return "spirv/" + FileSystem::Normalize(glsl_path) + ".spv";
+}
+
+bool IsSpirvSupported()
+{
+	return GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_gl_spirv;
+}
+
+std::unordered_map<std::string, GLint> ReflectUniformLocations(
+	std::span<const std::uint8_t> spirv)
+{
+	if (spirv.size() < HEADER_WORDS * 4 || spirv.size() % 4 != 0)
+	{
+		throw std::runtime_error("Not a SPIR-V module.");
+	}
+	std::vector<std::uint32_t> words(spirv.size() / 4);
+	std::memcpy(words.data(), spirv.data(), spirv.size());
+	if (words[0] != SPIRV_MAGIC)
+	{
+		throw std::runtime_error("Not a SPIR-V module.");
+	}
+
+	std::unordered_map<std::uint32_t, std::string> names;
+	std::unordered_map<std::uint32_t, GLint> locations;
+	std::vector<std::uint32_t> uniforms;
+	for (std::size_t i = HEADER_WORDS; i < words.size();)
+	{
+		const std::uint32_t word_count = words[i] >> 16;
+		const std::uint32_t opcode = words[i] & 0xffff;
+		if (word_count == 0 || i + word_count > words.size())
+		{
+			throw std::runtime_error("Truncated SPIR-V module.");
+		}
+		if (opcode == OP_NAME && word_count > 2)
+		{
+			// Nul terminated, padded to a word.
+			const char* name = reinterpret_cast<const char*>(&words[i + 2]);
+			names[words[i + 1]] = std::string(
+				name,
+				std::find(name, name + (word_count - 2) * sizeof(std::uint32_t), '\0'));
+		}
+		else if (opcode == OP_DECORATE &&
+			word_count > 3 &&
+			words[i + 2] == DECORATION_LOCATION)
+		{
+			locations[words[i + 1]] = static_cast<GLint>(words[i + 3]);
+		}
+		else if (opcode == OP_VARIABLE &&
+			word_count > 3 &&
+			words[i + 3] == STORAGE_UNIFORM_CONSTANT)
+		{
+			uniforms.push_back(words[i + 2]);
+		}
+		i += word_count;
+	}
+
+	std::unordered_map<std::string, GLint> result;
+	for (const std::uint32_t id : uniforms)
+	{
+		const auto name = names.find(id);
+		const auto location = locations.find(id);
+		if (name == names.end() || location == locations.end()) continue;
+		result[name->second] = location->second;
+	}
+	return result;
+}
+
+} // End namespace gl.
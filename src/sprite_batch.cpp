@@ -0,0 +1,243 @@
+#include <sprite_batch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	std::uint32_t PackUnorm(float value)
+	{
+		return static_cast<std::uint32_t>(
+			std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	std::uint32_t PackColor(const glm::vec4& color)
+	{
+		return
+			PackUnorm(color.x) |
+			PackUnorm(color.y) << 8 |
+			PackUnorm(color.z) << 16 |
+			PackUnorm(color.w) << 24;
+	}
+
+} // End anonymous namespace.
+
+void SpriteBatch::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void SpriteBatch::Init(const std::string& path, std::size_t max_sprites)
+{
+	max_sprites_ = max_sprites;
+	shader_ = std::make_unique<Shader>(
+		path + "data/shaders/sprite_batch/sprite.vert",
+		path + "data/shaders/sprite_batch/sprite.frag");
+	stream_.Init(max_sprites_ * 4 * sizeof(SpriteVertex));
+	sprites_.reserve(max_sprites_);
+	keys_.reserve(max_sprites_);
+
+	// Every quad has the same topology, only the vertices are streamed.
+	std::vector<GLuint> indices(max_sprites_ * 6);
+	for (std::size_t i = 0; i < max_sprites_; ++i)
+	{
+		const auto base = static_cast<GLuint>(i * 4);
+		indices[i * 6 + 0] = base + 0;
+		indices[i * 6 + 1] = base + 1;
+		indices[i * 6 + 2] = base + 2;
+		indices[i * 6 + 3] = base + 2;
+		indices[i * 6 + 4] = base + 3;
+		indices[i * 6 + 5] = base + 0;
+	}
+	vao_.Create("SpriteBatch");
+	ebo_.Create("SpriteBatch indices");
+	ebo_.SetBytes(indices.size() * sizeof(GLuint));
+	glBindVertexArray(vao_.Get());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_.Get());
+	glBufferData(
+		GL_ELEMENT_ARRAY_BUFFER,
+		indices.size() * sizeof(GLuint),
+		indices.data(),
+		GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+
+	shader_->Use();
+	shader_->SetInt("sprite_texture", 0);
+}
+
+void SpriteBatch::Destroy()
+{
+	stream_.Destroy();
+	vao_.Reset();
+	ebo_.Reset();
+	shader_.reset();
+	sprites_.clear();
+	keys_.clear();
+}
+
+void SpriteBatch::Begin(const glm::mat4& projection)
+{
+	projection_ = projection;
+	sprites_.clear();
+	dropped_sprites_ = 0;
+}
+
+void SpriteBatch::Draw(const Sprite& sprite)
+{
+	if (sprites_.size() >= max_sprites_)
+	{
+		++dropped_sprites_;
+		return;
+	}
+	sprites_.push_back(sprite);
+}
+
+void SpriteBatch::End()
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	last_sprite_count_ = sprites_.size();
+	last_draw_calls_ = 0;
+	if (sprites_.empty())
+	{
+		last_end_ms_ = 0.0f;
+		return;
+	}
+
+	// Layer in the top bits, then the texture, then the submission index
+	// so equal sprites keep their order.
+	keys_.clear();
+	for (std::size_t i = 0; i < sprites_.size(); ++i)
+	{
+		const auto layer = static_cast<std::uint64_t>(
+			std::clamp(sprites_[i].layer + 0x8000, 0, 0xFFFF));
+		const auto texture = static_cast<std::uint64_t>(
+			sprites_[i].region.texture & 0xFFFF);
+		keys_.push_back(layer << 48 | texture << 32 | i);
+	}
+	std::sort(keys_.begin(), keys_.end());
+
+	stream_.BeginFrame();
+	const StreamAllocation allocation = stream_.Allocate(
+		sprites_.size() * 4 * sizeof(SpriteVertex),
+		StreamUsageEnum::VERTEX);
+	auto* vertices = static_cast<SpriteVertex*>(allocation.data);
+	for (const std::uint64_t key : keys_)
+	{
+		const Sprite& sprite = sprites_[key & 0xFFFFFFFF];
+		const glm::vec2 half = sprite.size * 0.5f;
+		const float c = std::cos(sprite.rotation);
+		const float s = std::sin(sprite.rotation);
+		const glm::vec2 right(c * half.x, s * half.x);
+		const glm::vec2 down(-s * half.y, c * half.y);
+		const std::uint32_t color = PackColor(sprite.color);
+		const glm::vec2& uv_min = sprite.region.uv_min;
+		const glm::vec2& uv_max = sprite.region.uv_max;
+		vertices[0] = { sprite.position - right - down, uv_min, color };
+		vertices[1] = {
+			sprite.position + right - down,
+			glm::vec2(uv_max.x, uv_min.y),
+			color };
+		vertices[2] = { sprite.position + right + down, uv_max, color };
+		vertices[3] = {
+			sprite.position - right + down,
+			glm::vec2(uv_min.x, uv_max.y),
+			color };
+		vertices += 4;
+	}
+	stream_.Flush();
+
+	shader_->Use();
+	shader_->SetMat4("projection", projection_);
+	glBindVertexArray(vao_.Get());
+	glBindBuffer(GL_ARRAY_BUFFER, allocation.buffer);
+	glVertexAttribPointer(
+		0,
+		2,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(SpriteVertex),
+		(GLvoid*)(allocation.offset + offsetof(SpriteVertex, position)));
+	glVertexAttribPointer(
+		1,
+		2,
+		GL_FLOAT,
+		GL_FALSE,
+		sizeof(SpriteVertex),
+		(GLvoid*)(allocation.offset + offsetof(SpriteVertex, uv)));
+	glVertexAttribPointer(
+		2,
+		4,
+		GL_UNSIGNED_BYTE,
+		GL_TRUE,
+		sizeof(SpriteVertex),
+		(GLvoid*)(allocation.offset + offsetof(SpriteVertex, color)));
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glActiveTexture(GL_TEXTURE0);
+
+	// One draw per run of the same texture.
+	std::size_t run_start = 0;
+	for (std::size_t i = 1; i <= keys_.size(); ++i)
+	{
+		const GLuint texture =
+			sprites_[keys_[run_start] & 0xFFFFFFFF].region.texture;
+		if (i < keys_.size() &&
+			sprites_[keys_[i] & 0xFFFFFFFF].region.texture == texture)
+		{
+			continue;
+		}
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glDrawElements(
+			GL_TRIANGLES,
+			static_cast<GLsizei>((i - run_start) * 6),
+			GL_UNSIGNED_INT,
+			(GLvoid*)(run_start * 6 * sizeof(GLuint)));
+		++last_draw_calls_;
+		run_start = i;
+	}
+	IsError(__FILE__, __LINE__);
+
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	stream_.EndFrame();
+	last_end_ms_ = std::chrono::duration<float, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SpriteBatch::DrawImGui() const
+{
+	ImGui::Text(
+		"Sprites: %zu in %zu draw calls",
+		last_sprite_count_,
+		last_draw_calls_);
+	if (dropped_sprites_)
+	{
+		ImGui::Text("Dropped: %zu over the limit", dropped_sprites_);
+	}
+	ImGui::Text("End: %.3f ms", last_end_ms_);
+	stream_.DrawImGui();
+}
+
+} // End namespace gl.
@@ -0,0 +1,413 @@
+#include <startup.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "file_system.h"
+#include "job_system.h"
+
+namespace gl {
+
+namespace {
+
+	// As close to the start of the process as static initialization gets.
+	const std::chrono::steady_clock::time_point process_start =
+		std::chrono::steady_clock::now();
+
+	double Now()
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - process_start).count();
+	}
+
+	const char* GetQueueName(StartupQueueEnum queue)
+	{
+		switch (queue)
+		{
+		case StartupQueueEnum::MAIN: return "main";
+		case StartupQueueEnum::WORKER: return "worker";
+		case StartupQueueEnum::GL: return "gl";
+		}
+		return "";
+	}
+
+	std::string GetThreadName(unsigned int thread)
+	{
+		return thread == 0 ? "main" : "worker " + std::to_string(thread);
+	}
+
+	std::string Escape(const std::string& text)
+	{
+		std::string escaped;
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+		}
+		return escaped;
+	}
+
+} // End anonymous namespace.
+
+Startup& Startup::GetInstance()
+{
+	static Startup instance;
+	return instance;
+}
+
+Startup::Startup()
+{
+	// Created from the main thread, by the engine.
+	threads_.push_back(std::this_thread::get_id());
+}
+
+Startup::~Startup() = default;
+
+StartupTaskId Startup::AddTask(
+	const std::string& name,
+	std::function<void()> task,
+	const std::vector<StartupTaskId>& dependencies)
+{
+	return Add(name, StartupQueueEnum::WORKER, std::move(task), dependencies);
+}
+
+StartupTaskId Startup::AddGlTask(
+	const std::string& name,
+	std::function<void()> task,
+	const std::vector<StartupTaskId>& dependencies)
+{
+	return Add(name, StartupQueueEnum::GL, std::move(task), dependencies);
+}
+
+StartupTaskId Startup::AddPrefetch(const std::string& directory)
+{
+	return AddTask("Prefetch " + directory, [this, directory] {
+		const FileSystem& fileSystem = FileSystem::GetInstance();
+		std::vector<std::string> paths;
+		for (const std::string& root :
+			{ directory, "spirv/" + FileSystem::Normalize(directory) })
+		{
+			const std::vector<std::string> files = fileSystem.List(root);
+			paths.insert(paths.end(), files.begin(), files.end());
+		}
+		// Running on a worker, jobs_ lives until Finish.
+		fileSystem.Prefetch(paths, *jobs_);
+	});
+}
+
+StartupTaskId Startup::Add(
+	const std::string& name,
+	StartupQueueEnum queue,
+	std::function<void()> task,
+	const std::vector<StartupTaskId>& dependencies)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const StartupTaskId id = tasks_.size();
+	for (const StartupTaskId dependency : dependencies)
+	{
+		if (dependency >= id)
+		{
+			throw std::runtime_error(
+				"Startup task " + name + " depends on an unknown task");
+		}
+	}
+	Task& added = tasks_.emplace_back();
+	added.name = name;
+	added.queue = queue;
+	added.function = std::move(task);
+	for (const StartupTaskId dependency : dependencies)
+	{
+		Task& before = tasks_[dependency];
+		if (before.done)
+		{
+			added.cancelled |= before.cancelled;
+			continue;
+		}
+		++added.remaining;
+		before.dependents.push_back(id);
+	}
+	++pending_;
+	if (added.remaining == 0) MakeReady(id);
+	return id;
+}
+
+void Startup::MakeReady(StartupTaskId id)
+{
+	if (tasks_[id].queue == StartupQueueEnum::GL)
+	{
+		ready_gl_.push_back(id);
+		changed_.notify_all();
+		return;
+	}
+	// Only alive during the startup, the frames use their own pools.
+	if (!jobs_) jobs_ = std::make_unique<JobSystem>();
+	jobs_->Schedule([this, id] { Run(id); });
+}
+
+unsigned int Startup::GetThreadIndex()
+{
+	const auto id = std::this_thread::get_id();
+	const auto it = std::find(threads_.begin(), threads_.end(), id);
+	if (it != threads_.end())
+	{
+		return static_cast<unsigned int>(it - threads_.begin());
+	}
+	threads_.push_back(id);
+	return static_cast<unsigned int>(threads_.size() - 1);
+}
+
+void Startup::Run(StartupTaskId id)
+{
+	StartupEvent event;
+	std::function<void()> function;
+	bool cancelled = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		Task& task = tasks_[id];
+		event.name = task.name;
+		event.queue = task.queue;
+		event.thread = GetThreadIndex();
+		function = std::move(task.function);
+		cancelled = task.cancelled;
+	}
+	std::exception_ptr error;
+	event.begin_ms = Now();
+	if (!cancelled)
+	{
+		try
+		{
+			function();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+	}
+	event.end_ms = Now();
+	// Captures in the function are released outside the lock.
+	function = nullptr;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!cancelled) events_.push_back(std::move(event));
+	if (error && !error_) error_ = error;
+	Task& task = tasks_[id];
+	task.done = true;
+	task.cancelled = cancelled || error;
+	for (const StartupTaskId dependent : task.dependents)
+	{
+		Task& after = tasks_[dependent];
+		after.cancelled |= task.cancelled;
+		if (--after.remaining == 0) MakeReady(dependent);
+	}
+	--pending_;
+	changed_.notify_all();
+}
+
+bool Startup::RunReadyGlTask()
+{
+	StartupTaskId id = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!context_ready_ || ready_gl_.empty()) return false;
+		id = ready_gl_.front();
+		ready_gl_.pop_front();
+	}
+	Run(id);
+	return true;
+}
+
+void Startup::BeginSpan(const std::string& name)
+{
+	StartupEvent span;
+	span.name = name;
+	span.begin_ms = Now();
+	spans_.push_back(std::move(span));
+}
+
+void Startup::EndSpan()
+{
+	if (spans_.empty()) return;
+	StartupEvent span = std::move(spans_.back());
+	spans_.pop_back();
+	span.end_ms = Now();
+	std::lock_guard<std::mutex> lock(mutex_);
+	events_.push_back(std::move(span));
+}
+
+void Startup::SetContextReady()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		context_ready_ = true;
+	}
+	Pump();
+}
+
+void Startup::Pump()
+{
+	while (RunReadyGlTask()) {}
+}
+
+void Startup::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!context_ready_)
+		{
+			throw std::runtime_error("Startup finished before the context");
+		}
+	}
+	std::exception_ptr error;
+	std::unique_ptr<JobSystem> jobs;
+	BeginSpan("Waiting for startup tasks");
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (pending_ > 0)
+		{
+			if (!ready_gl_.empty())
+			{
+				lock.unlock();
+				Pump();
+				lock.lock();
+				continue;
+			}
+			changed_.wait(lock);
+		}
+		error = std::exchange(error_, nullptr);
+		jobs = std::move(jobs_);
+	}
+	// Joins the workers, they have nothing left to do.
+	jobs.reset();
+	EndSpan();
+	if (error) std::rethrow_exception(error);
+}
+
+void Startup::MarkFirstFrame()
+{
+	if (first_frame_ms_ >= 0.0) return;
+	first_frame_ms_ = Now();
+	PrintReport(std::cout);
+	const char* trace = std::getenv("GPR5300_STARTUP_TRACE");
+	const std::string path = trace ? trace : "startup_trace.json";
+	if (path.empty()) return;
+	try
+	{
+		WriteTrace(path);
+		std::cout << "Wrote " << path << "\n";
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+	}
+}
+
+void Startup::PrintReport(std::ostream& os) const
+{
+	std::vector<StartupEvent> events;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		events = events_;
+	}
+	std::stable_sort(
+		events.begin(),
+		events.end(),
+		[](const StartupEvent& a, const StartupEvent& b) {
+			return a.begin_ms < b.begin_ms;
+		});
+	double main_ms = 0.0;
+	double worker_ms = 0.0;
+	const auto flags = os.flags();
+	const auto precision = os.precision();
+	os << std::fixed << std::setprecision(1);
+	os << "Startup timeline (ms)\n";
+	os << std::setw(9) << "begin" << std::setw(9) << "length"
+		<< "  " << std::left << std::setw(10) << "thread"
+		<< std::setw(8) << "queue" << "name\n" << std::right;
+	for (const auto& event : events)
+	{
+		const double ms = event.end_ms - event.begin_ms;
+		// Spans nest and cover the GL tasks run inside them, only the
+		// outermost events of the main thread add up.
+		if (event.queue == StartupQueueEnum::WORKER)
+		{
+			worker_ms += ms;
+		}
+		else if (std::none_of(
+			events.begin(),
+			events.end(),
+			[&event](const StartupEvent& outer) {
+				return &outer != &event &&
+					outer.queue == StartupQueueEnum::MAIN &&
+					outer.begin_ms <= event.begin_ms &&
+					outer.end_ms >= event.end_ms;
+			}))
+		{
+			main_ms += ms;
+		}
+		os << std::setw(9) << event.begin_ms << std::setw(9) << ms
+			<< "  " << std::left << std::setw(10) << GetThreadName(event.thread)
+			<< std::setw(8) << GetQueueName(event.queue) << event.name << "\n"
+			<< std::right;
+	}
+	os << "Main thread busy " << main_ms << " ms, workers busy "
+		<< worker_ms << " ms\n";
+	if (first_frame_ms_ >= 0.0)
+	{
+		os << "First frame after " << first_frame_ms_ << " ms\n";
+	}
+	os.flags(flags);
+	os.precision(precision);
+}
+
+void Startup::WriteTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		throw std::runtime_error("Could not write " + path);
+	}
+	std::vector<StartupEvent> events;
+	unsigned int thread_count = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		events = events_;
+		thread_count = static_cast<unsigned int>(threads_.size());
+	}
+	// Chrome trace event format, timestamps in microseconds.
+	file << std::fixed << std::setprecision(1);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+		<< "\"args\":{\"name\":\"GPR5300 startup\"}}";
+	for (unsigned int thread = 0; thread < thread_count; ++thread)
+	{
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			<< thread << ",\"args\":{\"name\":\"" << GetThreadName(thread)
+			<< "\"}}";
+	}
+	for (const auto& event : events)
+	{
+		file << ",\n{\"name\":\"" << Escape(event.name)
+			<< "\",\"cat\":\"" << GetQueueName(event.queue)
+			<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << event.begin_ms * 1000.0
+			<< ",\"dur\":" << (event.end_ms - event.begin_ms) * 1000.0 << "}";
+	}
+	if (first_frame_ms_ >= 0.0)
+	{
+		file << ",\n{\"name\":\"First frame\",\"ph\":\"i\",\"s\":\"g\","
+			<< "\"pid\":1,\"tid\":0,\"ts\":" << first_frame_ms_ * 1000.0 << "}";
+	}
+	file << "\n]}\n";
+	if (!file)
+	{
+		throw std::runtime_error("Could not write " + path);
+	}
+}
+
+} // End namespace gl.
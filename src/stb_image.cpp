@@ -0,0 +1,3 @@
+// Single stb_image implementation for the whole project.
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
@@ -0,0 +1,274 @@
+#include <stream_buffer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include "gl_capture.h"
+#include "imgui.h"
+
+namespace gl {
+
+namespace {
+
+	std::size_t AlignUp(std::size_t value, std::size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+} // End anonymous namespace.
+
+void StreamBuffer::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void StreamBuffer::Init(
+	std::size_t bytes_per_frame,
+	int frame_count,
+	bool allow_persistent)
+{
+	const bool has_buffer_storage =
+		(GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) &&
+		glBufferStorage;
+	// Writes through a persistent mapping are not seen by GlCapture.
+	mode_ = (allow_persistent && has_buffer_storage &&
+		!GlCapture::GetInstance().IsCapturing()) ?
+		StreamBufferModeEnum::PERSISTENT :
+		StreamBufferModeEnum::ORPHANING;
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	uniform_alignment_ = std::max<std::size_t>(alignment, 16);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	storage_alignment_ = std::max<std::size_t>(alignment, 16);
+	IsError(__FILE__, __LINE__);
+
+	// Every region starts aligned for any usage.
+	region_size_ = AlignUp(
+		bytes_per_frame,
+		std::max(uniform_alignment_, storage_alignment_));
+	const std::size_t region_count =
+		mode_ == StreamBufferModeEnum::PERSISTENT ?
+			static_cast<std::size_t>(std::max(frame_count, 1)) : 1;
+	buffer_.Create("StreamBuffer");
+	buffer_.SetBytes(region_size_ * region_count);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_.Get());
+	if (mode_ == StreamBufferModeEnum::PERSISTENT)
+	{
+		const GLbitfield flags =
+			GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(
+			GL_COPY_WRITE_BUFFER,
+			region_size_ * region_count,
+			nullptr,
+			flags);
+		IsError(__FILE__, __LINE__);
+		mapped_ = static_cast<std::uint8_t*>(glMapBufferRange(
+			GL_COPY_WRITE_BUFFER,
+			0,
+			region_size_ * region_count,
+			flags));
+		IsError(__FILE__, __LINE__);
+		if (!mapped_)
+		{
+			throw std::runtime_error("Could not map the stream buffer.");
+		}
+	}
+	else
+	{
+		glBufferData(
+			GL_COPY_WRITE_BUFFER,
+			region_size_,
+			nullptr,
+			GL_STREAM_DRAW);
+		staging_.resize(region_size_);
+		IsError(__FILE__, __LINE__);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	fences_.assign(region_count, nullptr);
+	region_ = 0;
+	head_ = 0;
+	flushed_ = 0;
+}
+
+void StreamBuffer::Destroy()
+{
+	for (auto& fence : fences_)
+	{
+		if (fence) glDeleteSync(fence);
+	}
+	fences_.clear();
+	if (mapped_)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_.Get());
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		mapped_ = nullptr;
+	}
+	buffer_.Reset();
+	staging_.clear();
+	IsError(__FILE__, __LINE__);
+}
+
+void StreamBuffer::BeginFrame()
+{
+	region_ = (region_ + 1) % static_cast<int>(fences_.size());
+	head_ = 0;
+	flushed_ = 0;
+	allocation_count_ = 0;
+	last_fence_wait_ms_ = 0.0f;
+	if (mode_ == StreamBufferModeEnum::ORPHANING)
+	{
+		// The driver hands out fresh storage, no wait on the old one.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_.Get());
+		glBufferData(
+			GL_COPY_WRITE_BUFFER,
+			region_size_,
+			nullptr,
+			GL_STREAM_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		IsError(__FILE__, __LINE__);
+		return;
+	}
+	GLsync& fence = fences_[region_];
+	if (!fence) return;
+	// Most of the time the GPU is already done with it.
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		++fence_wait_count_;
+		const auto start = std::chrono::high_resolution_clock::now();
+		do
+		{
+			result = glClientWaitSync(
+				fence,
+				GL_SYNC_FLUSH_COMMANDS_BIT,
+				1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		last_fence_wait_ms_ = std::chrono::duration<float, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+		total_fence_wait_ms_ += last_fence_wait_ms_;
+	}
+	if (result == GL_WAIT_FAILED)
+	{
+		throw std::runtime_error("Waiting on a stream buffer fence failed.");
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void StreamBuffer::EndFrame()
+{
+	Flush();
+	last_frame_bytes_ = head_;
+	last_allocation_count_ = allocation_count_;
+	peak_frame_bytes_ = std::max(peak_frame_bytes_, head_);
+	if (mode_ == StreamBufferModeEnum::PERSISTENT)
+	{
+		fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		IsError(__FILE__, __LINE__);
+	}
+}
+
+std::size_t StreamBuffer::GetAlignment(StreamUsageEnum usage) const
+{
+	switch (usage)
+	{
+	case StreamUsageEnum::INDEX: return 4;
+	case StreamUsageEnum::UNIFORM: return uniform_alignment_;
+	case StreamUsageEnum::STORAGE: return storage_alignment_;
+	// Enough for any vertex attribute type.
+	case StreamUsageEnum::VERTEX:
+	default: return 16;
+	}
+}
+
+StreamAllocation StreamBuffer::Allocate(std::size_t size, StreamUsageEnum usage)
+{
+	return Allocate(size, GetAlignment(usage));
+}
+
+StreamAllocation StreamBuffer::Allocate(std::size_t size, std::size_t alignment)
+{
+	const std::size_t offset = AlignUp(head_, alignment);
+	if (offset + size > region_size_)
+	{
+		throw std::runtime_error(
+			"Stream buffer full: " + std::to_string(offset + size) +
+			" > " + std::to_string(region_size_) + " bytes this frame");
+	}
+	head_ = offset + size;
+	++allocation_count_;
+	StreamAllocation allocation;
+	allocation.buffer = buffer_.Get();
+	allocation.size = static_cast<GLsizeiptr>(size);
+	if (mode_ == StreamBufferModeEnum::PERSISTENT)
+	{
+		const std::size_t base = static_cast<std::size_t>(region_) * region_size_;
+		allocation.data = mapped_ + base + offset;
+		allocation.offset = static_cast<GLintptr>(base + offset);
+	}
+	else
+	{
+		allocation.data = staging_.data() + offset;
+		allocation.offset = static_cast<GLintptr>(offset);
+	}
+	return allocation;
+}
+
+void StreamBuffer::Flush()
+{
+	if (mode_ == StreamBufferModeEnum::PERSISTENT || flushed_ == head_) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_.Get());
+	glBufferSubData(
+		GL_COPY_WRITE_BUFFER,
+		static_cast<GLintptr>(flushed_),
+		static_cast<GLsizeiptr>(head_ - flushed_),
+		staging_.data() + flushed_);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+	flushed_ = head_;
+}
+
+void StreamBuffer::BindRange(
+	GLenum target,
+	GLuint index,
+	const StreamAllocation& allocation) const
+{
+	glBindBufferRange(
+		target,
+		index,
+		allocation.buffer,
+		allocation.offset,
+		allocation.size);
+	IsError(__FILE__, __LINE__);
+}
+
+void StreamBuffer::DrawImGui() const
+{
+	ImGui::Text(
+		"Mode: %s",
+		mode_ == StreamBufferModeEnum::PERSISTENT ?
+			"persistent mapping" : "orphaning");
+	ImGui::Text(
+		"Streamed: %.1f KB in %zu allocations (peak %.1f KB / %.1f KB)",
+		last_frame_bytes_ / 1024.0f,
+		last_allocation_count_,
+		peak_frame_bytes_ / 1024.0f,
+		region_size_ / 1024.0f);
+	ImGui::Text(
+		"Fence waits: %zu (last %.3f ms, total %.1f ms)",
+		fence_wait_count_,
+		last_fence_wait_ms_,
+		total_fence_wait_ms_);
+}
+
+} // End namespace gl.
@@ -0,0 +1,326 @@
+#include <texture_atlas.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "file_system.h"
+#include "imgui.h"
+#include "stb_image.h"
+
+namespace gl {
+
+RectanglePacker::RectanglePacker(int width, int height) :
+	width_(width),
+	height_(height)
+{
+	skyline_.push_back({ 0, 0, width });
+}
+
+int RectanglePacker::Fit(std::size_t index, int width, int height) const
+{
+	const int x = skyline_[index].x;
+	if (x + width > width_) return -1;
+	int y = skyline_[index].y;
+	int remaining = width;
+	for (std::size_t i = index; remaining > 0; ++i)
+	{
+		if (i >= skyline_.size()) return -1;
+		y = std::max(y, skyline_[i].y);
+		if (y + height > height_) return -1;
+		remaining -= skyline_[i].width;
+	}
+	return y;
+}
+
+bool RectanglePacker::Insert(int width, int height, glm::ivec2& position)
+{
+	int best_top = std::numeric_limits<int>::max();
+	int best_width = std::numeric_limits<int>::max();
+	std::size_t best_index = skyline_.size();
+	int best_y = 0;
+	for (std::size_t i = 0; i < skyline_.size(); ++i)
+	{
+		const int y = Fit(i, width, height);
+		if (y < 0) continue;
+		// Lowest top first, then the tightest node to keep gaps small.
+		if (y + height < best_top ||
+			(y + height == best_top && skyline_[i].width < best_width))
+		{
+			best_top = y + height;
+			best_width = skyline_[i].width;
+			best_index = i;
+			best_y = y;
+		}
+	}
+	if (best_index == skyline_.size()) return false;
+
+	position = glm::ivec2(skyline_[best_index].x, best_y);
+	const SkylineNode node = { position.x, best_y + height, width };
+	skyline_.insert(skyline_.begin() + best_index, node);
+	// Cut the nodes now under the new one.
+	for (std::size_t i = best_index + 1; i < skyline_.size();)
+	{
+		const int overlap = node.x + node.width - skyline_[i].x;
+		if (overlap <= 0) break;
+		skyline_[i].x += overlap;
+		skyline_[i].width -= overlap;
+		if (skyline_[i].width > 0) break;
+		skyline_.erase(skyline_.begin() + i);
+	}
+	// Merge neighbours at the same height.
+	for (std::size_t i = 0; i + 1 < skyline_.size();)
+	{
+		if (skyline_[i].y == skyline_[i + 1].y)
+		{
+			skyline_[i].width += skyline_[i + 1].width;
+			skyline_.erase(skyline_.begin() + i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+	used_area_ += static_cast<std::size_t>(width) * height;
+	return true;
+}
+
+float RectanglePacker::GetOccupancy() const
+{
+	return static_cast<float>(used_area_) /
+		(static_cast<float>(width_) * static_cast<float>(height_));
+}
+
+void TextureAtlas::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void TextureAtlas::Load(const std::string& file_name)
+{
+	int width, height, channels;
+	const FileData file = FileSystem::GetInstance().Read(file_name);
+	stbi_uc* pixels = stbi_load_from_memory(
+		file.GetData(),
+		static_cast<int>(file.GetSize()),
+		&width,
+		&height,
+		&channels,
+		4);
+	if (!pixels)
+	{
+		throw std::runtime_error("Could not load texture: " + file_name);
+	}
+	Add(
+		std::filesystem::path(file_name).stem().string(),
+		width,
+		height,
+		pixels);
+	stbi_image_free(pixels);
+}
+
+void TextureAtlas::LoadDirectory(const std::string& directory)
+{
+	// Sorted, directory order isn't stable across platforms.
+	for (const auto& file : FileSystem::GetInstance().List(directory))
+	{
+		std::string extension = std::filesystem::path(file).extension().string();
+		std::transform(
+			extension.begin(),
+			extension.end(),
+			extension.begin(),
+			[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (extension == ".png" || extension == ".jpg" || extension == ".tga")
+		{
+			Load(file);
+		}
+	}
+}
+
+void TextureAtlas::Add(
+	const std::string& name,
+	int width,
+	int height,
+	const std::uint8_t* rgba)
+{
+	Image image;
+	image.name = name;
+	image.width = width;
+	image.height = height;
+	image.pixels.assign(
+		rgba,
+		rgba + static_cast<std::size_t>(width) * height * 4);
+	images_.push_back(std::move(image));
+}
+
+void TextureAtlas::Build(int page_size, int padding)
+{
+	page_size_ = page_size;
+	// Tallest first packs tighter on a skyline.
+	std::vector<std::size_t> order(images_.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(
+		order.begin(),
+		order.end(),
+		[this](std::size_t a, std::size_t b) {
+			if (images_[a].height != images_[b].height)
+				return images_[a].height > images_[b].height;
+			return images_[a].width > images_[b].width;
+		});
+
+	std::vector<RectanglePacker> packers;
+	std::vector<std::pair<int, glm::ivec2>> placements(images_.size());
+	for (const std::size_t index : order)
+	{
+		const Image& image = images_[index];
+		const int width = image.width + 2 * padding;
+		const int height = image.height + 2 * padding;
+		if (width > page_size || height > page_size)
+		{
+			throw std::runtime_error(
+				"Image " + image.name + " doesn't fit in a " +
+				std::to_string(page_size) + " atlas page.");
+		}
+		glm::ivec2 position;
+		std::size_t page = 0;
+		while (page < packers.size() &&
+			!packers[page].Insert(width, height, position))
+		{
+			++page;
+		}
+		if (page == packers.size())
+		{
+			packers.emplace_back(page_size, page_size);
+			packers.back().Insert(width, height, position);
+		}
+		placements[index] = { static_cast<int>(page), position };
+	}
+
+	std::vector<std::vector<std::uint8_t>> page_pixels(
+		packers.size(),
+		std::vector<std::uint8_t>(
+			static_cast<std::size_t>(page_size) * page_size * 4,
+			0));
+	for (std::size_t i = 0; i < images_.size(); ++i)
+	{
+		const Image& image = images_[i];
+		const auto& [page, position] = placements[i];
+		auto& pixels = page_pixels[page];
+		// Clamped reads extrude the border into the padding.
+		for (int y = -padding; y < image.height + padding; ++y)
+		{
+			const int source_y = std::clamp(y, 0, image.height - 1);
+			for (int x = -padding; x < image.width + padding; ++x)
+			{
+				const int source_x = std::clamp(x, 0, image.width - 1);
+				const std::size_t source =
+					(static_cast<std::size_t>(source_y) * image.width + source_x) * 4;
+				const std::size_t destination =
+					(static_cast<std::size_t>(position.y + padding + y) * page_size +
+						position.x + padding + x) * 4;
+				std::copy_n(&image.pixels[source], 4, &pixels[destination]);
+			}
+		}
+	}
+
+	pages_.clear();
+	for (std::size_t page = 0; page < page_pixels.size(); ++page)
+	{
+		TextureHandle texture("TextureAtlas page");
+		texture.SetBytes(EstimateTextureBytes(GL_RGBA8, page_size, page_size, 1, 1));
+		glBindTexture(GL_TEXTURE_2D, texture.Get());
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			0,
+			GL_RGBA8,
+			page_size,
+			page_size,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			page_pixels[page].data());
+		// No mips, they would mix neighbours once the padding is gone.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		IsError(__FILE__, __LINE__);
+		pages_.push_back(std::move(texture));
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	regions_.clear();
+	const float inverse_size = 1.0f / static_cast<float>(page_size);
+	for (std::size_t i = 0; i < images_.size(); ++i)
+	{
+		const Image& image = images_[i];
+		const auto& [page, position] = placements[i];
+		AtlasRegion region;
+		region.page = page;
+		region.texture = pages_[page].Get();
+		region.size = glm::ivec2(image.width, image.height);
+		region.uv_min = glm::vec2(position + padding) * inverse_size;
+		region.uv_max =
+			glm::vec2(position + padding + region.size) * inverse_size;
+		regions_[image.name] = region;
+	}
+
+	occupancy_ = 0.0f;
+	for (const auto& packer : packers) occupancy_ += packer.GetOccupancy();
+	if (!packers.empty()) occupancy_ /= static_cast<float>(packers.size());
+	// The pixels are on the GPU now.
+	images_.clear();
+}
+
+void TextureAtlas::Destroy()
+{
+	pages_.clear();
+	regions_.clear();
+	images_.clear();
+}
+
+const AtlasRegion& TextureAtlas::GetRegion(const std::string& name) const
+{
+	auto it = regions_.find(name);
+	if (it == regions_.end())
+	{
+		throw std::runtime_error("No image " + name + " in the atlas.");
+	}
+	return it->second;
+}
+
+std::vector<std::string> TextureAtlas::GetNames() const
+{
+	std::vector<std::string> names;
+	for (const auto& [name, region] : regions_) names.push_back(name);
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+void TextureAtlas::DrawImGui() const
+{
+	ImGui::Text(
+		"Atlas: %zu images in %zu pages of %d, %.0f%% used",
+		regions_.size(),
+		pages_.size(),
+		page_size_,
+		occupancy_ * 100.0f);
+	for (const auto& page : pages_)
+	{
+		ImGui::Image(
+			(ImTextureID)(std::intptr_t)page.Get(),
+			ImVec2(192.0f, 192.0f));
+	}
+}
+
+} // End namespace gl.
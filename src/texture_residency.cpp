@@ -0,0 +1,284 @@
+#include <texture_residency.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "file_system.h"
+#include "imgui.h"
+#include "stb_image.h"
+
+namespace gl {
+
+namespace {
+
+	GLsizei MipLevelCount(int width, int height)
+	{
+		return static_cast<GLsizei>(
+			std::floor(std::log2(std::max(width, height))) + 1);
+	}
+
+	void SetSamplerParameters(GLenum target)
+	{
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+} // End anonymous namespace.
+
+void TextureResidency::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+void TextureResidency::Init(bool allow_bindless)
+{
+	// Mesa llvmpipe and most GLES drivers don't have bindless. Handles
+	// read per instance aren't dynamically uniform, sampling them needs
+	// NV_gpu_shader5 on top.
+	const bool has_bindless =
+		GLAD_GL_ARB_bindless_texture &&
+		GLAD_GL_NV_gpu_shader5 &&
+		glGetTextureHandleARB &&
+		glMakeTextureHandleResidentARB;
+	mode_ = (allow_bindless && has_bindless) ?
+		TextureResidencyModeEnum::BINDLESS :
+		TextureResidencyModeEnum::ARRAYS;
+	GLint max_layers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+	max_layers_ = std::min(MAX_LAYERS_PER_PAGE, static_cast<int>(max_layers));
+	table_ssbo_.Create("TextureResidency table");
+	IsError(__FILE__, __LINE__);
+}
+
+void TextureResidency::Destroy()
+{
+	// Handles have to be non resident before their texture goes away.
+	for (const auto& entry : entries_)
+	{
+		if (entry.handle) glMakeTextureHandleNonResidentARB(entry.handle);
+	}
+	entries_.clear();
+	textures_.clear();
+	pages_.clear();
+	table_ssbo_.Reset();
+	IsError(__FILE__, __LINE__);
+}
+
+std::uint32_t TextureResidency::Load(const std::string& file_name)
+{
+	int width, height, channels;
+	// Everything goes to RGBA8 so all textures of a size share a page.
+	const FileData file = FileSystem::GetInstance().Read(file_name);
+	stbi_uc* pixels = stbi_load_from_memory(
+		file.GetData(),
+		static_cast<int>(file.GetSize()),
+		&width,
+		&height,
+		&channels,
+		4);
+	if (!pixels)
+	{
+		throw std::runtime_error("Could not load texture: " + file_name);
+	}
+	const std::uint32_t index = Add(width, height, pixels);
+	stbi_image_free(pixels);
+	return index;
+}
+
+std::uint32_t TextureResidency::Add(
+	int width,
+	int height,
+	const std::uint8_t* rgba)
+{
+	return mode_ == TextureResidencyModeEnum::BINDLESS ?
+		AddBindless(width, height, rgba) :
+		AddToPage(width, height, rgba);
+}
+
+std::uint32_t TextureResidency::AddToPage(
+	int width,
+	int height,
+	const std::uint8_t* rgba)
+{
+	auto it = std::find_if(
+		pages_.begin(),
+		pages_.end(),
+		[&](const Page& page) {
+			return page.width == width &&
+				page.height == height &&
+				page.layer_count < max_layers_;
+		});
+	if (it == pages_.end())
+	{
+		if (pages_.size() >= MAX_PAGES)
+		{
+			throw std::runtime_error("Out of texture array pages.");
+		}
+		Page page;
+		page.width = width;
+		page.height = height;
+		page.texture.Create("TextureResidency page");
+		page.texture.SetBytes(
+			EstimateTextureBytes(GL_RGBA8, width, height, max_layers_));
+		IsError(__FILE__, __LINE__);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.Get());
+		IsError(__FILE__, __LINE__);
+		glTexStorage3D(
+			GL_TEXTURE_2D_ARRAY,
+			MipLevelCount(width, height),
+			GL_RGBA8,
+			width,
+			height,
+			max_layers_);
+		IsError(__FILE__, __LINE__);
+		SetSamplerParameters(GL_TEXTURE_2D_ARRAY);
+		IsError(__FILE__, __LINE__);
+		pages_.push_back(std::move(page));
+		it = pages_.end() - 1;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, it->texture.Get());
+	IsError(__FILE__, __LINE__);
+	glTexSubImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		0,
+		0,
+		it->layer_count,
+		width,
+		height,
+		1,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		rgba);
+	IsError(__FILE__, __LINE__);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	TextureEntry entry;
+	entry.page = static_cast<std::uint32_t>(it - pages_.begin());
+	entry.layer = static_cast<std::uint32_t>(it->layer_count++);
+	it->dirty = true;
+	entries_.push_back(entry);
+	return static_cast<std::uint32_t>(entries_.size() - 1);
+}
+
+std::uint32_t TextureResidency::AddBindless(
+	int width,
+	int height,
+	const std::uint8_t* rgba)
+{
+	TextureHandle texture("TextureResidency bindless");
+	texture.SetBytes(EstimateTextureBytes(GL_RGBA8, width, height));
+	IsError(__FILE__, __LINE__);
+	glBindTexture(GL_TEXTURE_2D, texture.Get());
+	IsError(__FILE__, __LINE__);
+	glTexStorage2D(
+		GL_TEXTURE_2D,
+		MipLevelCount(width, height),
+		GL_RGBA8,
+		width,
+		height);
+	IsError(__FILE__, __LINE__);
+	glTexSubImage2D(
+		GL_TEXTURE_2D,
+		0,
+		0,
+		0,
+		width,
+		height,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		rgba);
+	IsError(__FILE__, __LINE__);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	// Sampler state is frozen once a handle exists, so set it first.
+	SetSamplerParameters(GL_TEXTURE_2D);
+	IsError(__FILE__, __LINE__);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	TextureEntry entry;
+	entry.handle = glGetTextureHandleARB(texture.Get());
+	IsError(__FILE__, __LINE__);
+	glMakeTextureHandleResidentARB(entry.handle);
+	IsError(__FILE__, __LINE__);
+	textures_.push_back(std::move(texture));
+	entries_.push_back(entry);
+	return static_cast<std::uint32_t>(entries_.size() - 1);
+}
+
+void TextureResidency::Commit()
+{
+	for (auto& page : pages_)
+	{
+		if (!page.dirty) continue;
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.Get());
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		IsError(__FILE__, __LINE__);
+		page.dirty = false;
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	table_ssbo_.SetBytes(entries_.size() * sizeof(TextureEntry));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, table_ssbo_.Get());
+	glBufferData(
+		GL_SHADER_STORAGE_BUFFER,
+		entries_.size() * sizeof(TextureEntry),
+		entries_.data(),
+		GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+void TextureResidency::Bind(const Shader& shader, int first_unit) const
+{
+	shader.Use();
+	shader.SetBool(
+		"use_bindless",
+		mode_ == TextureResidencyModeEnum::BINDLESS);
+	for (int i = 0; i < MAX_PAGES; ++i)
+	{
+		// Unused slots still need a unit that doesn't alias a 2D texture.
+		const int page = std::min(i, static_cast<int>(pages_.size()) - 1);
+		shader.SetInt(
+			"texture_pages[" + std::to_string(i) + "]",
+			first_unit + std::max(page, 0));
+	}
+	for (std::size_t i = 0; i < pages_.size(); ++i)
+	{
+		glActiveTexture(GL_TEXTURE0 + first_unit + static_cast<GLenum>(i));
+		glBindTexture(GL_TEXTURE_2D_ARRAY, pages_[i].texture.Get());
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_TABLE_BINDING, table_ssbo_.Get());
+	IsError(__FILE__, __LINE__);
+}
+
+void TextureResidency::DrawImGui() const
+{
+	ImGui::Text(
+		"Mode: %s",
+		mode_ == TextureResidencyModeEnum::BINDLESS ?
+			"bindless handles" : "texture arrays");
+	ImGui::Text("Textures: %zu", entries_.size());
+	for (std::size_t i = 0; i < pages_.size(); ++i)
+	{
+		ImGui::Text(
+			"Page %zu: %dx%d, %d / %d layers",
+			i,
+			pages_[i].width,
+			pages_[i].height,
+			pages_[i].layer_count,
+			max_layers_);
+	}
+}
+
+} // End namespace gl.
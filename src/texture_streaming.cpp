@@ -0,0 +1,587 @@
+#include <texture_streaming.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "file_system.h"
+#include "imgui.h"
+#include "stb_image.h"
+
+namespace gl {
+
+namespace {
+
+	int LevelSize(int size, int level)
+	{
+		return std::max(size >> level, 1);
+	}
+
+	// 2x2 box filter to the next level, odd sizes clamp the last texel.
+	std::vector<std::uint8_t> Downsample(
+		const std::vector<std::uint8_t>& source,
+		int width,
+		int height)
+	{
+		const int out_width = std::max(width / 2, 1);
+		const int out_height = std::max(height / 2, 1);
+		std::vector<std::uint8_t> result(
+			static_cast<std::size_t>(out_width) * out_height * 4);
+		for (int y = 0; y < out_height; ++y)
+		{
+			const int y0 = std::min(y * 2, height - 1);
+			const int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < out_width; ++x)
+			{
+				const int x0 = std::min(x * 2, width - 1);
+				const int x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; ++c)
+				{
+					const int sum =
+						source[(static_cast<std::size_t>(y0) * width + x0) * 4 + c] +
+						source[(static_cast<std::size_t>(y0) * width + x1) * 4 + c] +
+						source[(static_cast<std::size_t>(y1) * width + x0) * 4 + c] +
+						source[(static_cast<std::size_t>(y1) * width + x1) * 4 + c];
+					result[(static_cast<std::size_t>(y) * out_width + x) * 4 + c] =
+						static_cast<std::uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	double ToMegabytes(std::size_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+
+} // End anonymous namespace.
+
+void TextureStreamer::IsError(const char* file, int line) const
+{
+	auto error_code = glGetError();
+	if (error_code != GL_NO_ERROR)
+	{
+		throw std::runtime_error(
+			std::to_string(error_code) +
+			" in file: " + file +
+			" at line: " + std::to_string(line));
+	}
+}
+
+std::size_t TextureStreamer::LevelBytes(int width, int height, int level)
+{
+	return static_cast<std::size_t>(LevelSize(width, level)) *
+		LevelSize(height, level) * 4;
+}
+
+TextureStreamer::TextureStreamer(JobSystem& jobs, std::size_t budget_bytes) :
+	jobs_(jobs),
+	budget_bytes_(budget_bytes)
+{
+	// Bound while the mip tail of a texture is still loading.
+	const std::uint8_t gray[4] = { 128, 128, 128, 255 };
+	fallback_.Create("TextureStreamer fallback");
+	fallback_.SetBytes(4);
+	glBindTexture(GL_TEXTURE_2D, fallback_.Get());
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		0,
+		GL_RGBA8,
+		1,
+		1,
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		gray);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// Jobs still hold this to hand back their results.
+	jobs_.Wait();
+}
+
+std::uint32_t TextureStreamer::Load(const std::string& file_name)
+{
+	int width, height, channels;
+	const FileData file = FileSystem::GetInstance().Read(file_name, &jobs_);
+	if (!stbi_info_from_memory(
+		file.GetData(),
+		static_cast<int>(file.GetSize()),
+		&width,
+		&height,
+		&channels))
+	{
+		throw std::runtime_error("Could not read texture: " + file_name);
+	}
+	return Add(
+		width,
+		height,
+		[this, file_name](int level, int, int) {
+			int w, h, c;
+			// Read again on the job, free from a mapped archive, otherwise
+			// the blocks are shared with the other workers.
+			const FileData file =
+				FileSystem::GetInstance().Read(file_name, &jobs_);
+			stbi_uc* data = stbi_load_from_memory(
+				file.GetData(),
+				static_cast<int>(file.GetSize()),
+				&w,
+				&h,
+				&c,
+				4);
+			if (!data)
+			{
+				throw std::runtime_error("Could not load texture: " + file_name);
+			}
+			std::vector<std::uint8_t> pixels(
+				data,
+				data + static_cast<std::size_t>(w) * h * 4);
+			stbi_image_free(data);
+			for (int i = 0; i < level; ++i)
+			{
+				pixels = Downsample(pixels, w, h);
+				w = std::max(w / 2, 1);
+				h = std::max(h / 2, 1);
+			}
+			return pixels;
+		});
+}
+
+std::uint32_t TextureStreamer::Add(
+	int width,
+	int height,
+	MipGenerator generator)
+{
+	StreamedTexture streamed;
+	streamed.generator = std::move(generator);
+	streamed.width = width;
+	streamed.height = height;
+	streamed.level_count = static_cast<int>(
+		std::floor(std::log2(std::max(width, height)))) + 1;
+	while (streamed.tail_level < streamed.level_count - 1 &&
+		std::max(
+			LevelSize(width, streamed.tail_level),
+			LevelSize(height, streamed.tail_level)) > TAIL_SIZE)
+	{
+		++streamed.tail_level;
+	}
+	streamed.resident_level = streamed.level_count;
+	streamed.wanted_level = streamed.tail_level;
+
+	streamed.texture.Create("TextureStreamer texture");
+	glBindTexture(GL_TEXTURE_2D, streamed.texture.Get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, streamed.level_count - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, streamed.level_count - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+
+	const auto index = static_cast<std::uint32_t>(textures_.size());
+	textures_.push_back(std::move(streamed));
+	ScheduleLoad(
+		index,
+		textures_[index].tail_level,
+		textures_[index].level_count - 1);
+	return index;
+}
+
+void TextureStreamer::Destroy()
+{
+	jobs_.Wait();
+	results_.clear();
+	textures_.clear();
+	fallback_.Reset();
+	resident_bytes_ = 0;
+	pending_bytes_ = 0;
+	loads_in_flight_ = 0;
+}
+
+void TextureStreamer::ScheduleLoad(
+	std::uint32_t index,
+	int first_level,
+	int last_level)
+{
+	StreamedTexture& streamed = textures_[index];
+	streamed.loading = true;
+	++loads_in_flight_;
+	for (int level = first_level; level <= last_level; ++level)
+	{
+		pending_bytes_ += LevelBytes(streamed.width, streamed.height, level);
+	}
+	// Copies only, textures_ may grow while the job runs.
+	jobs_.Schedule([this,
+		index,
+		first_level,
+		last_level,
+		generator = streamed.generator,
+		width = streamed.width,
+		height = streamed.height]
+	{
+		LoadResult result;
+		result.texture = index;
+		result.first_level = first_level;
+		try
+		{
+			int w = LevelSize(width, first_level);
+			int h = LevelSize(height, first_level);
+			result.pixels.push_back(generator(first_level, w, h));
+			if (result.pixels.back().size() != static_cast<std::size_t>(w) * h * 4)
+			{
+				throw std::runtime_error("Mip generator returned a wrong size.");
+			}
+			// Coarser levels of the same job are filtered from the finer.
+			for (int level = first_level + 1; level <= last_level; ++level)
+			{
+				result.pixels.push_back(Downsample(result.pixels.back(), w, h));
+				w = std::max(w / 2, 1);
+				h = std::max(h / 2, 1);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Texture streaming: " << e.what() << "\n";
+			result.pixels.clear();
+			result.failed_level_count = last_level - first_level + 1;
+		}
+		std::lock_guard<std::mutex> lock(result_mutex_);
+		results_.push_back(std::move(result));
+	});
+}
+
+void TextureStreamer::BeginFrame(const Camera& camera, int viewport_height)
+{
+	++frame_;
+	camera_position_ = camera.position;
+	pixels_per_unit_at_one_ = static_cast<float>(viewport_height) /
+		(2.0f * std::tan(glm::radians(camera.Zoom) * 0.5f));
+	for (auto& streamed : textures_)
+	{
+		streamed.wanted_level = streamed.tail_level;
+	}
+}
+
+void TextureStreamer::Request(
+	std::uint32_t texture,
+	const glm::vec3& center,
+	float radius,
+	float uv_density)
+{
+	StreamedTexture& streamed = textures_[texture];
+	const float distance = std::max(
+		glm::length(center - camera_position_) - radius,
+		0.01f);
+	// One level per halving of the texels covering a pixel.
+	const float texels_per_unit =
+		static_cast<float>(std::max(streamed.width, streamed.height)) * uv_density;
+	const float pixels_per_unit = pixels_per_unit_at_one_ / distance;
+	const float lod = std::log2(texels_per_unit / pixels_per_unit) + lod_bias_;
+	const int level = std::clamp(
+		static_cast<int>(std::floor(lod)),
+		0,
+		streamed.tail_level);
+	streamed.wanted_level = std::min(streamed.wanted_level, level);
+	streamed.last_needed_frame = frame_;
+}
+
+void TextureStreamer::SetResidentLevel(StreamedTexture& streamed, int level)
+{
+	// Only finer levels arriving over resident ones fade in.
+	if (level < streamed.resident_level &&
+		streamed.resident_level < streamed.level_count)
+	{
+		streamed.lod_fade +=
+			static_cast<float>(streamed.resident_level - level);
+	}
+	else
+	{
+		streamed.lod_fade = 0.0f;
+	}
+	streamed.resident_level = level;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	// MIN_LOD is relative to the base level.
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, streamed.lod_fade);
+}
+
+void TextureStreamer::Upload(LoadResult& result)
+{
+	StreamedTexture& streamed = textures_[result.texture];
+	streamed.loading = false;
+	--loads_in_flight_;
+	const int level_count = result.pixels.empty() ?
+		result.failed_level_count :
+		static_cast<int>(result.pixels.size());
+	std::size_t bytes = 0;
+	for (int i = 0; i < level_count; ++i)
+	{
+		bytes += LevelBytes(
+			streamed.width,
+			streamed.height,
+			result.first_level + i);
+	}
+	pending_bytes_ -= bytes;
+	if (result.pixels.empty())
+	{
+		streamed.failed = true;
+		return;
+	}
+	// Levels evicted meanwhile, this one doesn't connect anymore.
+	if (result.first_level + level_count != streamed.resident_level) return;
+	const bool is_tail = result.first_level >= streamed.tail_level;
+	if (!is_tail)
+	{
+		const bool still_wanted = result.first_level >= streamed.wanted_level;
+		// Only push out levels nobody needs this frame, and only for a
+		// level that is itself still needed.
+		while (still_wanted &&
+			resident_bytes_ + bytes > budget_bytes_ &&
+			EvictOne(false))
+		{
+		}
+		if (resident_bytes_ + bytes > budget_bytes_) return;
+	}
+
+	std::size_t texture_bytes = 0;
+	for (int level = result.first_level; level < streamed.level_count; ++level)
+	{
+		texture_bytes += LevelBytes(streamed.width, streamed.height, level);
+	}
+	streamed.texture.SetBytes(texture_bytes);
+	glBindTexture(GL_TEXTURE_2D, streamed.texture.Get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (int i = 0; i < level_count; ++i)
+	{
+		const int level = result.first_level + i;
+		glTexImage2D(
+			GL_TEXTURE_2D,
+			level,
+			GL_RGBA8,
+			LevelSize(streamed.width, level),
+			LevelSize(streamed.height, level),
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			result.pixels[i].data());
+	}
+	SetResidentLevel(streamed, result.first_level);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+	resident_bytes_ += bytes;
+	uploaded_last_frame_ += bytes;
+	uploaded_total_ += bytes;
+}
+
+bool TextureStreamer::EvictOne(bool allow_needed)
+{
+	StreamedTexture* victim = nullptr;
+	for (auto& streamed : textures_)
+	{
+		if (streamed.resident_level >= streamed.tail_level) continue;
+		const bool spare = streamed.resident_level < streamed.wanted_level;
+		if (!spare && !allow_needed) continue;
+		if (!victim)
+		{
+			victim = &streamed;
+			continue;
+		}
+		const bool victim_spare = victim->resident_level < victim->wanted_level;
+		// Spare levels first, then least recently needed, then biggest.
+		if (spare != victim_spare)
+		{
+			if (spare) victim = &streamed;
+		}
+		else if (streamed.last_needed_frame != victim->last_needed_frame)
+		{
+			if (streamed.last_needed_frame < victim->last_needed_frame)
+				victim = &streamed;
+		}
+		else if (
+			LevelBytes(streamed.width, streamed.height, streamed.resident_level) >
+			LevelBytes(victim->width, victim->height, victim->resident_level))
+		{
+			victim = &streamed;
+		}
+	}
+	if (!victim) return false;
+
+	const int level = victim->resident_level;
+	const std::size_t bytes = LevelBytes(victim->width, victim->height, level);
+	glBindTexture(GL_TEXTURE_2D, victim->texture.Get());
+	SetResidentLevel(*victim, level + 1);
+	// A zero sized image releases the storage of a mutable texture level.
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		level,
+		GL_RGBA8,
+		0,
+		0,
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+	resident_bytes_ -= bytes;
+	victim->texture.SetBytes(
+		EstimateTextureBytes(
+			GL_RGBA8,
+			LevelSize(victim->width, level + 1),
+			LevelSize(victim->height, level + 1)));
+	evicted_last_frame_ += bytes;
+	evicted_total_ += bytes;
+	return true;
+}
+
+void TextureStreamer::Update(float dt)
+{
+	uploaded_last_frame_ = 0;
+	evicted_last_frame_ = 0;
+
+	// Finished loads, at least one per frame so big levels still land.
+	while (uploaded_last_frame_ < upload_bytes_per_frame_)
+	{
+		LoadResult result;
+		{
+			std::lock_guard<std::mutex> lock(result_mutex_);
+			if (results_.empty()) break;
+			result = std::move(results_.front());
+			results_.pop_front();
+		}
+		Upload(result);
+	}
+
+	for (auto& streamed : textures_)
+	{
+		if (streamed.lod_fade <= 0.0f) continue;
+		streamed.lod_fade = std::max(streamed.lod_fade - fade_speed_ * dt, 0.0f);
+		glBindTexture(GL_TEXTURE_2D, streamed.texture.Get());
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_LOD, streamed.lod_fade);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	IsError(__FILE__, __LINE__);
+
+	// The budget may have shrunk.
+	while (resident_bytes_ > budget_bytes_ && (EvictOne(false) || EvictOne(true)))
+	{
+	}
+
+	// Textures seen this frame first, the furthest from what they want
+	// first among those.
+	std::vector<std::uint32_t> candidates;
+	for (std::uint32_t i = 0; i < textures_.size(); ++i)
+	{
+		const StreamedTexture& streamed = textures_[i];
+		if (streamed.loading || streamed.failed) continue;
+		if (streamed.resident_level >= streamed.level_count) continue;
+		if (streamed.wanted_level >= streamed.resident_level) continue;
+		candidates.push_back(i);
+	}
+	std::sort(
+		candidates.begin(),
+		candidates.end(),
+		[this](std::uint32_t a, std::uint32_t b) {
+			const StreamedTexture& ta = textures_[a];
+			const StreamedTexture& tb = textures_[b];
+			if (ta.last_needed_frame != tb.last_needed_frame)
+				return ta.last_needed_frame > tb.last_needed_frame;
+			return ta.resident_level - ta.wanted_level >
+				tb.resident_level - tb.wanted_level;
+		});
+	for (const std::uint32_t index : candidates)
+	{
+		if (loads_in_flight_ >= max_loads_in_flight_) break;
+		const StreamedTexture& streamed = textures_[index];
+		const int level = streamed.resident_level - 1;
+		const std::size_t bytes =
+			LevelBytes(streamed.width, streamed.height, level);
+		while (resident_bytes_ + pending_bytes_ + bytes > budget_bytes_ &&
+			EvictOne(false))
+		{
+		}
+		// Everything resident is needed, stay at this quality.
+		if (resident_bytes_ + pending_bytes_ + bytes > budget_bytes_) break;
+		ScheduleLoad(index, level, level);
+	}
+}
+
+void TextureStreamer::Bind(std::uint32_t texture, unsigned int unit) const
+{
+	const StreamedTexture& streamed = textures_[texture];
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(
+		GL_TEXTURE_2D,
+		streamed.resident_level < streamed.level_count ?
+			streamed.texture.Get() :
+			fallback_.Get());
+	IsError(__FILE__, __LINE__);
+}
+
+std::size_t TextureStreamer::GetFullBytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto& streamed : textures_)
+	{
+		bytes += EstimateTextureBytes(GL_RGBA8, streamed.width, streamed.height);
+	}
+	return bytes;
+}
+
+void TextureStreamer::DrawImGui()
+{
+	ImGui::Text(
+		"Resident: %.1f / %.1f MB (full set %.1f MB)",
+		ToMegabytes(resident_bytes_),
+		ToMegabytes(budget_bytes_),
+		ToMegabytes(GetFullBytes()));
+	ImGui::ProgressBar(
+		budget_bytes_ ?
+			static_cast<float>(resident_bytes_) / static_cast<float>(budget_bytes_) :
+			0.0f);
+	ImGui::Text(
+		"Loads in flight: %d (%.1f MB reserved)",
+		loads_in_flight_,
+		ToMegabytes(pending_bytes_));
+	ImGui::Text(
+		"This frame: +%.2f MB / -%.2f MB",
+		ToMegabytes(uploaded_last_frame_),
+		ToMegabytes(evicted_last_frame_));
+	ImGui::Text(
+		"Total: +%.1f MB / -%.1f MB",
+		ToMegabytes(uploaded_total_),
+		ToMegabytes(evicted_total_));
+	int budget_mb = static_cast<int>(budget_bytes_ / (1024 * 1024));
+	if (ImGui::SliderInt("Budget (MB)", &budget_mb, 16, 4096))
+	{
+		budget_bytes_ = static_cast<std::size_t>(budget_mb) * 1024 * 1024;
+	}
+	ImGui::SliderFloat("LOD bias", &lod_bias_, -2.0f, 4.0f);
+	ImGui::SliderFloat("Fade (levels/s)", &fade_speed_, 0.5f, 16.0f);
+	if (ImGui::CollapsingHeader("Resident levels"))
+	{
+		std::vector<int> histogram;
+		for (const auto& streamed : textures_)
+		{
+			const int level = streamed.resident_level;
+			if (level >= static_cast<int>(histogram.size()))
+				histogram.resize(level + 1, 0);
+			++histogram[level];
+		}
+		for (std::size_t level = 0; level < histogram.size(); ++level)
+		{
+			if (!histogram[level]) continue;
+			ImGui::Text("Level %zu: %d textures", level, histogram[level]);
+		}
+	}
+}
+
+} // End namespace gl.